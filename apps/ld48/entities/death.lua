@@ -108,8 +108,12 @@ function Death:onInit(simulation)
 end
 function Death:onStep()
 	local lavaAnimationIndex = 1 + math.floor(client.state.frame / 20) % 4
-	for _, lava in ipairs(self.entitySys:findAll("lava")) do
-		lava.spriteId = "lava"..lavaAnimationIndex
+	local lavaSpriteId = "lava"..lavaAnimationIndex
+	for _, lava in self.entitySys:iterate("lava") do
+		if lava.spriteId ~= lavaSpriteId then
+			lava.spriteId = lavaSpriteId
+			self.entitySys:invalidate(lava)
+		end
 	end
 end
 
@@ -18,6 +18,7 @@ function Decoration:onInit(simulation)
 		},
 		["tags"] = {
 			["sprite"] = true,
+			["spriteStatic"] = true,
 		},
 		["editor"] = {
 			["category"] = "common",
@@ -34,6 +35,7 @@ function Decoration:onInit(simulation)
 		},
 		["tags"] = {
 			["sprite"] = true,
+			["spriteStatic"] = true,
 		},
 		["editor"] = {
 			["category"] = "common",
@@ -50,6 +52,7 @@ function Decoration:onInit(simulation)
 		},
 		["tags"] = {
 			["sprite"] = true,
+			["spriteStatic"] = true,
 		},
 		["editor"] = {
 			["category"] = "common",
@@ -66,6 +69,7 @@ function Decoration:onInit(simulation)
 		},
 		["tags"] = {
 			["sprite"] = true,
+			["spriteStatic"] = true,
 		},
 		["editor"] = {
 			["category"] = "common",
@@ -82,6 +86,7 @@ function Decoration:onInit(simulation)
 		},
 		["tags"] = {
 			["sprite"] = true,
+			["spriteStatic"] = true,
 		},
 		["editor"] = {
 			["category"] = "common",
@@ -98,6 +103,7 @@ function Decoration:onInit(simulation)
 		},
 		["tags"] = {
 			["sprite"] = true,
+			["spriteStatic"] = true,
 		},
 		["editor"] = {
 			["category"] = "common",
@@ -170,6 +170,7 @@ function Player:tickEntity(player)
 	-- 	droneFloatOffsetY = 0
 	-- end
 	player.offsetY = droneFloatOffsetY
+	self.entitySys:invalidate(player)
 end
 function Player:die()
 	log.debug("player death")
@@ -290,7 +291,7 @@ function Player:onLoadState()
 	self:reloadWorld()
 end
 function Player:onStep()
-	for _, player in ipairs(self.entitySys:findAll("player")) do
+	for _, player in self.entitySys:iterate("player") do
 		self:tickEntity(player)
 	end
 end
@@ -12,6 +12,7 @@ function Wall:onInit(simulation)
 
 	local tags = {
 		["sprite"] = true,
+		["spriteStatic"] = true,
 		["material"] = true,
 		["solid"] = true,
 	}
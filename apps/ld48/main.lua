@@ -6,6 +6,7 @@ local Audio = require("engine/systems/audio")
 local Sprite = require("engine/systems/sprite")
 local Text = require("engine/systems/text")
 local Shape = require("engine/systems/shape")
+local Rewind = require("engine/systems/rewind")
 
 local Editor = require("apps/ld48/systems/editor")
 local MainMenu = require("apps/ld48/systems/main_menu")
@@ -29,6 +30,7 @@ function ld48:onInit(simulation)
 	self.textSys = self.simulation:addSystem(Text)
 	self.shapeSys = self.simulation:addSystem(Shape)
 	self.editorSys = self.simulation:addSystem(Editor)
+	self.rewindSys = self.simulation:addSystem(Rewind)
 
 	self.mainMenuSys = self.simulation:addSystem(MainMenu)
 	self.materialSys = self.simulation:addSystem(Material)
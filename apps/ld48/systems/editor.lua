@@ -1,5 +1,6 @@
 local util = require("engine/util/util")
 local log = require("engine/util/log")
+local client = require("engine/client/client")
 local Input = require("engine/systems/input")
 local Entity = require("engine/systems/entity")
 local Sprite = require("engine/systems/sprite")
@@ -32,6 +33,7 @@ function Placeholder:setTemplate(placeholder, template)
 	self.entitySys:setSize(placeholder, newW, newH)
 
 	placeholder.placeholderTemplateId = template.templateId
+	self.entitySys:invalidate(placeholder)
 end
 function Placeholder:create(template, x, y)
 	local placeholder = self.templateSys:instantiate(self.placeholderTemplate, x, y)
@@ -170,6 +172,7 @@ function Editor:unsetEditorTemplate(editor)
 	editor.offsetY = 0
 	editor.spriteId = self.spriteSys:getInvalid().spriteId
 	editor.placeholderTemplateId = self.editorNoSelectionTemplate.templateId
+	self.entitySys:invalidate(editor)
 end
 function Editor:setEditorTemplate(editor, template)
 	local currentTemplate = self.templateSys:get(editor.placeholderTemplateId)
@@ -194,6 +197,7 @@ function Editor:setEditorTemplate(editor, template)
 	local newW, newH = editor.w, editor.h
 	editor.w, editor.h = oldW, oldH
 	self.entitySys:setSize(editor, newW, newH)
+	self.entitySys:invalidate(editor)
 end
 function Editor:editModeStep()
 	local editor = self:getInstance()
@@ -251,7 +255,7 @@ function Editor:editModeDraw(camera)
 		self.textSys:drawDebugString("hover="..templatesStr)
 	end
 
-	local editorOutline = util.deepcopy(editor)
+	local editorOutline = util.tableCopyInto(self.editorOutline, editor)
 	editorOutline.r = 0
 	editorOutline.g = 0
 	editorOutline.b = 0
@@ -444,6 +448,7 @@ function Editor:onInit(simulation)
 	self.placeholderInstanceSys = self.simulation:addSystem(PlaceholderInstance)
 
 	self.gridSize = 8
+	self.editorOutline = {}
 
 	self.editorNoSelectionTemplate = self.templateSys:add("editorNoSelection", {
 		["properties"] = {
@@ -580,4 +585,83 @@ function Editor:onCameraDraw(camera)
 	end
 end
 
+function Editor:onRunTests()
+	-- a save replayed from its snapshot and journal must equal a full snapshot, so the editor and placeholder fields
+	-- written directly must be invalidated
+	local saveFilename = "test_editor_save.sav"
+	log.assert(self.simulation:save(saveFilename))
+	local editor = self:getInstance()
+	local placeholder = self.placeholderSys:create(self:findNextEditorTemplate(), 0, 0)
+	log.assert(self.simulation:save(saveFilename))
+	self:setEditorTemplate(editor, self:findNextEditorTemplate())
+	self.placeholderSys:setTemplate(placeholder, self:findNextEditorTemplate(placeholder.placeholderTemplateId))
+	log.assert(self.simulation:save(saveFilename))
+	self:unsetEditorTemplate(editor)
+	log.assert(self.simulation:save(saveFilename))
+	local matches, journal = self.simulation:getSaveMatchesSnapshot(saveFilename)
+	log.assert(matches)
+	log.assert(journal.recordCount > 0)
+	os.remove(saveFilename)
+	os.remove(self.simulation:getJournalFilename(saveFilename))
+	self.entitySys:destroy(placeholder)
+	self.entitySys:destroy(editor)
+
+	-- util.json is the c client's codec when one is running; it must agree with the lua fallback on every world
+	if util.json == util.luaJson then
+		return
+	end
+
+	local playerSys = self.simulation:getSystem("player")
+	for _, worldName in ipairs(self.simulation.constants.worldIdToWorld) do
+		local worldStr = util.readDataUncompressed(playerSys:computeWorldFilename(worldName))
+		local world = util.json.decode(worldStr)
+		log.assert(util.tableDeepEquals(world, util.luaJson.decode(worldStr)))
+		log.assert(util.json.encode(world) == util.luaJson.encode(world))
+	end
+end
+function Editor:onRunBenchmarks()
+	if client.state.headless then
+		log.info("headless client has no native encoder, skipping")
+		return 1
+	end
+
+	-- compares client.encode()/decode() and the native json codec with the lua one on every world,
+	-- as json dominates loading them
+	local playerSys = self.simulation:getSystem("player")
+	local worlds = {}
+	local jsonWorlds = {}
+	local encodedWorlds = {}
+	local jsonBytes = 0
+	local encodedBytes = 0
+	for i, worldName in ipairs(self.simulation.constants.worldIdToWorld) do
+		worlds[i] = util.json.decode(util.readDataUncompressed(playerSys:computeWorldFilename(worldName)))
+		jsonWorlds[i] = util.json.encode(worlds[i])
+		encodedWorlds[i] = client.encode(worlds[i])
+		jsonBytes = jsonBytes + #jsonWorlds[i]
+		encodedBytes = encodedBytes + #encodedWorlds[i]
+	end
+
+	local function runAll(fn, values)
+		for _, value in ipairs(values) do
+			fn(value)
+		end
+	end
+
+	local iterations = 100
+	util.benchmark(string.format("luaJson.encode, worlds=%d, bytes=%d", #worlds, jsonBytes),
+		iterations, runAll, util.luaJson.encode, worlds)
+	util.benchmark(string.format("json.encode, worlds=%d, bytes=%d", #worlds, jsonBytes),
+		iterations, runAll, util.json.encode, worlds)
+	util.benchmark(string.format("client.encode, worlds=%d, bytes=%d", #worlds, encodedBytes),
+		iterations, runAll, client.encode, worlds)
+	util.benchmark(string.format("luaJson.decode, worlds=%d", #worlds),
+		iterations, runAll, util.luaJson.decode, jsonWorlds)
+	util.benchmark(string.format("json.decode, worlds=%d", #worlds),
+		iterations, runAll, util.json.decode, jsonWorlds)
+	util.benchmark(string.format("client.decode, worlds=%d", #worlds),
+		iterations, runAll, client.decode, encodedWorlds)
+
+	return 1
+end
+
 return Editor
@@ -70,6 +70,7 @@ function MainMenu:onInit(simulation)
 	self.editorSys = self.simulation:addSystem(Editor)
 
 	self.selectedButtonId = 1
+	self.buttonOutline = {}
 	self.font = self.textSys:getDefaultFont()
 
 	self.buttonTemplate = self.templateSys:add("mainMenuButton", {
@@ -124,7 +125,7 @@ function MainMenu:onCameraDraw(camera)
 		return
 	end
 
-	local buttonOutline = util.deepcopy(selectedButton)
+	local buttonOutline = util.tableCopyInto(self.buttonOutline, selectedButton)
 	buttonOutline.r = 1
 	buttonOutline.g = 1
 	buttonOutline.b = 1
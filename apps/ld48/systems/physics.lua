@@ -8,32 +8,33 @@ local Material = require("apps/ld48/systems/material")
 
 local Physics = {}
 Physics.SYSTEM_NAME = "physics"
+Physics.MATERIAL_TAGS = {"material"}
 function Physics:getMaterialPhysics(entity)
 	local constants = self.simulation.constants
 
 	local gravitySignX = util.sign(constants.physicsGravityX)
 	local gravitySignY = util.sign(constants.physicsGravityY)
-	local materialEntity = self.entitySys:findBounded(
+	local entitySys = self.entitySys
+	local materialEntity = entitySys:findBoundedWith(
 		entity.x + math.min(0, gravitySignX),
 		entity.y + math.min(0, gravitySignY),
 		entity.w + math.max(0, gravitySignX),
 		entity.h + math.max(0, gravitySignY),
-		"material",
+		self.MATERIAL_TAGS,
+		nil,
 		entity.id
 	)
 
 	local materialsPhysics = constants.physicsMaterials
 	local materialPhysics = materialsPhysics.air
 	if materialEntity then
-		local entityTags = materialEntity.tags
-
-		local materials = constants.materials
-		local materialsCount = #materials
-		for i = 1, materialsCount do
-			local material = materials[i]
-			local candidateMaterialPhysics = materialsPhysics[material]
-			if entityTags[material] and candidateMaterialPhysics then
-				materialPhysics = candidateMaterialPhysics
+		-- the first material the entity has, in the order materials were declared
+		local materialEntityId = materialEntity.id
+		local physicsMaterialsTags = constants.physicsMaterialsTags
+		for i = 1, #physicsMaterialsTags do
+			local materialTags = physicsMaterialsTags[i]
+			if entitySys:getTagMaskMatches(materialEntityId, entitySys:getTagMask(materialTags)) then
+				materialPhysics = materialsPhysics[materialTags[1]]
 				break
 			end
 		end
@@ -50,9 +51,14 @@ function Physics:getCarryablesRecursive(entity, outCarryables, recursionDepth)
 		return outCarryables
 	end
 
-	local candidates = self.entitySys:findAllRelative(
+	-- each recursion depth keeps its own candidates buffer, as deeper calls run while it is being read
+	local candidates = self.carryableCandidates[recursionDepth]
+	if candidates == nil then
+		candidates = {}
+		self.carryableCandidates[recursionDepth] = candidates
+	end
+	local candidatesCount = self.entitySys:findAllRelativeInto(candidates,
 		entity, -util.sign(constants.physicsGravityX), -util.sign(constants.physicsGravityY), "physicsCarryable")
-	local candidatesCount = #candidates
 
 	for i = 1, candidatesCount do
 		local candidate = candidates[i]
@@ -65,19 +71,34 @@ function Physics:getCarryablesRecursive(entity, outCarryables, recursionDepth)
 
 	return outCarryables
 end
+-- carried entities are collected into a table per recursion depth, as deeper moves can carry while it is being read.
+-- it is emptied by the caller once read
+function Physics:getCarryablesBuffer(recursionDepth)
+	local carryables = self.carryables[recursionDepth]
+	if carryables == nil then
+		carryables = {}
+		self.carryables[recursionDepth] = carryables
+	end
+
+	return carryables
+end
 function Physics:stopX(entity)
 	self.simulation:broadcast("onPhysicsEntityStopX", true, entity)
 
-	entity.forceX = 0
-	entity.speedX = 0
-	entity.overflowX = 0
+	local columns = self.entitySys:getComponentColumns("physics")
+	local entityId = entity.id
+	columns.forceX[entityId] = 0
+	columns.speedX[entityId] = 0
+	columns.overflowX[entityId] = 0
 end
 function Physics:stopY(entity)
 	self.simulation:broadcast("onPhysicsEntityStopY", true, entity)
 
-	entity.forceY = 0
-	entity.speedY = 0
-	entity.overflowY = 0
+	local columns = self.entitySys:getComponentColumns("physics")
+	local entityId = entity.id
+	columns.forceY[entityId] = 0
+	columns.speedY[entityId] = 0
+	columns.overflowY[entityId] = 0
 end
 function Physics:tryPushX(entity, signX, recursionDepth)
 	local constants = self.simulation.constants
@@ -158,9 +179,14 @@ function Physics:tryMoveX(entity, moveX, recursionDepth, innerMove)
 	self.entitySys:setBounds(entity, entity.x + curMoveX, entity.y, entity.w, entity.h)
 
 	if curMoveX ~= 0 and entity.physicsCanCarry and not innerMove and constants.physicsGravityY ~= 0 then
-		for _, carryable in pairs(self:getCarryablesRecursive(entity, {}, recursionDepth + 1)) do
+		local carryables = self:getCarryablesRecursive(
+			entity, self:getCarryablesBuffer(recursionDepth), recursionDepth + 1)
+		for _, carryable in pairs(carryables) do
 			self:tryMoveX(carryable, curMoveX, recursionDepth + 1, true)
 		end
+		for entityId, _ in pairs(carryables) do
+			carryables[entityId] = nil
+		end
 	end
 
 	return moveSuccessful
@@ -197,23 +223,86 @@ function Physics:tryMoveY(entity, moveY, recursionDepth, innerMove)
 	end
 
 	if curMoveY ~= 0 and entity.physicsCanCarry and not innerMove and constants.physicsGravityX ~= 0 then
-		for _, carryable in pairs(self:getCarryablesRecursive(entity, {}, recursionDepth + 1)) do
+		local carryables = self:getCarryablesRecursive(
+			entity, self:getCarryablesBuffer(recursionDepth), recursionDepth + 1)
+		for _, carryable in pairs(carryables) do
 			self:tryMoveY(carryable, curMoveY, recursionDepth + 1, true)
 		end
+		for entityId, _ in pairs(carryables) do
+			carryables[entityId] = nil
+		end
 	end
 
 	self.entitySys:setBounds(entity, entity.x, entity.y + curMoveY, entity.w, entity.h)
 
 	return moveSuccessful
 end
+-- returns how many of the moves ahead, one pixel at a time, can skip the checks in tryMoveX() and tryMoveY(): those
+-- that have no solids to push or stop at, and nothing to carry.  only moves along one axis are swept; moves along both
+-- are either all free, when there is nothing in the bounds covering all of them, or all checked
+function Physics:getFreeMoves(entity, moveX, moveY)
+	local constants = self.simulation.constants
+	local entitySys = self.entitySys
+
+	local absMoveX = math.abs(moveX)
+	local absMoveY = math.abs(moveY)
+	local gravitySignX = util.sign(constants.physicsGravityX)
+	local gravitySignY = util.sign(constants.physicsGravityY)
+	local carryingX = entity.physicsCanCarry and (moveX ~= 0) and (gravitySignY ~= 0)
+	local carryingY = entity.physicsCanCarry and (moveY ~= 0) and (gravitySignX ~= 0)
+
+	if (moveX ~= 0) and (moveY ~= 0) then
+		local x = entity.x + math.min(0, moveX)
+		local y = entity.y + math.min(0, moveY)
+		local w = entity.w + absMoveX
+		local h = entity.h + absMoveY
+		if entitySys:findBounded(x, y, w, h, "solid", entity.id) ~= nil then
+			return 0, 0
+		end
+		if ((carryingX or carryingY) and (entitySys:findBounded(
+			x - gravitySignX, y - gravitySignY, w, h, "physicsCarryable", entity.id) ~= nil)) then
+			return 0, 0
+		end
+		return absMoveX, absMoveY
+	end
+
+	local _, solidStep = entitySys:sweep(entity, moveX, moveY, "solid")
+	local freeMoves = (solidStep or (absMoveX + absMoveY + 1)) - 1
+
+	-- carryables are found against gravity from the entity, after it moves along x and before it moves along y
+	if carryingX or carryingY then
+		local carryFrom = self.carryFrom
+		carryFrom.id, carryFrom.x, carryFrom.y = entity.id, entity.x - gravitySignX, entity.y - gravitySignY
+		carryFrom.w, carryFrom.h = entity.w, entity.h
+
+		local carryable, carryableStep = entitySys:sweep(carryFrom, moveX, moveY, "physicsCarryable")
+		if carryingY and (entitySys:findRelative(carryFrom, 0, 0, "physicsCarryable") ~= nil) then
+			freeMoves = 0
+		elseif carryable ~= nil then
+			freeMoves = math.min(freeMoves, carryableStep - (carryingX and 1 or 0))
+		end
+	end
+
+	if moveX ~= 0 then
+		return freeMoves, 0
+	end
+	return 0, freeMoves
+end
 function Physics:tickForces(entity)
 	local constants = self.simulation.constants
 
+	local columns = self.entitySys:getComponentColumns("physics")
+	local forceXs = columns.forceX
+	local forceYs = columns.forceY
+	local speedXs = columns.speedX
+	local speedYs = columns.speedY
+	local entityId = entity.id
+
 	-- apply force to speed
-	entity.speedX = entity.speedX + entity.forceX
-	entity.speedY = entity.speedY + entity.forceY
-	entity.forceX = 0
-	entity.forceY = 0
+	speedXs[entityId] = speedXs[entityId] + forceXs[entityId]
+	speedYs[entityId] = speedYs[entityId] + forceYs[entityId]
+	forceXs[entityId] = 0
+	forceYs[entityId] = 0
 
 	-- get material physics to apply
 	local materialPhysics = self:getMaterialPhysics(entity)
@@ -226,7 +315,7 @@ function Physics:tickForces(entity)
 	local gravityForceX = constants.physicsGravityX * entityGravityMultiplier
 	local gravityForceY = constants.physicsGravityY * entityGravityMultiplier
 	local gravityForceApplied = (gravityForceX ~= 0) or (gravityForceY ~= 0)
-	if gravityForceApplied then
+	if gravityForceApplied and log.getLevelEnabled(log.LOG_LEVEL_TRACE) then
 		log.trace(
 			"gravity applied, entity=%s, gravityForceX=%s, gravityForceY=%s",
 			util.getComparable(entity),
@@ -234,16 +323,16 @@ function Physics:tickForces(entity)
 			gravityForceY
 		)
 	end
-	entity.forceX = entity.forceX + gravityForceX
-	entity.forceY = entity.forceY + gravityForceY
+	forceXs[entityId] = forceXs[entityId] + gravityForceX
+	forceYs[entityId] = forceYs[entityId] + gravityForceY
 
 	-- apply "friction" to speed
-	local speedSignX = util.sign(entity.speedX)
-	local speedSignY = util.sign(entity.speedY)
-	local frictionX = -(materialPhysics.friction * util.sign(entity.speedX))
-	local frictionY = -(materialPhysics.friction * util.sign(entity.speedY))
+	local speedSignX = util.sign(speedXs[entityId])
+	local speedSignY = util.sign(speedYs[entityId])
+	local frictionX = -(materialPhysics.friction * speedSignX)
+	local frictionY = -(materialPhysics.friction * speedSignY)
 	local frictionApplied = (frictionX ~= 0) or (frictionY ~= 0)
-	if frictionApplied then
+	if frictionApplied and log.getLevelEnabled(log.LOG_LEVEL_TRACE) then
 		log.trace(
 			"friction applied, entity=%s, frictionX=%s, frictionY=%s",
 			util.getComparable(entity),
@@ -252,29 +341,39 @@ function Physics:tickForces(entity)
 		)
 	end
 
-	entity.speedX = entity.speedX + frictionX
-	entity.speedY = entity.speedY + frictionY
-	if util.sign(entity.speedX) ~= speedSignX then
+	speedXs[entityId] = speedXs[entityId] + frictionX
+	speedYs[entityId] = speedYs[entityId] + frictionY
+	if util.sign(speedXs[entityId]) ~= speedSignX then
 		self:stopX(entity)
 	end
-	if util.sign(entity.speedY) ~= speedSignY then
+	if util.sign(speedYs[entityId]) ~= speedSignY then
 		self:stopY(entity)
 	end
 end
 function Physics:tickMovement(entity)
 	local constants = self.simulation.constants
 
+	local columns = self.entitySys:getComponentColumns("physics")
+	local speedXs = columns.speedX
+	local speedYs = columns.speedY
+	local overflowXs = columns.overflowX
+	local overflowYs = columns.overflowY
+	local entityId = entity.id
+
 	-- clamp speed to max speed
-	entity.speedX = math.max(-constants.physicsMaxSpeed, math.min(constants.physicsMaxSpeed, entity.speedX))
-	entity.speedY = math.max(-constants.physicsMaxSpeed, math.min(constants.physicsMaxSpeed, entity.speedY))
+	local maxSpeed = constants.physicsMaxSpeed
+	local speedX = math.max(-maxSpeed, math.min(maxSpeed, speedXs[entityId]))
+	local speedY = math.max(-maxSpeed, math.min(maxSpeed, speedYs[entityId]))
+	speedXs[entityId] = speedX
+	speedYs[entityId] = speedY
 
 	-- compute amount to move (integer values).  the fractional movement component is accumulated for subsequent ticks
-	local moveX, overflowX = math.modf(entity.speedX)
-	local moveY, overflowY = math.modf(entity.speedY)
-	local overflowCarryX, overflowRemainderX = math.modf(overflowX + entity.overflowX)
-	local overflowCarryY, overflowRemainderY = math.modf(overflowY + entity.overflowY)
-	entity.overflowX = overflowRemainderX
-	entity.overflowY = overflowRemainderY
+	local moveX, overflowX = math.modf(speedX)
+	local moveY, overflowY = math.modf(speedY)
+	local overflowCarryX, overflowRemainderX = math.modf(overflowX + overflowXs[entityId])
+	local overflowCarryY, overflowRemainderY = math.modf(overflowY + overflowYs[entityId])
+	overflowXs[entityId] = overflowRemainderX
+	overflowYs[entityId] = overflowRemainderY
 	moveX = moveX + overflowCarryX
 	moveY = moveY + overflowCarryY
 
@@ -284,22 +383,45 @@ function Physics:tickMovement(entity)
 	local movingY = (signY ~= 0)
 	local absMoveX = math.abs(moveX)
 	local absMoveY = math.abs(moveY)
+
+	-- moving one pixel at a time checks for solids at every pixel, so the pixels known to be free are moved without
+	-- checking.  the rest still move through tryMoveX() and tryMoveY(), so pushes, carries and stops are unchanged
+	local freeMovesX = 0
+	local freeMovesY = 0
+	if constants.physicsFreeMovesEnabled and ((absMoveX > 1) or (absMoveY > 1)) then
+		freeMovesX, freeMovesY = self:getFreeMoves(entity, moveX, moveY)
+	end
+
+	local entitySys = self.entitySys
 	for i = 1, math.max(absMoveX, absMoveY) do
 		if not movingX and not movingY then
 			break
 		end
 
 		if movingX then
-			movingX = self:tryMoveX(entity, signX) and (i < absMoveX)
+			if i <= freeMovesX then
+				entitySys:setBounds(entity, entity.x + signX, entity.y, entity.w, entity.h)
+				movingX = (i < absMoveX)
+			else
+				movingX = self:tryMoveX(entity, signX) and (i < absMoveX)
+			end
 		end
 		if movingY then
-			movingY = self:tryMoveY(entity, signY) and (i < absMoveY)
+			if i <= freeMovesY then
+				entitySys:setBounds(entity, entity.x, entity.y + signY, entity.w, entity.h)
+				movingY = (i < absMoveY)
+			else
+				movingY = self:tryMoveY(entity, signY) and (i < absMoveY)
+			end
 		end
 	end
 end
 function Physics:tick(entity)
 	self:tickForces(entity)
 	self:tickMovement(entity)
+
+	-- forces and speeds change every tick, even when the entity doesn't move
+	self.entitySys:invalidate(entity)
 end
 function Physics:onInit(simulation)
 	self.simulation = simulation
@@ -308,6 +430,15 @@ function Physics:onInit(simulation)
 	self.templateSys = self.simulation:addSystem(Template)
 	self.materialSys = self.simulation:addSystem(Material)
 
+	self.carryableCandidates = {}
+	self.carryables = {}
+	-- the bounds carryables are swept from, reused each tick
+	self.carryFrom = {["id"] = 0, ["x"] = 0, ["y"] = 0, ["w"] = 0, ["h"] = 0}
+
+	-- forces, speeds and overflow (from the last tick; an artefact of locking x, y to integer values) change every
+	-- tick, so are kept in component columns.  they start at 0
+	self.entitySys:addComponent("physics", {"forceX", "forceY", "speedX", "speedY", "overflowX", "overflowY"})
+
 	local constants = self.simulation.constants
 
 	constants.physicsGravityX = 0
@@ -315,6 +446,8 @@ function Physics:onInit(simulation)
 	constants.physicsMaxSpeed = 8
 	constants.physicsMaxRecursionDepth = 100
 	constants.physicsPushCounterforce = 0.1
+	-- disabling checks every pixel moved, which the tests compare against
+	constants.physicsFreeMovesEnabled = true
 
 	local defaultMaterialPhysics = {
 		["friction"] = 0.3,
@@ -322,33 +455,76 @@ function Physics:onInit(simulation)
 		["jumpForceStrength"] = 1,
 	}
 	constants.physicsMaterials = {}
+	-- a tag list per material, kept so that their tag masks are cached
+	constants.physicsMaterialsTags = {}
 	for _, materialName in ipairs(self.simulation.constants.materials) do
 		constants.physicsMaterials[materialName] = util.tableExtend({["id"] = materialName}, defaultMaterialPhysics)
+		constants.physicsMaterialsTags[#constants.physicsMaterialsTags + 1] = {materialName}
 	end
 	local airPhysics = constants.physicsMaterials.air
 	airPhysics.friction = 0.1
 	airPhysics.moveForceStrength = 0.5
 end
 function Physics:onStep()
-	for _, entity in ipairs(self.entitySys:findAll("physics")) do
+	for _, entity in self.entitySys:iterate("physics") do
 		self:tick(entity)
 	end
 end
 function Physics.onEntityTag(_, entity, tag, tagId)
 	if tagId ~= nil and tag == "physics" then
-		entity.forceX = entity.forceX or 0
-		entity.forceY = entity.forceY or 0
-		entity.speedX = entity.speedX or 0
-		entity.speedY = entity.speedY or 0
-
-		-- overflow from last physics tick.  an artefact of locking x, y to integer values
-		entity.overflowX = entity.overflowX or 0
-		entity.overflowY = entity.overflowY or 0
-
 		entity.physicsCanPush = entity.physicsCanPush or false
 		entity.physicsCanCarry = entity.physicsCanCarry or false
 	end
 end
+function Physics:onRunTests()
+	-- moves known to be free skip the per-pixel checks, which must not change the outcome of any step.  each world
+	-- is stepped with the same scripted input and kicks, with free moves disabled and then enabled
+	local constants = self.simulation.constants
+	local playerSys = self.simulation:getSystem("player")
+	local inputSys = self.simulation:getSystem("input")
+	local screen = self.simulation.input.screen
+	local screenBackup = util.deepcopy(screen)
+	screen.x2, screen.y2 = 160, 120
+	local inputs = {}
+	inputSys.get = function(_, key)
+		return inputs[key] or false
+	end
+	local function replayWorld(worldName, freeMovesEnabled)
+		constants.physicsFreeMovesEnabled = freeMovesEnabled
+		playerSys:loadWorld(worldName)
+		for step = 1, 60 do
+			local inputPattern = math.floor(step / 10) % 4
+			inputs.left = (inputPattern == 1)
+			inputs.right = (inputPattern >= 2)
+			inputs.up = (inputPattern ~= 0)
+			if (step % 10) == 5 then
+				for i, entity in ipairs(self.entitySys:findAll("physics")) do
+					entity.speedX = ((((step + i) % 2) * 2) - 1) * 3
+				end
+			end
+
+			self:onStep()
+			playerSys:onStep()
+		end
+
+		return util.deepcopy(self.simulation.state.world)
+	end
+	for _, worldName in ipairs(constants.worldIdToWorld) do
+		log.assert(util.tableDeepEquals(replayWorld(worldName, false), replayWorld(worldName, true)))
+	end
+	constants.physicsFreeMovesEnabled = true
+	inputSys.get = nil
+	screen.x2, screen.y2 = screenBackup.x2, screenBackup.y2
+end
+function Physics:onRunBenchmarks()
+	-- steps every entity tagged "physics" in each world
+	local playerSys = self.simulation:getSystem("player")
+	for _, worldName in ipairs(self.simulation.constants.worldIdToWorld) do
+		playerSys:loadWorld(worldName)
+		util.benchmark(string.format("physics step, world=%s, physicsEntities=%d", worldName,
+			#self.entitySys:findAll("physics")), 1000, self.onStep, self)
+	end
+end
 
 return Physics
 
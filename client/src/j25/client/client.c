@@ -1,7 +1,13 @@
 #include <j25/client/client.h>
 
+#include <j25/client/deepcopy.h>
 #include <j25/core/common.h>
 #include <j25/core/container.h>
+#include <j25/core/codec.h>
+#include <j25/core/compression.h>
+#include <j25/core/json.h>
+#include <j25/core/spatial.h>
+#include <j25/platform/data.h>
 #include <j25/platform/image.h>
 #include <j25/platform/rendering.h>
 #include <j25/platform/audio.h>
@@ -10,10 +16,11 @@
 #include <ctype.h>
 #include <errno.h>
 #include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
-#include <zlib.h>
-
 /*
  * C and C++ have different default linkage.
  * Lua(jit) headers don't explicitly state linkage of symbols,
@@ -39,7 +46,6 @@ extern "C" {
 
 /*https://www.lua.org/manual/5.1/manual.html*/
 #define JE_LUA_STACK_TOP (-1)
-#define JE_LUA_DATA_BUFFER_SIZE (8 * 1024 * 1024)
 
 #define JE_LUA_CLIENT_BINDINGS_KEY "jeLuaClientBindings"
 #define JE_LUA_CLIENT_WINDOW_KEY "jeLuaWindow"
@@ -60,6 +66,150 @@ struct jeClient {
 	struct lua_State* lua;
 };
 
+/*Data queued by writeDataAsync() is borrowed from lua strings, which are kept alive by the JE_LUA_DATA_WRITES_KEY
+ * registry table (along with the callbacks) until the write's completion is delivered during client.step()*/
+#define JE_LUA_DATA_WRITER_KEY "jeLuaDataWriter"
+#define JE_LUA_DATA_WRITES_KEY "jeLuaDataWrites"
+
+#define JE_LUA_JSON_PRESIZE_COUNT 4
+
+#define JE_LUA_SPATIAL_HASH_METATABLE "jeSpatialHashMetatable"
+
+#define JE_LUA_TEXT_MESH_COUNT 64
+#define JE_LUA_TEXT_CACHE_KEY "jeLuaTextCache"
+#define JE_LUA_TEXT_FONTS_KEY "jeLuaTextFonts"
+
+#define JE_LUA_STATE_FIELD_TYPE_BOOL 0
+#define JE_LUA_STATE_FIELD_TYPE_UINT32 1
+#define JE_LUA_STATE_FIELD_TYPE_INT32 2
+#define JE_LUA_STATE_FIELD(FIELD_NAME, FIELD_TYPE) \
+	{ #FIELD_NAME, offsetof(struct jeLuaClientState, FIELD_NAME), FIELD_TYPE }
+
+/*Per-frame client state, written in place by jeLua_updateStates() and read by lua as client.state.
+ * Inputs are bitmasks indexed by JE_INPUT_* and JE_MOUSE_BUTTON_*.*/
+struct jeLuaClientState {
+	uint32_t width;
+	uint32_t height;
+	uint32_t logLevel;
+	uint32_t testsLogLevel;
+	uint32_t fps;
+	uint32_t frame;
+	uint32_t inputMask;
+	uint32_t inputMouseMask;
+	int32_t inputMouseX;
+	int32_t inputMouseY;
+	uint32_t breakpointCount;
+	uint32_t frameVertexCount;
+	uint32_t frameInstanceCount;
+	uint32_t frameSortedPrimitiveCount;
+	uint32_t frameUploadBytes;
+	uint32_t frameUploadMicroseconds;
+	uint32_t frameLayerCount;
+	uint32_t frameLayerUploadBytes;
+	uint32_t frameBatchCount;
+	uint32_t frameTextureBindCount;
+	uint32_t frameCulledCount;
+	uint32_t frameSubmittedCount;
+	bool running;
+	bool headless;
+	bool testsEnabled;
+};
+
+struct jeLuaClientStateField {
+	const char* name;
+	size_t offset;
+	uint32_t type;
+};
+
+/*Strings already written, by string, are kept in a lua table at stringsIndex*/
+struct jeLuaEncoder {
+	struct jeEncoder encoder;
+	uint32_t stringCount;
+	int stringsIndex;
+};
+
+/*Strings already read, by index, are kept in a lua table at stringsIndex*/
+struct jeLuaDecoder {
+	struct jeDecoder decoder;
+	uint32_t stringCount;
+	int stringsIndex;
+};
+
+/*Tables being encoded, by depth, are kept to detect circular references*/
+struct jeLuaJsonEncoder {
+	struct jeJsonEncoder encoder;
+	const void* tables[JE_JSON_MAX_DEPTH];
+};
+
+/*Font fields, read once per font table; fonts are treated as constant after they are first drawn*/
+struct jeLuaFont {
+	float u;
+	float v;
+	uint32_t charW;
+	uint32_t charH;
+	uint32_t charColumns;
+	char charFirst;
+	char charLast;
+	uint32_t textureId;
+
+	/*Defaults for the renderable's color*/
+	float r;
+	float g;
+	float b;
+	float a;
+
+	/*Overrides of the renderable's z and color, or NAN when not set*/
+	float textZ;
+	float textR;
+	float textG;
+	float textB;
+	float textA;
+};
+
+/*Results are written to arrays kept with the hash, so that queries don't allocate once they have grown*/
+struct jeLuaSpatialHash {
+	struct jeSpatialHash hash;
+	struct jeArray entityIds;
+	struct jeArray steps;
+};
+
+/*Glyph sprites of a string, relative to the text origin.  Replayed as-is while the string is drawn unchanged.*/
+struct jeLuaTextMesh {
+	uint32_t fontIndex;
+	uint32_t hash;
+	uint32_t lastUsed;
+	float z;
+	float r;
+	float g;
+	float b;
+	float a;
+	struct jeString text;
+	struct jeArray vertices;
+};
+
+/*Fonts are looked up by table from the JE_LUA_TEXT_FONTS_KEY registry table; least recently used meshes are evicted*/
+struct jeLuaTextCache {
+	struct jeArray fonts;
+	struct jeLuaTextMesh meshes[JE_LUA_TEXT_MESH_COUNT];
+	uint32_t useCount;
+};
+
+/*C ABI handed to LuaJIT's ffi as client.ffiApi, so Lua can submit jeVertex arrays without marshalling tables.
+ * Function pointers are used rather than exported symbols, as the client is linked statically (and with
+ * -fwhole-program in release).  The layout must match the ffi.cdef in engine/client/client.lua.*/
+struct jeLuaFfiApi {
+	struct jeWindow* window;
+	struct jeLuaClientState state;
+	void (*drawPrimitives)(
+		struct jeWindow* window,
+		const struct jeVertex* vertices,
+		uint32_t primitiveCount,
+		uint32_t primitiveType,
+		uint32_t textureId,
+		float offsetX,
+		float offsetY);
+};
+
 const char* jeLua_getError(lua_State* lua);
 double jeLua_getNumberField(lua_State* lua, uint32_t tableIndex, const char* field);
 double jeLua_getOptionalNumberField(lua_State* lua, uint32_t tableIndex, const char* field, double defaultValue);
@@ -67,19 +217,86 @@ bool jeLua_getBoolField(lua_State* lua, uint32_t tableIndex, const char* field);
 const char* jeLua_getStringField(lua_State* lua, uint32_t tableIndex, const char* field, uint32_t* optOutSize);
 struct jeWindow* jeLua_getWindow(lua_State* lua);
 bool jeLua_addWindow(lua_State* lua, struct jeWindow* window);
+struct jeLuaClientState* jeLua_getState(lua_State* lua);
+int jeLua_getStateField(lua_State* lua);
+bool jeLua_addState(lua_State* lua);
 void jeLua_updateStates(lua_State* lua);
 int jeLua_readData(lua_State* lua);
+int jeLua_getDataExists(lua_State* lua);
 int jeLua_writeData(lua_State* lua);
+struct jeDataWriter* jeLua_getDataWriter(lua_State* lua);
+int jeLua_destroyDataWriter(lua_State* lua);
+bool jeLua_addDataWriter(lua_State* lua);
+void jeLua_dispatchDataWrites(lua_State* lua);
+int jeLua_writeDataAsync(lua_State* lua);
+bool jeLua_encodeValue(lua_State* lua, struct jeLuaEncoder* encoder, int valueIndex, uint32_t depth);
+int jeLua_encode(lua_State* lua);
+bool jeLua_decodeValue(lua_State* lua, struct jeLuaDecoder* decoder, uint32_t depth);
+int jeLua_decode(lua_State* lua);
+int jeLua_compress(lua_State* lua);
+int jeLua_decompress(lua_State* lua);
+bool jeLua_encodeJsonValue(lua_State* lua, struct jeLuaJsonEncoder* encoder, int valueIndex, uint32_t depth);
+int jeLua_jsonEncode(lua_State* lua);
+bool jeLua_decodeJsonValue(lua_State* lua, struct jeJsonDecoder* decoder, uint32_t depth);
+int jeLua_jsonDecode(lua_State* lua);
+int jeLua_deepcopy(lua_State* lua);
+struct jeLuaSpatialHash* jeLua_checkSpatialHash(lua_State* lua, int hashIndex);
+uint32_t jeLua_checkSpatialEntityId(lua_State* lua, int entityIdIndex);
+uint32_t jeLua_getSpatialExcludeEntityId(lua_State* lua, int entityIdIndex);
+void jeLua_pushSpatialEntityIds(lua_State* lua, struct jeArray* entityIds, int outEntityIdsIndex);
+int jeLua_spatialHashSet(lua_State* lua);
+int jeLua_spatialHashRemove(lua_State* lua);
+int jeLua_spatialHashQuery(lua_State* lua);
+int jeLua_spatialHashSweep(lua_State* lua);
+int jeLua_spatialHashClear(lua_State* lua);
+int jeLua_destroySpatialHash(lua_State* lua);
+int jeLua_newSpatialHash(lua_State* lua);
+void jeLua_getCameraOffset(lua_State* lua, uint32_t cameraIndex, float* outOffsetX, float* outOffsetY);
+void jeLua_getRenderableVertices(
+	lua_State* lua,
+	uint32_t renderableIndex,
+	uint32_t defaultsIndex,
+	float cameraOffsetX,
+	float cameraOffsetY,
+	struct jeVertex* vertices,
+	uint32_t vertexCount);
 void jeLua_getPrimitiveImpl(lua_State* lua, struct jeVertex* vertices, uint32_t vertexCount);
 void jeLua_drawPrimitiveImpl(lua_State* lua, uint32_t primitiveType);
+void jeLua_ffiDrawPrimitives(
+	struct jeWindow* window,
+	const struct jeVertex* vertices,
+	uint32_t primitiveCount,
+	uint32_t primitiveType,
+	uint32_t textureId,
+	float offsetX,
+	float offsetY);
+bool jeLua_addFfiApi(lua_State* lua);
 int jeLua_drawPoint(lua_State* lua);
 int jeLua_drawLine(lua_State* lua);
 int jeLua_drawTriangle(lua_State* lua);
 int jeLua_drawSprite(lua_State* lua);
+int jeLua_drawSprites(lua_State* lua);
+struct jeLuaTextCache* jeLua_getTextCache(lua_State* lua);
+int jeLua_destroyTextCache(lua_State* lua);
+bool jeLua_addTextCache(lua_State* lua);
+const struct jeLuaFont* jeLua_getFont(lua_State* lua, struct jeLuaTextCache* textCache, int fontStackIndex);
+uint32_t jeLua_getTextHash(const char* text, uint32_t textLength);
+const struct jeLuaTextMesh* jeLua_getTextMesh(
+	struct jeLuaTextCache* textCache,
+	const struct jeLuaFont* font,
+	const char* text,
+	uint32_t textLength,
+	const struct jeVertex* origin);
 int jeLua_drawText(lua_State* lua);
 int jeLua_drawReset(lua_State* lua);
+int jeLua_loadTexture(lua_State* lua);
+int jeLua_beginLayer(lua_State* lua);
+int jeLua_endLayer(lua_State* lua);
+int jeLua_drawLayer(lua_State* lua);
+int jeLua_setVertexFormat(lua_State* lua);
 int jeLua_playAudio(lua_State* lua);
 int jeLua_runTests(lua_State* lua);
+int jeLua_runBenchmarks(lua_State* lua);
 int jeLua_step(lua_State* lua);
 bool jeLua_addBindings(lua_State* lua);
 bool jeLua_run(struct jeWindow* window, const char* filename, int argumentCount, char** arguments);
@@ -210,105 +427,207 @@ bool jeLua_addWindow(lua_State* lua, struct jeWindow* window) {
 
 	return ok;
 }
-void jeLua_updateStates(lua_State* lua) {
+struct jeLuaClientState* jeLua_getState(lua_State* lua) {
 	JE_TRACE("lua=%p", (void*)lua);
 
 	bool ok = true;
+	struct jeLuaClientState* state = NULL;
 
 	if (lua == NULL) {
 		JE_ERROR("lua=NULL");
 		ok = false;
 	}
 
-	struct jeWindow* window = jeLua_getWindow(lua);
-
 	if (ok) {
 		int stackPos = lua_gettop(lua);
-		int stateStackPos = 0;
 
-		lua_settop(lua, 0);
 		lua_getglobal(lua, JE_LUA_CLIENT_BINDINGS_KEY);
-		lua_getfield(lua, JE_LUA_STACK_TOP, "state");
-
-		stateStackPos = lua_gettop(lua);
-
-		lua_pushnumber(lua, (lua_Number)JE_WINDOW_MIN_WIDTH);
-		lua_setfield(lua, stateStackPos, "width");
+		lua_getfield(lua, JE_LUA_STACK_TOP, "ffiApi");
 
-		lua_pushnumber(lua, (lua_Number)JE_WINDOW_MIN_HEIGHT);
-		lua_setfield(lua, stateStackPos, "height");
-
-		lua_pushnumber(lua, (lua_Number)jeLogger_getLevel());
-		lua_setfield(lua, stateStackPos, "logLevel");
+		struct jeLuaFfiApi* ffiApi = (struct jeLuaFfiApi*)lua_touserdata(lua, JE_LUA_STACK_TOP);
+		if (ffiApi == NULL) {
+			JE_ERROR("ffiApi is not set");
+			ok = false;
+		}
 
-		lua_pushboolean(lua, true);
-		lua_setfield(lua, stateStackPos, "testsEnabled");
+		if (ok) {
+			state = &ffiApi->state;
+		}
 
-		lua_pushnumber(lua, (lua_Number)JE_TESTS_LOG_LEVEL);
-		lua_setfield(lua, stateStackPos, "testsLogLevel");
+		lua_settop(lua, stackPos);
+	}
 
-		lua_pushboolean(lua, (window != NULL) && jeWindow_getIsOpen(window));
-		lua_setfield(lua, stateStackPos, "running");
+	return state;
+}
+int jeLua_getStateField(lua_State* lua) {
+	static const struct jeLuaClientStateField fields[] = {
+		JE_LUA_STATE_FIELD(width, JE_LUA_STATE_FIELD_TYPE_UINT32),
+		JE_LUA_STATE_FIELD(height, JE_LUA_STATE_FIELD_TYPE_UINT32),
+		JE_LUA_STATE_FIELD(logLevel, JE_LUA_STATE_FIELD_TYPE_UINT32),
+		JE_LUA_STATE_FIELD(testsLogLevel, JE_LUA_STATE_FIELD_TYPE_UINT32),
+		JE_LUA_STATE_FIELD(fps, JE_LUA_STATE_FIELD_TYPE_UINT32),
+		JE_LUA_STATE_FIELD(frame, JE_LUA_STATE_FIELD_TYPE_UINT32),
+		JE_LUA_STATE_FIELD(inputMask, JE_LUA_STATE_FIELD_TYPE_UINT32),
+		JE_LUA_STATE_FIELD(inputMouseMask, JE_LUA_STATE_FIELD_TYPE_UINT32),
+		JE_LUA_STATE_FIELD(inputMouseX, JE_LUA_STATE_FIELD_TYPE_INT32),
+		JE_LUA_STATE_FIELD(inputMouseY, JE_LUA_STATE_FIELD_TYPE_INT32),
+		JE_LUA_STATE_FIELD(breakpointCount, JE_LUA_STATE_FIELD_TYPE_UINT32),
+		JE_LUA_STATE_FIELD(frameVertexCount, JE_LUA_STATE_FIELD_TYPE_UINT32),
+		JE_LUA_STATE_FIELD(frameInstanceCount, JE_LUA_STATE_FIELD_TYPE_UINT32),
+		JE_LUA_STATE_FIELD(frameSortedPrimitiveCount, JE_LUA_STATE_FIELD_TYPE_UINT32),
+		JE_LUA_STATE_FIELD(frameUploadBytes, JE_LUA_STATE_FIELD_TYPE_UINT32),
+		JE_LUA_STATE_FIELD(frameUploadMicroseconds, JE_LUA_STATE_FIELD_TYPE_UINT32),
+		JE_LUA_STATE_FIELD(frameLayerCount, JE_LUA_STATE_FIELD_TYPE_UINT32),
+		JE_LUA_STATE_FIELD(frameLayerUploadBytes, JE_LUA_STATE_FIELD_TYPE_UINT32),
+		JE_LUA_STATE_FIELD(frameBatchCount, JE_LUA_STATE_FIELD_TYPE_UINT32),
+		JE_LUA_STATE_FIELD(frameTextureBindCount, JE_LUA_STATE_FIELD_TYPE_UINT32),
+		JE_LUA_STATE_FIELD(frameCulledCount, JE_LUA_STATE_FIELD_TYPE_UINT32),
+		JE_LUA_STATE_FIELD(frameSubmittedCount, JE_LUA_STATE_FIELD_TYPE_UINT32),
+		JE_LUA_STATE_FIELD(running, JE_LUA_STATE_FIELD_TYPE_BOOL),
+		JE_LUA_STATE_FIELD(headless, JE_LUA_STATE_FIELD_TYPE_BOOL),
+		JE_LUA_STATE_FIELD(testsEnabled, JE_LUA_STATE_FIELD_TYPE_BOOL),
+	};
+	static const int stateIndex = 1;
+	static const int keyIndex = 2;
+
+	struct jeLuaClientState** stateRef = (struct jeLuaClientState**)lua_touserdata(lua, stateIndex);
+	const char* key = lua_tostring(lua, keyIndex);
+
+	const struct jeLuaClientStateField* field = NULL;
+	if ((stateRef != NULL) && (key != NULL)) {
+		for (uint32_t i = 0; i < (uint32_t)(sizeof(fields) / sizeof(fields[0])); i++) {
+			if (strcmp(fields[i].name, key) == 0) {
+				field = &fields[i];
+				break;
+			}
+		}
+	}
 
-		lua_pushboolean(lua, false);
-		lua_setfield(lua, stateStackPos, "headless");
+	if (field != NULL) {
+		const char* fieldData = (const char*)(*stateRef) + field->offset;
 
-		if (window != NULL) {
+		switch (field->type) {
+			case JE_LUA_STATE_FIELD_TYPE_BOOL: {
+				bool value = false;
+				memcpy(&value, fieldData, sizeof(value));
+				lua_pushboolean(lua, value);
+				break;
+			}
+			case JE_LUA_STATE_FIELD_TYPE_INT32: {
+				int32_t value = 0;
+				memcpy(&value, fieldData, sizeof(value));
+				lua_pushnumber(lua, (lua_Number)value);
+				break;
+			}
+			default: {
+				uint32_t value = 0;
+				memcpy(&value, fieldData, sizeof(value));
+				lua_pushnumber(lua, (lua_Number)value);
+				break;
+			}
+		}
+	} else {
+		lua_pushnil(lua);
+	}
 
-			lua_pushnumber(lua, (lua_Number)jeWindow_getFps(window));
-			lua_setfield(lua, stateStackPos, "fps");
+	return 1;
+}
+bool jeLua_addState(lua_State* lua) {
+	JE_TRACE("lua=%p", (void*)lua);
 
-			lua_pushnumber(lua, (lua_Number)jeWindow_getFrame(window));
-			lua_setfield(lua, stateStackPos, "frame");
+	bool ok = true;
+	struct jeLuaClientState* state = jeLua_getState(lua);
 
-			lua_pushboolean(lua, jeWindow_getInput(window, JE_INPUT_LEFT));
-			lua_setfield(lua, stateStackPos, "inputLeft");
+	if (state == NULL) {
+		JE_ERROR("state=NULL");
+		ok = false;
+	}
 
-			lua_pushboolean(lua, jeWindow_getInput(window, JE_INPUT_RIGHT));
-			lua_setfield(lua, stateStackPos, "inputRight");
+	/*Without the ffi, client.state is a userdata that only reads the fields that lua asks for*/
+	if (ok) {
+		struct jeLuaClientState** stateRef =
+			(struct jeLuaClientState**)lua_newuserdata(lua, sizeof(struct jeLuaClientState*));
+		if (stateRef == NULL) {
+			JE_ERROR("lua_newuserdata() failed");
+			ok = false;
+		}
 
-			lua_pushboolean(lua, jeWindow_getInput(window, JE_INPUT_UP));
-			lua_setfield(lua, stateStackPos, "inputUp");
+		if (ok) {
+			*stateRef = state;
 
-			lua_pushboolean(lua, jeWindow_getInput(window, JE_INPUT_DOWN));
-			lua_setfield(lua, stateStackPos, "inputDown");
+			luaL_newmetatable(lua, "jeClientStateMetatable");
+			lua_pushcfunction(lua, jeLua_getStateField);
+			lua_setfield(lua, JE_LUA_STACK_TOP - 1, "__index");
+			lua_setmetatable(lua, JE_LUA_STACK_TOP - 1);
 
-			lua_pushboolean(lua, jeWindow_getInput(window, JE_INPUT_A));
-			lua_setfield(lua, stateStackPos, "inputA");
+			lua_setfield(lua, JE_LUA_STACK_TOP - 1, "state");
+		}
+	}
 
-			lua_pushboolean(lua, jeWindow_getInput(window, JE_INPUT_B));
-			lua_setfield(lua, stateStackPos, "inputB");
+	return ok;
+}
+void jeLua_updateStates(lua_State* lua) {
+	JE_TRACE("lua=%p", (void*)lua);
 
-			lua_pushboolean(lua, jeWindow_getInput(window, JE_INPUT_X));
-			lua_setfield(lua, stateStackPos, "inputX");
+	bool ok = true;
 
-			lua_pushboolean(lua, jeWindow_getInput(window, JE_INPUT_Y));
-			lua_setfield(lua, stateStackPos, "inputY");
+	if (lua == NULL) {
+		JE_ERROR("lua=NULL");
+		ok = false;
+	}
 
-			int32_t mouseX = 0;
-			int32_t mouseY = 0;
-			jeWindow_getMousePos(window, &mouseX, &mouseY);
+	struct jeWindow* window = jeLua_getWindow(lua);
+	struct jeLuaClientState* state = NULL;
 
-			lua_pushnumber(lua, (lua_Number)mouseX);
-			lua_setfield(lua, stateStackPos, "inputMouseX");
+	if (ok) {
+		state = jeLua_getState(lua);
+		ok = (state != NULL);
+	}
 
-			lua_pushnumber(lua, (lua_Number)mouseY);
-			lua_setfield(lua, stateStackPos, "inputMouseY");
+	if (ok) {
+		state->width = JE_WINDOW_MIN_WIDTH;
+		state->height = JE_WINDOW_MIN_HEIGHT;
+		state->logLevel = jeLogger_getLevel();
+		state->testsEnabled = true;
+		state->testsLogLevel = JE_TESTS_LOG_LEVEL;
+		state->running = (window != NULL) && jeWindow_getIsOpen(window);
+		state->headless = false;
 
-			lua_pushboolean(lua, jeWindow_getMouseButton(window, JE_MOUSE_BUTTON_LEFT));
-			lua_setfield(lua, stateStackPos, "inputMouseLeft");
+		if (window != NULL) {
+			state->fps = jeWindow_getFps(window);
+			state->frame = jeWindow_getFrame(window);
 
-			lua_pushboolean(lua, jeWindow_getMouseButton(window, JE_MOUSE_BUTTON_MIDDLE));
-			lua_setfield(lua, stateStackPos, "inputMouseMiddle");
+			state->inputMask = 0;
+			for (uint32_t i = JE_INPUT_FIRST; i < JE_INPUT_COUNT; i++) {
+				if (jeWindow_getInput(window, i)) {
+					state->inputMask |= (1U << i);
+				}
+			}
 
-			lua_pushboolean(lua, jeWindow_getMouseButton(window, JE_MOUSE_BUTTON_RIGHT));
-			lua_setfield(lua, stateStackPos, "inputMouseRight");
+			state->inputMouseMask = 0;
+			for (uint32_t i = JE_MOUSE_BUTTON_FIRST; i < JE_MOUSE_BUTTON_COUNT; i++) {
+				if (jeWindow_getMouseButton(window, i)) {
+					state->inputMouseMask |= (1U << i);
+				}
+			}
 
-			lua_pushnumber(lua, (lua_Number)jeBreakpoint_getCount());
-			lua_setfield(lua, stateStackPos, "breakpointCount");
+			jeWindow_getMousePos(window, &state->inputMouseX, &state->inputMouseY);
+
+			state->breakpointCount = jeBreakpoint_getCount();
+
+			struct jeWindowFrameStats frameStats = jeWindow_getFrameStats(window);
+			state->frameVertexCount = frameStats.vertexCount;
+			state->frameInstanceCount = frameStats.instanceCount;
+			state->frameSortedPrimitiveCount = frameStats.sortedPrimitiveCount;
+			state->frameUploadBytes = frameStats.uploadBytes;
+			state->frameUploadMicroseconds = frameStats.uploadMicroseconds;
+			state->frameLayerCount = frameStats.layerCount;
+			state->frameLayerUploadBytes = frameStats.layerUploadBytes;
+			state->frameBatchCount = frameStats.batchCount;
+			state->frameTextureBindCount = frameStats.textureBindCount;
+			state->frameCulledCount = frameStats.culledCount;
+			state->frameSubmittedCount = frameStats.submittedCount;
 		}
-
-		lua_settop(lua, stackPos);
 	}
 }
 
@@ -324,52 +643,67 @@ int jeLua_readData(lua_State* lua) {
 		ok = false;
 	}
 
-	gzFile file = NULL;
 	const char* filename = "";
+	bool compressed = true;
+	uint32_t sizeHint = 0;
 	if (ok) {
 		filename = luaL_checkstring(lua, 1);
 
 		JE_TRACE("lua=%p, filename=%s", (void*)lua, filename);
 
-		file = gzopen(filename, "rb");
+		/*Queued async writes to the file are finished first, so that reads see the latest data*/
+		jeDataWriter_wait(jeLua_getDataWriter(lua), filename);
 
-		if (file == NULL) {
-			JE_ERROR("gzopen() failed with filename=%s, errno=%d err=%s", filename, errno, strerror(errno));
-			ok = false;
-		}
+		ok = jeData_getInfo(filename, &compressed, &sizeHint);
 	}
 
-	static char data[JE_LUA_DATA_BUFFER_SIZE] = {0};
-	memset((void*)&data, 0, sizeof(data));
+	/*Large uncompressed files are mapped and copied straight into the lua string*/
+	if (ok && !compressed && jeDataMapping_getSupported() && (sizeHint >= JE_DATA_MAPPING_MIN_SIZE)) {
+		struct jeDataMapping mapping;
+		ok = jeDataMapping_create(&mapping, filename);
 
-	int dataSize = 0;
-	if (ok) {
-		dataSize = gzread(file, data, JE_LUA_DATA_BUFFER_SIZE);
-		if (dataSize < 0) {
-			int errnum = 0;
-			JE_ERROR("gzread() failed with filename=%s, gzerr=%s", filename, gzerror(file, &errnum));
-			JE_MAYBE_UNUSED(errnum);
-			ok = false;
+		if (ok) {
+			lua_pushlstring(lua, mapping.data, mapping.size);
 		}
-	}
 
-	if (ok) {
-		/*Exclude null terminator if string exists*/
-		if (dataSize > 0) {
-			dataSize--;
+		jeDataMapping_destroy(&mapping);
+	} else if (ok) {
+		struct jeString data;
+		ok = jeString_create(&data);
+		ok = ok && jeData_read(&data, filename, sizeHint);
+
+		if (ok) {
+			uint32_t dataSize = jeString_getCount(&data);
+			lua_pushlstring(lua, (dataSize > 0) ? jeString_get(&data, 0) : "", (size_t)dataSize);
 		}
 
-		lua_pushlstring(lua, data, (size_t)dataSize);
-		numResponses++;
+		jeString_destroy(&data);
+	}
 
-		JE_DEBUG("fread() bytes=%d (after decompression) read from filename=%s", dataSize + 1, filename);
+	if (ok) {
+		numResponses++;
 	}
 
+	return numResponses;
+}
+int jeLua_getDataExists(lua_State* lua) {
+	JE_TRACE("lua=%p", (void*)lua);
+
+	static const int filenameArg = 1;
+
+	const char* filename = luaL_checkstring(lua, filenameArg);
+
+	/*Queued async writes to the file are finished first, as they may be what creates it*/
+	jeDataWriter_wait(jeLua_getDataWriter(lua), filename);
+
+	FILE* file = fopen(filename, "rb");
+	lua_pushboolean(lua, file != NULL);
+
 	if (file != NULL) {
-		gzclose(file);
+		fclose(file);
 	}
 
-	return numResponses;
+	return 1;
 }
 int jeLua_writeData(lua_State* lua) {
 	JE_TRACE("lua=%p", (void*)lua);
@@ -382,56 +716,1644 @@ int jeLua_writeData(lua_State* lua) {
 		ok = false;
 	}
 
-	const char* filename = "";
-	const char* data = "";
-	size_t dataSize = 0;
-	gzFile file = NULL;
-
 	if (ok) {
 		static const int filenameArg = 1;
 		static const int dataArg = 2;
 
+		const char* filename = luaL_checkstring(lua, filenameArg);
+		const char* data = luaL_checkstring(lua, dataArg);
+		size_t dataSize = lua_objlen(lua, dataArg) + 1;
+
+		JE_TRACE("lua=%p, filename=%s, dataSize=%u", (void*)lua, filename, (uint32_t)dataSize);
+
+		/*Wait out queued async writes, so that they can't overwrite this one*/
+		jeDataWriter_wait(jeLua_getDataWriter(lua), filename);
+
+		ok = jeData_write(filename, data, dataSize, false);
+	}
+
+	if (ok) {
+		lua_pushboolean(lua, true);
+		numResponses++;
+	}
+
+	return numResponses;
+}
+struct jeDataWriter* jeLua_getDataWriter(lua_State* lua) {
+	JE_TRACE("lua=%p", (void*)lua);
+
+	struct jeDataWriter* writer = NULL;
+
+	if (lua != NULL) {
+		lua_getfield(lua, LUA_REGISTRYINDEX, JE_LUA_DATA_WRITER_KEY);
+		struct jeDataWriter** writerPtr = (struct jeDataWriter**)lua_touserdata(lua, JE_LUA_STACK_TOP);
+		writer = (writerPtr != NULL) ? *writerPtr : NULL;
+		lua_pop(lua, 1);
+	}
+
+	if (writer == NULL) {
+		JE_ERROR("%s is not set", JE_LUA_DATA_WRITER_KEY);
+	}
+
+	return writer;
+}
+int jeLua_destroyDataWriter(lua_State* lua) {
+	JE_TRACE("lua=%p", (void*)lua);
+
+	struct jeDataWriter** writerPtr = (struct jeDataWriter**)lua_touserdata(lua, 1);
+
+	/*Userdata are finalized before the lua state frees anything else, so borrowed data is still valid here*/
+	if (writerPtr != NULL) {
+		jeDataWriter_destroy(*writerPtr);
+		*writerPtr = NULL;
+	}
+
+	return 0;
+}
+bool jeLua_addDataWriter(lua_State* lua) {
+	JE_TRACE("lua=%p", (void*)lua);
+
+	bool ok = true;
+	struct jeDataWriter** writerPtr = NULL;
+
+	if (lua == NULL) {
+		JE_ERROR("lua=NULL");
+		ok = false;
+	}
+
+	if (ok) {
+		writerPtr = (struct jeDataWriter**)lua_newuserdata(lua, sizeof(struct jeDataWriter*));
+		if (writerPtr == NULL) {
+			JE_ERROR("lua_newuserdata() failed");
+			ok = false;
+		}
+	}
+
+	if (ok) {
+		*writerPtr = NULL;
+
+		luaL_newmetatable(lua, "jeDataWriterMetatable");
+		lua_pushcfunction(lua, jeLua_destroyDataWriter);
+		lua_setfield(lua, JE_LUA_STACK_TOP - 1, "__gc");
+		lua_setmetatable(lua, JE_LUA_STACK_TOP - 1);
+
+		lua_setfield(lua, LUA_REGISTRYINDEX, JE_LUA_DATA_WRITER_KEY);
+
+		lua_newtable(lua);
+		lua_setfield(lua, LUA_REGISTRYINDEX, JE_LUA_DATA_WRITES_KEY);
+
+		*writerPtr = jeDataWriter_create();
+		ok = (*writerPtr != NULL);
+	}
+
+	return ok;
+}
+void jeLua_dispatchDataWrites(lua_State* lua) {
+	JE_TRACE("lua=%p", (void*)lua);
+
+	/*Completions are moved out before running callbacks, as callbacks may queue more writes*/
+	struct jeArray completedWrites;
+	bool ok = jeDataWriter_takeCompletedWrites(jeLua_getDataWriter(lua), &completedWrites);
+
+	uint32_t completedCount = ok ? jeArray_getCount(&completedWrites) : 0;
+	if (completedCount > 0) {
+		int stackPos = lua_gettop(lua);
+		lua_getfield(lua, LUA_REGISTRYINDEX, JE_LUA_DATA_WRITES_KEY);
+		int writesIndex = lua_gettop(lua);
+
+		for (uint32_t i = 0; i < completedCount; i++) {
+			struct jeDataWrite* write = (struct jeDataWrite*)jeArray_get(&completedWrites, i);
+			const char* filename = jeString_get(&write->filename, 0);
+
+			JE_DEBUG(
+				"write complete, filename=%s, ok=%u, bytes=%u, workerMicroseconds=%u, latencyMicroseconds=%u",
+				filename,
+				(uint32_t)write->ok,
+				(uint32_t)write->dataSize,
+				write->workerMicroseconds,
+				write->latencyMicroseconds);
+
+			lua_rawgeti(lua, writesIndex, (int)write->requestId);
+			int entryIndex = lua_gettop(lua);
+
+			lua_pushnil(lua);
+			lua_rawseti(lua, writesIndex, (int)write->requestId);
+
+			size_t callbackCount = lua_objlen(lua, entryIndex);
+			for (size_t j = 1; j <= callbackCount; j++) {
+				lua_rawgeti(lua, entryIndex, (int)j);
+				lua_pushboolean(lua, write->ok);
+				lua_pushstring(lua, filename);
+				lua_call(lua, 2, 0);
+			}
+
+			lua_settop(lua, writesIndex);
+		}
+
+		lua_settop(lua, stackPos);
+	}
+
+	if (ok) {
+		jeDataWriter_destroyCompletedWrites(&completedWrites);
+	}
+}
+int jeLua_writeDataAsync(lua_State* lua) {
+	JE_TRACE("lua=%p", (void*)lua);
+
+	static const int filenameArg = 1;
+	static const int dataArg = 2;
+	static const int callbackArg = 3;
+	static const int appendArg = 4;
+
+	bool ok = true;
+	int numResponses = 0;
+	struct jeDataWriter* writer = jeLua_getDataWriter(lua);
+
+	if (writer == NULL) {
+		JE_ERROR("writer is not valid");
+		ok = false;
+	}
+
+	const char* filename = "";
+	const char* data = "";
+	size_t dataSize = 0;
+	bool append = false;
+	bool hasCallback = false;
+	if (ok) {
 		filename = luaL_checkstring(lua, filenameArg);
 		data = luaL_checkstring(lua, dataArg);
-		dataSize = lua_objlen(lua, dataArg) + 1;
+		append = lua_toboolean(lua, appendArg) != 0;
+
+		/*Appended data is written without a null terminator, so that appends read back contiguously*/
+		dataSize = lua_objlen(lua, dataArg) + (append ? 0 : 1);
+
+		hasCallback = !lua_isnoneornil(lua, callbackArg);
+		if (hasCallback) {
+			luaL_checktype(lua, callbackArg, LUA_TFUNCTION);
+		}
 
 		JE_TRACE("lua=%p, filename=%s, dataSize=%u", (void*)lua, filename, (uint32_t)dataSize);
+	}
 
-		file = gzopen(filename, "wb");
+	uint32_t requestId = 0;
+	bool coalesced = false;
+	ok = ok && jeDataWriter_queue(writer, filename, data, dataSize, append, &requestId, &coalesced);
 
-		if (file == NULL) {
-			JE_ERROR("gzopen() failed with filename=%s, errno=%d err=%s", filename, errno, strerror(errno));
-			ok = false;
+	/*The data stays on the stack until this returns, and completions are only delivered during client.step(), so
+	 * it is safe to register the data and callback after the worker can see the write*/
+	if (ok) {
+		lua_getfield(lua, LUA_REGISTRYINDEX, JE_LUA_DATA_WRITES_KEY);
+		lua_rawgeti(lua, JE_LUA_STACK_TOP, (int)requestId);
+		if (lua_isnil(lua, JE_LUA_STACK_TOP)) {
+			lua_pop(lua, 1);
+			lua_newtable(lua);
+			lua_pushvalue(lua, JE_LUA_STACK_TOP);
+			lua_rawseti(lua, JE_LUA_STACK_TOP - 2, (int)requestId);
+		}
+
+		lua_pushvalue(lua, dataArg);
+		lua_setfield(lua, JE_LUA_STACK_TOP - 1, "data");
+
+		if (hasCallback) {
+			lua_pushvalue(lua, callbackArg);
+			lua_rawseti(lua, JE_LUA_STACK_TOP - 1, (int)lua_objlen(lua, JE_LUA_STACK_TOP - 1) + 1);
 		}
+
+		lua_pop(lua, 2);
 	}
 
-	int dataSizeWritten = 0;
 	if (ok) {
-		dataSizeWritten = gzwrite(file, data, (unsigned)dataSize);
+		lua_pushboolean(lua, true);
+		numResponses++;
+	}
 
-		if (dataSizeWritten < 0) {
-			int errnum = 0;
-			JE_ERROR("gzwrite() failed with filename=%s, gzerr=%s", filename, gzerror(file, &errnum));
-			JE_MAYBE_UNUSED(errnum);
-			ok = false;
+	return numResponses;
+}
+bool jeLua_encodeValue(lua_State* lua, struct jeLuaEncoder* encoder, int valueIndex, uint32_t depth) {
+	bool ok = true;
+
+	if (depth > JE_CODEC_MAX_DEPTH) {
+		JE_ERROR("max depth exceeded (is there a reference cycle?), maxDepth=%u", JE_CODEC_MAX_DEPTH);
+		ok = false;
+	}
+
+	int valueType = LUA_TNIL;
+	if (ok) {
+		valueType = lua_type(lua, valueIndex);
+	}
+
+	switch (valueType) {
+		case LUA_TNIL: {
+			ok = ok && jeEncoder_pushTag(&encoder->encoder, JE_CODEC_TAG_NIL);
+			break;
+		}
+		case LUA_TBOOLEAN: {
+			ok = ok && jeEncoder_pushBoolean(&encoder->encoder, lua_toboolean(lua, valueIndex) != 0);
+			break;
+		}
+		case LUA_TNUMBER: {
+			ok = ok && jeEncoder_pushNumber(&encoder->encoder, (double)lua_tonumber(lua, valueIndex));
+			break;
+		}
+		case LUA_TSTRING: {
+			/*Each distinct string is stored once; repeats (table keys, tags, template names) refer back to it*/
+			lua_pushvalue(lua, valueIndex);
+			lua_rawget(lua, encoder->stringsIndex);
+			uint32_t stringId = (uint32_t)lua_tonumber(lua, JE_LUA_STACK_TOP);
+			lua_pop(lua, 1);
+
+			if (stringId > 0) {
+				ok = ok && jeEncoder_pushStringRef(&encoder->encoder, stringId - 1);
+			} else {
+				size_t stringSize = 0;
+				const char* string = lua_tolstring(lua, valueIndex, &stringSize);
+				ok = ok && jeEncoder_pushString(&encoder->encoder, string, stringSize);
+
+				encoder->stringCount++;
+				lua_pushvalue(lua, valueIndex);
+				lua_pushnumber(lua, (lua_Number)encoder->stringCount);
+				lua_rawset(lua, encoder->stringsIndex);
+			}
+			break;
+		}
+		case LUA_TTABLE: {
+			/*Sequence values are stored in order, followed by the remaining key-value pairs*/
+			uint32_t arrayCount = (uint32_t)lua_objlen(lua, valueIndex);
+			uint32_t hashCount = 0;
+
+			if (ok && (lua_checkstack(lua, 4) == 0)) {
+				JE_ERROR("lua_checkstack() failed, depth=%u", depth);
+				ok = false;
+			}
+
+			lua_pushnil(lua);
+			while (ok && (lua_next(lua, valueIndex) != 0)) {
+				int keyIndex = lua_gettop(lua) - 1;
+				lua_Number key = lua_tonumber(lua, keyIndex);
+				if ((lua_type(lua, keyIndex) != LUA_TNUMBER) || (key < 1) || (key > (lua_Number)arrayCount) ||
+					(key != floor(key))) {
+					hashCount++;
+				}
+				lua_pop(lua, 1);
+			}
+
+			ok = ok && jeEncoder_pushTable(&encoder->encoder, arrayCount, hashCount);
+
+			for (uint32_t i = 1; ok && (i <= arrayCount); i++) {
+				lua_rawgeti(lua, valueIndex, (int)i);
+				ok = jeLua_encodeValue(lua, encoder, lua_gettop(lua), depth + 1);
+				lua_pop(lua, 1);
+			}
+
+			if (ok) {
+				lua_pushnil(lua);
+				while (lua_next(lua, valueIndex) != 0) {
+					int keyIndex = lua_gettop(lua) - 1;
+					lua_Number key = lua_tonumber(lua, keyIndex);
+					if ((lua_type(lua, keyIndex) != LUA_TNUMBER) || (key < 1) || (key > (lua_Number)arrayCount) ||
+						(key != floor(key))) {
+						ok = ok && jeLua_encodeValue(lua, encoder, keyIndex, depth + 1);
+						ok = ok && jeLua_encodeValue(lua, encoder, keyIndex + 1, depth + 1);
+					}
+					lua_pop(lua, 1);
+
+					if (!ok) {
+						lua_pop(lua, 1);
+						break;
+					}
+				}
+			}
+			break;
+		}
+		default: {
+			if (ok) {
+				JE_ERROR("type cannot be encoded, type=%s", lua_typename(lua, valueType));
+				ok = false;
+			}
+			break;
 		}
 	}
 
-	if (ok) {
-		lua_pushboolean(lua, true);
-		numResponses++;
+	return ok;
+}
+int jeLua_encode(lua_State* lua) {
+	JE_TRACE("lua=%p", (void*)lua);
+
+	static const int valueArg = 1;
+
+	bool ok = true;
+	int numResponses = 0;
+
+	if (lua == NULL) {
+		JE_ERROR("lua=NULL");
+		ok = false;
+	}
+
+	struct jeLuaEncoder encoder;
+	memset((void*)&encoder, 0, sizeof(struct jeLuaEncoder));
+
+	ok = ok && jeEncoder_create(&encoder.encoder);
+
+	if (ok) {
+		luaL_checkany(lua, valueArg);
+		lua_settop(lua, valueArg);
+
+		lua_newtable(lua);
+		encoder.stringsIndex = lua_gettop(lua);
+
+		ok = jeLua_encodeValue(lua, &encoder, valueArg, 0);
+	}
+
+	if (ok) {
+		struct jeString* data = &encoder.encoder.data;
+		lua_pushlstring(lua, jeString_get(data, 0), (size_t)jeString_getCount(data));
+		numResponses++;
+	}
+
+	jeEncoder_destroy(&encoder.encoder);
+
+	return numResponses;
+}
+bool jeLua_decodeValue(lua_State* lua, struct jeLuaDecoder* decoder, uint32_t depth) {
+	bool ok = true;
+
+	if (depth > JE_CODEC_MAX_DEPTH) {
+		JE_ERROR("max depth exceeded, maxDepth=%u", JE_CODEC_MAX_DEPTH);
+		ok = false;
+	}
+
+	if (ok && (lua_checkstack(lua, 4) == 0)) {
+		JE_ERROR("lua_checkstack() failed, depth=%u", depth);
+		ok = false;
+	}
+
+	uint8_t tag = JE_CODEC_TAG_INVALID;
+	ok = ok && jeDecoder_readTag(&decoder->decoder, &tag);
+
+	switch (ok ? tag : JE_CODEC_TAG_INVALID) {
+		case JE_CODEC_TAG_NIL: {
+			lua_pushnil(lua);
+			break;
+		}
+		case JE_CODEC_TAG_FALSE: {
+			lua_pushboolean(lua, false);
+			break;
+		}
+		case JE_CODEC_TAG_TRUE: {
+			lua_pushboolean(lua, true);
+			break;
+		}
+		case JE_CODEC_TAG_INTEGER:
+		case JE_CODEC_TAG_NUMBER: {
+			double number = 0.0;
+			if (tag == JE_CODEC_TAG_INTEGER) {
+				ok = jeDecoder_readInteger(&decoder->decoder, &number);
+			} else {
+				ok = jeDecoder_readNumber(&decoder->decoder, &number);
+			}
+
+			if (ok) {
+				lua_pushnumber(lua, (lua_Number)number);
+			}
+			break;
+		}
+		case JE_CODEC_TAG_STRING: {
+			const char* string = NULL;
+			size_t stringSize = 0;
+			ok = jeDecoder_readString(&decoder->decoder, &string, &stringSize);
+
+			if (ok) {
+				lua_pushlstring(lua, string, stringSize);
+
+				decoder->stringCount++;
+				lua_pushvalue(lua, JE_LUA_STACK_TOP);
+				lua_rawseti(lua, decoder->stringsIndex, (int)decoder->stringCount);
+			}
+			break;
+		}
+		case JE_CODEC_TAG_STRING_REF: {
+			uint32_t stringId = 0;
+			ok = jeDecoder_readStringRef(&decoder->decoder, decoder->stringCount, &stringId);
+
+			if (ok) {
+				lua_rawgeti(lua, decoder->stringsIndex, (int)stringId + 1);
+			}
+			break;
+		}
+		case JE_CODEC_TAG_TABLE: {
+			uint32_t arrayCount = 0;
+			uint32_t hashCount = 0;
+			ok = jeDecoder_readTable(&decoder->decoder, &arrayCount, &hashCount);
+
+			if (ok) {
+				lua_createtable(lua, (int)arrayCount, (int)hashCount);
+				int tableIndex = lua_gettop(lua);
+
+				for (uint32_t i = 1; ok && (i <= arrayCount); i++) {
+					ok = jeLua_decodeValue(lua, decoder, depth + 1);
+					if (ok) {
+						lua_rawseti(lua, tableIndex, (int)i);
+					}
+				}
+
+				for (uint32_t i = 0; ok && (i < hashCount); i++) {
+					ok = jeLua_decodeValue(lua, decoder, depth + 1);
+					ok = ok && jeLua_decodeValue(lua, decoder, depth + 1);
+
+					if (ok && lua_isnil(lua, JE_LUA_STACK_TOP - 1)) {
+						JE_ERROR("invalid table key, key=nil");
+						ok = false;
+					}
+
+					if (ok) {
+						lua_rawset(lua, tableIndex);
+					}
+				}
+
+				lua_settop(lua, tableIndex);
+			}
+			break;
+		}
+		default: {
+			if (ok) {
+				JE_ERROR("invalid tag, tag=%u, pos=%u", (uint32_t)tag, (uint32_t)decoder->decoder.pos - 1);
+				ok = false;
+			}
+			break;
+		}
+	}
+
+	return ok;
+}
+int jeLua_decode(lua_State* lua) {
+	JE_TRACE("lua=%p", (void*)lua);
+
+	static const int dataArg = 1;
+
+	bool ok = true;
+	int numResponses = 0;
+
+	if (lua == NULL) {
+		JE_ERROR("lua=NULL");
+		ok = false;
+	}
+
+	struct jeLuaDecoder decoder;
+	memset((void*)&decoder, 0, sizeof(struct jeLuaDecoder));
+
+	if (ok) {
+		size_t dataSize = 0;
+		const char* data = luaL_checklstring(lua, dataArg, &dataSize);
+		lua_settop(lua, dataArg);
+
+		ok = jeDecoder_create(&decoder.decoder, data, dataSize);
+	}
+
+	if (ok) {
+		lua_newtable(lua);
+		decoder.stringsIndex = lua_gettop(lua);
+
+		ok = jeLua_decodeValue(lua, &decoder, 0);
+	}
+
+	if (ok && !jeDecoder_getDone(&decoder.decoder)) {
+		JE_ERROR(
+			"unexpected data after value, pos=%u, size=%u",
+			(uint32_t)decoder.decoder.pos,
+			(uint32_t)decoder.decoder.size);
+		ok = false;
+	}
+
+	if (ok) {
+		numResponses++;
+	}
+
+	return numResponses;
+}
+int jeLua_compress(lua_State* lua) {
+	JE_TRACE("lua=%p", (void*)lua);
+
+	static const int dataArg = 1;
+	static const int levelArg = 2;
+
+	bool ok = true;
+	int numResponses = 0;
+
+	if (lua == NULL) {
+		JE_ERROR("lua=NULL");
+		ok = false;
+	}
+
+	struct jeString compressed;
+	ok = ok && jeString_create(&compressed);
+
+	if (ok) {
+		size_t dataSize = 0;
+		const char* data = luaL_checklstring(lua, dataArg, &dataSize);
+		int level = (int)luaL_optinteger(lua, levelArg, JE_COMPRESSION_DEFAULT_LEVEL);
+
+		ok = jeCompression_compress(&compressed, data, dataSize, level);
+	}
+
+	if (ok) {
+		lua_pushlstring(lua, jeString_get(&compressed, 0), (size_t)jeString_getCount(&compressed));
+		numResponses++;
+	}
+
+	jeString_destroy(&compressed);
+
+	return numResponses;
+}
+int jeLua_decompress(lua_State* lua) {
+	JE_TRACE("lua=%p", (void*)lua);
+
+	static const int dataArg = 1;
+
+	bool ok = true;
+	int numResponses = 0;
+
+	if (lua == NULL) {
+		JE_ERROR("lua=NULL");
+		ok = false;
+	}
+
+	struct jeString data;
+	ok = ok && jeString_create(&data);
+
+	if (ok) {
+		size_t compressedSize = 0;
+		const char* compressed = luaL_checklstring(lua, dataArg, &compressedSize);
+
+		ok = jeCompression_decompress(&data, compressed, compressedSize);
+	}
+
+	if (ok) {
+		uint32_t dataSize = jeString_getCount(&data);
+		lua_pushlstring(lua, (dataSize > 0) ? jeString_get(&data, 0) : "", (size_t)dataSize);
+		numResponses++;
+	}
+
+	jeString_destroy(&data);
+
+	return numResponses;
+}
+bool jeLua_encodeJsonValue(lua_State* lua, struct jeLuaJsonEncoder* encoder, int valueIndex, uint32_t depth) {
+	bool ok = true;
+	int valueType = lua_type(lua, valueIndex);
+
+	switch (valueType) {
+		case LUA_TNIL: {
+			ok = jeJsonEncoder_pushNull(&encoder->encoder);
+			break;
+		}
+		case LUA_TBOOLEAN: {
+			ok = jeJsonEncoder_pushBoolean(&encoder->encoder, lua_toboolean(lua, valueIndex) != 0);
+			break;
+		}
+		case LUA_TNUMBER: {
+			ok = jeJsonEncoder_pushNumber(&encoder->encoder, (double)lua_tonumber(lua, valueIndex));
+			break;
+		}
+		case LUA_TSTRING: {
+			size_t stringSize = 0;
+			const char* string = lua_tolstring(lua, valueIndex, &stringSize);
+			ok = jeJsonEncoder_pushString(&encoder->encoder, string, stringSize);
+			break;
+		}
+		case LUA_TTABLE: {
+			const void* table = lua_topointer(lua, valueIndex);
+			for (uint32_t i = 0; ok && (i < depth); i++) {
+				if (encoder->tables[i] == table) {
+					jeJsonEncoder_setError(&encoder->encoder, "circular reference");
+					ok = false;
+				}
+			}
+
+			if (ok && ((depth >= JE_JSON_MAX_DEPTH) || (lua_checkstack(lua, 4) == 0))) {
+				jeJsonEncoder_setError(&encoder->encoder, "max depth exceeded, maxDepth=%u", JE_JSON_MAX_DEPTH);
+				ok = false;
+			}
+
+			if (!ok) {
+				break;
+			}
+
+			encoder->tables[depth] = table;
+
+			/*Same rules as engine/lib/json: tables with [1] set (or no keys) are arrays, anything else is an object*/
+			lua_rawgeti(lua, valueIndex, 1);
+			bool isArray = !lua_isnil(lua, JE_LUA_STACK_TOP);
+			lua_pop(lua, 1);
+
+			uint32_t keyCount = 0;
+			bool keysValid = true;
+			lua_pushnil(lua);
+			while (lua_next(lua, valueIndex) != 0) {
+				keysValid = keysValid && (lua_type(lua, JE_LUA_STACK_TOP - 1) == (isArray ? LUA_TNUMBER : LUA_TSTRING));
+				keyCount++;
+				lua_pop(lua, 1);
+			}
+			isArray = isArray || (keyCount == 0);
+
+			if (!keysValid) {
+				jeJsonEncoder_setError(&encoder->encoder, "invalid table: mixed or invalid key types");
+				ok = false;
+			} else if (isArray && (keyCount != (uint32_t)lua_objlen(lua, valueIndex))) {
+				jeJsonEncoder_setError(&encoder->encoder, "invalid table: sparse array");
+				ok = false;
+			}
+
+			if (ok && isArray) {
+				ok = jeJsonEncoder_pushSyntax(&encoder->encoder, '[');
+				for (uint32_t i = 1; ok && (i <= keyCount); i++) {
+					if (i > 1) {
+						ok = jeJsonEncoder_pushSyntax(&encoder->encoder, ',');
+					}
+
+					lua_rawgeti(lua, valueIndex, (int)i);
+					ok = ok && jeLua_encodeJsonValue(lua, encoder, lua_gettop(lua), depth + 1);
+					lua_pop(lua, 1);
+				}
+				ok = ok && jeJsonEncoder_pushSyntax(&encoder->encoder, ']');
+			} else if (ok) {
+				ok = jeJsonEncoder_pushSyntax(&encoder->encoder, '{');
+
+				bool first = true;
+				lua_pushnil(lua);
+				while (ok && (lua_next(lua, valueIndex) != 0)) {
+					int keyIndex = lua_gettop(lua) - 1;
+					if (!first) {
+						ok = jeJsonEncoder_pushSyntax(&encoder->encoder, ',');
+					}
+					first = false;
+
+					ok = ok && jeLua_encodeJsonValue(lua, encoder, keyIndex, depth + 1);
+					ok = ok && jeJsonEncoder_pushSyntax(&encoder->encoder, ':');
+					ok = ok && jeLua_encodeJsonValue(lua, encoder, keyIndex + 1, depth + 1);
+					lua_pop(lua, 1);
+
+					if (!ok) {
+						lua_pop(lua, 1);
+					}
+				}
+
+				ok = ok && jeJsonEncoder_pushSyntax(&encoder->encoder, '}');
+			}
+			break;
+		}
+		default: {
+			jeJsonEncoder_setError(&encoder->encoder, "unexpected type '%s'", lua_typename(lua, valueType));
+			ok = false;
+			break;
+		}
+	}
+
+	return ok;
+}
+int jeLua_jsonEncode(lua_State* lua) {
+	JE_TRACE("lua=%p", (void*)lua);
+
+	static const int valueArg = 1;
+
+	struct jeLuaJsonEncoder encoder;
+	bool ok = jeJsonEncoder_create(&encoder.encoder);
+
+	if (ok) {
+		lua_settop(lua, valueArg);
+
+		ok = jeLua_encodeJsonValue(lua, &encoder, valueArg, 0);
+	}
+
+	if (ok) {
+		lua_pushlstring(
+			lua, jeString_get(&encoder.encoder.data, 0), (size_t)jeString_getCount(&encoder.encoder.data));
+	}
+
+	jeJsonEncoder_destroy(&encoder.encoder);
+
+	/*Errors are raised like engine/lib/json's, after cleaning up*/
+	if (!ok) {
+		luaL_error(lua, "%s", (encoder.encoder.error[0] != '\0') ? encoder.encoder.error : "failed to encode");
+	}
+
+	return 1;
+}
+bool jeLua_decodeJsonValue(lua_State* lua, struct jeJsonDecoder* decoder, uint32_t depth) {
+	bool ok = true;
+
+	if ((depth >= JE_JSON_MAX_DEPTH) || (lua_checkstack(lua, 4) == 0)) {
+		jeJsonDecoder_setError(decoder, decoder->pos, "max depth exceeded");
+		ok = false;
+	}
+
+	uint32_t type = ok ? jeJsonDecoder_getNextType(decoder) : JE_JSON_TYPE_INVALID;
+
+	switch (type) {
+		case JE_JSON_TYPE_NUMBER: {
+			double number = 0.0;
+			ok = jeJsonDecoder_readNumber(decoder, &number);
+			if (ok) {
+				lua_pushnumber(lua, (lua_Number)number);
+			}
+			break;
+		}
+		case JE_JSON_TYPE_STRING: {
+			const char* string = NULL;
+			size_t stringSize = 0;
+			ok = jeJsonDecoder_readString(decoder, &string, &stringSize);
+			if (ok) {
+				lua_pushlstring(lua, string, stringSize);
+			}
+			break;
+		}
+		case JE_JSON_TYPE_LITERAL: {
+			uint32_t literal = JE_JSON_LITERAL_NULL;
+			ok = jeJsonDecoder_readLiteral(decoder, &literal);
+			if (ok && (literal == JE_JSON_LITERAL_NULL)) {
+				lua_pushnil(lua);
+			} else if (ok) {
+				lua_pushboolean(lua, literal == JE_JSON_LITERAL_TRUE);
+			}
+			break;
+		}
+		case JE_JSON_TYPE_ARRAY: {
+			ok = jeJsonDecoder_readOpening(decoder, '[');
+			lua_createtable(lua, JE_LUA_JSON_PRESIZE_COUNT, 0);
+			int tableIndex = lua_gettop(lua);
+			int nextIndex = 1;
+
+			bool closed = false;
+			while (ok && !closed && !jeJsonDecoder_readClosing(decoder, ']')) {
+				/*null elements leave holes, like engine/lib/json*/
+				ok = jeLua_decodeJsonValue(lua, decoder, depth + 1);
+				if (ok) {
+					lua_rawseti(lua, tableIndex, nextIndex);
+					nextIndex++;
+				}
+
+				ok = ok && jeJsonDecoder_readSeparator(decoder, ']', &closed);
+			}
+			break;
+		}
+		case JE_JSON_TYPE_OBJECT: {
+			ok = jeJsonDecoder_readOpening(decoder, '{');
+			lua_createtable(lua, 0, JE_LUA_JSON_PRESIZE_COUNT);
+			int tableIndex = lua_gettop(lua);
+
+			bool closed = false;
+			while (ok && !closed && !jeJsonDecoder_readClosing(decoder, '}')) {
+				const char* key = NULL;
+				size_t keySize = 0;
+				ok = jeJsonDecoder_readKey(decoder, &key, &keySize);
+				if (ok) {
+					lua_pushlstring(lua, key, keySize);
+				}
+
+				ok = ok && jeLua_decodeJsonValue(lua, decoder, depth + 1);
+				if (ok) {
+					lua_rawset(lua, tableIndex);
+				}
+
+				ok = ok && jeJsonDecoder_readSeparator(decoder, '}', &closed);
+			}
+			break;
+		}
+		default: {
+			/*The error was set by the depth check or jeJsonDecoder_getNextType()*/
+			ok = false;
+			break;
+		}
+	}
+
+	return ok;
+}
+int jeLua_jsonDecode(lua_State* lua) {
+	JE_TRACE("lua=%p", (void*)lua);
+
+	static const int dataArg = 1;
+
+	if (lua_type(lua, dataArg) != LUA_TSTRING) {
+		luaL_error(lua, "expected argument of type string, got %s", luaL_typename(lua, dataArg));
+	}
+
+	size_t dataSize = 0;
+	const char* data = lua_tolstring(lua, dataArg, &dataSize);
+	lua_settop(lua, dataArg);
+
+	struct jeJsonDecoder decoder;
+	bool ok = jeJsonDecoder_create(&decoder, data, dataSize);
+
+	if (ok) {
+		jeJsonDecoder_skipSpace(&decoder);
+		ok = jeLua_decodeJsonValue(lua, &decoder, 0);
+	}
+
+	ok = ok && jeJsonDecoder_readEnd(&decoder);
+
+	jeJsonDecoder_destroy(&decoder);
+
+	/*Errors are raised like engine/lib/json's, after cleaning up*/
+	if (!ok) {
+		luaL_error(lua, "%s", (decoder.error[0] != '\0') ? decoder.error : "failed to decode");
+	}
+
+	return 1;
+}
+int jeLua_deepcopy(lua_State* lua) {
+	JE_TRACE("lua=%p", (void*)lua);
+
+	static const int valueArg = 1;
+
+	luaL_checkany(lua, valueArg);
+	lua_settop(lua, valueArg);
+
+	/*Errors are raised, as with the json round trip this replaces*/
+	if (!jeDeepcopy_pushCopy(lua, valueArg)) {
+		luaL_error(lua, "failed to copy, maxDepth=%u", JE_DEEPCOPY_MAX_DEPTH);
+	}
+
+	return 1;
+}
+struct jeLuaSpatialHash* jeLua_checkSpatialHash(lua_State* lua, int hashIndex) {
+	/*Methods have the metatable as their upvalue, which is faster to compare against than looking it up by name*/
+	bool isSpatialHash = false;
+	if (lua_getmetatable(lua, hashIndex)) {
+		isSpatialHash = lua_rawequal(lua, JE_LUA_STACK_TOP, lua_upvalueindex(1));
+		lua_pop(lua, 1);
+	}
+	if (!isSpatialHash) {
+		luaL_argerror(lua, hashIndex, "spatial hash expected");
+	}
+
+	return (struct jeLuaSpatialHash*)lua_touserdata(lua, hashIndex);
+}
+uint32_t jeLua_checkSpatialEntityId(lua_State* lua, int entityIdIndex) {
+	lua_Number entityId = luaL_checknumber(lua, entityIdIndex);
+	luaL_argcheck(
+		lua,
+		(entityId >= 1) && (entityId <= JE_SPATIAL_MAX_ENTITY_ID) && (entityId == floor(entityId)),
+		entityIdIndex,
+		"entity ids must be positive integers");
+
+	return (uint32_t)entityId;
+}
+uint32_t jeLua_getSpatialExcludeEntityId(lua_State* lua, int entityIdIndex) {
+	/*Anything other than an entity id excludes nothing, as no entity has it*/
+	lua_Number entityId = luaL_optnumber(lua, entityIdIndex, 0);
+	bool valid = (entityId >= 1) && (entityId <= JE_SPATIAL_MAX_ENTITY_ID) && (entityId == floor(entityId));
+
+	return valid ? (uint32_t)entityId : 0;
+}
+void jeLua_pushSpatialEntityIds(lua_State* lua, struct jeArray* entityIds, int outEntityIdsIndex) {
+	const uint32_t* values = (const uint32_t*)entityIds->data;
+	uint32_t count = jeArray_getCount(entityIds);
+	for (uint32_t i = 0; i < count; i++) {
+		lua_pushnumber(lua, (lua_Number)values[i]);
+		lua_rawseti(lua, outEntityIdsIndex, (int)i + 1);
+	}
+}
+int jeLua_spatialHashSet(lua_State* lua) {
+	JE_TRACE("lua=%p", (void*)lua);
+
+	static const int hashArg = 1;
+	static const int entityIdArg = 2;
+	static const int xArg = 3;
+	static const int yArg = 4;
+	static const int wArg = 5;
+	static const int hArg = 6;
+
+	struct jeLuaSpatialHash* hash = jeLua_checkSpatialHash(lua, hashArg);
+	uint32_t entityId = jeLua_checkSpatialEntityId(lua, entityIdArg);
+	double x = (double)luaL_checknumber(lua, xArg);
+	double y = (double)luaL_checknumber(lua, yArg);
+	double w = (double)luaL_checknumber(lua, wArg);
+	double h = (double)luaL_checknumber(lua, hArg);
+
+	if (!jeSpatialHash_set(&hash->hash, entityId, x, y, w, h)) {
+		luaL_error(lua, "failed to add entity to spatial hash, entityId=%u", entityId);
+	}
+
+	return 0;
+}
+int jeLua_spatialHashRemove(lua_State* lua) {
+	JE_TRACE("lua=%p", (void*)lua);
+
+	static const int hashArg = 1;
+	static const int entityIdArg = 2;
+
+	struct jeLuaSpatialHash* hash = jeLua_checkSpatialHash(lua, hashArg);
+	uint32_t entityId = jeLua_checkSpatialEntityId(lua, entityIdArg);
+
+	jeSpatialHash_remove(&hash->hash, entityId);
+
+	return 0;
+}
+int jeLua_spatialHashQuery(lua_State* lua) {
+	JE_TRACE("lua=%p", (void*)lua);
+
+	static const int hashArg = 1;
+	static const int xArg = 2;
+	static const int yArg = 3;
+	static const int wArg = 4;
+	static const int hArg = 5;
+	static const int outEntityIdsArg = 6;
+	static const int excludeEntityIdArg = 7;
+
+	struct jeLuaSpatialHash* hash = jeLua_checkSpatialHash(lua, hashArg);
+	double x = (double)luaL_checknumber(lua, xArg);
+	double y = (double)luaL_checknumber(lua, yArg);
+	double w = (double)luaL_checknumber(lua, wArg);
+	double h = (double)luaL_checknumber(lua, hArg);
+	luaL_checktype(lua, outEntityIdsArg, LUA_TTABLE);
+	uint32_t excludeEntityId = jeLua_getSpatialExcludeEntityId(lua, excludeEntityIdArg);
+
+	if (!jeSpatialHash_query(&hash->hash, x, y, w, h, excludeEntityId, &hash->entityIds)) {
+		luaL_error(lua, "failed to query spatial hash");
+	}
+	jeLua_pushSpatialEntityIds(lua, &hash->entityIds, outEntityIdsArg);
+
+	lua_pushinteger(lua, (lua_Integer)jeArray_getCount(&hash->entityIds));
+	return 1;
+}
+int jeLua_spatialHashSweep(lua_State* lua) {
+	JE_TRACE("lua=%p", (void*)lua);
+
+	static const int hashArg = 1;
+	static const int xArg = 2;
+	static const int yArg = 3;
+	static const int wArg = 4;
+	static const int hArg = 5;
+	static const int moveXArg = 6;
+	static const int moveYArg = 7;
+	static const int outEntityIdsArg = 8;
+	static const int outStepsArg = 9;
+	static const int excludeEntityIdArg = 10;
+
+	struct jeLuaSpatialHash* hash = jeLua_checkSpatialHash(lua, hashArg);
+	double x = (double)luaL_checknumber(lua, xArg);
+	double y = (double)luaL_checknumber(lua, yArg);
+	double w = (double)luaL_checknumber(lua, wArg);
+	double h = (double)luaL_checknumber(lua, hArg);
+	lua_Number moveX = luaL_checknumber(lua, moveXArg);
+	lua_Number moveY = luaL_checknumber(lua, moveYArg);
+	luaL_checktype(lua, outEntityIdsArg, LUA_TTABLE);
+	luaL_checktype(lua, outStepsArg, LUA_TTABLE);
+	uint32_t excludeEntityId = jeLua_getSpatialExcludeEntityId(lua, excludeEntityIdArg);
+	luaL_argcheck(
+		lua,
+		(moveX == floor(moveX)) && (fabs(moveX) <= JE_SPATIAL_MAX_SWEEP_STEPS),
+		moveXArg,
+		"moves must be integers");
+	luaL_argcheck(
+		lua,
+		(moveY == floor(moveY)) && (fabs(moveY) <= JE_SPATIAL_MAX_SWEEP_STEPS) && ((moveX == 0) || (moveY == 0)),
+		moveYArg,
+		"moves must be integers, along one axis");
+
+	bool ok = jeSpatialHash_sweep(
+		&hash->hash,
+		x,
+		y,
+		w,
+		h,
+		(int32_t)moveX,
+		(int32_t)moveY,
+		excludeEntityId,
+		&hash->entityIds,
+		&hash->steps);
+	if (!ok) {
+		luaL_error(lua, "failed to sweep spatial hash");
+	}
+	jeLua_pushSpatialEntityIds(lua, &hash->entityIds, outEntityIdsArg);
+	jeLua_pushSpatialEntityIds(lua, &hash->steps, outStepsArg);
+
+	lua_pushinteger(lua, (lua_Integer)jeArray_getCount(&hash->entityIds));
+	return 1;
+}
+int jeLua_spatialHashClear(lua_State* lua) {
+	JE_TRACE("lua=%p", (void*)lua);
+
+	static const int hashArg = 1;
+
+	struct jeLuaSpatialHash* hash = jeLua_checkSpatialHash(lua, hashArg);
+
+	if (!jeSpatialHash_clear(&hash->hash)) {
+		luaL_error(lua, "failed to clear spatial hash");
+	}
+
+	return 0;
+}
+int jeLua_destroySpatialHash(lua_State* lua) {
+	JE_TRACE("lua=%p", (void*)lua);
+
+	struct jeLuaSpatialHash* hash = (struct jeLuaSpatialHash*)lua_touserdata(lua, 1);
+
+	if (hash != NULL) {
+		jeArray_destroy(&hash->steps);
+		jeArray_destroy(&hash->entityIds);
+		jeSpatialHash_destroy(&hash->hash);
+	}
+
+	return 0;
+}
+int jeLua_newSpatialHash(lua_State* lua) {
+	JE_TRACE("lua=%p", (void*)lua);
+
+	static const int cellSizeArg = 1;
+
+	static const luaL_Reg spatialHashMethods[] = {
+		{"insert", jeLua_spatialHashSet},
+		{"move", jeLua_spatialHashSet},
+		{"remove", jeLua_spatialHashRemove},
+		{"query", jeLua_spatialHashQuery},
+		{"sweep", jeLua_spatialHashSweep},
+		{"clear", jeLua_spatialHashClear},
+		{NULL, NULL}
+	};
+
+	double cellSize = (double)luaL_checknumber(lua, cellSizeArg);
+	luaL_argcheck(lua, cellSize > 0.0, cellSizeArg, "cellSize must be positive");
+
+	struct jeLuaSpatialHash* hash = (struct jeLuaSpatialHash*)lua_newuserdata(lua, sizeof(struct jeLuaSpatialHash));
+	if (hash == NULL) {
+		luaL_error(lua, "lua_newuserdata() failed");
+	}
+	memset((void*)hash, 0, sizeof(struct jeLuaSpatialHash));
+
+	/*The metatable is set before anything is allocated, so that __gc frees it even if a later step fails*/
+	if (luaL_newmetatable(lua, JE_LUA_SPATIAL_HASH_METATABLE)) {
+		lua_pushcfunction(lua, jeLua_destroySpatialHash);
+		lua_setfield(lua, JE_LUA_STACK_TOP - 1, "__gc");
+
+		lua_newtable(lua);
+		lua_pushvalue(lua, JE_LUA_STACK_TOP - 1);
+		luaL_setfuncs(lua, spatialHashMethods, 1);
+		lua_setfield(lua, JE_LUA_STACK_TOP - 1, "__index");
+	}
+	lua_setmetatable(lua, JE_LUA_STACK_TOP - 1);
+
+	bool ok = true;
+	ok = ok && jeSpatialHash_create(&hash->hash, cellSize);
+	ok = ok && jeArray_create(&hash->entityIds, sizeof(uint32_t));
+	ok = ok && jeArray_create(&hash->steps, sizeof(uint32_t));
+	if (!ok) {
+		luaL_error(lua, "failed to create spatial hash, cellSize=%f", cellSize);
+	}
+
+	return 1;
+}
+void jeLua_getCameraOffset(lua_State* lua, uint32_t cameraIndex, float* outOffsetX, float* outOffsetY) {
+	float cameraX1 = (float)jeLua_getOptionalNumberField(lua, cameraIndex, "x", 0.0F);
+	float cameraY1 = (float)jeLua_getOptionalNumberField(lua, cameraIndex, "y", 0.0F);
+	float cameraX2 = cameraX1 + (float)jeLua_getOptionalNumberField(lua, cameraIndex, "w", 0.0F);
+	float cameraY2 = cameraY1 + (float)jeLua_getOptionalNumberField(lua, cameraIndex, "h", 0.0F);
+	cameraX1 = (float)jeLua_getOptionalNumberField(lua, cameraIndex, "x1", cameraX1);
+	cameraY1 = (float)jeLua_getOptionalNumberField(lua, cameraIndex, "y1", cameraY1);
+	cameraX2 = (float)jeLua_getOptionalNumberField(lua, cameraIndex, "x2", cameraX2);
+	cameraY2 = (float)jeLua_getOptionalNumberField(lua, cameraIndex, "y2", cameraY2);
+
+	*outOffsetX = -(cameraX1 + floorf((cameraX2 - cameraX1) / 2.0F));
+	*outOffsetY = -(cameraY1 + floorf((cameraY2 - cameraY1) / 2.0F));
+}
+void jeLua_getRenderableVertices(
+	lua_State* lua,
+	uint32_t renderableIndex,
+	uint32_t defaultsIndex,
+	float cameraOffsetX,
+	float cameraOffsetY,
+	struct jeVertex* vertices,
+	uint32_t vertexCount) {
+	JE_TRACE("lua=%p, vertices=%p, vertexCount=%u", (void*)lua, (void*)vertices, vertexCount);
+
+	bool ok = true;
+
+	if (lua == NULL) {
+		JE_ERROR("lua=NULL");
+		ok = false;
+	}
+
+	if (vertices == NULL) {
+		JE_ERROR("vertices=NULL");
+		ok = false;
+	}
+
+	if (vertexCount == 0) {
+		JE_ERROR("vertexCount=0");
+		ok = false;
+	}
+
+	if (ok) {
+		vertices[0].x = (float)jeLua_getOptionalNumberField(lua, renderableIndex, "x", 0.0F);
+		vertices[0].y = (float)jeLua_getOptionalNumberField(lua, renderableIndex, "y", 0.0F);
+		vertices[0].x = (float)jeLua_getOptionalNumberField(lua, renderableIndex, "x1", vertices[0].x);
+		vertices[0].y = (float)jeLua_getOptionalNumberField(lua, renderableIndex, "y1", vertices[0].y);
+		vertices[0].z = (float)jeLua_getOptionalNumberField(lua, renderableIndex, "z", 0.0F);
+		vertices[0].u = (float)jeLua_getOptionalNumberField(lua, defaultsIndex, "u1", 0.0F);
+		vertices[0].v = (float)jeLua_getOptionalNumberField(lua, defaultsIndex, "v1", 0.0F);
+
+		vertices[0].r = (float)jeLua_getOptionalNumberField(lua, defaultsIndex, "r", 1.0F);
+		vertices[0].g = (float)jeLua_getOptionalNumberField(lua, defaultsIndex, "g", 1.0F);
+		vertices[0].b = (float)jeLua_getOptionalNumberField(lua, defaultsIndex, "b", 1.0F);
+		vertices[0].a = (float)jeLua_getOptionalNumberField(lua, defaultsIndex, "a", 1.0F);
+		vertices[0].r = (float)jeLua_getOptionalNumberField(lua, renderableIndex, "r", vertices[0].r);
+		vertices[0].g = (float)jeLua_getOptionalNumberField(lua, renderableIndex, "g", vertices[0].g);
+		vertices[0].b = (float)jeLua_getOptionalNumberField(lua, renderableIndex, "b", vertices[0].b);
+		vertices[0].a = (float)jeLua_getOptionalNumberField(lua, renderableIndex, "a", vertices[0].a);
+
+		if (vertexCount >= 2) {
+			vertices[1].x = vertices[0].x + (float)jeLua_getOptionalNumberField(lua, renderableIndex, "w", 0.0F);
+			vertices[1].y = vertices[0].y + (float)jeLua_getOptionalNumberField(lua, renderableIndex, "h", 0.0F);
+			vertices[1].x = (float)jeLua_getOptionalNumberField(lua, renderableIndex, "x2", vertices[1].x);
+			vertices[1].y = (float)jeLua_getOptionalNumberField(lua, renderableIndex, "y2", vertices[1].y);
+			vertices[1].u = (float)jeLua_getOptionalNumberField(lua, defaultsIndex, "u2", 1.0F);
+			vertices[1].v = (float)jeLua_getOptionalNumberField(lua, defaultsIndex, "v2", 1.0F);
+		}
+
+		if (vertexCount >= 3) {
+			vertices[2].x = (float)jeLua_getOptionalNumberField(lua, renderableIndex, "x3", 0.0F);
+			vertices[2].y = (float)jeLua_getOptionalNumberField(lua, renderableIndex, "y3", 0.0F);
+			vertices[2].u = (float)jeLua_getOptionalNumberField(lua, defaultsIndex, "u3", 1.0F);
+			vertices[2].v = (float)jeLua_getOptionalNumberField(lua, defaultsIndex, "v3", 1.0F);
+		}
+
+		for (uint32_t i = 1; i < vertexCount; i++) {
+			vertices[i].z = vertices[0].z;
+			vertices[i].r = vertices[0].r;
+			vertices[i].g = vertices[0].g;
+			vertices[i].b = vertices[0].b;
+			vertices[i].a = vertices[0].a;
+		}
+
+		float offsetX = 0.0F;
+		float offsetY = 0.0F;
+		offsetX = (float)jeLua_getOptionalNumberField(lua, renderableIndex, "offsetX", 0.0F);
+		offsetY = (float)jeLua_getOptionalNumberField(lua, renderableIndex, "offsetY", 0.0F);
+
+		offsetX += cameraOffsetX;
+		offsetY += cameraOffsetY;
+
+		/*Vertices end up in window space; off-screen primitives are culled by jeWindow_pushTexturedPrimitive()*/
+		for (uint32_t i = 0; i < vertexCount; i++) {
+			vertices[i].x += offsetX;
+			vertices[i].y += offsetY;
+		}
+	}
+}
+void jeLua_getPrimitiveImpl(lua_State* lua, struct jeVertex* vertices, uint32_t vertexCount) {
+	JE_TRACE("lua=%p, vertices=%p, vertexCount=%u", (void*)lua, (void*)vertices, vertexCount);
+
+	bool ok = true;
+
+	if (lua == NULL) {
+		JE_ERROR("lua=NULL");
+		ok = false;
+	}
+
+	if (vertices == NULL) {
+		JE_ERROR("vertices=NULL");
+		ok = false;
+	}
+
+	if (vertexCount == 0) {
+		JE_ERROR("vertexCount=0");
+		ok = false;
+	}
+
+	if (ok) {
+		static const int renderableIndex = 1;
+		static const int defaultsIndex = 2;
+		static const int cameraIndex = 3;
+
+		luaL_checktype(lua, renderableIndex, LUA_TTABLE);
+		luaL_checktype(lua, defaultsIndex, LUA_TTABLE);
+		luaL_checktype(lua, cameraIndex, LUA_TTABLE);
+
+		float cameraOffsetX = 0.0F;
+		float cameraOffsetY = 0.0F;
+		jeLua_getCameraOffset(lua, cameraIndex, &cameraOffsetX, &cameraOffsetY);
+
+		jeLua_getRenderableVertices(
+			lua, renderableIndex, defaultsIndex, cameraOffsetX, cameraOffsetY, vertices, vertexCount);
+	}
+}
+void jeLua_drawPrimitiveImpl(lua_State* lua, uint32_t primitiveType) {
+	struct jeWindow* window = jeLua_getWindow(lua);
+
+	JE_TRACE("lua=%p, window=%p", (void*)lua, (void*)window);
+
+	bool ok = true;
+
+	if (lua == NULL) {
+		JE_ERROR("lua=NULL");
+		ok = false;
+	}
+
+	if (jeWindow_getIsValid(window) == false) {
+		// JE_ERROR("window is not valid");
+		ok = false;
+	}
+
+	if (jePrimitiveType_getValid(primitiveType) == false) {
+		JE_ERROR("not a valid primitiveType, primitiveType=%u", primitiveType);
+		ok = false;
+	}
+
+	struct jeVertex vertices[JE_PRIMITIVE_TYPE_MAX_VERTEX_COUNT];
+	memset(&vertices, 0, sizeof(vertices));
+
+	uint32_t vertexCount = jePrimitiveType_getVertexCount(primitiveType);
+
+	if (ok) {
+		static const int renderableIndex = 1;
+		static const int defaultsIndex = 2;
+
+		jeLua_getPrimitiveImpl(lua, vertices, vertexCount);
+
+		lua_Number textureId = jeLua_getOptionalNumberField(lua, defaultsIndex, "textureId", 0.0);
+		textureId = jeLua_getOptionalNumberField(lua, renderableIndex, "textureId", textureId);
+
+		JE_TRACE(
+			"lua=%p, primitiveType=%u, vertexCount=%u, vertices={%s}",
+			(void*)lua,
+			primitiveType,
+			vertexCount,
+			jeVertex_arrayGetDebugString(vertices, vertexCount));
+
+		jeWindow_pushTexturedPrimitive(window, vertices, primitiveType, (uint32_t)textureId);
+	}
+}
+void jeLua_ffiDrawPrimitives(
+	struct jeWindow* window,
+	const struct jeVertex* vertices,
+	uint32_t primitiveCount,
+	uint32_t primitiveType,
+	uint32_t textureId,
+	float offsetX,
+	float offsetY) {
+	JE_TRACE("window=%p, primitiveCount=%u, primitiveType=%u", (void*)window, primitiveCount, primitiveType);
+
+	if (jeWindow_getIsValid(window)) {
+		jeWindow_pushTexturedPrimitives(window, vertices, primitiveCount, primitiveType, textureId, offsetX, offsetY);
+	}
+}
+int jeLua_drawPoint(lua_State* lua) {
+	JE_TRACE("lua=%p", (void*)lua);
+	jeLua_drawPrimitiveImpl(lua, JE_PRIMITIVE_TYPE_POINTS);
+	return 0;
+}
+int jeLua_drawLine(lua_State* lua) {
+	JE_TRACE("lua=%p", (void*)lua);
+	jeLua_drawPrimitiveImpl(lua, JE_PRIMITIVE_TYPE_LINES);
+	return 0;
+}
+int jeLua_drawTriangle(lua_State* lua) {
+	JE_TRACE("lua=%p", (void*)lua);
+	jeLua_drawPrimitiveImpl(lua, JE_PRIMITIVE_TYPE_TRIANGLES);
+	return 0;
+}
+int jeLua_drawSprite(lua_State* lua) {
+	JE_TRACE("lua=%p", (void*)lua);
+	jeLua_drawPrimitiveImpl(lua, JE_PRIMITIVE_TYPE_SPRITES);
+	return 0;
+}
+int jeLua_drawSprites(lua_State* lua) {
+	struct jeWindow* window = jeLua_getWindow(lua);
+
+	JE_TRACE("lua=%p, window=%p", (void*)lua, (void*)window);
+
+	bool ok = true;
+	uint32_t missingCount = 0;
+
+	if (lua == NULL) {
+		JE_ERROR("lua=NULL");
+		ok = false;
+	}
+
+	if (jeWindow_getIsValid(window) == false) {
+		// JE_ERROR("window is not valid");
+		ok = false;
+	}
+
+	if (ok) {
+		static const int entitiesIndex = 1;
+		static const int spritesIndex = 2;
+		static const int cameraIndex = 3;
+		static const int excludeTagIndex = 4;
+
+		luaL_checktype(lua, entitiesIndex, LUA_TTABLE);
+		luaL_checktype(lua, spritesIndex, LUA_TTABLE);
+		luaL_checktype(lua, cameraIndex, LUA_TTABLE);
+		const char* excludeTag = luaL_optstring(lua, excludeTagIndex, NULL);
+
+		/*The camera is the same for the whole batch, so it is only read once*/
+		float cameraOffsetX = 0.0F;
+		float cameraOffsetY = 0.0F;
+		jeLua_getCameraOffset(lua, cameraIndex, &cameraOffsetX, &cameraOffsetY);
+
+		int batchStackPos = lua_gettop(lua);
+		uint32_t entityCount = (uint32_t)lua_objlen(lua, entitiesIndex);
+		for (uint32_t i = 1; i <= entityCount; i++) {
+			lua_rawgeti(lua, entitiesIndex, (int)i);
+			uint32_t entityIndex = (uint32_t)lua_gettop(lua);
+
+			bool draw = lua_istable(lua, JE_LUA_STACK_TOP);
+
+			if (draw && (excludeTag != NULL)) {
+				lua_getfield(lua, (int)entityIndex, "tags");
+				if (lua_istable(lua, JE_LUA_STACK_TOP)) {
+					draw = !jeLua_getBoolField(lua, (uint32_t)lua_gettop(lua), excludeTag);
+				}
+			}
+
+			uint32_t spriteIndex = 0;
+			if (draw) {
+				lua_getfield(lua, (int)entityIndex, "spriteId");
+				lua_rawget(lua, spritesIndex);
+				spriteIndex = (uint32_t)lua_gettop(lua);
+
+				if (lua_istable(lua, JE_LUA_STACK_TOP) == 0) {
+					missingCount++;
+					draw = false;
+				}
+			}
+
+			if (draw) {
+				struct jeVertex vertices[JE_PRIMITIVE_TYPE_SPRITES_VERTEX_COUNT];
+				memset(&vertices, 0, sizeof(vertices));
+
+				jeLua_getRenderableVertices(
+					lua,
+					entityIndex,
+					spriteIndex,
+					cameraOffsetX,
+					cameraOffsetY,
+					vertices,
+					JE_PRIMITIVE_TYPE_SPRITES_VERTEX_COUNT);
+
+				lua_Number textureId = jeLua_getOptionalNumberField(lua, spriteIndex, "textureId", 0.0);
+				textureId = jeLua_getOptionalNumberField(lua, entityIndex, "textureId", textureId);
+
+				jeWindow_pushTexturedPrimitive(window, vertices, JE_PRIMITIVE_TYPE_SPRITES, (uint32_t)textureId);
+			}
+
+			lua_settop(lua, batchStackPos);
+		}
+	}
+
+	if (lua != NULL) {
+		lua_pushnumber(lua, (lua_Number)missingCount);
+	}
+
+	return 1;
+}
+struct jeLuaTextCache* jeLua_getTextCache(lua_State* lua) {
+	JE_TRACE("lua=%p", (void*)lua);
+
+	struct jeLuaTextCache* textCache = NULL;
+
+	if (lua != NULL) {
+		lua_getfield(lua, LUA_REGISTRYINDEX, JE_LUA_TEXT_CACHE_KEY);
+		textCache = (struct jeLuaTextCache*)lua_touserdata(lua, JE_LUA_STACK_TOP);
+		lua_pop(lua, 1);
+	}
+
+	if (textCache == NULL) {
+		JE_ERROR("%s is not set", JE_LUA_TEXT_CACHE_KEY);
+	}
+
+	return textCache;
+}
+int jeLua_destroyTextCache(lua_State* lua) {
+	JE_TRACE("lua=%p", (void*)lua);
+
+	struct jeLuaTextCache* textCache = (struct jeLuaTextCache*)lua_touserdata(lua, 1);
+
+	if (textCache != NULL) {
+		for (uint32_t i = 0; i < JE_LUA_TEXT_MESH_COUNT; i++) {
+			jeArray_destroy(&textCache->meshes[i].vertices);
+			jeString_destroy(&textCache->meshes[i].text);
+		}
+
+		jeArray_destroy(&textCache->fonts);
+	}
+
+	return 0;
+}
+bool jeLua_addTextCache(lua_State* lua) {
+	JE_TRACE("lua=%p", (void*)lua);
+
+	bool ok = true;
+	struct jeLuaTextCache* textCache = NULL;
+
+	if (lua == NULL) {
+		JE_ERROR("lua=NULL");
+		ok = false;
+	}
+
+	if (ok) {
+		textCache = (struct jeLuaTextCache*)lua_newuserdata(lua, sizeof(struct jeLuaTextCache));
+		if (textCache == NULL) {
+			JE_ERROR("lua_newuserdata() failed");
+			ok = false;
+		}
+	}
+
+	if (ok) {
+		memset((void*)textCache, 0, sizeof(struct jeLuaTextCache));
+
+		luaL_newmetatable(lua, "jeTextCacheMetatable");
+		lua_pushcfunction(lua, jeLua_destroyTextCache);
+		lua_setfield(lua, JE_LUA_STACK_TOP - 1, "__gc");
+		lua_setmetatable(lua, JE_LUA_STACK_TOP - 1);
+
+		lua_setfield(lua, LUA_REGISTRYINDEX, JE_LUA_TEXT_CACHE_KEY);
+
+		lua_newtable(lua);
+		lua_setfield(lua, LUA_REGISTRYINDEX, JE_LUA_TEXT_FONTS_KEY);
+	}
+
+	ok = ok && jeArray_create(&textCache->fonts, sizeof(struct jeLuaFont));
+
+	for (uint32_t i = 0; ok && (i < JE_LUA_TEXT_MESH_COUNT); i++) {
+		ok = ok && jeArray_create(&textCache->meshes[i].vertices, sizeof(struct jeVertex));
+		ok = ok && jeString_create(&textCache->meshes[i].text);
+	}
+
+	return ok;
+}
+const struct jeLuaFont* jeLua_getFont(lua_State* lua, struct jeLuaTextCache* textCache, int fontStackIndex) {
+	JE_TRACE("lua=%p, textCache=%p, fontStackIndex=%d", (void*)lua, (void*)textCache, fontStackIndex);
+
+	bool ok = true;
+	const struct jeLuaFont* result = NULL;
+	uint32_t fontIndex = 0;
+
+	int stackPos = lua_gettop(lua);
+
+	lua_getfield(lua, LUA_REGISTRYINDEX, JE_LUA_TEXT_FONTS_KEY);
+	int fontsStackIndex = lua_gettop(lua);
+
+	lua_pushvalue(lua, fontStackIndex);
+	lua_rawget(lua, fontsStackIndex);
+
+	if (lua_isnumber(lua, JE_LUA_STACK_TOP)) {
+		fontIndex = (uint32_t)lua_tonumber(lua, JE_LUA_STACK_TOP);
+	} else {
+		struct jeLuaFont font;
+		memset((void*)&font, 0, sizeof(font));
+
+		uint32_t fontIndexArg = (uint32_t)fontStackIndex;
+		font.u = (float)jeLua_getOptionalNumberField(lua, fontIndexArg, "u1", 0.0F);
+		font.v = (float)jeLua_getOptionalNumberField(lua, fontIndexArg, "v1", 0.0F);
+		font.charW = (uint32_t)jeLua_getNumberField(lua, fontIndexArg, "charW");
+		font.charH = (uint32_t)jeLua_getNumberField(lua, fontIndexArg, "charH");
+		font.charColumns = (uint32_t)jeLua_getNumberField(lua, fontIndexArg, "charColumns");
+		font.charFirst = jeLua_getStringField(lua, fontIndexArg, "charFirst", NULL)[0];
+		font.charLast = jeLua_getStringField(lua, fontIndexArg, "charLast", NULL)[0];
+		font.textureId = (uint32_t)jeLua_getOptionalNumberField(lua, fontIndexArg, "textureId", 0.0);
+
+		font.r = (float)jeLua_getOptionalNumberField(lua, fontIndexArg, "r", 1.0F);
+		font.g = (float)jeLua_getOptionalNumberField(lua, fontIndexArg, "g", 1.0F);
+		font.b = (float)jeLua_getOptionalNumberField(lua, fontIndexArg, "b", 1.0F);
+		font.a = (float)jeLua_getOptionalNumberField(lua, fontIndexArg, "a", 1.0F);
+
+		font.textZ = (float)jeLua_getOptionalNumberField(lua, fontIndexArg, "textZ", NAN);
+		font.textR = (float)jeLua_getOptionalNumberField(lua, fontIndexArg, "textR", NAN);
+		font.textG = (float)jeLua_getOptionalNumberField(lua, fontIndexArg, "textG", NAN);
+		font.textB = (float)jeLua_getOptionalNumberField(lua, fontIndexArg, "textB", NAN);
+		font.textA = (float)jeLua_getOptionalNumberField(lua, fontIndexArg, "textA", NAN);
+
+		if (font.charColumns == 0) {
+			JE_ERROR("charColumns=0");
+			ok = false;
+		}
+
+		if (ok) {
+			fontIndex = jeArray_getCount(&textCache->fonts);
+			ok = jeArray_push(&textCache->fonts, (const void*)&font, 1);
+		}
+
+		if (ok) {
+			lua_pushvalue(lua, fontStackIndex);
+			lua_pushnumber(lua, (lua_Number)fontIndex);
+			lua_rawset(lua, fontsStackIndex);
+		}
+	}
+
+	if (ok) {
+		result = (const struct jeLuaFont*)jeArray_get(&textCache->fonts, fontIndex);
+	}
+
+	lua_settop(lua, stackPos);
+
+	return result;
+}
+uint32_t jeLua_getTextHash(const char* text, uint32_t textLength) {
+	/*FNV-1a*/
+	uint32_t hash = 2166136261U;
+	for (uint32_t i = 0; i < textLength; i++) {
+		hash ^= (uint32_t)(unsigned char)text[i];
+		hash *= 16777619U;
+	}
+
+	return hash;
+}
+const struct jeLuaTextMesh* jeLua_getTextMesh(
+	struct jeLuaTextCache* textCache,
+	const struct jeLuaFont* font,
+	const char* text,
+	uint32_t textLength,
+	const struct jeVertex* origin) {
+	JE_TRACE("textCache=%p, font=%p, textLength=%u", (void*)textCache, (const void*)font, textLength);
+
+	bool ok = true;
+
+	uint32_t fontIndex = (uint32_t)(font - (const struct jeLuaFont*)textCache->fonts.data);
+	uint32_t hash = jeLua_getTextHash(text, textLength);
+
+	textCache->useCount++;
+
+	struct jeLuaTextMesh* textMesh = NULL;
+	struct jeLuaTextMesh* leastRecentlyUsed = &textCache->meshes[0];
+	for (uint32_t i = 0; i < JE_LUA_TEXT_MESH_COUNT; i++) {
+		struct jeLuaTextMesh* candidate = &textCache->meshes[i];
+
+		if ((candidate->lastUsed > 0) && (candidate->hash == hash) && (candidate->fontIndex == fontIndex) &&
+			(candidate->z == origin->z) && (candidate->r == origin->r) && (candidate->g == origin->g) &&
+			(candidate->b == origin->b) && (candidate->a == origin->a) &&
+			(jeString_getCount(&candidate->text) == textLength) &&
+			(memcmp(candidate->text.array.data, text, textLength) == 0)) {
+			textMesh = candidate;
+			break;
+		}
+
+		if (candidate->lastUsed < leastRecentlyUsed->lastUsed) {
+			leastRecentlyUsed = candidate;
+		}
+	}
+
+	if (textMesh == NULL) {
+		textMesh = leastRecentlyUsed;
+		JE_TRACE("building text mesh, textLength=%u, evictedLastUsed=%u", textLength, textMesh->lastUsed);
+
+		textMesh->lastUsed = 0;
+		textMesh->fontIndex = fontIndex;
+		textMesh->hash = hash;
+		textMesh->z = origin->z;
+		textMesh->r = origin->r;
+		textMesh->g = origin->g;
+		textMesh->b = origin->b;
+		textMesh->a = origin->a;
+
+		ok = ok && jeString_set(&textMesh->text, text, textLength);
+		ok = ok && jeArray_setCount(&textMesh->vertices, textLength * JE_PRIMITIVE_TYPE_SPRITES_VERTEX_COUNT);
+
+		for (uint32_t i = 0; ok && (i < textLength); i++) {
+			static const char charDefault = ' ';
+
+			char charVal = (char)toupper((unsigned char)text[i]);
+			if ((charVal < font->charFirst) || (charVal > font->charLast)) {
+				JE_WARN(
+					"character outside range, char=%u, min=%u, max=%u",
+					(uint32_t)charVal,
+					(uint32_t)font->charFirst,
+					(uint32_t)font->charLast);
+				charVal = charDefault;
+			}
+
+			uint32_t charIndex = (uint32_t)(charVal - font->charFirst);
+
+			static const uint32_t renderScaleX = 1;
+			static const uint32_t renderScaleY = 1;
+
+			struct jeVertex* charVertices =
+				(struct jeVertex*)jeArray_get(&textMesh->vertices, i * JE_PRIMITIVE_TYPE_SPRITES_VERTEX_COUNT);
+			charVertices[0] = *origin;
+			charVertices[0].x = (float)(font->charW * renderScaleX * i);
+			charVertices[0].y = 0.0F;
+			charVertices[0].u = font->u + (float)(font->charW * (charIndex % font->charColumns));
+			charVertices[0].v = font->v + (float)(font->charH * (charIndex / font->charColumns));
 
-		JE_DEBUG("bytes=%d (before compression) written to filename=%s", dataSizeWritten, filename);
-	}
+			charVertices[1] = charVertices[0];
+			charVertices[1].x += (float)(font->charW * renderScaleX);
+			charVertices[1].y += (float)(font->charH * renderScaleY);
+			charVertices[1].u += (float)font->charW;
+			charVertices[1].v += (float)font->charH;
+		}
 
-	if (file != NULL) {
-		gzclose(file);
+		if (!ok) {
+			jeArray_setCount(&textMesh->vertices, 0);
+		}
 	}
 
-	return numResponses;
+	textMesh->lastUsed = textCache->useCount;
+
+	return textMesh;
 }
-void jeLua_getPrimitiveImpl(lua_State* lua, struct jeVertex* vertices, uint32_t vertexCount) {
-	JE_TRACE("lua=%p, vertices=%p, vertexCount=%u", (void*)lua, (void*)vertices, vertexCount);
+int jeLua_drawText(lua_State* lua) {
+	struct jeWindow* window = jeLua_getWindow(lua);
+
+	JE_TRACE("lua=%p, window=%p", (void*)lua, (void*)window);
 
 	bool ok = true;
 
@@ -440,14 +2362,14 @@ void jeLua_getPrimitiveImpl(lua_State* lua, struct jeVertex* vertices, uint32_t
 		ok = false;
 	}
 
-	if (vertices == NULL) {
-		JE_ERROR("vertices=NULL");
+	if (jeWindow_getIsValid(window) == false) {
 		ok = false;
 	}
 
-	if (vertexCount == 0) {
-		JE_ERROR("vertexCount=0");
-		ok = false;
+	struct jeLuaTextCache* textCache = NULL;
+	if (ok) {
+		textCache = jeLua_getTextCache(lua);
+		ok = (textCache != NULL);
 	}
 
 	if (ok) {
@@ -455,80 +2377,84 @@ void jeLua_getPrimitiveImpl(lua_State* lua, struct jeVertex* vertices, uint32_t
 		static const int defaultsIndex = 2;
 		static const int cameraIndex = 3;
 
-		luaL_checktype(lua, renderableIndex, LUA_TTABLE);
 		luaL_checktype(lua, defaultsIndex, LUA_TTABLE);
+		luaL_checktype(lua, renderableIndex, LUA_TTABLE);
 		luaL_checktype(lua, cameraIndex, LUA_TTABLE);
 
-		vertices[0].x = (float)jeLua_getOptionalNumberField(lua, renderableIndex, "x", 0.0F);
-		vertices[0].y = (float)jeLua_getOptionalNumberField(lua, renderableIndex, "y", 0.0F);
-		vertices[0].x = (float)jeLua_getOptionalNumberField(lua, renderableIndex, "x1", vertices[0].x);
-		vertices[0].y = (float)jeLua_getOptionalNumberField(lua, renderableIndex, "y1", vertices[0].y);
-		vertices[0].z = (float)jeLua_getOptionalNumberField(lua, renderableIndex, "z", 0.0F);
-		vertices[0].u = (float)jeLua_getOptionalNumberField(lua, defaultsIndex, "u1", 0.0F);
-		vertices[0].v = (float)jeLua_getOptionalNumberField(lua, defaultsIndex, "v1", 0.0F);
-
-		vertices[0].r = (float)jeLua_getOptionalNumberField(lua, defaultsIndex, "r", 1.0F);
-		vertices[0].g = (float)jeLua_getOptionalNumberField(lua, defaultsIndex, "g", 1.0F);
-		vertices[0].b = (float)jeLua_getOptionalNumberField(lua, defaultsIndex, "b", 1.0F);
-		vertices[0].a = (float)jeLua_getOptionalNumberField(lua, defaultsIndex, "a", 1.0F);
-		vertices[0].r = (float)jeLua_getOptionalNumberField(lua, renderableIndex, "r", vertices[0].r);
-		vertices[0].g = (float)jeLua_getOptionalNumberField(lua, renderableIndex, "g", vertices[0].g);
-		vertices[0].b = (float)jeLua_getOptionalNumberField(lua, renderableIndex, "b", vertices[0].b);
-		vertices[0].a = (float)jeLua_getOptionalNumberField(lua, renderableIndex, "a", vertices[0].a);
+		const struct jeLuaFont* font = jeLua_getFont(lua, textCache, defaultsIndex);
 
-		if (vertexCount >= 2) {
-			vertices[1].x = vertices[0].x + (float)jeLua_getOptionalNumberField(lua, renderableIndex, "w", 0.0F);
-			vertices[1].y = vertices[0].y + (float)jeLua_getOptionalNumberField(lua, renderableIndex, "h", 0.0F);
-			vertices[1].x = (float)jeLua_getOptionalNumberField(lua, renderableIndex, "x2", vertices[1].x);
-			vertices[1].y = (float)jeLua_getOptionalNumberField(lua, renderableIndex, "y2", vertices[1].y);
-			vertices[1].u = (float)jeLua_getOptionalNumberField(lua, defaultsIndex, "u2", 1.0F);
-			vertices[1].v = (float)jeLua_getOptionalNumberField(lua, defaultsIndex, "v2", 1.0F);
-		}
+		uint32_t textLength = 0;
+		const char* text = jeLua_getStringField(lua, renderableIndex, "text", &textLength);
 
-		if (vertexCount >= 3) {
-			vertices[2].x = (float)jeLua_getOptionalNumberField(lua, renderableIndex, "x3", 0.0F);
-			vertices[2].y = (float)jeLua_getOptionalNumberField(lua, renderableIndex, "y3", 0.0F);
-			vertices[2].u = (float)jeLua_getOptionalNumberField(lua, defaultsIndex, "u3", 1.0F);
-			vertices[2].v = (float)jeLua_getOptionalNumberField(lua, defaultsIndex, "v3", 1.0F);
+		float cameraOffsetX = 0.0F;
+		float cameraOffsetY = 0.0F;
+		jeLua_getCameraOffset(lua, cameraIndex, &cameraOffsetX, &cameraOffsetY);
+
+		struct jeVertex origin;
+		memset(&origin, 0, sizeof(origin));
+		origin.x = (float)jeLua_getOptionalNumberField(lua, renderableIndex, "x", 0.0F);
+		origin.y = (float)jeLua_getOptionalNumberField(lua, renderableIndex, "y", 0.0F);
+		origin.x = (float)jeLua_getOptionalNumberField(lua, renderableIndex, "x1", origin.x);
+		origin.y = (float)jeLua_getOptionalNumberField(lua, renderableIndex, "y1", origin.y);
+		origin.x += (float)jeLua_getOptionalNumberField(lua, renderableIndex, "offsetX", 0.0F) + cameraOffsetX;
+		origin.y += (float)jeLua_getOptionalNumberField(lua, renderableIndex, "offsetY", 0.0F) + cameraOffsetY;
+
+		if ((font != NULL) && (textLength > 0)) {
+			origin.z = (float)jeLua_getOptionalNumberField(lua, renderableIndex, "z", 0.0F);
+			origin.r = (float)jeLua_getOptionalNumberField(lua, renderableIndex, "r", font->r);
+			origin.g = (float)jeLua_getOptionalNumberField(lua, renderableIndex, "g", font->g);
+			origin.b = (float)jeLua_getOptionalNumberField(lua, renderableIndex, "b", font->b);
+			origin.a = (float)jeLua_getOptionalNumberField(lua, renderableIndex, "a", font->a);
+			origin.z = isnan(font->textZ) ? origin.z : font->textZ;
+			origin.r = isnan(font->textR) ? origin.r : font->textR;
+			origin.g = isnan(font->textG) ? origin.g : font->textG;
+			origin.b = isnan(font->textB) ? origin.b : font->textB;
+			origin.a = isnan(font->textA) ? origin.a : font->textA;
+
+			const struct jeLuaTextMesh* textMesh = jeLua_getTextMesh(textCache, font, text, textLength, &origin);
+
+			JE_TRACE("lua=%p, text=%s, origin=%s", (void*)lua, text, jeVertex_getDebugString(&origin));
+			jeWindow_pushTexturedPrimitives(
+				window,
+				(const struct jeVertex*)textMesh->vertices.data,
+				textMesh->vertices.count / JE_PRIMITIVE_TYPE_SPRITES_VERTEX_COUNT,
+				JE_PRIMITIVE_TYPE_SPRITES,
+				font->textureId,
+				origin.x,
+				origin.y);
 		}
+	}
 
-		for (uint32_t i = 1; i < vertexCount; i++) {
-			vertices[i].z = vertices[0].z;
-			vertices[i].r = vertices[0].r;
-			vertices[i].g = vertices[0].g;
-			vertices[i].b = vertices[0].b;
-			vertices[i].a = vertices[0].a;
-		}
+	return 0;
+}
+int jeLua_drawReset(lua_State* lua) {
+	struct jeWindow* window = jeLua_getWindow(lua);
+	JE_TRACE("lua=%p, window=%p", (void*)lua, (void*)window);
 
-		float cameraX1 = (float)jeLua_getOptionalNumberField(lua, cameraIndex, "x", 0.0F);
-		float cameraY1 = (float)jeLua_getOptionalNumberField(lua, cameraIndex, "y", 0.0F);
-		float cameraX2 = cameraX1 + (float)jeLua_getOptionalNumberField(lua, cameraIndex, "w", 0.0F);
-		float cameraY2 = cameraY1 + (float)jeLua_getOptionalNumberField(lua, cameraIndex, "h", 0.0F);
-		cameraX1 = (float)jeLua_getOptionalNumberField(lua, cameraIndex, "x1", cameraX1);
-		cameraY1 = (float)jeLua_getOptionalNumberField(lua, cameraIndex, "y1", cameraY1);
-		cameraX2 = (float)jeLua_getOptionalNumberField(lua, cameraIndex, "x2", cameraX2);
-		cameraY2 = (float)jeLua_getOptionalNumberField(lua, cameraIndex, "y2", cameraY2);
+	bool ok = true;
 
-		float offsetX = 0.0F;
-		float offsetY = 0.0F;
-		offsetX = (float)jeLua_getOptionalNumberField(lua, renderableIndex, "offsetX", 0.0F);
-		offsetY = (float)jeLua_getOptionalNumberField(lua, renderableIndex, "offsetY", 0.0F);
+	if (lua == NULL) {
+		JE_ERROR("lua=NULL");
+		ok = false;
+	}
 
-		offsetX -= cameraX1 + floorf((cameraX2 - cameraX1) / 2.0F);
-		offsetY -= cameraY1 + floorf((cameraY2 - cameraY1) / 2.0F);
+	if (jeWindow_getIsValid(window) == false) {
+		JE_ERROR("window is not valid");
+		ok = false;
+	}
 
-		for (uint32_t i = 0; i < vertexCount; i++) {
-			vertices[i].x += offsetX;
-			vertices[i].y += offsetY;
-		}
+	if (ok) {
+		jeWindow_resetPrimitives(window);
 	}
+
+	return 0;
 }
-void jeLua_drawPrimitiveImpl(lua_State* lua, uint32_t primitiveType) {
+int jeLua_loadTexture(lua_State* lua) {
 	struct jeWindow* window = jeLua_getWindow(lua);
-
 	JE_TRACE("lua=%p, window=%p", (void*)lua, (void*)window);
 
 	bool ok = true;
+	int numResponses = 0;
 
 	if (lua == NULL) {
 		JE_ERROR("lua=NULL");
@@ -536,55 +2462,45 @@ void jeLua_drawPrimitiveImpl(lua_State* lua, uint32_t primitiveType) {
 	}
 
 	if (jeWindow_getIsValid(window) == false) {
-		// JE_ERROR("window is not valid");
+		JE_ERROR("window is not valid");
 		ok = false;
 	}
 
-	if (jePrimitiveType_getValid(primitiveType) == false) {
-		JE_ERROR("not a valid primitiveType, primitiveType=%u", primitiveType);
-		ok = false;
-	}
+	uint32_t filenameLength = 0;
+	const char* filename = NULL;
+	if (ok) {
+		static const int textureIndex = 1;
 
-	struct jeVertex vertices[JE_PRIMITIVE_TYPE_MAX_VERTEX_COUNT];
-	memset(&vertices, 0, sizeof(vertices));
+		luaL_checktype(lua, textureIndex, LUA_TTABLE);
 
-	uint32_t vertexCount = jePrimitiveType_getVertexCount(primitiveType);
+		filename = jeLua_getStringField(lua, textureIndex, "filename", &filenameLength);
 
-	if (ok) {
-		jeLua_getPrimitiveImpl(lua, vertices, vertexCount);
+		if (filenameLength == 0) {
+			JE_ERROR("filenameLength=0");
+			ok = false;
+		}
+		if (filename == NULL) {
+			JE_ERROR("filename=NULL");
+			ok = false;
+		}
+	}
 
-		JE_TRACE(
-			"lua=%p, primitiveType=%u, vertexCount=%u, vertices={%s}",
-			(void*)lua,
-			primitiveType,
-			vertexCount,
-			jeVertex_arrayGetDebugString(vertices, vertexCount));
+	uint32_t textureId = 0;
+	ok = ok && jeWindow_loadTexture(window, filename, &textureId);
+
+	if (lua != NULL) {
+		lua_pushboolean(lua, ok);
+		numResponses++;
 
-		jeWindow_pushPrimitive(window, vertices, primitiveType);
+		lua_pushnumber(lua, (lua_Number)textureId);
+		numResponses++;
 	}
+
+	return numResponses;
 }
-int jeLua_drawPoint(lua_State* lua) {
-	JE_TRACE("lua=%p", (void*)lua);
-	jeLua_drawPrimitiveImpl(lua, JE_PRIMITIVE_TYPE_POINTS);
-	return 0;
-}
-int jeLua_drawLine(lua_State* lua) {
-	JE_TRACE("lua=%p", (void*)lua);
-	jeLua_drawPrimitiveImpl(lua, JE_PRIMITIVE_TYPE_LINES);
-	return 0;
-}
-int jeLua_drawTriangle(lua_State* lua) {
-	JE_TRACE("lua=%p", (void*)lua);
-	jeLua_drawPrimitiveImpl(lua, JE_PRIMITIVE_TYPE_TRIANGLES);
-	return 0;
-}
-int jeLua_drawSprite(lua_State* lua) {
-	JE_TRACE("lua=%p", (void*)lua);
-	jeLua_drawPrimitiveImpl(lua, JE_PRIMITIVE_TYPE_SPRITES);
-	return 0;
-}
-int jeLua_drawText(lua_State* lua) {
-	JE_TRACE("lua=%p", (void*)lua);
+int jeLua_beginLayer(lua_State* lua) {
+	struct jeWindow* window = jeLua_getWindow(lua);
+	JE_TRACE("lua=%p, window=%p", (void*)lua, (void*)window);
 
 	bool ok = true;
 
@@ -593,77 +2509,76 @@ int jeLua_drawText(lua_State* lua) {
 		ok = false;
 	}
 
+	if (jeWindow_getIsValid(window) == false) {
+		JE_ERROR("window is not valid");
+		ok = false;
+	}
+
 	if (ok) {
-		static const int renderableIndex = 1;
-		static const int defaultsIndex = 2;
+		static const int layerIdIndex = 1;
 
-		luaL_checktype(lua, defaultsIndex, LUA_TTABLE);
-		luaL_checktype(lua, renderableIndex, LUA_TTABLE);
+		/*Primitives drawn until client.endLayer() replace the layer's contents, in world coords*/
+		lua_Number layerId = luaL_checknumber(lua, layerIdIndex);
+		jeWindow_beginLayer(window, (uint32_t)layerId);
+	}
 
-		uint32_t charW = (uint32_t)jeLua_getNumberField(lua, defaultsIndex, "charW");
-		uint32_t charH = (uint32_t)jeLua_getNumberField(lua, defaultsIndex, "charH");
+	return 0;
+}
+int jeLua_endLayer(lua_State* lua) {
+	struct jeWindow* window = jeLua_getWindow(lua);
+	JE_TRACE("lua=%p, window=%p", (void*)lua, (void*)window);
 
-		const char* charFirst = jeLua_getStringField(lua, defaultsIndex, "charFirst", NULL);
-		const char* charLast = jeLua_getStringField(lua, defaultsIndex, "charLast", NULL);
-		uint32_t charColumns = (uint32_t)jeLua_getNumberField(lua, defaultsIndex, "charColumns");
+	bool ok = true;
 
-		uint32_t textLength = 0;
-		const char* text = jeLua_getStringField(lua, renderableIndex, "text", &textLength);
+	if (lua == NULL) {
+		JE_ERROR("lua=NULL");
+		ok = false;
+	}
 
-		struct jeVertex textBoundsVertices[2];
-		memset(&textBoundsVertices, 0, sizeof(textBoundsVertices));
+	if (jeWindow_getIsValid(window) == false) {
+		JE_ERROR("window is not valid");
+		ok = false;
+	}
 
-		jeLua_getPrimitiveImpl(lua, textBoundsVertices, 1);
-		textBoundsVertices[0].z = (float)jeLua_getOptionalNumberField(lua, defaultsIndex, "textZ", textBoundsVertices[0].z);
-		textBoundsVertices[0].r = (float)jeLua_getOptionalNumberField(lua, defaultsIndex, "textR", textBoundsVertices[0].r);
-		textBoundsVertices[0].g = (float)jeLua_getOptionalNumberField(lua, defaultsIndex, "textG", textBoundsVertices[0].g);
-		textBoundsVertices[0].b = (float)jeLua_getOptionalNumberField(lua, defaultsIndex, "textB", textBoundsVertices[0].b);
-		textBoundsVertices[0].a = (float)jeLua_getOptionalNumberField(lua, defaultsIndex, "textA", textBoundsVertices[0].a);
-		textBoundsVertices[1] = textBoundsVertices[0];
+	if (ok) {
+		jeWindow_endLayer(window);
+	}
 
-		JE_TRACE(
-			"lua=%p, text=%s, textBoundsVertices=%s",
-			(void*)lua,
-			text,
-			jeVertex_arrayGetDebugString(textBoundsVertices, 2));
-		for (uint32_t i = 0; i < textLength; i++) {
-			static const char charDefault = ' ';
+	return 0;
+}
+int jeLua_drawLayer(lua_State* lua) {
+	struct jeWindow* window = jeLua_getWindow(lua);
+	JE_TRACE("lua=%p, window=%p", (void*)lua, (void*)window);
 
-			char charVal = (char)toupper((uint32_t)text[i]);
-			if ((charVal < charFirst[0]) || (charVal > charLast[0])) {
-				JE_WARN(
-					"character outside range, char=%u, min=%u, max=%u",
-					(uint32_t)charVal,
-					(uint32_t)charFirst[0],
-					(uint32_t)charLast[0]);
-				charVal = charDefault;
-			}
+	bool ok = true;
 
-			uint32_t charIndex = (uint32_t)(charVal - charFirst[0]);
+	if (lua == NULL) {
+		JE_ERROR("lua=NULL");
+		ok = false;
+	}
 
-			static const uint32_t renderScaleX = 1;
-			static const uint32_t renderScaleY = 1;
+	if (jeWindow_getIsValid(window) == false) {
+		// JE_ERROR("window is not valid");
+		ok = false;
+	}
 
-			struct jeVertex charVertices[2];
-			memcpy(charVertices, textBoundsVertices, sizeof(charVertices));
-			charVertices[0].x += (float)(charW * renderScaleX * i);
-			charVertices[0].u += (float)(charW * (charIndex % charColumns));
-			charVertices[0].v += (float)(charH * (charIndex / charColumns));
+	if (ok) {
+		static const int layerIdIndex = 1;
+		static const int cameraIndex = 2;
 
-			charVertices[1] = charVertices[0];
-			charVertices[1].x += (float)(charW * renderScaleX);
-			charVertices[1].y += (float)(charH * renderScaleY);
-			charVertices[1].u += (float)charW;
-			charVertices[1].v += (float)charH;
+		lua_Number layerId = luaL_checknumber(lua, layerIdIndex);
+		luaL_checktype(lua, cameraIndex, LUA_TTABLE);
 
-			JE_TRACE("lua=%p, charVertices={%s}", (void*)lua, jeVertex_arrayGetDebugString(charVertices, 2));
-			jeWindow_pushPrimitive(jeLua_getWindow(lua), charVertices, JE_PRIMITIVE_TYPE_SPRITES);
-		}
+		float offsetX = 0.0F;
+		float offsetY = 0.0F;
+		jeLua_getCameraOffset(lua, cameraIndex, &offsetX, &offsetY);
+
+		jeWindow_drawLayer(window, (uint32_t)layerId, offsetX, offsetY);
 	}
 
 	return 0;
 }
-int jeLua_drawReset(lua_State* lua) {
+int jeLua_setVertexFormat(lua_State* lua) {
 	struct jeWindow* window = jeLua_getWindow(lua);
 	JE_TRACE("lua=%p, window=%p", (void*)lua, (void*)window);
 
@@ -680,10 +2595,17 @@ int jeLua_drawReset(lua_State* lua) {
 	}
 
 	if (ok) {
-		jeWindow_resetPrimitives(window);
+		static const int vertexFormatIndex = 1;
+
+		/*Names are in JE_VERTEX_FORMAT_* order.  "packed" trades sub-pixel positions and float colors for size*/
+		static const char* const vertexFormatNames[] = {"float", "packed", NULL};
+		int vertexFormat = luaL_checkoption(lua, vertexFormatIndex, NULL, vertexFormatNames);
+
+		ok = jeWindow_setVertexFormat(window, (uint32_t)vertexFormat);
 	}
 
-	return 0;
+	lua_pushboolean(lua, ok);
+	return 1;
 }
 int jeLua_loadAudio(lua_State* lua) {
 	JE_TRACE("lua=%p", (void*)lua);
@@ -881,6 +2803,24 @@ int jeLua_runTests(lua_State* lua) {
 	jeContainer_runTests();
 	numTestSuites++;
 
+	jeCompression_runTests();
+	numTestSuites++;
+
+	jeCodec_runTests();
+	numTestSuites++;
+
+	jeJson_runTests();
+	numTestSuites++;
+
+	jeSpatial_runTests();
+	numTestSuites++;
+
+	jeDeepcopy_runTests();
+	numTestSuites++;
+
+	jeData_runTests();
+	numTestSuites++;
+
 	jeImage_runTests();
 	numTestSuites++;
 
@@ -899,6 +2839,20 @@ int jeLua_runTests(lua_State* lua) {
 	lua_pushnumber(lua, numTestSuites);
 	return 1;
 }
+int jeLua_runBenchmarks(lua_State* lua) {
+	JE_TRACE("lua=%p", (void*)lua);
+
+	uint32_t numBenchmarkSuites = 0;
+
+	jeRendering_runBenchmarks();
+	numBenchmarkSuites++;
+
+	jeData_runBenchmarks();
+	numBenchmarkSuites++;
+
+	lua_pushnumber(lua, numBenchmarkSuites);
+	return 1;
+}
 int jeLua_step(lua_State* lua) {
 	struct jeWindow* window = jeLua_getWindow(lua);
 
@@ -923,6 +2877,7 @@ int jeLua_step(lua_State* lua) {
 
 	if (lua != NULL) {
 		jeLua_updateStates(lua);
+		jeLua_dispatchDataWrites(lua);
 
 		lua_pushboolean(lua, ok);
 	}
@@ -930,23 +2885,69 @@ int jeLua_step(lua_State* lua) {
 	return 1;
 }
 
+bool jeLua_addFfiApi(lua_State* lua) {
+	JE_TRACE("lua=%p", (void*)lua);
+
+	bool ok = true;
+
+	if (lua == NULL) {
+		JE_ERROR("lua=NULL");
+		ok = false;
+	}
+
+	if (ok) {
+		/*Owned by the bindings table, so it lives as long as the lua state*/
+		struct jeLuaFfiApi* ffiApi = (struct jeLuaFfiApi*)lua_newuserdata(lua, sizeof(struct jeLuaFfiApi));
+		if (ffiApi == NULL) {
+			JE_ERROR("lua_newuserdata() failed");
+			ok = false;
+		}
+
+		if (ok) {
+			memset((void*)ffiApi, 0, sizeof(struct jeLuaFfiApi));
+			ffiApi->window = jeLua_getWindow(lua);
+			ffiApi->drawPrimitives = jeLua_ffiDrawPrimitives;
+
+			lua_setfield(lua, JE_LUA_STACK_TOP - 1, "ffiApi");
+		}
+	}
+
+	return ok;
+}
 bool jeLua_addBindings(lua_State* lua) {
 	JE_TRACE("lua=%p", (void*)lua);
 
 	static const luaL_Reg clientBindings[] = {
 		JE_LUA_CLIENT_BINDING(readData),
+		JE_LUA_CLIENT_BINDING(getDataExists),
 		JE_LUA_CLIENT_BINDING(writeData),
+		JE_LUA_CLIENT_BINDING(writeDataAsync),
+		JE_LUA_CLIENT_BINDING(encode),
+		JE_LUA_CLIENT_BINDING(decode),
+		JE_LUA_CLIENT_BINDING(compress),
+		JE_LUA_CLIENT_BINDING(decompress),
+		JE_LUA_CLIENT_BINDING(jsonEncode),
+		JE_LUA_CLIENT_BINDING(jsonDecode),
+		JE_LUA_CLIENT_BINDING(deepcopy),
+		JE_LUA_CLIENT_BINDING(newSpatialHash),
 		JE_LUA_CLIENT_BINDING(drawPoint),
 		JE_LUA_CLIENT_BINDING(drawLine),
 		JE_LUA_CLIENT_BINDING(drawTriangle),
 		JE_LUA_CLIENT_BINDING(drawSprite),
+		JE_LUA_CLIENT_BINDING(drawSprites),
 		JE_LUA_CLIENT_BINDING(drawText),
 		JE_LUA_CLIENT_BINDING(drawReset),
+		JE_LUA_CLIENT_BINDING(loadTexture),
+		JE_LUA_CLIENT_BINDING(beginLayer),
+		JE_LUA_CLIENT_BINDING(endLayer),
+		JE_LUA_CLIENT_BINDING(drawLayer),
+		JE_LUA_CLIENT_BINDING(setVertexFormat),
 		JE_LUA_CLIENT_BINDING(loadAudio),
 		JE_LUA_CLIENT_BINDING(unloadAudio),
 		JE_LUA_CLIENT_BINDING(playAudio),
 		JE_LUA_CLIENT_BINDING(stopAllAudio),
 		JE_LUA_CLIENT_BINDING(runTests),
+		JE_LUA_CLIENT_BINDING(runBenchmarks),
 		JE_LUA_CLIENT_BINDING(step),
 		{NULL, NULL} /*sentinel value*/
 	};
@@ -978,9 +2979,13 @@ bool jeLua_addBindings(lua_State* lua) {
 		lua_pushvalue(lua, JE_LUA_STACK_TOP);
 		lua_setglobal(lua, JE_LUA_CLIENT_BINDINGS_KEY);
 
-		lua_createtable(lua, /*numArrayElems*/ 0, /*numNonArrayElems*/ 16);
-		lua_setfield(lua, JE_LUA_STACK_TOP - 1, "state");
+		ok = jeLua_addFfiApi(lua);
+		ok = ok && jeLua_addState(lua);
+		ok = ok && jeLua_addTextCache(lua);
+		ok = ok && jeLua_addDataWriter(lua);
+	}
 
+	if (ok) {
 		jeLua_updateStates(lua);
 
 		lua_settop(lua, 0);
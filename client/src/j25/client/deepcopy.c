@@ -0,0 +1,235 @@
+#include <j25/client/deepcopy.h>
+
+#include <j25/core/common.h>
+
+#include <string.h>
+
+/*
+ * C and C++ have different default linkage.
+ * Lua(jit) headers don't explicitly state linkage of symbols,
+ * but libs are (normally) built with C, so we need to do their job for them.
+ */
+#if defined(__cplusplus)
+extern "C" {
+#endif
+#include <luajit-2.1/lauxlib.h>
+#include <luajit-2.1/lua.h>
+#if defined(__cplusplus)
+} /*extern "C"*/
+#endif
+
+/*Stack index of a table mapping each source table copied so far to its copy, like util.deepcopy()'s copies*/
+struct jeDeepcopier {
+	int copiesIndex;
+};
+
+bool jeDeepcopier_pushValue(lua_State* lua, struct jeDeepcopier* copier, int valueIndex, uint32_t depth);
+
+bool jeDeepcopier_pushValue(lua_State* lua, struct jeDeepcopier* copier, int valueIndex, uint32_t depth) {
+	bool ok = true;
+
+	bool copied = false;
+	if (lua_type(lua, valueIndex) != LUA_TTABLE) {
+		lua_pushvalue(lua, valueIndex);
+		copied = true;
+	} else if ((depth >= JE_DEEPCOPY_MAX_DEPTH) || (lua_checkstack(lua, 5) == 0)) {
+		JE_ERROR("max depth exceeded, maxDepth=%u", JE_DEEPCOPY_MAX_DEPTH);
+		ok = false;
+	} else {
+		lua_pushvalue(lua, valueIndex);
+		lua_rawget(lua, copier->copiesIndex);
+		copied = !lua_isnil(lua, -1);
+		if (!copied) {
+			lua_pop(lua, 1);
+		}
+	}
+
+	if (ok && !copied) {
+		/*Presized from the source, to avoid rehashing while the copy is filled*/
+		int keyCount = 0;
+		lua_pushnil(lua);
+		while (lua_next(lua, valueIndex) != 0) {
+			keyCount++;
+			lua_pop(lua, 1);
+		}
+		int arrayCount = (int)lua_objlen(lua, valueIndex);
+		arrayCount = (arrayCount < keyCount) ? arrayCount : keyCount;
+		lua_createtable(lua, arrayCount, keyCount - arrayCount);
+
+		int copyIndex = lua_gettop(lua);
+		lua_pushvalue(lua, valueIndex);
+		lua_pushvalue(lua, copyIndex);
+		lua_rawset(lua, copier->copiesIndex);
+
+		lua_pushnil(lua);
+		while (ok && (lua_next(lua, valueIndex) != 0)) {
+			int keyIndex = lua_gettop(lua) - 1;
+			ok = jeDeepcopier_pushValue(lua, copier, keyIndex, depth + 1);
+			ok = ok && jeDeepcopier_pushValue(lua, copier, keyIndex + 1, depth + 1);
+			if (ok) {
+				lua_rawset(lua, copyIndex);
+			}
+			lua_settop(lua, keyIndex);
+		}
+	}
+
+	return ok;
+}
+bool jeDeepcopy_pushCopy(lua_State* lua, int valueIndex) {
+	JE_TRACE("lua=%p, valueIndex=%d", (void*)lua, valueIndex);
+
+	bool ok = true;
+
+	if (lua == NULL) {
+		JE_ERROR("lua=NULL");
+		ok = false;
+	}
+
+	int top = (lua != NULL) ? lua_gettop(lua) : 0;
+
+	/*Relative indices would shift as the copy is pushed*/
+	if ((valueIndex < 0) && (valueIndex > LUA_REGISTRYINDEX)) {
+		valueIndex = top + valueIndex + 1;
+	}
+
+	if (ok && (lua_checkstack(lua, 2) == 0)) {
+		JE_ERROR("lua_checkstack() failed");
+		ok = false;
+	}
+
+	struct jeDeepcopier copier;
+	if (ok) {
+		lua_newtable(lua);
+		copier.copiesIndex = lua_gettop(lua);
+
+		ok = jeDeepcopier_pushValue(lua, &copier, valueIndex, 0);
+	}
+
+	if (ok) {
+		lua_replace(lua, copier.copiesIndex);
+	} else if (lua != NULL) {
+		lua_settop(lua, top);
+	}
+
+	return ok;
+}
+
+void jeDeepcopy_runTests() {
+#if JE_DEBUGGING
+	JE_DEBUG(" ");
+
+	lua_State* lua = luaL_newstate();
+	JE_ASSERT(lua != NULL);
+
+	{
+		lua_pushnumber(lua, 0.5);
+		JE_ASSERT(jeDeepcopy_pushCopy(lua, -1));
+		JE_ASSERT((lua_gettop(lua) == 2) && (lua_tonumber(lua, -1) == 0.5));
+
+		lua_pushstring(lua, "a");
+		JE_ASSERT(jeDeepcopy_pushCopy(lua, -1));
+		JE_ASSERT(lua_rawequal(lua, -1, -2));
+
+		lua_settop(lua, 0);
+	}
+
+	{
+		/*{0.5, [3] = "a", b = {true, cycle = <root>}, [{}] = false, shared = <shared>, sharedToo = <shared>}*/
+		lua_createtable(lua, 0, 0);
+		int tableIndex = lua_gettop(lua);
+		lua_pushnumber(lua, 0.5);
+		lua_rawseti(lua, tableIndex, 1);
+		lua_pushstring(lua, "a");
+		lua_rawseti(lua, tableIndex, 3);
+
+		lua_createtable(lua, 0, 0);
+		lua_pushboolean(lua, true);
+		lua_rawseti(lua, -2, 1);
+		lua_pushvalue(lua, tableIndex);
+		lua_setfield(lua, -2, "cycle");
+		lua_setfield(lua, tableIndex, "b");
+
+		lua_createtable(lua, 0, 0);
+		lua_pushboolean(lua, false);
+		lua_rawset(lua, tableIndex);
+
+		lua_createtable(lua, 0, 0);
+		lua_pushvalue(lua, -1);
+		lua_setfield(lua, tableIndex, "shared");
+		lua_setfield(lua, tableIndex, "sharedToo");
+
+		JE_ASSERT(jeDeepcopy_pushCopy(lua, tableIndex));
+		JE_ASSERT(lua_gettop(lua) == (tableIndex + 1));
+		int copyIndex = lua_gettop(lua);
+		JE_ASSERT(lua_istable(lua, copyIndex) && !lua_rawequal(lua, copyIndex, tableIndex));
+
+		lua_rawgeti(lua, copyIndex, 1);
+		JE_ASSERT(lua_tonumber(lua, -1) == 0.5);
+		lua_rawgeti(lua, copyIndex, 3);
+		JE_ASSERT(strcmp(lua_tostring(lua, -1), "a") == 0);
+		lua_pop(lua, 2);
+
+		lua_getfield(lua, copyIndex, "b");
+		lua_getfield(lua, tableIndex, "b");
+		JE_ASSERT(lua_istable(lua, -2) && !lua_rawequal(lua, -1, -2));
+		lua_pop(lua, 1);
+		lua_rawgeti(lua, -1, 1);
+		JE_ASSERT(lua_toboolean(lua, -1));
+		lua_pop(lua, 1);
+		lua_getfield(lua, -1, "cycle");
+		JE_ASSERT(lua_rawequal(lua, -1, copyIndex));
+		lua_pop(lua, 2);
+
+		lua_getfield(lua, copyIndex, "shared");
+		lua_getfield(lua, copyIndex, "sharedToo");
+		lua_getfield(lua, tableIndex, "shared");
+		JE_ASSERT(lua_istable(lua, -3) && lua_rawequal(lua, -2, -3) && !lua_rawequal(lua, -1, -3));
+		lua_pop(lua, 3);
+
+		/*The table key is copied too, so the copy has 6 keys, none of them the source's key table*/
+		uint32_t keyCount = 0;
+		lua_pushnil(lua);
+		while (lua_next(lua, copyIndex) != 0) {
+			keyCount++;
+			if (lua_type(lua, -2) == LUA_TTABLE) {
+				lua_pushvalue(lua, -2);
+				lua_rawget(lua, tableIndex);
+				JE_ASSERT(lua_isnil(lua, -1));
+				lua_pop(lua, 1);
+			}
+			lua_pop(lua, 1);
+		}
+		JE_ASSERT(keyCount == 6);
+
+		lua_settop(lua, 0);
+	}
+
+	{
+		/*Tables nested past the max depth are rejected, leaving the stack as it was.  Logging is off while copying,
+		 * which also disables asserts, so results are asserted after.*/
+		lua_createtable(lua, 0, 0);
+		for (uint32_t i = 0; i < JE_DEEPCOPY_MAX_DEPTH; i++) {
+			lua_createtable(lua, 1, 0);
+			lua_insert(lua, -2);
+			lua_rawseti(lua, -2, 1);
+		}
+
+		uint32_t logLevelBackup = jeLogger_getLevel();
+		jeLogger_setLevelOverride(JE_LOG_LEVEL_NONE);
+
+		bool copied = jeDeepcopy_pushCopy(lua, 1);
+
+		jeLogger_setLevelOverride(logLevelBackup);
+
+		JE_ASSERT(!copied);
+		JE_ASSERT(lua_gettop(lua) == 1);
+
+		lua_rawgeti(lua, 1, 1);
+		JE_ASSERT(jeDeepcopy_pushCopy(lua, -1));
+
+		lua_settop(lua, 0);
+	}
+
+	lua_close(lua);
+#endif
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#if !defined(JE_CLIENT_DEEPCOPY_H)
+#define JE_CLIENT_DEEPCOPY_H
+
+#include <j25/core/common.h>
+
+#define JE_DEEPCOPY_MAX_DEPTH 256U
+
+struct lua_State;
+
+/*Pushes a copy of the value at valueIndex, like util.deepcopy().  Shared subtables are copied once and stay shared,
+ * cycles are pointed at the copies, and metatables are not copied.  Nothing is pushed if the max depth is exceeded.*/
+bool jeDeepcopy_pushCopy(struct lua_State* lua, int valueIndex);
+
+void jeDeepcopy_runTests();
+
+#endif
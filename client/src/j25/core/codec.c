@@ -0,0 +1,386 @@
+#include <j25/core/codec.h>
+
+#include <j25/core/common.h>
+#include <j25/core/container.h>
+
+#include <math.h>
+#include <string.h>
+
+uint32_t jeCodec_getEncodedVarint(uint64_t value, char* outEncoded);
+bool jeEncoder_pushHeader(struct jeEncoder* encoder, uint8_t tag, uint64_t value);
+bool jeDecoder_readVarint(struct jeDecoder* decoder, uint64_t* outValue);
+
+uint32_t jeCodec_getEncodedVarint(uint64_t value, char* outEncoded) {
+	/*Unsigned LEB128; writes at most 10 bytes*/
+	uint32_t encodedSize = 0;
+
+	do {
+		uint8_t byte = (uint8_t)(value & 0x7FU);
+		value >>= 7U;
+		if (value != 0) {
+			byte |= 0x80U;
+		}
+		outEncoded[encodedSize] = (char)byte;
+		encodedSize++;
+	} while (value != 0);
+
+	return encodedSize;
+}
+
+bool jeEncoder_create(struct jeEncoder* encoder) {
+	JE_TRACE("encoder=%p", (void*)encoder);
+
+	bool ok = true;
+
+	if (encoder == NULL) {
+		JE_ERROR("encoder=NULL");
+		ok = false;
+	}
+
+	ok = ok && jeString_create(&encoder->data);
+	ok = ok && jeString_push(&encoder->data, JE_CODEC_HEADER, JE_CODEC_HEADER_SIZE);
+
+	return ok;
+}
+void jeEncoder_destroy(struct jeEncoder* encoder) {
+	JE_TRACE("encoder=%p", (void*)encoder);
+
+	if (encoder != NULL) {
+		jeString_destroy(&encoder->data);
+	}
+}
+bool jeEncoder_pushHeader(struct jeEncoder* encoder, uint8_t tag, uint64_t value) {
+	char header[1 + JE_CODEC_VARINT_MAX_SIZE];
+	header[0] = (char)tag;
+
+	uint32_t headerSize = 1 + jeCodec_getEncodedVarint(value, &header[1]);
+
+	return jeString_push(&encoder->data, header, headerSize);
+}
+bool jeEncoder_pushTag(struct jeEncoder* encoder, uint8_t tag) {
+	char encoded = (char)tag;
+	return jeString_push(&encoder->data, &encoded, 1);
+}
+bool jeEncoder_pushBoolean(struct jeEncoder* encoder, bool value) {
+	return jeEncoder_pushTag(encoder, value ? JE_CODEC_TAG_TRUE : JE_CODEC_TAG_FALSE);
+}
+bool jeEncoder_pushNumber(struct jeEncoder* encoder, double value) {
+	bool ok = true;
+
+	if ((value >= -JE_CODEC_MAX_INTEGER) && (value <= JE_CODEC_MAX_INTEGER) && (value == floor(value))) {
+		int64_t integer = (int64_t)value;
+		uint64_t zigzag = (uint64_t)integer << 1U;
+		if (integer < 0) {
+			zigzag = (((uint64_t)(-(integer + 1))) << 1U) | 1U;
+		}
+		ok = jeEncoder_pushHeader(encoder, JE_CODEC_TAG_INTEGER, zigzag);
+	} else {
+		char encoded[1 + sizeof(double)];
+		encoded[0] = (char)JE_CODEC_TAG_NUMBER;
+		memcpy((void*)&encoded[1], (const void*)&value, sizeof(double));
+		ok = jeString_push(&encoder->data, encoded, (uint32_t)sizeof(encoded));
+	}
+
+	return ok;
+}
+bool jeEncoder_pushString(struct jeEncoder* encoder, const char* string, size_t stringSize) {
+	bool ok = jeEncoder_pushHeader(encoder, JE_CODEC_TAG_STRING, (uint64_t)stringSize);
+
+	if (ok && (stringSize > 0)) {
+		ok = jeString_push(&encoder->data, string, (uint32_t)stringSize);
+	}
+
+	return ok;
+}
+bool jeEncoder_pushStringRef(struct jeEncoder* encoder, uint32_t stringId) {
+	return jeEncoder_pushHeader(encoder, JE_CODEC_TAG_STRING_REF, (uint64_t)stringId);
+}
+bool jeEncoder_pushTable(struct jeEncoder* encoder, uint32_t arrayCount, uint32_t hashCount) {
+	char header[1 + (2 * JE_CODEC_VARINT_MAX_SIZE)];
+	header[0] = (char)JE_CODEC_TAG_TABLE;
+
+	uint32_t headerSize = 1;
+	headerSize += jeCodec_getEncodedVarint((uint64_t)arrayCount, &header[headerSize]);
+	headerSize += jeCodec_getEncodedVarint((uint64_t)hashCount, &header[headerSize]);
+
+	return jeString_push(&encoder->data, header, headerSize);
+}
+
+bool jeDecoder_create(struct jeDecoder* decoder, const char* data, size_t size) {
+	JE_TRACE("decoder=%p, size=%u", (void*)decoder, (uint32_t)size);
+
+	bool ok = true;
+
+	if (decoder == NULL) {
+		JE_ERROR("decoder=NULL");
+		ok = false;
+	}
+
+	if (decoder != NULL) {
+		memset((void*)decoder, 0, sizeof(struct jeDecoder));
+	}
+
+	if (ok && ((data == NULL) || (size < JE_CODEC_HEADER_SIZE) ||
+			   (memcmp((const void*)data, (const void*)JE_CODEC_HEADER, JE_CODEC_HEADER_SIZE) != 0))) {
+		JE_ERROR("data is not encoded, header missing");
+		ok = false;
+	}
+
+	if (ok) {
+		decoder->data = (const uint8_t*)data;
+		decoder->size = size;
+		decoder->pos = JE_CODEC_HEADER_SIZE;
+	}
+
+	return ok;
+}
+bool jeDecoder_getDone(const struct jeDecoder* decoder) {
+	return decoder->pos >= decoder->size;
+}
+bool jeDecoder_readVarint(struct jeDecoder* decoder, uint64_t* outValue) {
+	bool ok = true;
+	uint64_t value = 0;
+
+	for (uint32_t shift = 0; ok; shift += 7) {
+		if ((decoder->pos >= decoder->size) || (shift >= 64)) {
+			JE_ERROR("invalid varint, pos=%u", (uint32_t)decoder->pos);
+			ok = false;
+			break;
+		}
+
+		uint8_t byte = decoder->data[decoder->pos];
+		decoder->pos++;
+
+		value |= ((uint64_t)(byte & 0x7FU)) << shift;
+		if ((byte & 0x80U) == 0) {
+			break;
+		}
+	}
+
+	*outValue = value;
+	return ok;
+}
+bool jeDecoder_readTag(struct jeDecoder* decoder, uint8_t* outTag) {
+	bool ok = true;
+
+	*outTag = JE_CODEC_TAG_INVALID;
+
+	if (decoder->pos >= decoder->size) {
+		JE_ERROR("unexpected end of data, size=%u", (uint32_t)decoder->size);
+		ok = false;
+	}
+
+	if (ok) {
+		*outTag = decoder->data[decoder->pos];
+		decoder->pos++;
+	}
+
+	return ok;
+}
+bool jeDecoder_readInteger(struct jeDecoder* decoder, double* outValue) {
+	uint64_t value = 0;
+	bool ok = jeDecoder_readVarint(decoder, &value);
+
+	int64_t integer = (int64_t)(value >> 1U);
+	if (value & 1U) {
+		integer = -integer - 1;
+	}
+	*outValue = ok ? (double)integer : 0.0;
+
+	return ok;
+}
+bool jeDecoder_readNumber(struct jeDecoder* decoder, double* outValue) {
+	bool ok = true;
+
+	*outValue = 0.0;
+
+	if ((decoder->size - decoder->pos) < sizeof(double)) {
+		JE_ERROR("unexpected end of data, size=%u", (uint32_t)decoder->size);
+		ok = false;
+	}
+
+	if (ok) {
+		memcpy((void*)outValue, (const void*)&decoder->data[decoder->pos], sizeof(double));
+		decoder->pos += sizeof(double);
+	}
+
+	return ok;
+}
+bool jeDecoder_readString(struct jeDecoder* decoder, const char** outString, size_t* outStringSize) {
+	uint64_t value = 0;
+	bool ok = jeDecoder_readVarint(decoder, &value);
+
+	*outString = "";
+	*outStringSize = 0;
+
+	if (ok && (value > (uint64_t)(decoder->size - decoder->pos))) {
+		JE_ERROR("string exceeds data, stringSize=%u, size=%u", (uint32_t)value, (uint32_t)decoder->size);
+		ok = false;
+	}
+
+	if (ok) {
+		*outString = (const char*)&decoder->data[decoder->pos];
+		*outStringSize = (size_t)value;
+		decoder->pos += (size_t)value;
+	}
+
+	return ok;
+}
+bool jeDecoder_readStringRef(struct jeDecoder* decoder, uint32_t stringCount, uint32_t* outStringId) {
+	uint64_t value = 0;
+	bool ok = jeDecoder_readVarint(decoder, &value);
+
+	*outStringId = 0;
+
+	if (ok && (value >= (uint64_t)stringCount)) {
+		JE_ERROR("invalid string reference, stringId=%u", (uint32_t)value);
+		ok = false;
+	}
+
+	if (ok) {
+		*outStringId = (uint32_t)value;
+	}
+
+	return ok;
+}
+bool jeDecoder_readTable(struct jeDecoder* decoder, uint32_t* outArrayCount, uint32_t* outHashCount) {
+	uint64_t arrayCount = 0;
+	uint64_t hashCount = 0;
+
+	bool ok = jeDecoder_readVarint(decoder, &arrayCount);
+	ok = ok && jeDecoder_readVarint(decoder, &hashCount);
+
+	/*Every value takes at least one byte, so counts beyond the remaining data are corrupt*/
+	size_t remaining = decoder->size - decoder->pos;
+	if (ok && ((arrayCount > remaining) || (hashCount > (remaining / 2)))) {
+		JE_ERROR("invalid table, arrayCount=%u, hashCount=%u", (uint32_t)arrayCount, (uint32_t)hashCount);
+		ok = false;
+	}
+
+	*outArrayCount = ok ? (uint32_t)arrayCount : 0;
+	*outHashCount = ok ? (uint32_t)hashCount : 0;
+
+	return ok;
+}
+
+void jeCodec_runTests() {
+#if JE_DEBUGGING
+	JE_DEBUG(" ");
+
+	{
+		char varint[JE_CODEC_VARINT_MAX_SIZE];
+		JE_ASSERT(jeCodec_getEncodedVarint(0, varint) == 1);
+		JE_ASSERT(jeCodec_getEncodedVarint(127, varint) == 1);
+		JE_ASSERT(jeCodec_getEncodedVarint(128, varint) == 2);
+		JE_ASSERT(jeCodec_getEncodedVarint(UINT64_MAX, varint) == JE_CODEC_VARINT_MAX_SIZE);
+	}
+
+	{
+		/*{1, -2, 0.5, "a", "a", true, {}} written by hand, the way a caller walking its values would*/
+		struct jeEncoder encoder;
+		JE_ASSERT(jeEncoder_create(&encoder));
+		JE_ASSERT(jeEncoder_pushTable(&encoder, 7, 0));
+		JE_ASSERT(jeEncoder_pushNumber(&encoder, 1.0));
+		JE_ASSERT(jeEncoder_pushNumber(&encoder, -2.0));
+		JE_ASSERT(jeEncoder_pushNumber(&encoder, 0.5));
+		JE_ASSERT(jeEncoder_pushString(&encoder, "a", 1));
+		JE_ASSERT(jeEncoder_pushStringRef(&encoder, 0));
+		JE_ASSERT(jeEncoder_pushBoolean(&encoder, true));
+		JE_ASSERT(jeEncoder_pushTable(&encoder, 0, 0));
+
+		/*Header, table, 2 integers, 1 double, string, string ref, boolean, empty table*/
+		JE_ASSERT(jeString_getCount(&encoder.data) == (JE_CODEC_HEADER_SIZE + 3 + 4 + 9 + 3 + 2 + 1 + 3));
+
+		struct jeDecoder decoder;
+		JE_ASSERT(jeDecoder_create(&decoder, jeString_get(&encoder.data, 0), jeString_getCount(&encoder.data)));
+
+		uint8_t tag = JE_CODEC_TAG_INVALID;
+		uint32_t arrayCount = 0;
+		uint32_t hashCount = 0;
+		double number = 0.0;
+		const char* string = NULL;
+		size_t stringSize = 0;
+		uint32_t stringId = 0;
+
+		JE_ASSERT(jeDecoder_readTag(&decoder, &tag) && (tag == JE_CODEC_TAG_TABLE));
+		JE_ASSERT(jeDecoder_readTable(&decoder, &arrayCount, &hashCount));
+		JE_ASSERT((arrayCount == 7) && (hashCount == 0));
+		JE_ASSERT(jeDecoder_readTag(&decoder, &tag) && (tag == JE_CODEC_TAG_INTEGER));
+		JE_ASSERT(jeDecoder_readInteger(&decoder, &number) && (number == 1.0));
+		JE_ASSERT(jeDecoder_readTag(&decoder, &tag) && (tag == JE_CODEC_TAG_INTEGER));
+		JE_ASSERT(jeDecoder_readInteger(&decoder, &number) && (number == -2.0));
+		JE_ASSERT(jeDecoder_readTag(&decoder, &tag) && (tag == JE_CODEC_TAG_NUMBER));
+		JE_ASSERT(jeDecoder_readNumber(&decoder, &number) && (number == 0.5));
+		JE_ASSERT(jeDecoder_readTag(&decoder, &tag) && (tag == JE_CODEC_TAG_STRING));
+		JE_ASSERT(jeDecoder_readString(&decoder, &string, &stringSize) && (stringSize == 1) && (string[0] == 'a'));
+		JE_ASSERT(jeDecoder_readTag(&decoder, &tag) && (tag == JE_CODEC_TAG_STRING_REF));
+		JE_ASSERT(jeDecoder_readStringRef(&decoder, 1, &stringId) && (stringId == 0));
+		JE_ASSERT(jeDecoder_readTag(&decoder, &tag) && (tag == JE_CODEC_TAG_TRUE));
+		JE_ASSERT(jeDecoder_readTag(&decoder, &tag) && (tag == JE_CODEC_TAG_TABLE));
+		JE_ASSERT(jeDecoder_readTable(&decoder, &arrayCount, &hashCount));
+		JE_ASSERT((arrayCount == 0) && (hashCount == 0));
+		JE_ASSERT(jeDecoder_getDone(&decoder));
+
+		jeEncoder_destroy(&encoder);
+	}
+
+	{
+		/*Corrupt data is rejected.  Logging is off while decoding it, which also disables asserts, so results are
+		 * asserted after.*/
+		static const char missingHeader[] = "JEB2\x07\x00\x00";
+		static const char truncatedTable[] = JE_CODEC_HEADER "\x07\x80";
+		static const char oversizedTable[] = JE_CODEC_HEADER "\x07\xFF\xFF\xFF\x0F\x00";
+		static const char oversizedString[] = JE_CODEC_HEADER "\x05\x10" "a";
+		static const char invalidStringRef[] = JE_CODEC_HEADER "\x06\x00";
+		static const char truncatedNumber[] = JE_CODEC_HEADER "\x04\x00\x00";
+
+		uint8_t tag = JE_CODEC_TAG_INVALID;
+		uint32_t arrayCount = 0;
+		uint32_t hashCount = 0;
+		double number = 0.0;
+		const char* string = NULL;
+		size_t stringSize = 0;
+		uint32_t stringId = 0;
+		uint32_t rejectedCount = 0;
+		struct jeDecoder decoder;
+
+		uint32_t logLevelBackup = jeLogger_getLevel();
+		jeLogger_setLevelOverride(JE_LOG_LEVEL_NONE);
+
+		rejectedCount += !jeDecoder_create(&decoder, missingHeader, sizeof(missingHeader) - 1);
+
+		if (jeDecoder_create(&decoder, truncatedTable, sizeof(truncatedTable) - 1) &&
+			jeDecoder_readTag(&decoder, &tag)) {
+			rejectedCount += !jeDecoder_readTable(&decoder, &arrayCount, &hashCount);
+		}
+
+		if (jeDecoder_create(&decoder, oversizedTable, sizeof(oversizedTable) - 1) &&
+			jeDecoder_readTag(&decoder, &tag)) {
+			rejectedCount += !jeDecoder_readTable(&decoder, &arrayCount, &hashCount);
+		}
+
+		if (jeDecoder_create(&decoder, oversizedString, sizeof(oversizedString) - 1) &&
+			jeDecoder_readTag(&decoder, &tag)) {
+			rejectedCount += !jeDecoder_readString(&decoder, &string, &stringSize);
+		}
+
+		if (jeDecoder_create(&decoder, invalidStringRef, sizeof(invalidStringRef) - 1) &&
+			jeDecoder_readTag(&decoder, &tag)) {
+			rejectedCount += !jeDecoder_readStringRef(&decoder, 0, &stringId);
+		}
+
+		if (jeDecoder_create(&decoder, truncatedNumber, sizeof(truncatedNumber) - 1) &&
+			jeDecoder_readTag(&decoder, &tag)) {
+			rejectedCount += !jeDecoder_readNumber(&decoder, &number);
+		}
+
+		if (jeDecoder_create(&decoder, JE_CODEC_HEADER, JE_CODEC_HEADER_SIZE)) {
+			rejectedCount += !jeDecoder_readTag(&decoder, &tag);
+		}
+
+		jeLogger_setLevelOverride(logLevelBackup);
+
+		JE_ASSERT(rejectedCount == 7);
+	}
+#endif
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#if !defined(JE_CORE_CODEC_H)
+#define JE_CORE_CODEC_H
+
+#include <j25/core/common.h>
+#include <j25/core/container.h>
+
+/*Encoded format: the header, then one value.  Values are a tag byte followed by:
+ * integer: zigzag varint; number: raw double; string: varint size and bytes; string ref: varint index of an
+ * earlier string; table: varint sequence count and varint key-value pair count, then the values and pairs.*/
+#define JE_CODEC_HEADER "JEB1"
+#define JE_CODEC_HEADER_SIZE 4
+#define JE_CODEC_MAX_DEPTH 128U
+#define JE_CODEC_MAX_INTEGER 9007199254740992.0
+#define JE_CODEC_VARINT_MAX_SIZE 10
+#define JE_CODEC_TAG_NIL 0
+#define JE_CODEC_TAG_FALSE 1
+#define JE_CODEC_TAG_TRUE 2
+#define JE_CODEC_TAG_INTEGER 3
+#define JE_CODEC_TAG_NUMBER 4
+#define JE_CODEC_TAG_STRING 5
+#define JE_CODEC_TAG_STRING_REF 6
+#define JE_CODEC_TAG_TABLE 7
+#define JE_CODEC_TAG_INVALID 255
+
+/*Writes values in the encoded format; the caller walks its values and tracks which strings were already written*/
+struct jeEncoder {
+	struct jeString data;
+};
+
+/*Reads values in the encoded format.  Sizes and counts are checked against the remaining data, so that corrupt data
+ * can't cause huge allocations.*/
+struct jeDecoder {
+	const uint8_t* data;
+	size_t size;
+	size_t pos;
+};
+
+JE_API_PUBLIC bool jeEncoder_create(struct jeEncoder* encoder);
+JE_API_PUBLIC void jeEncoder_destroy(struct jeEncoder* encoder);
+JE_API_PUBLIC bool jeEncoder_pushTag(struct jeEncoder* encoder, uint8_t tag);
+JE_API_PUBLIC bool jeEncoder_pushBoolean(struct jeEncoder* encoder, bool value);
+/*Integral numbers (most of them, in game state) are stored as zigzag varints; the rest as raw doubles*/
+JE_API_PUBLIC bool jeEncoder_pushNumber(struct jeEncoder* encoder, double value);
+JE_API_PUBLIC bool jeEncoder_pushString(struct jeEncoder* encoder, const char* string, size_t stringSize);
+JE_API_PUBLIC bool jeEncoder_pushStringRef(struct jeEncoder* encoder, uint32_t stringId);
+JE_API_PUBLIC bool jeEncoder_pushTable(struct jeEncoder* encoder, uint32_t arrayCount, uint32_t hashCount);
+
+JE_API_PUBLIC bool jeDecoder_create(struct jeDecoder* decoder, const char* data, size_t size);
+JE_API_PUBLIC bool jeDecoder_getDone(const struct jeDecoder* decoder);
+JE_API_PUBLIC bool jeDecoder_readTag(struct jeDecoder* decoder, uint8_t* outTag);
+JE_API_PUBLIC bool jeDecoder_readInteger(struct jeDecoder* decoder, double* outValue);
+JE_API_PUBLIC bool jeDecoder_readNumber(struct jeDecoder* decoder, double* outValue);
+/*The string is not copied, and is not null terminated*/
+JE_API_PUBLIC bool jeDecoder_readString(struct jeDecoder* decoder, const char** outString, size_t* outStringSize);
+JE_API_PUBLIC bool jeDecoder_readStringRef(struct jeDecoder* decoder, uint32_t stringCount, uint32_t* outStringId);
+JE_API_PUBLIC bool jeDecoder_readTable(struct jeDecoder* decoder, uint32_t* outArrayCount, uint32_t* outHashCount);
+
+JE_API_PUBLIC void jeCodec_runTests();
+
+#endif
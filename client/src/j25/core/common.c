@@ -3,6 +3,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #define JE_LOG_LABEL_TRACE "trace"
 #define JE_LOG_LABEL_DEBUG "debug"
@@ -118,6 +119,24 @@ void jeLogger_assert(struct jeLogger logger, bool value, const char* expressionS
 	}
 }
 
+double jeBenchmark_getSeconds() {
+	return (double)clock() / (double)CLOCKS_PER_SEC;
+}
+void jeBenchmark_log(const char* label, double seconds, uint32_t iterations) {
+	/*Benchmark results are always printed, as they are most useful in optimized builds with logging compiled out*/
+	label = label ? label : "<jeBenchmark_log null label>";
+	iterations = (iterations > 0) ? iterations : 1;
+
+	fprintf(
+		stdout,
+		"[bench] %s: iterations=%u, total=%.3fms, average=%.3fus\n",
+		label,
+		iterations,
+		seconds * 1000.0,
+		(seconds * 1000000.0) / (double)iterations);
+	fflush(stdout);
+}
+
 char* je_temp_buffer_allocate(uint32_t size) {
 	static uint32_t currentSize = 0;
 	static char buffer[JE_TEMP_BUFFER_CAPACITY] = {0};
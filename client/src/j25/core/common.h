@@ -100,6 +100,9 @@ JE_API_PUBLIC void jeLogger_log(struct jeLogger logger, uint32_t loggerLevel, co
 	JE_API_PRINTF(3, 4);
 JE_API_PUBLIC void jeLogger_assert(struct jeLogger logger, bool value, const char* expressionStr);
 
+JE_API_PUBLIC double jeBenchmark_getSeconds();
+JE_API_PUBLIC void jeBenchmark_log(const char* label, double seconds, uint32_t iterations);
+
 JE_API_PUBLIC char* je_temp_buffer_allocate(uint32_t size);
 JE_API_PUBLIC char* je_temp_buffer_allocate_aligned(uint32_t size, uint32_t alignment);
 JE_API_PUBLIC const char* je_temp_buffer_format(const char* formatStr, ...) JE_API_PRINTF(1, 2);
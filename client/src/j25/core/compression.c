@@ -0,0 +1,185 @@
+#include <j25/core/compression.h>
+
+#include <j25/core/common.h>
+#include <j25/core/container.h>
+
+#include <string.h>
+
+#include <zlib.h>
+
+/*deflate can't shrink data by more than about 1032:1, so larger uncompressed sizes mean the prefix is corrupt*/
+#define JE_COMPRESSION_MAX_RATIO 1032U
+
+bool jeCompression_getCompressed(const char* compressed, size_t compressedSize) {
+	return (compressed != NULL) && (compressedSize >= JE_COMPRESSION_PREFIX_SIZE) &&
+		   (memcmp((const void*)compressed, (const void*)JE_COMPRESSION_HEADER, JE_COMPRESSION_HEADER_SIZE) == 0);
+}
+bool jeCompression_compress(struct jeString* outCompressed, const char* data, size_t dataSize, int level) {
+	JE_TRACE("outCompressed=%p, dataSize=%u, level=%d", (void*)outCompressed, (uint32_t)dataSize, level);
+
+	bool ok = true;
+
+	if (outCompressed == NULL) {
+		JE_ERROR("outCompressed=NULL");
+		ok = false;
+	}
+
+	if ((data == NULL) && (dataSize > 0)) {
+		JE_ERROR("data=NULL");
+		ok = false;
+	}
+
+	if (dataSize > (size_t)JE_COMPRESSION_MAX_SIZE) {
+		JE_ERROR("data too large, dataSize=%llu", (unsigned long long)dataSize);
+		ok = false;
+	}
+
+	uLongf compressedSize = 0;
+	if (ok) {
+		compressedSize = compressBound((uLong)dataSize);
+		ok = jeString_setCount(outCompressed, (uint32_t)(JE_COMPRESSION_PREFIX_SIZE + compressedSize));
+	}
+
+	if (ok) {
+		char* prefix = jeString_get(outCompressed, 0);
+		memcpy((void*)prefix, (const void*)JE_COMPRESSION_HEADER, JE_COMPRESSION_HEADER_SIZE);
+		for (uint32_t i = 0; i < 4; i++) {
+			prefix[JE_COMPRESSION_HEADER_SIZE + i] = (char)((dataSize >> (8U * i)) & 0xFFU);
+		}
+
+		int result = compress2(
+			(Bytef*)jeString_get(outCompressed, JE_COMPRESSION_PREFIX_SIZE),
+			&compressedSize,
+			(const Bytef*)((data != NULL) ? data : ""),
+			(uLong)dataSize,
+			level);
+		if (result != Z_OK) {
+			JE_ERROR("compress2() failed, result=%d, dataSize=%u", result, (uint32_t)dataSize);
+			ok = false;
+		}
+	}
+
+	ok = ok && jeString_setCount(outCompressed, (uint32_t)(JE_COMPRESSION_PREFIX_SIZE + compressedSize));
+
+	return ok;
+}
+bool jeCompression_decompress(struct jeString* outData, const char* compressed, size_t compressedSize) {
+	JE_TRACE("outData=%p, compressedSize=%u", (void*)outData, (uint32_t)compressedSize);
+
+	bool ok = true;
+
+	if (outData == NULL) {
+		JE_ERROR("outData=NULL");
+		ok = false;
+	}
+
+	if (ok && !jeCompression_getCompressed(compressed, compressedSize)) {
+		JE_ERROR("data is not compressed, header missing");
+		ok = false;
+	}
+
+	uint64_t dataSize = 0;
+	if (ok) {
+		for (uint32_t i = 0; i < 4; i++) {
+			dataSize |= (uint64_t)(uint8_t)compressed[JE_COMPRESSION_HEADER_SIZE + i] << (8U * i);
+		}
+
+		uint64_t streamSize = (uint64_t)(compressedSize - JE_COMPRESSION_PREFIX_SIZE);
+		if ((dataSize > JE_COMPRESSION_MAX_SIZE) || (dataSize > (streamSize * JE_COMPRESSION_MAX_RATIO))) {
+			JE_ERROR(
+				"invalid uncompressed size, dataSize=%llu, streamSize=%llu",
+				(unsigned long long)dataSize,
+				(unsigned long long)streamSize);
+			ok = false;
+		}
+	}
+
+	/*One spare byte, so that empty data still has a buffer to decompress into*/
+	ok = ok && jeString_setCount(outData, (uint32_t)dataSize + 1);
+
+	if (ok) {
+		uLongf decompressedSize = (uLongf)dataSize;
+		int result = uncompress(
+			(Bytef*)jeString_get(outData, 0),
+			&decompressedSize,
+			(const Bytef*)compressed + JE_COMPRESSION_PREFIX_SIZE,
+			(uLong)(compressedSize - JE_COMPRESSION_PREFIX_SIZE));
+		if ((result != Z_OK) || (decompressedSize != (uLongf)dataSize)) {
+			JE_ERROR("uncompress() failed, result=%d, dataSize=%u", result, (uint32_t)dataSize);
+			ok = false;
+		}
+	}
+
+	ok = ok && jeString_setCount(outData, (uint32_t)dataSize);
+
+	return ok;
+}
+
+void jeCompression_runTests() {
+#if JE_DEBUGGING
+	JE_DEBUG(" ");
+
+	struct jeString data = {0};
+	struct jeString compressed = {0};
+	struct jeString decompressed = {0};
+	JE_ASSERT(jeString_create(&data));
+	JE_ASSERT(jeString_create(&compressed));
+	JE_ASSERT(jeString_create(&decompressed));
+
+	{
+		for (uint32_t i = 0; i < 64; i++) {
+			JE_ASSERT(jeString_push(&data, "compress", 8));
+		}
+
+		JE_ASSERT(jeCompression_compress(&compressed, jeString_get(&data, 0), jeString_getCount(&data), 1));
+		JE_ASSERT(jeCompression_getCompressed(jeString_get(&compressed, 0), jeString_getCount(&compressed)));
+		JE_ASSERT(jeString_getCount(&compressed) < jeString_getCount(&data));
+
+		JE_ASSERT(
+			jeCompression_decompress(&decompressed, jeString_get(&compressed, 0), jeString_getCount(&compressed)));
+		JE_ASSERT(jeString_getCount(&decompressed) == jeString_getCount(&data));
+		JE_ASSERT(memcmp(jeString_get(&decompressed, 0), jeString_get(&data, 0), jeString_getCount(&data)) == 0);
+
+		JE_ASSERT(jeCompression_compress(&compressed, NULL, 0, 9));
+		JE_ASSERT(
+			jeCompression_decompress(&decompressed, jeString_get(&compressed, 0), jeString_getCount(&compressed)));
+		JE_ASSERT(jeString_getCount(&decompressed) == 0);
+
+		JE_ASSERT(!jeCompression_getCompressed(jeString_get(&data, 0), jeString_getCount(&data)));
+	}
+
+	{
+		/*Corrupt data is rejected without trusting the size prefix.  Logging is off while corrupting, which also
+		 * disables asserts, so results are asserted after.*/
+		JE_ASSERT(jeCompression_compress(&compressed, jeString_get(&data, 0), jeString_getCount(&data), 1));
+		char* compressedData = jeString_get(&compressed, 0);
+		uint32_t compressedSize = jeString_getCount(&compressed);
+		uint32_t rejectedCount = 0;
+
+		uint32_t logLevelBackup = jeLogger_getLevel();
+		jeLogger_setLevelOverride(JE_LOG_LEVEL_NONE);
+
+		rejectedCount += !jeCompression_decompress(&decompressed, jeString_get(&data, 0), jeString_getCount(&data));
+		rejectedCount += !jeCompression_decompress(&decompressed, compressedData, compressedSize - 4);
+
+		compressedData[JE_COMPRESSION_HEADER_SIZE + 3] = (char)0xFF;
+		rejectedCount += !jeCompression_decompress(&decompressed, compressedData, compressedSize);
+
+		compressedData[JE_COMPRESSION_HEADER_SIZE + 3] = 0;
+		compressedData[JE_COMPRESSION_HEADER_SIZE]++;
+		rejectedCount += !jeCompression_decompress(&decompressed, compressedData, compressedSize);
+
+		compressedData[JE_COMPRESSION_HEADER_SIZE]--;
+		compressedData[compressedSize / 2] = (char)~compressedData[compressedSize / 2];
+		rejectedCount += !jeCompression_decompress(&decompressed, compressedData, compressedSize);
+
+		jeLogger_setLevelOverride(logLevelBackup);
+
+		JE_ASSERT(rejectedCount == 5);
+	}
+
+	jeString_destroy(&decompressed);
+	jeString_destroy(&compressed);
+	jeString_destroy(&data);
+#endif
+}
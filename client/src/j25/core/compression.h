@@ -0,0 +1,29 @@
+#pragma once
+
+#if !defined(JE_CORE_COMPRESSION_H)
+#define JE_CORE_COMPRESSION_H
+
+#include <j25/core/common.h>
+
+/*Compressed format: the header, the uncompressed size as 4 little endian bytes, then a zlib stream*/
+#define JE_COMPRESSION_HEADER "JEZ1"
+#define JE_COMPRESSION_HEADER_SIZE 4
+#define JE_COMPRESSION_PREFIX_SIZE (JE_COMPRESSION_HEADER_SIZE + 4)
+#define JE_COMPRESSION_DEFAULT_LEVEL 1
+
+/*Uncompressed sizes above this are treated as corrupt, whatever the size in the prefix says*/
+#define JE_COMPRESSION_MAX_SIZE (256U * 1024U * 1024U)
+
+struct jeString;
+
+JE_API_PUBLIC bool jeCompression_getCompressed(const char* compressed, size_t compressedSize);
+/*Replaces the contents of outCompressed*/
+JE_API_PUBLIC bool jeCompression_compress(
+	struct jeString* outCompressed, const char* data, size_t dataSize, int level);
+/*Replaces the contents of outData.  The uncompressed size is checked against the compressed size before anything is
+ * allocated, so corrupt or truncated data fails cleanly.*/
+JE_API_PUBLIC bool jeCompression_decompress(struct jeString* outData, const char* compressed, size_t compressedSize);
+
+JE_API_PUBLIC void jeCompression_runTests();
+
+#endif
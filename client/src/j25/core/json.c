@@ -0,0 +1,708 @@
+#include <j25/core/json.h>
+
+#include <j25/core/common.h>
+#include <j25/core/container.h>
+
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define JE_JSON_IS_SPACE(CHARACTER) \
+	(((CHARACTER) == ' ') || ((CHARACTER) == '\t') || ((CHARACTER) == '\r') || ((CHARACTER) == '\n'))
+#define JE_JSON_IS_DELIMITER(CHARACTER) \
+	(JE_JSON_IS_SPACE(CHARACTER) || ((CHARACTER) == ']') || ((CHARACTER) == '}') || ((CHARACTER) == ','))
+
+size_t jeJsonDecoder_getTokenEnd(const struct jeJsonDecoder* decoder);
+bool jeJsonDecoder_readHex(const struct jeJsonDecoder* decoder, size_t pos, uint32_t* outValue);
+
+bool jeJsonEncoder_create(struct jeJsonEncoder* encoder) {
+	JE_TRACE("encoder=%p", (void*)encoder);
+
+	bool ok = true;
+
+	if (encoder == NULL) {
+		JE_ERROR("encoder=NULL");
+		ok = false;
+	}
+
+	if (ok) {
+		encoder->error[0] = '\0';
+	}
+
+	ok = ok && jeString_create(&encoder->data);
+
+	return ok;
+}
+void jeJsonEncoder_destroy(struct jeJsonEncoder* encoder) {
+	JE_TRACE("encoder=%p", (void*)encoder);
+
+	if (encoder != NULL) {
+		jeString_destroy(&encoder->data);
+	}
+}
+void jeJsonEncoder_setError(struct jeJsonEncoder* encoder, const char* formatStr, ...) {
+	va_list args = {0};
+	va_start(args, formatStr);
+	vsnprintf(encoder->error, sizeof(encoder->error), formatStr, args);
+	va_end(args);
+}
+bool jeJsonEncoder_pushNull(struct jeJsonEncoder* encoder) {
+	return jeString_push(&encoder->data, "null", 4);
+}
+bool jeJsonEncoder_pushBoolean(struct jeJsonEncoder* encoder, bool value) {
+	return value ? jeString_push(&encoder->data, "true", 4) : jeString_push(&encoder->data, "false", 5);
+}
+bool jeJsonEncoder_pushNumber(struct jeJsonEncoder* encoder, double value) {
+	bool ok = true;
+
+	if (!isfinite(value)) {
+		jeJsonEncoder_setError(
+			encoder, "unexpected number value '%s'", isnan(value) ? "nan" : ((value > 0) ? "inf" : "-inf"));
+		ok = false;
+	}
+
+	/*Same precision as engine/lib/json*/
+	char encoded[32];
+	int encodedSize = ok ? snprintf(encoded, sizeof(encoded), "%.14g", value) : 0;
+
+	ok = ok && (encodedSize > 0) && jeString_push(&encoder->data, encoded, (uint32_t)encodedSize);
+
+	return ok;
+}
+bool jeJsonEncoder_pushString(struct jeJsonEncoder* encoder, const char* string, size_t stringSize) {
+	static const char hexDigits[] = "0123456789abcdef";
+
+	bool ok = jeString_push(&encoder->data, "\"", 1);
+
+	/*Runs of characters that need no escaping are pushed at once*/
+	size_t runStart = 0;
+	for (size_t i = 0; ok && (i <= stringSize); i++) {
+		unsigned char character = (i < stringSize) ? (unsigned char)string[i] : 0;
+		bool escaped = (i < stringSize) && ((character < 32) || (character == '\\') || (character == '"'));
+
+		if ((escaped || (i == stringSize)) && (i > runStart)) {
+			ok = jeString_push(&encoder->data, &string[runStart], (uint32_t)(i - runStart));
+		}
+
+		if (ok && escaped) {
+			char escape[6] = {'\\', (char)character, 0, 0, 0, 0};
+			uint32_t escapeSize = 2;
+			switch (character) {
+				case '\b': {
+					escape[1] = 'b';
+					break;
+				}
+				case '\f': {
+					escape[1] = 'f';
+					break;
+				}
+				case '\n': {
+					escape[1] = 'n';
+					break;
+				}
+				case '\r': {
+					escape[1] = 'r';
+					break;
+				}
+				case '\t': {
+					escape[1] = 't';
+					break;
+				}
+				case '\\':
+				case '"': {
+					break;
+				}
+				default: {
+					escape[1] = 'u';
+					escape[2] = '0';
+					escape[3] = '0';
+					escape[4] = hexDigits[character >> 4U];
+					escape[5] = hexDigits[character & 0xFU];
+					escapeSize = 6;
+					break;
+				}
+			}
+
+			ok = jeString_push(&encoder->data, escape, escapeSize);
+			runStart = i + 1;
+		}
+	}
+
+	ok = ok && jeString_push(&encoder->data, "\"", 1);
+
+	return ok;
+}
+bool jeJsonEncoder_pushSyntax(struct jeJsonEncoder* encoder, char syntax) {
+	return jeString_push(&encoder->data, &syntax, 1);
+}
+
+bool jeJsonDecoder_create(struct jeJsonDecoder* decoder, const char* data, size_t size) {
+	JE_TRACE("decoder=%p, size=%u", (void*)decoder, (uint32_t)size);
+
+	bool ok = true;
+
+	if (decoder == NULL) {
+		JE_ERROR("decoder=NULL");
+		ok = false;
+	}
+
+	if (decoder != NULL) {
+		memset((void*)decoder, 0, sizeof(struct jeJsonDecoder));
+	}
+
+	if (data == NULL) {
+		JE_ERROR("data=NULL");
+		ok = false;
+	}
+
+	if (ok) {
+		decoder->data = data;
+		decoder->size = size;
+	}
+
+	ok = ok && jeString_create(&decoder->scratch);
+
+	return ok;
+}
+void jeJsonDecoder_destroy(struct jeJsonDecoder* decoder) {
+	JE_TRACE("decoder=%p", (void*)decoder);
+
+	if (decoder != NULL) {
+		jeString_destroy(&decoder->scratch);
+	}
+}
+void jeJsonDecoder_setError(struct jeJsonDecoder* decoder, size_t pos, const char* formatStr, ...) {
+	uint32_t line = 1;
+	uint32_t column = 1;
+	for (size_t i = 0; i < pos; i++) {
+		column++;
+		if ((i < decoder->size) && (decoder->data[i] == '\n')) {
+			line++;
+			column = 1;
+		}
+	}
+
+	char error[JE_JSON_ERROR_SIZE];
+	va_list args = {0};
+	va_start(args, formatStr);
+	vsnprintf(error, sizeof(error), formatStr, args);
+	va_end(args);
+
+	snprintf(decoder->error, sizeof(decoder->error), "%.200s at line %u col %u", error, line, column);
+}
+void jeJsonDecoder_skipSpace(struct jeJsonDecoder* decoder) {
+	while ((decoder->pos < decoder->size) && JE_JSON_IS_SPACE(decoder->data[decoder->pos])) {
+		decoder->pos++;
+	}
+}
+size_t jeJsonDecoder_getTokenEnd(const struct jeJsonDecoder* decoder) {
+	size_t tokenEnd = decoder->pos;
+	while ((tokenEnd < decoder->size) && !JE_JSON_IS_DELIMITER(decoder->data[tokenEnd])) {
+		tokenEnd++;
+	}
+
+	return tokenEnd;
+}
+bool jeJsonDecoder_readHex(const struct jeJsonDecoder* decoder, size_t pos, uint32_t* outValue) {
+	bool ok = (pos + 4) <= decoder->size;
+	uint32_t value = 0;
+
+	for (size_t i = pos; ok && (i < (pos + 4)); i++) {
+		char digit = decoder->data[i];
+		ok = isxdigit((unsigned char)digit) != 0;
+		int digitValue = isdigit((unsigned char)digit) ? (digit - '0') : ((tolower((unsigned char)digit) - 'a') + 10);
+		value = (value << 4U) | (uint32_t)digitValue;
+	}
+
+	*outValue = value;
+	return ok;
+}
+uint32_t jeJsonDecoder_getNextType(struct jeJsonDecoder* decoder) {
+	char character = (decoder->pos < decoder->size) ? decoder->data[decoder->pos] : '\0';
+	uint32_t type = JE_JSON_TYPE_INVALID;
+
+	if ((character == '-') || isdigit((unsigned char)character)) {
+		type = JE_JSON_TYPE_NUMBER;
+	} else if (character == '"') {
+		type = JE_JSON_TYPE_STRING;
+	} else if ((character == 't') || (character == 'f') || (character == 'n')) {
+		type = JE_JSON_TYPE_LITERAL;
+	} else if (character == '[') {
+		type = JE_JSON_TYPE_ARRAY;
+	} else if (character == '{') {
+		type = JE_JSON_TYPE_OBJECT;
+	} else {
+		int characterSize = (character != '\0') ? 1 : 0;
+		jeJsonDecoder_setError(decoder, decoder->pos, "unexpected character '%.*s'", characterSize, &character);
+	}
+
+	return type;
+}
+bool jeJsonDecoder_readNumber(struct jeJsonDecoder* decoder, double* outValue) {
+	bool ok = true;
+
+	/*Numbers run to the next delimiter, like engine/lib/json; strtod() parses what tonumber() does, and has to
+	 * consume all of it.  The data is null terminated, so strtod() can't read past it.*/
+	size_t tokenEnd = jeJsonDecoder_getTokenEnd(decoder);
+	char* numberEnd = NULL;
+	double value = strtod(&decoder->data[decoder->pos], &numberEnd);
+
+	if ((tokenEnd == decoder->pos) || (numberEnd != &decoder->data[tokenEnd])) {
+		jeJsonDecoder_setError(
+			decoder,
+			decoder->pos,
+			"invalid number '%.*s'",
+			(int)(tokenEnd - decoder->pos),
+			&decoder->data[decoder->pos]);
+		ok = false;
+	}
+
+	if (ok) {
+		*outValue = value;
+		decoder->pos = tokenEnd;
+	}
+
+	return ok;
+}
+bool jeJsonDecoder_readString(struct jeJsonDecoder* decoder, const char** outString, size_t* outStringSize) {
+	bool ok = true;
+	size_t start = decoder->pos;
+	size_t pos = start + 1;
+	size_t runStart = pos;
+	bool escaped = false;
+
+	if ((start >= decoder->size) || (decoder->data[start] != '"')) {
+		jeJsonDecoder_setError(decoder, start, "expected string");
+		ok = false;
+	}
+
+	ok = ok && jeString_setCount(&decoder->scratch, 0);
+
+	while (ok && (pos < decoder->size) && (decoder->data[pos] != '"')) {
+		unsigned char character = (unsigned char)decoder->data[pos];
+
+		if (character < 32) {
+			jeJsonDecoder_setError(decoder, pos, "control character in string");
+			ok = false;
+		} else if (character == '\\') {
+			/*Unescaped runs are only copied once the string turns out to have escapes*/
+			escaped = true;
+			if (pos > runStart) {
+				ok = jeString_push(&decoder->scratch, &decoder->data[runStart], (uint32_t)(pos - runStart));
+			}
+
+			char escape = ((pos + 1) < decoder->size) ? decoder->data[pos + 1] : '\0';
+			char unescaped[4];
+			uint32_t unescapedSize = 1;
+			unescaped[0] = escape;
+
+			switch (escape) {
+				case 'b': {
+					unescaped[0] = '\b';
+					break;
+				}
+				case 'f': {
+					unescaped[0] = '\f';
+					break;
+				}
+				case 'n': {
+					unescaped[0] = '\n';
+					break;
+				}
+				case 'r': {
+					unescaped[0] = '\r';
+					break;
+				}
+				case 't': {
+					unescaped[0] = '\t';
+					break;
+				}
+				case '\\':
+				case '/':
+				case '"': {
+					break;
+				}
+				case 'u': {
+					uint32_t codepoint = 0;
+					uint32_t lowSurrogate = 0;
+					if (!jeJsonDecoder_readHex(decoder, pos + 2, &codepoint)) {
+						jeJsonDecoder_setError(decoder, pos, "invalid unicode escape in string");
+						ok = false;
+						break;
+					}
+					pos += 4;
+
+					if ((codepoint >= 0xD800) && (codepoint <= 0xDBFF) && ((pos + 3) < decoder->size) &&
+						(decoder->data[pos + 2] == '\\') && (decoder->data[pos + 3] == 'u') &&
+						jeJsonDecoder_readHex(decoder, pos + 4, &lowSurrogate)) {
+						codepoint = ((codepoint - 0xD800) * 0x400) + (lowSurrogate - 0xDC00) + 0x10000;
+						pos += 6;
+					}
+
+					if (codepoint <= 0x7F) {
+						unescaped[0] = (char)codepoint;
+					} else if (codepoint <= 0x7FF) {
+						unescaped[0] = (char)(0xC0 | (codepoint >> 6U));
+						unescaped[1] = (char)(0x80 | (codepoint & 0x3FU));
+						unescapedSize = 2;
+					} else if (codepoint <= 0xFFFF) {
+						unescaped[0] = (char)(0xE0 | (codepoint >> 12U));
+						unescaped[1] = (char)(0x80 | ((codepoint >> 6U) & 0x3FU));
+						unescaped[2] = (char)(0x80 | (codepoint & 0x3FU));
+						unescapedSize = 3;
+					} else if (codepoint <= 0x10FFFF) {
+						unescaped[0] = (char)(0xF0 | (codepoint >> 18U));
+						unescaped[1] = (char)(0x80 | ((codepoint >> 12U) & 0x3FU));
+						unescaped[2] = (char)(0x80 | ((codepoint >> 6U) & 0x3FU));
+						unescaped[3] = (char)(0x80 | (codepoint & 0x3FU));
+						unescapedSize = 4;
+					} else {
+						jeJsonDecoder_setError(decoder, pos, "invalid unicode codepoint");
+						ok = false;
+					}
+					break;
+				}
+				default: {
+					jeJsonDecoder_setError(decoder, pos, "invalid escape char '%c' in string", escape);
+					ok = false;
+					break;
+				}
+			}
+
+			ok = ok && jeString_push(&decoder->scratch, unescaped, unescapedSize);
+			pos += 2;
+			runStart = pos;
+		} else {
+			pos++;
+		}
+	}
+
+	if (ok && (pos >= decoder->size)) {
+		jeJsonDecoder_setError(decoder, start, "expected closing quote for string");
+		ok = false;
+	}
+
+	if (ok && escaped && (pos > runStart)) {
+		ok = jeString_push(&decoder->scratch, &decoder->data[runStart], (uint32_t)(pos - runStart));
+	}
+
+	if (ok) {
+		if (escaped) {
+			*outString = jeString_get(&decoder->scratch, 0);
+			*outStringSize = (size_t)jeString_getCount(&decoder->scratch);
+		} else {
+			*outString = &decoder->data[start + 1];
+			*outStringSize = pos - (start + 1);
+		}
+
+		decoder->pos = pos + 1;
+	}
+
+	return ok;
+}
+bool jeJsonDecoder_readLiteral(struct jeJsonDecoder* decoder, uint32_t* outLiteral) {
+	bool ok = true;
+
+	size_t tokenEnd = jeJsonDecoder_getTokenEnd(decoder);
+	size_t tokenSize = tokenEnd - decoder->pos;
+	const char* token = &decoder->data[decoder->pos];
+
+	if ((tokenSize == 4) && (memcmp(token, "null", 4) == 0)) {
+		*outLiteral = JE_JSON_LITERAL_NULL;
+	} else if ((tokenSize == 5) && (memcmp(token, "false", 5) == 0)) {
+		*outLiteral = JE_JSON_LITERAL_FALSE;
+	} else if ((tokenSize == 4) && (memcmp(token, "true", 4) == 0)) {
+		*outLiteral = JE_JSON_LITERAL_TRUE;
+	} else {
+		jeJsonDecoder_setError(decoder, decoder->pos, "invalid literal '%.*s'", (int)tokenSize, token);
+		ok = false;
+	}
+
+	decoder->pos = tokenEnd;
+
+	return ok;
+}
+bool jeJsonDecoder_readOpening(struct jeJsonDecoder* decoder, char opening) {
+	bool ok = true;
+
+	if ((decoder->pos >= decoder->size) || (decoder->data[decoder->pos] != opening)) {
+		jeJsonDecoder_setError(decoder, decoder->pos, "expected '%c'", opening);
+		ok = false;
+	}
+
+	if (ok) {
+		decoder->pos++;
+	}
+
+	return ok;
+}
+bool jeJsonDecoder_readClosing(struct jeJsonDecoder* decoder, char closing) {
+	bool closed = false;
+
+	jeJsonDecoder_skipSpace(decoder);
+	if ((decoder->pos < decoder->size) && (decoder->data[decoder->pos] == closing)) {
+		decoder->pos++;
+		closed = true;
+	}
+
+	return closed;
+}
+bool jeJsonDecoder_readSeparator(struct jeJsonDecoder* decoder, char closing, bool* outClosed) {
+	bool ok = true;
+
+	jeJsonDecoder_skipSpace(decoder);
+	char delimiter = (decoder->pos < decoder->size) ? decoder->data[decoder->pos] : '\0';
+	decoder->pos++;
+
+	*outClosed = (delimiter == closing);
+	if (!*outClosed && (delimiter != ',')) {
+		jeJsonDecoder_setError(decoder, decoder->pos, "expected '%c' or ','", closing);
+		ok = false;
+	}
+
+	return ok;
+}
+bool jeJsonDecoder_readKey(struct jeJsonDecoder* decoder, const char** outKey, size_t* outKeySize) {
+	bool ok = true;
+
+	if ((decoder->pos >= decoder->size) || (decoder->data[decoder->pos] != '"')) {
+		jeJsonDecoder_setError(decoder, decoder->pos, "expected string for key");
+		ok = false;
+	}
+
+	ok = ok && jeJsonDecoder_readString(decoder, outKey, outKeySize);
+
+	if (ok) {
+		jeJsonDecoder_skipSpace(decoder);
+		if ((decoder->pos >= decoder->size) || (decoder->data[decoder->pos] != ':')) {
+			jeJsonDecoder_setError(decoder, decoder->pos, "expected ':' after key");
+			ok = false;
+		}
+	}
+
+	if (ok) {
+		decoder->pos++;
+		jeJsonDecoder_skipSpace(decoder);
+	}
+
+	return ok;
+}
+bool jeJsonDecoder_readEnd(struct jeJsonDecoder* decoder) {
+	bool ok = true;
+
+	jeJsonDecoder_skipSpace(decoder);
+	if (decoder->pos < decoder->size) {
+		jeJsonDecoder_setError(decoder, decoder->pos, "trailing garbage");
+		ok = false;
+	}
+
+	return ok;
+}
+
+void jeJson_runTests() {
+#if JE_DEBUGGING
+	JE_DEBUG(" ");
+
+	{
+		/*{"a":[1,0.1,1e+300,"q\"\\\n\1",true,false,null],"b":{}} written by hand, the way a caller walking its
+		 * values would*/
+		static const char expected[] = "{\"a\":[1,0.1,1e+300,\"q\\\"\\\\\\n\\u0001\",true,false,null],\"b\":{}}";
+
+		struct jeJsonEncoder encoder;
+		JE_ASSERT(jeJsonEncoder_create(&encoder));
+		JE_ASSERT(jeJsonEncoder_pushSyntax(&encoder, '{'));
+		JE_ASSERT(jeJsonEncoder_pushString(&encoder, "a", 1));
+		JE_ASSERT(jeJsonEncoder_pushSyntax(&encoder, ':'));
+		JE_ASSERT(jeJsonEncoder_pushSyntax(&encoder, '['));
+		JE_ASSERT(jeJsonEncoder_pushNumber(&encoder, 1.0));
+		JE_ASSERT(jeJsonEncoder_pushSyntax(&encoder, ','));
+		JE_ASSERT(jeJsonEncoder_pushNumber(&encoder, 0.1));
+		JE_ASSERT(jeJsonEncoder_pushSyntax(&encoder, ','));
+		JE_ASSERT(jeJsonEncoder_pushNumber(&encoder, 1e300));
+		JE_ASSERT(jeJsonEncoder_pushSyntax(&encoder, ','));
+		JE_ASSERT(jeJsonEncoder_pushString(&encoder, "q\"\\\n\1", 5));
+		JE_ASSERT(jeJsonEncoder_pushSyntax(&encoder, ','));
+		JE_ASSERT(jeJsonEncoder_pushBoolean(&encoder, true));
+		JE_ASSERT(jeJsonEncoder_pushSyntax(&encoder, ','));
+		JE_ASSERT(jeJsonEncoder_pushBoolean(&encoder, false));
+		JE_ASSERT(jeJsonEncoder_pushSyntax(&encoder, ','));
+		JE_ASSERT(jeJsonEncoder_pushNull(&encoder));
+		JE_ASSERT(jeJsonEncoder_pushSyntax(&encoder, ']'));
+		JE_ASSERT(jeJsonEncoder_pushSyntax(&encoder, ','));
+		JE_ASSERT(jeJsonEncoder_pushString(&encoder, "b", 1));
+		JE_ASSERT(jeJsonEncoder_pushSyntax(&encoder, ':'));
+		JE_ASSERT(jeJsonEncoder_pushSyntax(&encoder, '{'));
+		JE_ASSERT(jeJsonEncoder_pushSyntax(&encoder, '}'));
+		JE_ASSERT(jeJsonEncoder_pushSyntax(&encoder, '}'));
+
+		JE_ASSERT(jeString_getCount(&encoder.data) == (sizeof(expected) - 1));
+		JE_ASSERT(memcmp(jeString_get(&encoder.data, 0), expected, sizeof(expected) - 1) == 0);
+
+		JE_ASSERT(!jeJsonEncoder_pushNumber(&encoder, HUGE_VAL));
+		JE_ASSERT(strcmp(encoder.error, "unexpected number value 'inf'") == 0);
+		JE_ASSERT(!jeJsonEncoder_pushNumber(&encoder, -HUGE_VAL));
+		JE_ASSERT(strcmp(encoder.error, "unexpected number value '-inf'") == 0);
+		JE_ASSERT(!jeJsonEncoder_pushNumber(&encoder, NAN));
+		JE_ASSERT(strcmp(encoder.error, "unexpected number value 'nan'") == 0);
+		JE_ASSERT(jeString_getCount(&encoder.data) == (sizeof(expected) - 1));
+
+		jeJsonEncoder_destroy(&encoder);
+	}
+
+	{
+		/*Read back by hand.  Escaped strings are unescaped, surrogate pairs included; trailing commas are allowed.*/
+		static const char json[] =
+			" {\"a\" : [1, -2.5e1, \"b\\n\\u00e9\\ud83d\\ude00\", true, false, null,], \"b\\\"\":{}}\n";
+
+		struct jeJsonDecoder decoder;
+		double number = 0.0;
+		const char* string = NULL;
+		size_t stringSize = 0;
+		uint32_t literal = JE_JSON_LITERAL_NULL;
+		bool closed = false;
+
+		JE_ASSERT(jeJsonDecoder_create(&decoder, json, sizeof(json) - 1));
+		jeJsonDecoder_skipSpace(&decoder);
+		JE_ASSERT(jeJsonDecoder_getNextType(&decoder) == JE_JSON_TYPE_OBJECT);
+		JE_ASSERT(jeJsonDecoder_readOpening(&decoder, '{'));
+		JE_ASSERT(!jeJsonDecoder_readClosing(&decoder, '}'));
+		JE_ASSERT(jeJsonDecoder_readKey(&decoder, &string, &stringSize));
+		JE_ASSERT((stringSize == 1) && (string[0] == 'a') && (string == &json[3]));
+
+		JE_ASSERT(jeJsonDecoder_getNextType(&decoder) == JE_JSON_TYPE_ARRAY);
+		JE_ASSERT(jeJsonDecoder_readOpening(&decoder, '['));
+		JE_ASSERT(!jeJsonDecoder_readClosing(&decoder, ']'));
+		JE_ASSERT(jeJsonDecoder_getNextType(&decoder) == JE_JSON_TYPE_NUMBER);
+		JE_ASSERT(jeJsonDecoder_readNumber(&decoder, &number) && (number == 1.0));
+		JE_ASSERT(jeJsonDecoder_readSeparator(&decoder, ']', &closed) && !closed);
+		JE_ASSERT(!jeJsonDecoder_readClosing(&decoder, ']'));
+		JE_ASSERT(jeJsonDecoder_readNumber(&decoder, &number) && (number == -25.0));
+		JE_ASSERT(jeJsonDecoder_readSeparator(&decoder, ']', &closed) && !closed);
+		JE_ASSERT(!jeJsonDecoder_readClosing(&decoder, ']'));
+		JE_ASSERT(jeJsonDecoder_getNextType(&decoder) == JE_JSON_TYPE_STRING);
+		JE_ASSERT(jeJsonDecoder_readString(&decoder, &string, &stringSize));
+		JE_ASSERT((stringSize == 8) && (memcmp(string, "b\n\xC3\xA9\xF0\x9F\x98\x80", 8) == 0));
+		JE_ASSERT(jeJsonDecoder_readSeparator(&decoder, ']', &closed) && !closed);
+		JE_ASSERT(!jeJsonDecoder_readClosing(&decoder, ']'));
+		JE_ASSERT(jeJsonDecoder_getNextType(&decoder) == JE_JSON_TYPE_LITERAL);
+		JE_ASSERT(jeJsonDecoder_readLiteral(&decoder, &literal) && (literal == JE_JSON_LITERAL_TRUE));
+		JE_ASSERT(jeJsonDecoder_readSeparator(&decoder, ']', &closed) && !closed);
+		JE_ASSERT(!jeJsonDecoder_readClosing(&decoder, ']'));
+		JE_ASSERT(jeJsonDecoder_readLiteral(&decoder, &literal) && (literal == JE_JSON_LITERAL_FALSE));
+		JE_ASSERT(jeJsonDecoder_readSeparator(&decoder, ']', &closed) && !closed);
+		JE_ASSERT(!jeJsonDecoder_readClosing(&decoder, ']'));
+		JE_ASSERT(jeJsonDecoder_readLiteral(&decoder, &literal) && (literal == JE_JSON_LITERAL_NULL));
+		JE_ASSERT(jeJsonDecoder_readSeparator(&decoder, ']', &closed) && !closed);
+		JE_ASSERT(jeJsonDecoder_readClosing(&decoder, ']'));
+
+		JE_ASSERT(jeJsonDecoder_readSeparator(&decoder, '}', &closed) && !closed);
+		JE_ASSERT(!jeJsonDecoder_readClosing(&decoder, '}'));
+		JE_ASSERT(jeJsonDecoder_readKey(&decoder, &string, &stringSize));
+		JE_ASSERT((stringSize == 2) && (memcmp(string, "b\"", 2) == 0));
+		JE_ASSERT(jeJsonDecoder_readOpening(&decoder, '{'));
+		JE_ASSERT(jeJsonDecoder_readClosing(&decoder, '}'));
+		JE_ASSERT(jeJsonDecoder_readSeparator(&decoder, '}', &closed) && closed);
+		JE_ASSERT(jeJsonDecoder_readEnd(&decoder));
+
+		jeJsonDecoder_destroy(&decoder);
+	}
+
+	{
+		/*Invalid json is rejected with the error's position, whichever read finds it.  Each document is walked the way
+		 * a caller would, with a stack of the containers it is in.*/
+		static const char* const invalidJsons[][2] = {
+			{"1.2.3", "invalid number '1.2.3' at line 1 col 1"},
+			{"[1,\n -]", "invalid number '-' at line 2 col 2"},
+			{"\"a\\x\"", "invalid escape char 'x' in string at line 1 col 3"},
+			{"\"a\nb\"", "control character in string at line 1 col 3"},
+			{"[\"abc]", "expected closing quote for string at line 1 col 2"},
+			{"\"\\u12\"", "invalid unicode escape in string at line 1 col 2"},
+			{"[nul]", "invalid literal 'nul' at line 1 col 2"},
+			{"\n  x", "unexpected character 'x' at line 2 col 3"},
+			{"[1 2]", "expected ']' or ',' at line 1 col 5"},
+			{"{1:2}", "expected string for key at line 1 col 2"},
+			{"{\"a\" 1}", "expected ':' after key at line 1 col 6"},
+			{"{\"a\":1 ", "expected '}' or ',' at line 1 col 9"},
+			{"1 x", "trailing garbage at line 1 col 3"},
+		};
+
+		uint32_t rejectedCount = 0;
+		for (uint32_t i = 0; i < (sizeof(invalidJsons) / sizeof(invalidJsons[0])); i++) {
+			const char* json = invalidJsons[i][0];
+			char closings[8];
+			uint32_t closingCount = 0;
+			bool valueNext = true;
+			bool done = false;
+			double number = 0.0;
+			const char* string = NULL;
+			size_t stringSize = 0;
+			uint32_t literal = JE_JSON_LITERAL_NULL;
+
+			struct jeJsonDecoder decoder;
+			bool ok = jeJsonDecoder_create(&decoder, json, strlen(json));
+			jeJsonDecoder_skipSpace(&decoder);
+
+			while (ok && !done) {
+				char closing = (closingCount > 0) ? closings[closingCount - 1] : '\0';
+
+				if (!valueNext && (closingCount == 0)) {
+					ok = jeJsonDecoder_readEnd(&decoder);
+					done = true;
+				} else if (!valueNext) {
+					bool closed = false;
+					ok = jeJsonDecoder_readSeparator(&decoder, closing, &closed);
+					closingCount -= closed ? 1 : 0;
+					valueNext = !closed;
+				} else if ((closingCount > 0) && jeJsonDecoder_readClosing(&decoder, closing)) {
+					closingCount--;
+					valueNext = false;
+				} else {
+					if (closing == '}') {
+						ok = jeJsonDecoder_readKey(&decoder, &string, &stringSize);
+					}
+
+					uint32_t type = ok ? jeJsonDecoder_getNextType(&decoder) : JE_JSON_TYPE_INVALID;
+					ok = ok && (type != JE_JSON_TYPE_INVALID) && (closingCount < sizeof(closings));
+					valueNext = false;
+					switch (ok ? type : JE_JSON_TYPE_INVALID) {
+						case JE_JSON_TYPE_NUMBER: {
+							ok = jeJsonDecoder_readNumber(&decoder, &number);
+							break;
+						}
+						case JE_JSON_TYPE_STRING: {
+							ok = jeJsonDecoder_readString(&decoder, &string, &stringSize);
+							break;
+						}
+						case JE_JSON_TYPE_LITERAL: {
+							ok = jeJsonDecoder_readLiteral(&decoder, &literal);
+							break;
+						}
+						case JE_JSON_TYPE_ARRAY:
+						case JE_JSON_TYPE_OBJECT: {
+							bool isArray = (type == JE_JSON_TYPE_ARRAY);
+							ok = jeJsonDecoder_readOpening(&decoder, isArray ? '[' : '{');
+							closings[closingCount] = isArray ? ']' : '}';
+							closingCount++;
+							valueNext = true;
+							break;
+						}
+						default: {
+							break;
+						}
+					}
+				}
+			}
+
+			JE_ASSERT(!ok);
+			JE_ASSERT(strcmp(decoder.error, invalidJsons[i][1]) == 0);
+			rejectedCount += !ok;
+
+			jeJsonDecoder_destroy(&decoder);
+		}
+
+		JE_ASSERT(rejectedCount == (sizeof(invalidJsons) / sizeof(invalidJsons[0])));
+	}
+#endif
+}
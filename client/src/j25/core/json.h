@@ -0,0 +1,77 @@
+#pragma once
+
+#if !defined(JE_CORE_JSON_H)
+#define JE_CORE_JSON_H
+
+#include <j25/core/common.h>
+#include <j25/core/container.h>
+
+/*Mirrors the rules of engine/lib/json/json.lua, so the two can be swapped freely*/
+#define JE_JSON_MAX_DEPTH 512U
+#define JE_JSON_ERROR_SIZE 256
+#define JE_JSON_TYPE_INVALID 0
+#define JE_JSON_TYPE_NUMBER 1
+#define JE_JSON_TYPE_STRING 2
+#define JE_JSON_TYPE_LITERAL 3
+#define JE_JSON_TYPE_ARRAY 4
+#define JE_JSON_TYPE_OBJECT 5
+#define JE_JSON_LITERAL_NULL 0
+#define JE_JSON_LITERAL_FALSE 1
+#define JE_JSON_LITERAL_TRUE 2
+
+/*Writes json text; the caller walks its values.  Errors are not logged, but formatted into error, so that they can be
+ * raised the way engine/lib/json raises them.*/
+struct jeJsonEncoder {
+	struct jeString data;
+	char error[JE_JSON_ERROR_SIZE];
+};
+
+/*Reads json text; the caller walks its values.  Errors are formatted into error, with the line and column.  Strings
+ * with escapes are unescaped into scratch.*/
+struct jeJsonDecoder {
+	const char* data;
+	size_t size;
+	size_t pos;
+	struct jeString scratch;
+	char error[JE_JSON_ERROR_SIZE];
+};
+
+JE_API_PUBLIC bool jeJsonEncoder_create(struct jeJsonEncoder* encoder);
+JE_API_PUBLIC void jeJsonEncoder_destroy(struct jeJsonEncoder* encoder);
+JE_API_PUBLIC void jeJsonEncoder_setError(struct jeJsonEncoder* encoder, const char* formatStr, ...)
+	JE_API_PRINTF(2, 3);
+JE_API_PUBLIC bool jeJsonEncoder_pushNull(struct jeJsonEncoder* encoder);
+JE_API_PUBLIC bool jeJsonEncoder_pushBoolean(struct jeJsonEncoder* encoder, bool value);
+/*Non-finite numbers have no json representation, and are errors*/
+JE_API_PUBLIC bool jeJsonEncoder_pushNumber(struct jeJsonEncoder* encoder, double value);
+JE_API_PUBLIC bool jeJsonEncoder_pushString(struct jeJsonEncoder* encoder, const char* string, size_t stringSize);
+/*One of '[', ']', '{', '}', ',' or ':'*/
+JE_API_PUBLIC bool jeJsonEncoder_pushSyntax(struct jeJsonEncoder* encoder, char syntax);
+
+/*The data must be null terminated after size bytes (as lua strings are), so numbers can be parsed in place*/
+JE_API_PUBLIC bool jeJsonDecoder_create(struct jeJsonDecoder* decoder, const char* data, size_t size);
+JE_API_PUBLIC void jeJsonDecoder_destroy(struct jeJsonDecoder* decoder);
+JE_API_PUBLIC void jeJsonDecoder_setError(struct jeJsonDecoder* decoder, size_t pos, const char* formatStr, ...)
+	JE_API_PRINTF(3, 4);
+JE_API_PUBLIC void jeJsonDecoder_skipSpace(struct jeJsonDecoder* decoder);
+/*Returns the type of the value starting at the current position, without reading it*/
+JE_API_PUBLIC uint32_t jeJsonDecoder_getNextType(struct jeJsonDecoder* decoder);
+JE_API_PUBLIC bool jeJsonDecoder_readNumber(struct jeJsonDecoder* decoder, double* outValue);
+/*The string is only copied (into scratch) if it has escapes, is not null terminated, and is valid until the next read*/
+JE_API_PUBLIC bool jeJsonDecoder_readString(
+	struct jeJsonDecoder* decoder, const char** outString, size_t* outStringSize);
+JE_API_PUBLIC bool jeJsonDecoder_readLiteral(struct jeJsonDecoder* decoder, uint32_t* outLiteral);
+/*Reads the '[' or '{' that starts an array or object*/
+JE_API_PUBLIC bool jeJsonDecoder_readOpening(struct jeJsonDecoder* decoder, char opening);
+/*Skips space, then reads the closing ']' or '}' if it is next.  Trailing commas are allowed, like engine/lib/json.*/
+JE_API_PUBLIC bool jeJsonDecoder_readClosing(struct jeJsonDecoder* decoder, char closing);
+/*Reads the ',' or closing ']' or '}' after an element*/
+JE_API_PUBLIC bool jeJsonDecoder_readSeparator(struct jeJsonDecoder* decoder, char closing, bool* outClosed);
+/*Reads an object key and the ':' after it, like jeJsonDecoder_readString()*/
+JE_API_PUBLIC bool jeJsonDecoder_readKey(struct jeJsonDecoder* decoder, const char** outKey, size_t* outKeySize);
+/*Skips trailing space, which must be all that is left*/
+JE_API_PUBLIC bool jeJsonDecoder_readEnd(struct jeJsonDecoder* decoder);
+
+JE_API_PUBLIC void jeJson_runTests();
+
+#endif
@@ -0,0 +1,607 @@
+#include <j25/core/spatial.h>
+
+#include <j25/core/common.h>
+#include <j25/core/container.h>
+
+#include <math.h>
+#include <string.h>
+
+uint64_t jeSpatial_getCellKey(int32_t cellX, int32_t cellY);
+int32_t jeSpatial_getCellCoord(double pos, double cellSize);
+void jeSpatial_getCellBounds(double cellSize, double x, double y, double w, double h, int32_t* outCellBounds);
+bool jeSpatialEntity_getCollides(const struct jeSpatialEntity* entity, double x, double y, double w, double h);
+uint32_t jeSpatialEntity_getSweepStep(
+	const struct jeSpatialEntity* entity,
+	double x,
+	double y,
+	double w,
+	double h,
+	int32_t signX,
+	int32_t signY,
+	uint32_t steps);
+struct jeSpatialCell* jeSpatialHash_findCell(struct jeSpatialHash* hash, uint64_t key);
+bool jeSpatialHash_growCells(struct jeSpatialHash* hash);
+bool jeSpatialHash_addCellEntity(struct jeSpatialHash* hash, int32_t cellX, int32_t cellY, uint32_t entityId);
+void jeSpatialHash_removeCellEntity(struct jeSpatialHash* hash, int32_t cellX, int32_t cellY, uint32_t entityId);
+void jeSpatialHash_destroyCells(struct jeSpatialHash* hash);
+void jeSpatialHash_startQuery(struct jeSpatialHash* hash);
+
+uint64_t jeSpatial_getCellKey(int32_t cellX, int32_t cellY) {
+	return ((uint64_t)(uint32_t)cellX << 32U) | (uint64_t)(uint32_t)cellY;
+}
+int32_t jeSpatial_getCellCoord(double pos, double cellSize) {
+	double cellCoord = floor(pos / cellSize);
+
+	/*Also catches NaN, which fails every comparison*/
+	if (!(cellCoord >= (double)-JE_SPATIAL_MAX_CELL_COORD)) {
+		cellCoord = (double)-JE_SPATIAL_MAX_CELL_COORD;
+	}
+	if (cellCoord > (double)JE_SPATIAL_MAX_CELL_COORD) {
+		cellCoord = (double)JE_SPATIAL_MAX_CELL_COORD;
+	}
+
+	return (int32_t)cellCoord;
+}
+void jeSpatial_getCellBounds(double cellSize, double x, double y, double w, double h, int32_t* outCellBounds) {
+	/*Mirrors the chunk bounds in engine/util/spatial_hash.lua; empty bounds are in no cells*/
+	outCellBounds[0] = jeSpatial_getCellCoord(x, cellSize);
+	outCellBounds[1] = jeSpatial_getCellCoord(y, cellSize);
+	outCellBounds[2] = jeSpatial_getCellCoord(x + w - JE_SPATIAL_EPSILON, cellSize);
+	outCellBounds[3] = jeSpatial_getCellCoord(y + h - JE_SPATIAL_EPSILON, cellSize);
+
+	if (!(w > 0.0)) {
+		outCellBounds[2] = outCellBounds[0] - 1;
+	}
+	if (!(h > 0.0)) {
+		outCellBounds[3] = outCellBounds[1] - 1;
+	}
+}
+bool jeSpatialEntity_getCollides(const struct jeSpatialEntity* entity, double x, double y, double w, double h) {
+	/*Mirrors util.rectCollides()*/
+	return (
+		(x < (entity->x + entity->w)) && ((x + w) > entity->x) &&
+		(y < (entity->y + entity->h)) && ((y + h) > entity->y) &&
+		(w > 0.0) && (h > 0.0) && (entity->w > 0.0) && (entity->h > 0.0));
+}
+uint32_t jeSpatialEntity_getSweepStep(
+	const struct jeSpatialEntity* entity,
+	double x,
+	double y,
+	double w,
+	double h,
+	int32_t signX,
+	int32_t signY,
+	uint32_t steps) {
+	/*Returns the first step (from 1) that the bounds collide with the entity, or 0 if none do.  The step is
+	estimated from the entity's position on the moving axis, then confirmed with the same test as queries, so that
+	rounding never changes the result*/
+	bool movingX = (signX != 0);
+	int32_t sign = signX + signY;
+	double position = movingX ? x : y;
+	double size = movingX ? w : h;
+	double entityPosition = movingX ? entity->x : entity->y;
+	double entitySize = movingX ? entity->w : entity->h;
+
+	double lastFreeStep = (sign > 0) ? (entityPosition - position - size) : (position - entityPosition - entitySize);
+	double pastLastStep = (sign > 0) ? (entityPosition + entitySize - position) : (position + size - entityPosition);
+	double firstStep = floor(lastFreeStep) + 1.0;
+	if (firstStep > (double)steps) {
+		return 0;
+	}
+
+	uint32_t step = (firstStep > 1.0) ? (uint32_t)firstStep : 1U;
+	while ((step > 1) && jeSpatialEntity_getCollides(
+		entity, x + (double)(signX * (int32_t)(step - 1)), y + (double)(signY * (int32_t)(step - 1)), w, h)) {
+		step--;
+	}
+	while ((step <= steps) && ((double)step <= (pastLastStep + 1.0)) && !jeSpatialEntity_getCollides(
+		entity, x + (double)(signX * (int32_t)step), y + (double)(signY * (int32_t)step), w, h)) {
+		step++;
+	}
+
+	bool collides = (step <= steps) && jeSpatialEntity_getCollides(
+		entity, x + (double)(signX * (int32_t)step), y + (double)(signY * (int32_t)step), w, h);
+	return collides ? step : 0;
+}
+struct jeSpatialCell* jeSpatialHash_findCell(struct jeSpatialHash* hash, uint64_t key) {
+	/*Returns the cell with the key, or the unused cell it would go in; cells are never full*/
+	uint32_t cellMask = jeArray_getCount(&hash->cells) - 1;
+	uint32_t cellIndex = (uint32_t)((key * 0x9E3779B97F4A7C15ULL) >> 32U) & cellMask;
+
+	struct jeSpatialCell* cell = (struct jeSpatialCell*)jeArray_get(&hash->cells, cellIndex);
+	while (cell->used && (cell->key != key)) {
+		cellIndex = (cellIndex + 1) & cellMask;
+		cell = (struct jeSpatialCell*)jeArray_get(&hash->cells, cellIndex);
+	}
+
+	return cell;
+}
+bool jeSpatialHash_growCells(struct jeSpatialHash* hash) {
+	bool ok = true;
+
+	uint32_t oldCellCapacity = jeArray_getCount(&hash->cells);
+	uint32_t cellCapacity = JE_SPATIAL_MIN_CELL_CAPACITY;
+	while (cellCapacity <= (hash->cellCount * 2)) {
+		cellCapacity *= 2;
+	}
+
+	if (cellCapacity <= oldCellCapacity) {
+		return ok;
+	}
+
+	struct jeArray oldCells = hash->cells;
+
+	ok = ok && jeArray_create(&hash->cells, sizeof(struct jeSpatialCell));
+	ok = ok && jeArray_setCount(&hash->cells, cellCapacity);
+
+	if (ok) {
+		memset(hash->cells.data, 0, (size_t)cellCapacity * sizeof(struct jeSpatialCell));
+
+		for (uint32_t i = 0; i < oldCellCapacity; i++) {
+			const struct jeSpatialCell* oldCell = (const struct jeSpatialCell*)jeArray_get(&oldCells, i);
+			if (oldCell->used) {
+				*jeSpatialHash_findCell(hash, oldCell->key) = *oldCell;
+			}
+		}
+
+		jeArray_destroy(&oldCells);
+	} else {
+		jeArray_destroy(&hash->cells);
+		hash->cells = oldCells;
+	}
+
+	return ok;
+}
+bool jeSpatialHash_addCellEntity(struct jeSpatialHash* hash, int32_t cellX, int32_t cellY, uint32_t entityId) {
+	bool ok = true;
+
+	uint64_t key = jeSpatial_getCellKey(cellX, cellY);
+	struct jeSpatialCell* cell = jeSpatialHash_findCell(hash, key);
+
+	if (!cell->used) {
+		hash->cellCount++;
+		ok = jeSpatialHash_growCells(hash);
+
+		if (ok) {
+			cell = jeSpatialHash_findCell(hash, key);
+			cell->key = key;
+			cell->used = true;
+			ok = jeArray_create(&cell->entityIds, sizeof(uint32_t));
+		}
+	}
+
+	ok = ok && jeArray_push(&cell->entityIds, (const void*)&entityId, 1);
+
+	return ok;
+}
+void jeSpatialHash_removeCellEntity(struct jeSpatialHash* hash, int32_t cellX, int32_t cellY, uint32_t entityId) {
+	struct jeSpatialCell* cell = jeSpatialHash_findCell(hash, jeSpatial_getCellKey(cellX, cellY));
+	if (!cell->used) {
+		JE_ERROR("entity is not in cell, entityId=%u, cellX=%d, cellY=%d", entityId, cellX, cellY);
+		return;
+	}
+
+	uint32_t* entityIds = (uint32_t*)cell->entityIds.data;
+	uint32_t entityCount = jeArray_getCount(&cell->entityIds);
+	for (uint32_t i = 0; i < entityCount; i++) {
+		if (entityIds[i] == entityId) {
+			entityIds[i] = entityIds[entityCount - 1];
+			jeArray_setCount(&cell->entityIds, entityCount - 1);
+			return;
+		}
+	}
+
+	JE_ERROR("entity is not in cell, entityId=%u, cellX=%d, cellY=%d", entityId, cellX, cellY);
+}
+void jeSpatialHash_destroyCells(struct jeSpatialHash* hash) {
+	uint32_t cellCapacity = jeArray_getCount(&hash->cells);
+	for (uint32_t i = 0; i < cellCapacity; i++) {
+		struct jeSpatialCell* cell = (struct jeSpatialCell*)jeArray_get(&hash->cells, i);
+		if (cell->used) {
+			jeArray_destroy(&cell->entityIds);
+		}
+	}
+
+	jeArray_destroy(&hash->cells);
+	hash->cellCount = 0;
+}
+void jeSpatialHash_startQuery(struct jeSpatialHash* hash) {
+	/*Entities in more than one cell are only returned once; each query marks the entities it returns*/
+	hash->queryId++;
+	if (hash->queryId == 0) {
+		uint32_t entityCount = jeArray_getCount(&hash->entities);
+		for (uint32_t i = 0; i < entityCount; i++) {
+			((struct jeSpatialEntity*)jeArray_get(&hash->entities, i))->queryId = 0;
+		}
+		hash->queryId = 1;
+	}
+}
+bool jeSpatialHash_create(struct jeSpatialHash* hash, double cellSize) {
+	JE_TRACE("hash=%p, cellSize=%f", (void*)hash, cellSize);
+
+	bool ok = true;
+
+	if (hash == NULL) {
+		JE_ERROR("hash=NULL");
+		ok = false;
+	}
+
+	if (ok && !(cellSize > 0.0)) {
+		JE_ERROR("cellSize must be positive, cellSize=%f", cellSize);
+		ok = false;
+	}
+
+	if (ok) {
+		memset((void*)hash, 0, sizeof(struct jeSpatialHash));
+		hash->cellSize = cellSize;
+	}
+
+	ok = ok && jeArray_create(&hash->entities, sizeof(struct jeSpatialEntity));
+	ok = ok && jeArray_create(&hash->cells, sizeof(struct jeSpatialCell));
+	ok = ok && jeSpatialHash_growCells(hash);
+
+	return ok;
+}
+void jeSpatialHash_destroy(struct jeSpatialHash* hash) {
+	JE_TRACE("hash=%p", (void*)hash);
+
+	if (hash != NULL) {
+		jeSpatialHash_destroyCells(hash);
+		jeArray_destroy(&hash->entities);
+	}
+}
+bool jeSpatialHash_set(struct jeSpatialHash* hash, uint32_t entityId, double x, double y, double w, double h) {
+	bool ok = true;
+
+	uint32_t entityCount = jeArray_getCount(&hash->entities);
+	if (entityId >= entityCount) {
+		ok = jeArray_setCount(&hash->entities, entityId + 1);
+		if (ok) {
+			memset(
+				jeArray_get(&hash->entities, entityCount),
+				0,
+				(size_t)(entityId + 1 - entityCount) * sizeof(struct jeSpatialEntity));
+		}
+	}
+
+	if (!ok) {
+		return ok;
+	}
+
+	struct jeSpatialEntity* entity = (struct jeSpatialEntity*)jeArray_get(&hash->entities, entityId);
+	if (!entity->inserted) {
+		entity->cellX1 = 0;
+		entity->cellY1 = 0;
+		entity->cellX2 = -1;
+		entity->cellY2 = -1;
+	}
+
+	int32_t cellBounds[4] = {0, 0, -1, -1};
+	jeSpatial_getCellBounds(hash->cellSize, x, y, w, h, cellBounds);
+
+	/*Only cells entered or left are changed, so entities keep their place in the cells they stay in*/
+	for (int32_t cellY = entity->cellY1; cellY <= entity->cellY2; cellY++) {
+		for (int32_t cellX = entity->cellX1; cellX <= entity->cellX2; cellX++) {
+			bool outsideNewBounds = (
+				(cellX < cellBounds[0]) || (cellY < cellBounds[1]) ||
+				(cellX > cellBounds[2]) || (cellY > cellBounds[3]));
+			if (outsideNewBounds) {
+				jeSpatialHash_removeCellEntity(hash, cellX, cellY, entityId);
+			}
+		}
+	}
+
+	for (int32_t cellY = cellBounds[1]; ok && (cellY <= cellBounds[3]); cellY++) {
+		for (int32_t cellX = cellBounds[0]; ok && (cellX <= cellBounds[2]); cellX++) {
+			bool outsideOldBounds = (
+				(cellX < entity->cellX1) || (cellY < entity->cellY1) ||
+				(cellX > entity->cellX2) || (cellY > entity->cellY2));
+			if (outsideOldBounds) {
+				ok = jeSpatialHash_addCellEntity(hash, cellX, cellY, entityId);
+			}
+		}
+	}
+
+	if (ok) {
+		entity->x = x;
+		entity->y = y;
+		entity->w = w;
+		entity->h = h;
+		entity->cellX1 = cellBounds[0];
+		entity->cellY1 = cellBounds[1];
+		entity->cellX2 = cellBounds[2];
+		entity->cellY2 = cellBounds[3];
+		entity->inserted = true;
+	}
+
+	return ok;
+}
+void jeSpatialHash_remove(struct jeSpatialHash* hash, uint32_t entityId) {
+	if (entityId >= jeArray_getCount(&hash->entities)) {
+		return;
+	}
+
+	struct jeSpatialEntity* entity = (struct jeSpatialEntity*)jeArray_get(&hash->entities, entityId);
+	if (entity->inserted) {
+		for (int32_t cellY = entity->cellY1; cellY <= entity->cellY2; cellY++) {
+			for (int32_t cellX = entity->cellX1; cellX <= entity->cellX2; cellX++) {
+				jeSpatialHash_removeCellEntity(hash, cellX, cellY, entityId);
+			}
+		}
+
+		memset((void*)entity, 0, sizeof(struct jeSpatialEntity));
+	}
+}
+bool jeSpatialHash_clear(struct jeSpatialHash* hash) {
+	jeSpatialHash_destroyCells(hash);
+	jeArray_setCount(&hash->entities, 0);
+
+	return jeSpatialHash_growCells(hash);
+}
+bool jeSpatialHash_query(
+	struct jeSpatialHash* hash,
+	double x,
+	double y,
+	double w,
+	double h,
+	uint32_t excludeEntityId,
+	struct jeArray* outEntityIds) {
+	bool ok = true;
+
+	jeArray_setCount(outEntityIds, 0);
+	jeSpatialHash_startQuery(hash);
+
+	int32_t cellBounds[4] = {0, 0, -1, -1};
+	jeSpatial_getCellBounds(hash->cellSize, x, y, w, h, cellBounds);
+
+	for (int32_t cellY = cellBounds[1]; ok && (hash->cellCount > 0) && (cellY <= cellBounds[3]); cellY++) {
+		for (int32_t cellX = cellBounds[0]; ok && (cellX <= cellBounds[2]); cellX++) {
+			struct jeSpatialCell* cell = jeSpatialHash_findCell(hash, jeSpatial_getCellKey(cellX, cellY));
+			if (!cell->used) {
+				continue;
+			}
+
+			const uint32_t* entityIds = (const uint32_t*)cell->entityIds.data;
+			uint32_t entityCount = jeArray_getCount(&cell->entityIds);
+			for (uint32_t i = 0; ok && (i < entityCount); i++) {
+				uint32_t entityId = entityIds[i];
+				struct jeSpatialEntity* entity = (struct jeSpatialEntity*)jeArray_get(&hash->entities, entityId);
+
+				bool collides = jeSpatialEntity_getCollides(entity, x, y, w, h);
+				if (collides && (entity->queryId != hash->queryId) && (entityId != excludeEntityId)) {
+					entity->queryId = hash->queryId;
+					ok = jeArray_push(outEntityIds, (const void*)&entityId, 1);
+				}
+			}
+		}
+	}
+
+	return ok;
+}
+bool jeSpatialHash_sweep(
+	struct jeSpatialHash* hash,
+	double x,
+	double y,
+	double w,
+	double h,
+	int32_t moveX,
+	int32_t moveY,
+	uint32_t excludeEntityId,
+	struct jeArray* outEntityIds,
+	struct jeArray* outSteps) {
+	bool ok = true;
+
+	jeArray_setCount(outEntityIds, 0);
+	jeArray_setCount(outSteps, 0);
+
+	if ((moveX != 0) && (moveY != 0)) {
+		JE_ERROR("moves must be along one axis, moveX=%d, moveY=%d", moveX, moveY);
+		return false;
+	}
+
+	int32_t signX = (moveX > 0) - (moveX < 0);
+	int32_t signY = (moveY > 0) - (moveY < 0);
+	uint32_t steps = (uint32_t)fabs((double)moveX + (double)moveY);
+
+	/*Every entity colliding with the bounds at any step collides with the bounds covering all steps*/
+	double sweptX = x + ((signX < 0) ? (double)moveX : (double)signX);
+	double sweptY = y + ((signY < 0) ? (double)moveY : (double)signY);
+	double sweptW = w + fabs((double)moveX) - (double)(signX * signX);
+	double sweptH = h + fabs((double)moveY) - (double)(signY * signY);
+
+	jeSpatialHash_startQuery(hash);
+
+	int32_t cellBounds[4] = {0, 0, -1, -1};
+	jeSpatial_getCellBounds(hash->cellSize, sweptX, sweptY, sweptW, sweptH, cellBounds);
+
+	for (int32_t cellY = cellBounds[1]; ok && (hash->cellCount > 0) && (steps > 0) && (cellY <= cellBounds[3]);
+		 cellY++) {
+		for (int32_t cellX = cellBounds[0]; ok && (cellX <= cellBounds[2]); cellX++) {
+			struct jeSpatialCell* cell = jeSpatialHash_findCell(hash, jeSpatial_getCellKey(cellX, cellY));
+			if (!cell->used) {
+				continue;
+			}
+
+			const uint32_t* entityIds = (const uint32_t*)cell->entityIds.data;
+			uint32_t entityCount = jeArray_getCount(&cell->entityIds);
+			for (uint32_t i = 0; ok && (i < entityCount); i++) {
+				uint32_t entityId = entityIds[i];
+				struct jeSpatialEntity* entity = (struct jeSpatialEntity*)jeArray_get(&hash->entities, entityId);
+
+				if ((entity->queryId == hash->queryId) || (entityId == excludeEntityId)) {
+					continue;
+				}
+				entity->queryId = hash->queryId;
+
+				if (!jeSpatialEntity_getCollides(entity, sweptX, sweptY, sweptW, sweptH)) {
+					continue;
+				}
+
+				uint32_t step = jeSpatialEntity_getSweepStep(entity, x, y, w, h, signX, signY, steps);
+				if (step > 0) {
+					ok = jeArray_push(outEntityIds, (const void*)&entityId, 1);
+					ok = ok && jeArray_push(outSteps, (const void*)&step, 1);
+				}
+			}
+		}
+	}
+
+	return ok;
+}
+
+void jeSpatial_runTests() {
+#if JE_DEBUGGING
+	JE_DEBUG(" ");
+
+	struct jeArray entityIds;
+	struct jeArray steps;
+	JE_ASSERT(jeArray_create(&entityIds, sizeof(uint32_t)));
+	JE_ASSERT(jeArray_create(&steps, sizeof(uint32_t)));
+
+	{
+		JE_ASSERT(jeSpatial_getCellCoord(-0.5, 8.0) == -1);
+		JE_ASSERT(jeSpatial_getCellCoord(8.0, 8.0) == 1);
+		JE_ASSERT(jeSpatial_getCellCoord(1e300, 8.0) == JE_SPATIAL_MAX_CELL_COORD);
+		JE_ASSERT(jeSpatial_getCellCoord(NAN, 8.0) == -JE_SPATIAL_MAX_CELL_COORD);
+
+		/*Bounds ending on a cell edge are not in the next cell, and empty bounds are in no cells*/
+		int32_t cellBounds[4] = {0, 0, -1, -1};
+		jeSpatial_getCellBounds(8.0, 0.0, 4.0, 16.0, 8.0, cellBounds);
+		JE_ASSERT((cellBounds[0] == 0) && (cellBounds[1] == 0) && (cellBounds[2] == 1) && (cellBounds[3] == 1));
+		jeSpatial_getCellBounds(8.0, 4.0, 4.0, 0.0, 8.0, cellBounds);
+		JE_ASSERT(cellBounds[2] < cellBounds[0]);
+	}
+
+	{
+		struct jeSpatialHash hash;
+		JE_ASSERT(jeSpatialHash_create(&hash, 8.0));
+
+		/*Entity 2 is in 4 cells, but only returned once; results are in the order entities entered their cells*/
+		JE_ASSERT(jeSpatialHash_set(&hash, 1, 0.0, 0.0, 8.0, 8.0));
+		JE_ASSERT(jeSpatialHash_set(&hash, 2, 4.0, 4.0, 8.0, 8.0));
+		JE_ASSERT(jeSpatialHash_set(&hash, 3, 100.0, 0.0, 8.0, 8.0));
+		JE_ASSERT(jeSpatialHash_set(&hash, 4, 2.0, 2.0, 0.0, 0.0));
+		JE_ASSERT(jeSpatialHash_query(&hash, 0.0, 0.0, 16.0, 16.0, 0, &entityIds));
+		JE_ASSERT(jeArray_getCount(&entityIds) == 2);
+		JE_ASSERT(*(uint32_t*)jeArray_get(&entityIds, 0) == 1);
+		JE_ASSERT(*(uint32_t*)jeArray_get(&entityIds, 1) == 2);
+
+		JE_ASSERT(jeSpatialHash_query(&hash, 0.0, 0.0, 16.0, 16.0, 1, &entityIds));
+		JE_ASSERT(jeArray_getCount(&entityIds) == 1);
+		JE_ASSERT(*(uint32_t*)jeArray_get(&entityIds, 0) == 2);
+
+		/*Bounds touching an entity's edge don't collide with it*/
+		JE_ASSERT(jeSpatialHash_query(&hash, 8.0, 8.0, 8.0, 8.0, 0, &entityIds));
+		JE_ASSERT(jeArray_getCount(&entityIds) == 1);
+		JE_ASSERT(*(uint32_t*)jeArray_get(&entityIds, 0) == 2);
+
+		/*Moving keeps an entity's place in the cells it stays in, and removing swaps the last id into its place*/
+		JE_ASSERT(jeSpatialHash_set(&hash, 1, 1.0, 0.0, 8.0, 8.0));
+		JE_ASSERT(jeSpatialHash_query(&hash, 0.0, 0.0, 8.0, 8.0, 0, &entityIds));
+		JE_ASSERT(jeArray_getCount(&entityIds) == 2);
+		JE_ASSERT(*(uint32_t*)jeArray_get(&entityIds, 0) == 1);
+		JE_ASSERT(jeSpatialHash_set(&hash, 5, 0.0, 0.0, 4.0, 4.0));
+		jeSpatialHash_remove(&hash, 1);
+		jeSpatialHash_remove(&hash, 1);
+		jeSpatialHash_remove(&hash, 100);
+		JE_ASSERT(jeSpatialHash_query(&hash, 0.0, 0.0, 8.0, 8.0, 0, &entityIds));
+		JE_ASSERT(jeArray_getCount(&entityIds) == 2);
+		JE_ASSERT(*(uint32_t*)jeArray_get(&entityIds, 0) == 5);
+		JE_ASSERT(*(uint32_t*)jeArray_get(&entityIds, 1) == 2);
+
+		JE_ASSERT(jeSpatialHash_set(&hash, 2, 100.0, 8.0, 8.0, 8.0));
+		JE_ASSERT(jeSpatialHash_query(&hash, 4.0, 4.0, 8.0, 8.0, 0, &entityIds));
+		JE_ASSERT(jeArray_getCount(&entityIds) == 0);
+
+		/*Positions past the cell range share the cells at its edge, but still collide by position*/
+		JE_ASSERT(jeSpatialHash_set(&hash, 6, 1e12, 0.0, 8.0, 8.0));
+		JE_ASSERT(jeSpatialHash_set(&hash, 7, 2e12, 0.0, 8.0, 8.0));
+		JE_ASSERT(jeSpatialHash_query(&hash, 2e12, 0.0, 1.0, 1.0, 0, &entityIds));
+		JE_ASSERT(jeArray_getCount(&entityIds) == 1);
+		JE_ASSERT(*(uint32_t*)jeArray_get(&entityIds, 0) == 7);
+
+		/*A query id wrapping around resets the entities' marks*/
+		hash.queryId = UINT32_MAX;
+		JE_ASSERT(jeSpatialHash_query(&hash, 0.0, 0.0, 8.0, 8.0, 0, &entityIds));
+		JE_ASSERT(jeArray_getCount(&entityIds) == 1);
+		JE_ASSERT(hash.queryId == 1);
+
+		JE_ASSERT(jeSpatialHash_clear(&hash));
+		JE_ASSERT(hash.cellCount == 0);
+		JE_ASSERT(jeSpatialHash_query(&hash, -1e12, -1e12, 1e13, 1e13, 0, &entityIds));
+		JE_ASSERT(jeArray_getCount(&entityIds) == 0);
+
+		jeSpatialHash_destroy(&hash);
+	}
+
+	{
+		struct jeSpatialHash hash;
+		JE_ASSERT(jeSpatialHash_create(&hash, 8.0));
+		JE_ASSERT(jeSpatialHash_set(&hash, 1, 0.0, 0.0, 8.0, 8.0));
+		JE_ASSERT(jeSpatialHash_set(&hash, 2, 100.0, 8.0, 8.0, 8.0));
+		JE_ASSERT(jeSpatialHash_set(&hash, 3, 100.0, 0.0, 8.0, 8.0));
+		JE_ASSERT(jeSpatialHash_set(&hash, 4, 20.0, 40.0, 8.0, 8.0));
+
+		/*The first step colliding is the one after the gap between the bounds and the entity*/
+		JE_ASSERT(jeSpatialHash_sweep(&hash, 20.0, 0.0, 8.0, 8.0, -30, 0, 0, &entityIds, &steps));
+		JE_ASSERT((jeArray_getCount(&entityIds) == 1) && (jeArray_getCount(&steps) == 1));
+		JE_ASSERT(*(uint32_t*)jeArray_get(&entityIds, 0) == 1);
+		JE_ASSERT(*(uint32_t*)jeArray_get(&steps, 0) == 13);
+
+		JE_ASSERT(jeSpatialHash_sweep(&hash, 20.0, 0.0, 8.0, 8.0, 100, 0, 0, &entityIds, &steps));
+		JE_ASSERT(jeArray_getCount(&entityIds) == 1);
+		JE_ASSERT(*(uint32_t*)jeArray_get(&entityIds, 0) == 3);
+		JE_ASSERT(*(uint32_t*)jeArray_get(&steps, 0) == 73);
+
+		JE_ASSERT(jeSpatialHash_sweep(&hash, 20.0, 0.0, 8.0, 8.0, 0, 33, 0, &entityIds, &steps));
+		JE_ASSERT(jeArray_getCount(&entityIds) == 1);
+		JE_ASSERT(*(uint32_t*)jeArray_get(&steps, 0) == 33);
+		JE_ASSERT(jeSpatialHash_sweep(&hash, 20.0, 0.0, 8.0, 8.0, 0, 32, 0, &entityIds, &steps));
+		JE_ASSERT(jeArray_getCount(&entityIds) == 0);
+
+		/*Entities already colliding collide at the first step, and no moves collide with nothing*/
+		JE_ASSERT(jeSpatialHash_sweep(&hash, 4.0, 0.0, 8.0, 8.0, 10, 0, 0, &entityIds, &steps));
+		JE_ASSERT(jeArray_getCount(&entityIds) == 1);
+		JE_ASSERT(*(uint32_t*)jeArray_get(&steps, 0) == 1);
+		JE_ASSERT(jeSpatialHash_sweep(&hash, 4.0, 0.0, 8.0, 8.0, 10, 0, 1, &entityIds, &steps));
+		JE_ASSERT(jeArray_getCount(&entityIds) == 0);
+		JE_ASSERT(jeSpatialHash_sweep(&hash, 4.0, 0.0, 8.0, 8.0, 0, 0, 0, &entityIds, &steps));
+		JE_ASSERT(jeArray_getCount(&entityIds) == 0);
+
+		/*Diagonal moves are rejected.  Logging is off while sweeping, which also disables asserts, so results are
+		 * asserted after.*/
+		uint32_t logLevelBackup = jeLogger_getLevel();
+		jeLogger_setLevelOverride(JE_LOG_LEVEL_NONE);
+
+		bool swept = jeSpatialHash_sweep(&hash, 4.0, 0.0, 8.0, 8.0, 1, 1, 0, &entityIds, &steps);
+
+		jeLogger_setLevelOverride(logLevelBackup);
+
+		JE_ASSERT(!swept);
+
+		jeSpatialHash_destroy(&hash);
+	}
+
+	{
+		/*Enough cells to grow the cell table several times, each entity found again after*/
+		struct jeSpatialHash hash;
+		JE_ASSERT(jeSpatialHash_create(&hash, 8.0));
+		for (uint32_t i = 1; i <= 1000; i++) {
+			JE_ASSERT(jeSpatialHash_set(&hash, i, (double)(i % 40) * 8.0, (double)(i / 40) * -8.0, 8.0, 8.0));
+		}
+		JE_ASSERT(hash.cellCount == 1000);
+		JE_ASSERT(jeArray_getCount(&hash.cells) > (hash.cellCount * 2));
+		for (uint32_t i = 1; i <= 1000; i++) {
+			JE_ASSERT(jeSpatialHash_query(
+				&hash, (double)(i % 40) * 8.0 + 1.0, (double)(i / 40) * -8.0 + 1.0, 1.0, 1.0, 0, &entityIds));
+			JE_ASSERT(jeArray_getCount(&entityIds) == 1);
+			JE_ASSERT(*(uint32_t*)jeArray_get(&entityIds, 0) == i);
+		}
+
+		jeSpatialHash_destroy(&hash);
+	}
+
+	jeArray_destroy(&steps);
+	jeArray_destroy(&entityIds);
+#endif
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#if !defined(JE_CORE_SPATIAL_H)
+#define JE_CORE_SPATIAL_H
+
+#include <j25/core/common.h>
+#include <j25/core/container.h>
+
+#define JE_SPATIAL_MIN_CELL_CAPACITY 64U
+#define JE_SPATIAL_MAX_ENTITY_ID 0x7FFFFFFF
+#define JE_SPATIAL_MAX_SWEEP_STEPS 0x7FFFFFFF
+/*Cell coordinates are clamped to this range, so that they pack into 32 bits each*/
+#define JE_SPATIAL_MAX_CELL_COORD 0x3FFFFFFF
+/*Mirrors FLOAT_EPSILON in engine/systems/entity.lua*/
+#define JE_SPATIAL_EPSILON 1.19e-07
+
+/*Bounds of an entity in the spatial hash, and the range of cells it is in (empty when x2 < x1 or y2 < y1)*/
+struct jeSpatialEntity {
+	double x;
+	double y;
+	double w;
+	double h;
+	int32_t cellX1;
+	int32_t cellY1;
+	int32_t cellX2;
+	int32_t cellY2;
+	uint32_t queryId;
+	bool inserted;
+};
+
+/*Entity ids in a cell are kept in the order they were added, and removed by swapping with the last*/
+struct jeSpatialCell {
+	uint64_t key;
+	bool used;
+	struct jeArray entityIds;
+};
+
+/*Entities are indexed by id; cells are an open addressed table of packed cell coordinates.  Cells are kept once
+ * used, so that moving back and forth between cells does not reallocate, and are only freed by clear().
+ * Mirrored by engine/util/spatial_hash.lua, which must return the same results in the same order.*/
+struct jeSpatialHash {
+	double cellSize;
+	struct jeArray entities;
+	struct jeArray cells;
+	uint32_t cellCount;
+	uint32_t queryId;
+};
+
+JE_API_PUBLIC bool jeSpatialHash_create(struct jeSpatialHash* hash, double cellSize);
+JE_API_PUBLIC void jeSpatialHash_destroy(struct jeSpatialHash* hash);
+/*Inserts the entity, or moves it if already inserted.  Entity ids are from 1 to JE_SPATIAL_MAX_ENTITY_ID.*/
+JE_API_PUBLIC bool jeSpatialHash_set(
+	struct jeSpatialHash* hash, uint32_t entityId, double x, double y, double w, double h);
+JE_API_PUBLIC void jeSpatialHash_remove(struct jeSpatialHash* hash, uint32_t entityId);
+JE_API_PUBLIC bool jeSpatialHash_clear(struct jeSpatialHash* hash);
+/*Replaces the contents of outEntityIds (of uint32_t) with the ids of entities colliding with the bounds, other than
+ * excludeEntityId (0 for none)*/
+JE_API_PUBLIC bool jeSpatialHash_query(
+	struct jeSpatialHash* hash,
+	double x,
+	double y,
+	double w,
+	double h,
+	uint32_t excludeEntityId,
+	struct jeArray* outEntityIds);
+/*Like jeSpatialHash_query(), for the bounds moved one step at a time along one axis.  outSteps (of uint32_t) gets the
+ * first step (from 1) that each entity collides at.*/
+JE_API_PUBLIC bool jeSpatialHash_sweep(
+	struct jeSpatialHash* hash,
+	double x,
+	double y,
+	double w,
+	double h,
+	int32_t moveX,
+	int32_t moveY,
+	uint32_t excludeEntityId,
+	struct jeArray* outEntityIds,
+	struct jeArray* outSteps);
+
+JE_API_PUBLIC void jeSpatial_runTests();
+
+#endif
@@ -0,0 +1,727 @@
+#if defined(__unix__) || defined(__APPLE__)
+/*Exposes mmap() and friends under -std=c99*/
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <j25/platform/data.h>
+
+#include <j25/core/common.h>
+#include <j25/core/container.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <zlib.h>
+
+#include <SDL2/SDL.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define JE_DATA_MMAP 1
+#else
+#define JE_DATA_MMAP 0
+#endif
+
+#define JE_DATA_CHUNK_SIZE (64 * 1024)
+#define JE_DATA_TEST_FILENAME "jeDataTest"
+#define JE_DATA_BENCHMARK_FILENAME "jeBenchmarkData"
+
+struct jeDataWriter {
+	SDL_Thread* thread;
+	SDL_mutex* mutex;
+	SDL_cond* condition;
+	struct jeArray queuedWrites;
+	struct jeArray completedWrites;
+	struct jeDataWrite activeWrite;
+	bool active;
+	bool stopping;
+	uint32_t nextRequestId;
+};
+
+bool jeDataWriter_getWriting(struct jeDataWriter* writer, const char* optFilename);
+int jeDataWriter_run(void* writerPtr);
+
+bool jeData_getInfo(const char* filename, bool* outCompressed, uint32_t* outSizeHint) {
+	JE_TRACE("filename=%s", filename);
+
+	bool ok = true;
+
+	*outCompressed = false;
+	*outSizeHint = 0;
+
+	FILE* file = fopen(filename, "rb");
+	if (file == NULL) {
+		JE_ERROR("fopen() failed with filename=%s, errno=%d err=%s", filename, errno, strerror(errno));
+		ok = false;
+	}
+
+	if (ok) {
+		/*gzip member header and trailer; see RFC 1952*/
+		unsigned char magic[2] = {0, 0};
+		size_t magicSize = fread((void*)magic, 1, sizeof(magic), file);
+		*outCompressed = (magicSize == sizeof(magic)) && (magic[0] == 0x1F) && (magic[1] == 0x8B);
+
+		if (*outCompressed) {
+			/*Uncompressed size (mod 2^32) of the last member, little endian*/
+			unsigned char trailer[4] = {0, 0, 0, 0};
+			if ((fseek(file, -4, SEEK_END) == 0) && (fread((void*)trailer, 1, sizeof(trailer), file) == 4)) {
+				*outSizeHint = (uint32_t)trailer[0] | ((uint32_t)trailer[1] << 8) | ((uint32_t)trailer[2] << 16) |
+							   ((uint32_t)trailer[3] << 24);
+			}
+		} else if (fseek(file, 0, SEEK_END) == 0) {
+			long fileSize = ftell(file);
+			*outSizeHint = (fileSize > 0) ? (uint32_t)fileSize : 0;
+		}
+	}
+
+	if (file != NULL) {
+		fclose(file);
+	}
+
+	return ok;
+}
+bool jeData_read(struct jeString* outData, const char* filename, uint32_t sizeHint) {
+	JE_TRACE("outData=%p, filename=%s, sizeHint=%u", (void*)outData, filename, sizeHint);
+
+	bool ok = true;
+
+	if (outData == NULL) {
+		JE_ERROR("outData=NULL");
+		ok = false;
+	}
+
+	gzFile file = NULL;
+	if (ok) {
+		file = gzopen(filename, "rb");
+		if (file == NULL) {
+			JE_ERROR("gzopen() failed with filename=%s, errno=%d err=%s", filename, errno, strerror(errno));
+			ok = false;
+		}
+	}
+
+	/*The size hint is only used to reserve space up front; reads continue in chunks until the end of the file*/
+	ok = ok && jeString_setCount(outData, 0);
+	ok = ok && jeString_ensureCapacity(outData, sizeHint + 1);
+
+	for (int chunkRead = 1; ok && (chunkRead > 0);) {
+		uint32_t count = jeString_getCount(outData);
+		ok = jeString_ensureCapacity(outData, count + JE_DATA_CHUNK_SIZE);
+
+		if (ok) {
+			struct jeArray* array = &outData->array;
+			chunkRead = gzread(file, (char*)array->data + count, (unsigned)(array->capacity - count));
+			if (chunkRead < 0) {
+				int errnum = 0;
+				JE_ERROR("gzread() failed with filename=%s, gzerr=%s", filename, gzerror(file, &errnum));
+				JE_MAYBE_UNUSED(errnum);
+				ok = false;
+			}
+		}
+
+		ok = ok && jeString_setCount(outData, count + (uint32_t)chunkRead);
+	}
+
+	if (ok) {
+		/*Exclude null terminator if one was written*/
+		uint32_t dataSize = jeString_getCount(outData);
+		if ((dataSize > 0) && (*jeString_get(outData, dataSize - 1) == '\0')) {
+			ok = jeString_setCount(outData, dataSize - 1);
+		}
+
+		JE_DEBUG("bytes=%u (after decompression) read from filename=%s", jeString_getCount(outData), filename);
+	}
+
+	if (file != NULL) {
+		gzclose(file);
+	}
+
+	return ok;
+}
+bool jeData_write(const char* filename, const char* data, size_t dataSize, bool append) {
+	JE_TRACE("filename=%s, dataSize=%u, append=%u", filename, (uint32_t)dataSize, (uint32_t)append);
+
+	bool ok = true;
+
+	gzFile file = gzopen(filename, append ? "ab" : "wb");
+	if (file == NULL) {
+		JE_ERROR("gzopen() failed with filename=%s, errno=%d err=%s", filename, errno, strerror(errno));
+		ok = false;
+	}
+
+	int dataSizeWritten = 0;
+	if (ok) {
+		dataSizeWritten = gzwrite(file, data, (unsigned)dataSize);
+
+		if (dataSizeWritten < 0) {
+			int errnum = 0;
+			JE_ERROR("gzwrite() failed with filename=%s, gzerr=%s", filename, gzerror(file, &errnum));
+			JE_MAYBE_UNUSED(errnum);
+			ok = false;
+		}
+	}
+
+	if (file != NULL) {
+		if (gzclose(file) != Z_OK) {
+			JE_ERROR("gzclose() failed with filename=%s", filename);
+			ok = false;
+		}
+	}
+
+	if (ok) {
+		JE_DEBUG("bytes=%d (before compression) written to filename=%s", dataSizeWritten, filename);
+	}
+
+	return ok;
+}
+
+bool jeDataMapping_getSupported() {
+	return JE_DATA_MMAP;
+}
+bool jeDataMapping_create(struct jeDataMapping* mapping, const char* filename) {
+	JE_TRACE("mapping=%p, filename=%s", (void*)mapping, filename);
+
+	bool ok = true;
+
+	if (mapping == NULL) {
+		JE_ERROR("mapping=NULL");
+		ok = false;
+	}
+
+	if (mapping != NULL) {
+		memset((void*)mapping, 0, sizeof(struct jeDataMapping));
+		mapping->data = "";
+	}
+
+#if JE_DATA_MMAP
+	int fileDescriptor = -1;
+	if (ok) {
+		fileDescriptor = open(filename, O_RDONLY);
+		if (fileDescriptor < 0) {
+			JE_ERROR("open() failed with filename=%s, errno=%d err=%s", filename, errno, strerror(errno));
+			ok = false;
+		}
+	}
+
+	struct stat fileStat;
+	memset((void*)&fileStat, 0, sizeof(fileStat));
+	if (ok && (fstat(fileDescriptor, &fileStat) != 0)) {
+		JE_ERROR("fstat() failed with filename=%s, errno=%d err=%s", filename, errno, strerror(errno));
+		ok = false;
+	}
+
+	/*Zero-length mappings are invalid*/
+	if (ok && (fileStat.st_size > 0)) {
+		void* fileMapping = mmap(NULL, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+		if (fileMapping == MAP_FAILED) {
+			JE_ERROR("mmap() failed with filename=%s, errno=%d err=%s", filename, errno, strerror(errno));
+			ok = false;
+		} else {
+			mapping->mapping = fileMapping;
+			mapping->mappingSize = (size_t)fileStat.st_size;
+			mapping->data = (const char*)fileMapping;
+			mapping->size = mapping->mappingSize;
+		}
+	}
+
+	if (ok) {
+		/*Exclude null terminator if one was written*/
+		if ((mapping->size > 0) && (mapping->data[mapping->size - 1] == '\0')) {
+			mapping->size--;
+		}
+
+		JE_DEBUG("mapped bytes=%u read from filename=%s", (uint32_t)mapping->size, filename);
+	}
+
+	if (fileDescriptor >= 0) {
+		close(fileDescriptor);
+	}
+#else
+	JE_MAYBE_UNUSED(filename);
+	JE_ERROR("mapped reads are not supported on this platform");
+	ok = false;
+#endif
+
+	if (!ok) {
+		jeDataMapping_destroy(mapping);
+	}
+
+	return ok;
+}
+void jeDataMapping_destroy(struct jeDataMapping* mapping) {
+	JE_TRACE("mapping=%p", (void*)mapping);
+
+	if (mapping != NULL) {
+#if JE_DATA_MMAP
+		if (mapping->mapping != NULL) {
+			munmap(mapping->mapping, mapping->mappingSize);
+		}
+#endif
+
+		memset((void*)mapping, 0, sizeof(struct jeDataMapping));
+		mapping->data = "";
+	}
+}
+
+bool jeDataWriter_getWriting(struct jeDataWriter* writer, const char* optFilename) {
+	/*Must be called with writer->mutex locked*/
+	bool writing = false;
+
+	if (writer->active) {
+		writing = (optFilename == NULL) || (strcmp(jeString_get(&writer->activeWrite.filename, 0), optFilename) == 0);
+	}
+
+	uint32_t queuedCount = jeArray_getCount(&writer->queuedWrites);
+	for (uint32_t i = 0; !writing && (i < queuedCount); i++) {
+		struct jeDataWrite* write = (struct jeDataWrite*)jeArray_get(&writer->queuedWrites, i);
+		writing = (optFilename == NULL) || (strcmp(jeString_get(&write->filename, 0), optFilename) == 0);
+	}
+
+	return writing;
+}
+int jeDataWriter_run(void* writerPtr) {
+	struct jeDataWriter* writer = (struct jeDataWriter*)writerPtr;
+
+	SDL_LockMutex(writer->mutex);
+	while (true) {
+		while ((jeArray_getCount(&writer->queuedWrites) == 0) && !writer->stopping) {
+			SDL_CondWait(writer->condition, writer->mutex);
+		}
+
+		/*Queued writes are finished before stopping*/
+		uint32_t queuedCount = jeArray_getCount(&writer->queuedWrites);
+		if (queuedCount == 0) {
+			break;
+		}
+
+		writer->activeWrite = *(struct jeDataWrite*)jeArray_get(&writer->queuedWrites, 0);
+		writer->active = true;
+		memmove(
+			jeArray_get(&writer->queuedWrites, 0),
+			(const void*)((const struct jeDataWrite*)jeArray_get(&writer->queuedWrites, 0) + 1),
+			(queuedCount - 1) * sizeof(struct jeDataWrite));
+		jeArray_setCount(&writer->queuedWrites, queuedCount - 1);
+		SDL_UnlockMutex(writer->mutex);
+
+		struct jeDataWrite* write = &writer->activeWrite;
+		Uint64 startTime = SDL_GetPerformanceCounter();
+		write->ok = jeData_write(jeString_get(&write->filename, 0), write->data, write->dataSize, write->append);
+
+		Uint64 endTime = SDL_GetPerformanceCounter();
+		write->workerMicroseconds = (uint32_t)(((endTime - startTime) * 1000000) / SDL_GetPerformanceFrequency());
+		write->latencyMicroseconds =
+			(uint32_t)(((endTime - write->queuedTime) * 1000000) / SDL_GetPerformanceFrequency());
+
+		SDL_LockMutex(writer->mutex);
+		if (!jeArray_push(&writer->completedWrites, (const void*)write, 1)) {
+			JE_ERROR("jeArray_push() failed, completion dropped, filename=%s", jeString_get(&write->filename, 0));
+			jeString_destroy(&write->filename);
+		}
+		writer->active = false;
+		SDL_CondBroadcast(writer->condition);
+	}
+	SDL_UnlockMutex(writer->mutex);
+
+	return 0;
+}
+struct jeDataWriter* jeDataWriter_create() {
+	JE_TRACE(" ");
+
+	bool ok = true;
+
+	struct jeDataWriter* writer = (struct jeDataWriter*)malloc(sizeof(struct jeDataWriter));
+	if (writer == NULL) {
+		JE_ERROR("malloc() failed");
+		ok = false;
+	}
+
+	if (ok) {
+		memset((void*)writer, 0, sizeof(struct jeDataWriter));
+		writer->nextRequestId = 1;
+	}
+
+	ok = ok && jeArray_create(&writer->queuedWrites, sizeof(struct jeDataWrite));
+	ok = ok && jeArray_create(&writer->completedWrites, sizeof(struct jeDataWrite));
+
+	if (ok) {
+		writer->mutex = SDL_CreateMutex();
+		if (writer->mutex == NULL) {
+			JE_ERROR("SDL_CreateMutex() failed, error=%s", SDL_GetError());
+			ok = false;
+		}
+	}
+
+	if (ok) {
+		writer->condition = SDL_CreateCond();
+		if (writer->condition == NULL) {
+			JE_ERROR("SDL_CreateCond() failed, error=%s", SDL_GetError());
+			ok = false;
+		}
+	}
+
+	if (ok) {
+		writer->thread = SDL_CreateThread(jeDataWriter_run, "jeDataWriter", (void*)writer);
+		if (writer->thread == NULL) {
+			JE_ERROR("SDL_CreateThread() failed, error=%s", SDL_GetError());
+			ok = false;
+		}
+	}
+
+	if (!ok) {
+		jeDataWriter_destroy(writer);
+		writer = NULL;
+	}
+
+	return writer;
+}
+void jeDataWriter_destroy(struct jeDataWriter* writer) {
+	JE_TRACE("writer=%p", (void*)writer);
+
+	if (writer != NULL) {
+		if (writer->thread != NULL) {
+			SDL_LockMutex(writer->mutex);
+			writer->stopping = true;
+			SDL_CondBroadcast(writer->condition);
+			SDL_UnlockMutex(writer->mutex);
+
+			SDL_WaitThread(writer->thread, NULL);
+			writer->thread = NULL;
+		}
+
+		jeDataWriter_destroyCompletedWrites(&writer->queuedWrites);
+		jeDataWriter_destroyCompletedWrites(&writer->completedWrites);
+
+		if (writer->condition != NULL) {
+			SDL_DestroyCond(writer->condition);
+			writer->condition = NULL;
+		}
+
+		if (writer->mutex != NULL) {
+			SDL_DestroyMutex(writer->mutex);
+			writer->mutex = NULL;
+		}
+
+		free(writer);
+	}
+}
+bool jeDataWriter_queue(
+	struct jeDataWriter* writer,
+	const char* filename,
+	const char* data,
+	size_t dataSize,
+	bool append,
+	uint32_t* outRequestId,
+	bool* outCoalesced) {
+	JE_TRACE("writer=%p, filename=%s, dataSize=%u", (void*)writer, filename, (uint32_t)dataSize);
+
+	bool ok = true;
+
+	*outRequestId = 0;
+	*outCoalesced = false;
+
+	if (writer == NULL) {
+		JE_ERROR("writer=NULL");
+		ok = false;
+	}
+
+	struct jeDataWrite write;
+	memset((void*)&write, 0, sizeof(struct jeDataWrite));
+	write.data = data;
+	write.dataSize = dataSize;
+	write.append = append;
+	write.queuedTime = SDL_GetPerformanceCounter();
+
+	/*The last write to the same file that hasn't started yet takes this write's data instead, unless either appends*/
+	if (ok) {
+		SDL_LockMutex(writer->mutex);
+
+		struct jeDataWrite* lastQueuedWrite = NULL;
+		uint32_t queuedCount = jeArray_getCount(&writer->queuedWrites);
+		for (uint32_t i = 0; i < queuedCount; i++) {
+			struct jeDataWrite* queuedWrite = (struct jeDataWrite*)jeArray_get(&writer->queuedWrites, i);
+			if (strcmp(jeString_get(&queuedWrite->filename, 0), filename) == 0) {
+				lastQueuedWrite = queuedWrite;
+			}
+		}
+
+		if ((lastQueuedWrite != NULL) && !lastQueuedWrite->append && !append) {
+			lastQueuedWrite->data = data;
+			lastQueuedWrite->dataSize = dataSize;
+			*outRequestId = lastQueuedWrite->requestId;
+			*outCoalesced = true;
+		} else {
+			write.requestId = writer->nextRequestId;
+			writer->nextRequestId++;
+
+			ok = ok && jeString_create(&write.filename);
+			ok = ok && jeString_set(&write.filename, filename, (uint32_t)strlen(filename) + 1);
+			ok = ok && jeArray_push(&writer->queuedWrites, (const void*)&write, 1);
+
+			if (ok) {
+				*outRequestId = write.requestId;
+			} else {
+				JE_ERROR("failed to queue write, filename=%s", filename);
+				jeString_destroy(&write.filename);
+			}
+		}
+
+		SDL_CondBroadcast(writer->condition);
+		SDL_UnlockMutex(writer->mutex);
+	}
+
+	if (ok) {
+		JE_DEBUG(
+			"write queued, filename=%s, requestId=%u, coalesced=%u, append=%u, microseconds=%u",
+			filename,
+			*outRequestId,
+			(uint32_t)*outCoalesced,
+			(uint32_t)append,
+			(uint32_t)(((SDL_GetPerformanceCounter() - write.queuedTime) * 1000000) / SDL_GetPerformanceFrequency()));
+	}
+
+	return ok;
+}
+void jeDataWriter_wait(struct jeDataWriter* writer, const char* optFilename) {
+	JE_TRACE("writer=%p, optFilename=%s", (void*)writer, (optFilename != NULL) ? optFilename : "NULL");
+
+	if (writer != NULL) {
+		SDL_LockMutex(writer->mutex);
+		while (jeDataWriter_getWriting(writer, optFilename)) {
+			SDL_CondWait(writer->condition, writer->mutex);
+		}
+		SDL_UnlockMutex(writer->mutex);
+	}
+}
+bool jeDataWriter_takeCompletedWrites(struct jeDataWriter* writer, struct jeArray* outCompletedWrites) {
+	JE_TRACE("writer=%p, outCompletedWrites=%p", (void*)writer, (void*)outCompletedWrites);
+
+	bool ok = true;
+
+	if (writer == NULL) {
+		JE_ERROR("writer=NULL");
+		ok = false;
+	}
+
+	ok = ok && jeArray_create(outCompletedWrites, sizeof(struct jeDataWrite));
+
+	if (ok) {
+		SDL_LockMutex(writer->mutex);
+		if (jeArray_getCount(&writer->completedWrites) > 0) {
+			struct jeArray completedWrites = writer->completedWrites;
+			writer->completedWrites = *outCompletedWrites;
+			*outCompletedWrites = completedWrites;
+		}
+		SDL_UnlockMutex(writer->mutex);
+	}
+
+	return ok;
+}
+void jeDataWriter_destroyCompletedWrites(struct jeArray* completedWrites) {
+	uint32_t completedCount = jeArray_getCount(completedWrites);
+	for (uint32_t i = 0; i < completedCount; i++) {
+		jeString_destroy(&((struct jeDataWrite*)jeArray_get(completedWrites, i))->filename);
+	}
+	jeArray_destroy(completedWrites);
+}
+
+void jeData_runTests() {
+#if JE_DEBUGGING
+	JE_DEBUG(" ");
+
+	static const char testData[] = "jeDataTest data";
+	static const uint32_t testDataSize = (uint32_t)(sizeof(testData) - 1);
+
+	struct jeString data = {0};
+	JE_ASSERT(jeString_create(&data));
+
+	bool compressed = false;
+	uint32_t sizeHint = 0;
+
+	{
+		JE_ASSERT(jeData_write(JE_DATA_TEST_FILENAME, testData, testDataSize + 1, false));
+		JE_ASSERT(jeData_getInfo(JE_DATA_TEST_FILENAME, &compressed, &sizeHint));
+		JE_ASSERT(compressed && (sizeHint == (testDataSize + 1)));
+		JE_ASSERT(jeData_read(&data, JE_DATA_TEST_FILENAME, sizeHint));
+		JE_ASSERT(jeString_getCount(&data) == testDataSize);
+		JE_ASSERT(memcmp(jeString_get(&data, 0), testData, testDataSize) == 0);
+
+		/*Appended members read back as one stream*/
+		JE_ASSERT(jeData_write(JE_DATA_TEST_FILENAME, testData, testDataSize, false));
+		JE_ASSERT(jeData_write(JE_DATA_TEST_FILENAME, testData, testDataSize, true));
+		JE_ASSERT(jeData_read(&data, JE_DATA_TEST_FILENAME, 0));
+		JE_ASSERT(jeString_getCount(&data) == (testDataSize * 2));
+		JE_ASSERT(memcmp(jeString_get(&data, testDataSize), testData, testDataSize) == 0);
+	}
+
+	{
+		FILE* file = fopen(JE_DATA_TEST_FILENAME, "wb");
+		JE_ASSERT(file != NULL);
+		JE_ASSERT(fwrite(testData, 1, testDataSize, file) == testDataSize);
+		fclose(file);
+
+		JE_ASSERT(jeData_getInfo(JE_DATA_TEST_FILENAME, &compressed, &sizeHint));
+		JE_ASSERT(!compressed && (sizeHint == testDataSize));
+		JE_ASSERT(jeData_read(&data, JE_DATA_TEST_FILENAME, sizeHint));
+		JE_ASSERT(jeString_getCount(&data) == testDataSize);
+
+		if (jeDataMapping_getSupported()) {
+			struct jeDataMapping mapping;
+			JE_ASSERT(jeDataMapping_create(&mapping, JE_DATA_TEST_FILENAME));
+			JE_ASSERT(mapping.size == testDataSize);
+			JE_ASSERT(memcmp(mapping.data, testData, testDataSize) == 0);
+			jeDataMapping_destroy(&mapping);
+		}
+	}
+
+	{
+		/*The second write is coalesced into the first if the worker hasn't started it yet*/
+		struct jeDataWriter* writer = jeDataWriter_create();
+		JE_ASSERT(writer != NULL);
+
+		uint32_t requestIds[3] = {0, 0, 0};
+		bool coalesced[3] = {false, false, false};
+		JE_ASSERT(jeDataWriter_queue(
+			writer, JE_DATA_TEST_FILENAME, testData, 4, false, &requestIds[0], &coalesced[0]));
+		JE_ASSERT(jeDataWriter_queue(
+			writer, JE_DATA_TEST_FILENAME, testData, testDataSize, false, &requestIds[1], &coalesced[1]));
+		JE_ASSERT(jeDataWriter_queue(
+			writer, JE_DATA_TEST_FILENAME, testData, testDataSize, true, &requestIds[2], &coalesced[2]));
+		JE_ASSERT(!coalesced[0] && !coalesced[2]);
+		JE_ASSERT(coalesced[1] == (requestIds[1] == requestIds[0]));
+		JE_ASSERT(requestIds[2] != requestIds[1]);
+
+		jeDataWriter_wait(writer, JE_DATA_TEST_FILENAME);
+
+		struct jeArray completedWrites;
+		JE_ASSERT(jeDataWriter_takeCompletedWrites(writer, &completedWrites));
+		JE_ASSERT(jeArray_getCount(&completedWrites) == (coalesced[1] ? 2U : 3U));
+		for (uint32_t i = 0; i < jeArray_getCount(&completedWrites); i++) {
+			JE_ASSERT(((struct jeDataWrite*)jeArray_get(&completedWrites, i))->ok);
+		}
+		jeDataWriter_destroyCompletedWrites(&completedWrites);
+
+		JE_ASSERT(jeData_read(&data, JE_DATA_TEST_FILENAME, 0));
+		JE_ASSERT(jeString_getCount(&data) == (testDataSize * 2));
+
+		jeDataWriter_destroy(writer);
+	}
+
+	remove(JE_DATA_TEST_FILENAME);
+	jeString_destroy(&data);
+#endif
+}
+void jeData_runBenchmarks() {
+	static const uint32_t dataSizes[] = {1024, 1024 * 1024, 16 * 1024 * 1024};
+	static const uint32_t dataSizesCount = (uint32_t)(sizeof(dataSizes) / sizeof(dataSizes[0]));
+	static const uint32_t dataBenchmarkBytesTotal = 64 * 1024 * 1024;
+	static const uint32_t dataWriteBenchmarkBytesTotal = 4 * 1024 * 1024;
+
+	bool ok = true;
+
+	struct jeString data;
+	struct jeString readData;
+	ok = ok && jeString_create(&data);
+	ok = ok && jeString_create(&readData);
+
+	struct jeDataWriter* writer = NULL;
+	if (ok) {
+		writer = jeDataWriter_create();
+		ok = (writer != NULL);
+	}
+
+	for (uint32_t i = 0; ok && (i < dataSizesCount); i++) {
+		uint32_t dataSize = dataSizes[i];
+		uint32_t iterations = dataBenchmarkBytesTotal / dataSize;
+
+		ok = ok && jeString_setCount(&data, dataSize);
+		for (uint32_t j = 0; ok && (j < dataSize); j++) {
+			*jeString_get(&data, j) = (char)('a' + ((j * 7) % 26));
+		}
+
+		for (uint32_t compressed = 0; ok && (compressed <= 1); compressed++) {
+			if (compressed) {
+				ok = jeData_write(JE_DATA_BENCHMARK_FILENAME, jeString_get(&data, 0), dataSize, false);
+			} else {
+				FILE* file = fopen(JE_DATA_BENCHMARK_FILENAME, "wb");
+				ok = (file != NULL) && (fwrite(jeString_get(&data, 0), 1, dataSize, file) == dataSize);
+				if (file != NULL) {
+					fclose(file);
+				}
+			}
+
+			/*Reads the way the client does: large uncompressed files are mapped and copied, the rest are read*/
+			double startSeconds = jeBenchmark_getSeconds();
+			for (uint32_t j = 0; ok && (j < iterations); j++) {
+				bool dataCompressed = false;
+				uint32_t sizeHint = 0;
+				ok = jeData_getInfo(JE_DATA_BENCHMARK_FILENAME, &dataCompressed, &sizeHint);
+
+				if (ok && !dataCompressed && jeDataMapping_getSupported() && (sizeHint >= JE_DATA_MAPPING_MIN_SIZE)) {
+					struct jeDataMapping mapping;
+					ok = jeDataMapping_create(&mapping, JE_DATA_BENCHMARK_FILENAME);
+					ok = ok && (mapping.size == dataSize);
+					ok = ok && jeString_set(&readData, mapping.data, (uint32_t)mapping.size);
+					jeDataMapping_destroy(&mapping);
+				} else if (ok) {
+					ok = jeData_read(&readData, JE_DATA_BENCHMARK_FILENAME, sizeHint);
+					ok = ok && (jeString_getCount(&readData) == dataSize);
+				}
+			}
+			double seconds = jeBenchmark_getSeconds() - startSeconds;
+
+			jeBenchmark_log(
+				je_temp_buffer_format("jeData_read, bytes=%u, compressed=%u", dataSize, compressed),
+				seconds,
+				iterations);
+		}
+
+		/*Writes are timed on the main thread only; clock() would also count the worker thread*/
+		uint32_t writeIterations = (dataWriteBenchmarkBytesTotal + dataSize - 1) / dataSize;
+		for (uint32_t async = 0; ok && (async <= 1); async++) {
+			Uint64 ticks = 0;
+			for (uint32_t j = 0; ok && (j < writeIterations); j++) {
+				Uint64 startTicks = SDL_GetPerformanceCounter();
+				if (async) {
+					uint32_t requestId = 0;
+					bool coalesced = false;
+					ok = jeDataWriter_queue(
+						writer,
+						JE_DATA_BENCHMARK_FILENAME,
+						jeString_get(&data, 0),
+						dataSize,
+						false,
+						&requestId,
+						&coalesced);
+				} else {
+					ok = jeData_write(JE_DATA_BENCHMARK_FILENAME, jeString_get(&data, 0), dataSize, false);
+				}
+				ticks += SDL_GetPerformanceCounter() - startTicks;
+
+				jeDataWriter_wait(writer, NULL);
+
+				struct jeArray completedWrites;
+				ok = ok && jeDataWriter_takeCompletedWrites(writer, &completedWrites);
+				if (ok) {
+					jeDataWriter_destroyCompletedWrites(&completedWrites);
+				}
+			}
+			double seconds = (double)ticks / (double)SDL_GetPerformanceFrequency();
+
+			jeBenchmark_log(
+				je_temp_buffer_format("jeData_write, bytes=%u, async=%u", dataSize, async), seconds, writeIterations);
+		}
+	}
+
+	jeDataWriter_destroy(writer);
+	remove(JE_DATA_BENCHMARK_FILENAME);
+	jeString_destroy(&readData);
+	jeString_destroy(&data);
+
+	if (!ok) {
+		JE_ERROR("benchmark failed");
+	}
+}
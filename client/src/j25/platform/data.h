@@ -0,0 +1,72 @@
+#pragma once
+
+#if !defined(JE_PLATFORM_DATA_H)
+#define JE_PLATFORM_DATA_H
+
+#include <j25/core/common.h>
+#include <j25/core/container.h>
+
+/*Uncompressed files at least this big are mapped rather than read, when mapping is supported*/
+#define JE_DATA_MAPPING_MIN_SIZE (64 * 1024)
+
+/*A read-only view of a whole file.  Zero-length files are mapped as an empty string.*/
+struct jeDataMapping {
+	const char* data;
+	size_t size;
+	void* mapping;
+	size_t mappingSize;
+};
+
+/*A write queued by jeDataWriter_queue().  The data is borrowed, and must stay valid until the write completes.*/
+struct jeDataWrite {
+	uint32_t requestId;
+	struct jeString filename;
+	const char* data;
+	size_t dataSize;
+	uint64_t queuedTime;
+	uint32_t workerMicroseconds;
+	/*From queueing to completion*/
+	uint32_t latencyMicroseconds;
+	bool append;
+	bool ok;
+};
+
+struct jeDataWriter;
+
+/*The size hint is the uncompressed size of gzip files (mod 2^32), and the file size otherwise*/
+JE_API_PUBLIC bool jeData_getInfo(const char* filename, bool* outCompressed, uint32_t* outSizeHint);
+/*Reads gzip or uncompressed files into outData, replacing its contents.  A trailing null terminator is excluded.*/
+JE_API_PUBLIC bool jeData_read(struct jeString* outData, const char* filename, uint32_t sizeHint);
+/*Writes data as gzip.  Appends add another gzip member, which jeData_read() reads back as if it were one stream.*/
+JE_API_PUBLIC bool jeData_write(const char* filename, const char* data, size_t dataSize, bool append);
+
+JE_API_PUBLIC bool jeDataMapping_getSupported();
+/*A trailing null terminator is excluded from the mapping's size*/
+JE_API_PUBLIC bool jeDataMapping_create(struct jeDataMapping* mapping, const char* filename);
+JE_API_PUBLIC void jeDataMapping_destroy(struct jeDataMapping* mapping);
+
+/*Compresses and writes queued data on a worker thread, in the order it was queued.  A write to a file that is
+ * still queued is coalesced into the latest one, unless either appends.  Destroying the writer finishes queued writes
+ * first, so saves made right before closing aren't lost.*/
+JE_API_PUBLIC struct jeDataWriter* jeDataWriter_create();
+JE_API_PUBLIC void jeDataWriter_destroy(struct jeDataWriter* writer);
+/*outRequestId is shared by coalesced writes, which complete once*/
+JE_API_PUBLIC bool jeDataWriter_queue(
+	struct jeDataWriter* writer,
+	const char* filename,
+	const char* data,
+	size_t dataSize,
+	bool append,
+	uint32_t* outRequestId,
+	bool* outCoalesced);
+/*Waits for queued and active writes to optFilename, or to any file if optFilename is NULL*/
+JE_API_PUBLIC void jeDataWriter_wait(struct jeDataWriter* writer, const char* optFilename);
+/*Moves completed writes into outCompletedWrites, an uninitialized array of jeDataWrite, which must be destroyed with
+ * jeDataWriter_destroyCompletedWrites()*/
+JE_API_PUBLIC bool jeDataWriter_takeCompletedWrites(struct jeDataWriter* writer, struct jeArray* outCompletedWrites);
+JE_API_PUBLIC void jeDataWriter_destroyCompletedWrites(struct jeArray* completedWrites);
+
+JE_API_PUBLIC void jeData_runTests();
+JE_API_PUBLIC void jeData_runBenchmarks();
+
+#endif
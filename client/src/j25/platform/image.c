@@ -106,6 +106,25 @@ void jeImage_destroy(struct jeImage* image) {
 		image->width = 0;
 	}
 }
+bool jeImage_getBinaryAlpha(const struct jeImage* image) {
+	JE_TRACE("image=%p", (void*)image);
+
+	bool binaryAlpha = true;
+
+	if (image == NULL) {
+		JE_ERROR("image=NULL");
+		binaryAlpha = false;
+	}
+
+	if (binaryAlpha) {
+		const struct jeColorRGBA32* pixels = (const struct jeColorRGBA32*)image->buffer.data;
+		for (uint32_t i = 0; binaryAlpha && (i < image->buffer.count); i++) {
+			binaryAlpha = (pixels[i].a == 0x00) || (pixels[i].a == 0xFF);
+		}
+	}
+
+	return binaryAlpha;
+}
 
 void jeImage_runTests() {
 #if JE_DEBUGGING
@@ -114,6 +133,11 @@ void jeImage_runTests() {
 	struct jeImage image;
 	const struct jeColorRGBA32 white = {0xFF, 0xFF, 0xFF, 0xFF};
 	JE_ASSERT(jeImage_create(&image, 16, 16, white));
+	JE_ASSERT(jeImage_getBinaryAlpha(&image));
+	((struct jeColorRGBA32*)image.buffer.data)[3].a = 0x00;
+	JE_ASSERT(jeImage_getBinaryAlpha(&image));
+	((struct jeColorRGBA32*)image.buffer.data)[5].a = 0x80;
+	JE_ASSERT(jeImage_getBinaryAlpha(&image) == false);
 	jeImage_destroy(&image);
 #endif
 }
@@ -22,6 +22,8 @@ struct jeImage {
 JE_API_PUBLIC bool jeImage_create(struct jeImage* image, uint32_t width, uint32_t height, struct jeColorRGBA32 fill);
 JE_API_PUBLIC bool jeImage_createFromPNGFile(struct jeImage* image, const char* filename);
 JE_API_PUBLIC void jeImage_destroy(struct jeImage* image);
+/*True if every texel is either fully transparent or fully opaque*/
+JE_API_PUBLIC bool jeImage_getBinaryAlpha(const struct jeImage* image);
 
 JE_API_PUBLIC void jeImage_runTests();
 
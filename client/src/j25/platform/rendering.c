@@ -15,13 +15,93 @@
 
 #define JE_PRIMITIVE_TYPE_DEBUG_STRING_BUFFER_SIZE JE_VERTEX_ARRAY_DEBUG_STRING_BUFFER_SIZE
 
-/* Sort key which preserves both depth and order*/
+#define JE_PRIMITIVE_SORT_RADIX_BITS 8
+#define JE_PRIMITIVE_SORT_RADIX_SIZE (1U << JE_PRIMITIVE_SORT_RADIX_BITS)
+#define JE_PRIMITIVE_SORT_RADIX_MASK (JE_PRIMITIVE_SORT_RADIX_SIZE - 1U)
+#define JE_PRIMITIVE_SORT_RADIX_PASSES (32 / JE_PRIMITIVE_SORT_RADIX_BITS)
+
+#define JE_PRIMITIVE_SORT_BENCHMARK_PRIMITIVES_TOTAL 1000000
+#define JE_PRIMITIVE_SORT_BENCHMARK_DEPTH_COUNT 16
+
+/*Submissions index into the vertex buffer's quads, or into its instances when this bit is set*/
+#define JE_PRIMITIVE_SUBMISSION_INSTANCE_BIT 0x80000000U
+#define JE_PRIMITIVE_SUBMISSION_OPAQUE_BIT 0x40000000U
+#define JE_PRIMITIVE_SUBMISSION_TEXTURE_SHIFT 26U
+#define JE_PRIMITIVE_SUBMISSION_TEXTURE_MASK 0x3C000000U
+#define JE_PRIMITIVE_SUBMISSION_INDEX_MASK 0x03FFFFFFU
+
+/*Which primitives share a depth, tracked while sorting buffers with opaque primitives*/
+#define JE_PRIMITIVE_DEPTH_STATE_USED_BIT 0x1U
+#define JE_PRIMITIVE_DEPTH_STATE_TRANSLUCENT_BIT 0x2U
+#define JE_PRIMITIVE_DEPTH_STATE_OPAQUE_BIT 0x4U
+#define JE_PRIMITIVE_DEPTH_STATE_CONTESTED_BIT 0x8U
+#define JE_PRIMITIVE_DEPTH_STATE_TEXTURE_SHIFT 4U
+#define JE_PRIMITIVE_DEPTH_STATE_TEXTURE_MASK 0xF0U
+#define JE_PRIMITIVE_DEPTH_STATE_MIN_CAPACITY_BITS 4U
+
+/* Sort key which preserves both depth and order.  Depth is the primitive z mapped to an unsigned integer,
+ * such that sorting depth ascending orders primitives back-to-front (greatest z first)*/
 struct jePrimitiveSortKey {
+	uint32_t depth;
+	uint32_t index;
+};
+
+/*Sort key of the pre-radix jeVertexBuffer_sort(), kept only as the benchmark reference*/
+struct jePrimitiveReferenceSortKey {
 	float z;
 	uint32_t index;
 };
 
+/* Open addressing hash table entry, keyed by sort key depth.  A depth is contested if opaque primitives share it
+ * with translucent primitives or with opaque primitives of another texture*/
+struct jePrimitiveDepthState {
+	uint32_t depth;
+	uint32_t state;
+};
+
+/*Moves primitives into draw order, tracking the draw ranges they form*/
+struct jePrimitiveGather {
+	const char* vertices;
+	char* sortedVertices;
+	const struct jeInstance* instances;
+	struct jeInstance* sortedInstances;
+	size_t primitiveSize;
+	uint32_t primitiveVertexCount;
+
+	uint32_t sortedPrimitiveCount;
+	uint32_t sortedInstanceCount;
+	struct jeDrawRange drawRange;
+	struct jeArray* drawRanges;
+};
+
+uint32_t jePrimitiveSortKey_getDepth(float z);
 int jePrimitiveSortKey_less(const void* rawSortKeyA, const void* rawSortKeyB);
+struct jePrimitiveSortKey* jePrimitiveSortKey_radixSort(
+	struct jePrimitiveSortKey* sortKeys, struct jePrimitiveSortKey* scratchSortKeys, uint32_t count);
+
+int jePrimitiveReferenceSortKey_less(const void* rawSortKeyA, const void* rawSortKeyB);
+
+struct jePrimitiveDepthState* jePrimitiveDepthState_find(
+	struct jePrimitiveDepthState* depthStates, uint32_t capacityBits, uint32_t depth);
+void jePrimitiveDepthState_add(struct jePrimitiveDepthState* depthState, uint32_t depth, uint32_t submission);
+
+bool jePrimitiveGather_push(struct jePrimitiveGather* gather, uint32_t submission);
+bool jePrimitiveGather_flush(struct jePrimitiveGather* gather);
+
+int32_t jeVertex_packRound(float value, float min, float max);
+bool jeVertex_getOpaque(const struct jeVertex* vertices, uint32_t vertexCount);
+uint32_t jeVertexBuffer_getSubmissionFlags(struct jeVertexBuffer* vertexBuffer, bool opaque, uint32_t textureId);
+void jeVertexBuffer_pushVertices(
+	struct jeVertexBuffer* vertexBuffer, const struct jeVertex* vertices, uint32_t count, uint32_t flags);
+void jeVertexBuffer_pushInstance(
+	struct jeVertexBuffer* vertexBuffer, const struct jeInstance* instance, uint32_t flags);
+bool jeVertexBuffer_sortImpl(
+	struct jeVertexBuffer* vertexBuffer,
+	uint32_t primitiveType,
+	bool useRadixSort,
+	void* optDestVertices,
+	void* optDestInstances);
+bool jeVertexBuffer_sortReference(struct jeVertexBuffer* vertexBuffer, uint32_t primitiveType);
 
 bool jePrimitiveType_getValid(uint32_t primitiveType) {
 	bool isValid = true;
@@ -69,6 +149,46 @@ uint32_t jePrimitiveType_getVertexCount(uint32_t primitiveType) {
 
 	return vertexCount;
 }
+uint32_t jePrimitiveSortKey_getDepth(float z) {
+	uint32_t bits = 0;
+	memcpy((void*)&bits, (const void*)&z, sizeof(bits));
+
+	/*-0 and +0 compare equal as floats, so they must share a depth*/
+	if (bits == 0x80000000U) {
+		bits = 0;
+	}
+
+	/*Map the float bit pattern to an unsigned integer with the same ordering: negative floats are flipped
+	 * entirely (greater magnitude = lesser value), positive floats only have their sign bit set*/
+	uint32_t ascendingBits = ((bits & 0x80000000U) != 0) ? ~bits : (bits | 0x80000000U);
+
+	/*Invert, as primitives with greater z are drawn first*/
+	return ~ascendingBits;
+}
+bool jeVertexFormat_getValid(uint32_t vertexFormat) {
+	return vertexFormat < JE_VERTEX_FORMAT_COUNT;
+}
+uint32_t jeVertexFormat_getVertexSize(uint32_t vertexFormat) {
+	JE_TRACE("vertexFormat=%u", vertexFormat);
+
+	uint32_t vertexSize = (uint32_t)sizeof(struct jeVertex);
+	switch (vertexFormat) {
+		case JE_VERTEX_FORMAT_FLOAT: {
+			vertexSize = (uint32_t)sizeof(struct jeVertex);
+			break;
+		}
+		case JE_VERTEX_FORMAT_PACKED: {
+			vertexSize = (uint32_t)sizeof(struct jeVertexPacked);
+			break;
+		}
+		default: {
+			JE_ERROR("unexpected vertexFormat, vertexFormat=%u", vertexFormat);
+			break;
+		}
+	}
+
+	return vertexSize;
+}
 int jePrimitiveSortKey_less(const void* rawSortKeyA, const void* rawSortKeyB) {
 	const struct jePrimitiveSortKey* sortKeyA = (const struct jePrimitiveSortKey*)rawSortKeyA;
 	const struct jePrimitiveSortKey* sortKeyB = (const struct jePrimitiveSortKey*)rawSortKeyB;
@@ -89,9 +209,9 @@ int jePrimitiveSortKey_less(const void* rawSortKeyA, const void* rawSortKeyB) {
 
 	int result = 0;
 	if (ok) {
-		if (sortKeyA->z > sortKeyB->z) {
+		if (sortKeyA->depth < sortKeyB->depth) {
 			result = -1;
-		} else if (sortKeyA->z < sortKeyB->z) {
+		} else if (sortKeyA->depth > sortKeyB->depth) {
 			result = 1;
 		} else if (sortKeyA->index < sortKeyB->index) {
 			result = -1;
@@ -102,6 +222,140 @@ int jePrimitiveSortKey_less(const void* rawSortKeyA, const void* rawSortKeyB) {
 
 	return result;
 }
+struct jePrimitiveSortKey* jePrimitiveSortKey_radixSort(
+	struct jePrimitiveSortKey* sortKeys, struct jePrimitiveSortKey* scratchSortKeys, uint32_t count) {
+	/* Stable least-significant-digit radix sort on depth.  Keys are generated in submission order, so stability
+	 * alone keeps primitives of equal depth in submission order, without sorting on index.
+	 *
+	 * Returns whichever of the two buffers holds the sorted keys.*/
+
+	uint32_t histograms[JE_PRIMITIVE_SORT_RADIX_PASSES][JE_PRIMITIVE_SORT_RADIX_SIZE];
+	memset((void*)histograms, 0, sizeof(histograms));
+
+	for (uint32_t i = 0; i < count; i++) {
+		uint32_t depth = sortKeys[i].depth;
+		for (uint32_t pass = 0; pass < JE_PRIMITIVE_SORT_RADIX_PASSES; pass++) {
+			histograms[pass][(depth >> (pass * JE_PRIMITIVE_SORT_RADIX_BITS)) & JE_PRIMITIVE_SORT_RADIX_MASK]++;
+		}
+	}
+
+	struct jePrimitiveSortKey* srcSortKeys = sortKeys;
+	struct jePrimitiveSortKey* destSortKeys = scratchSortKeys;
+	for (uint32_t pass = 0; (pass < JE_PRIMITIVE_SORT_RADIX_PASSES) && (count > 0); pass++) {
+		uint32_t shift = pass * JE_PRIMITIVE_SORT_RADIX_BITS;
+		uint32_t* histogram = histograms[pass];
+
+		/*Skip passes where all keys share the same digit; scenes tend to use few distinct depths*/
+		if (histogram[(srcSortKeys[0].depth >> shift) & JE_PRIMITIVE_SORT_RADIX_MASK] == count) {
+			continue;
+		}
+
+		uint32_t offset = 0;
+		for (uint32_t digit = 0; digit < JE_PRIMITIVE_SORT_RADIX_SIZE; digit++) {
+			uint32_t digitCount = histogram[digit];
+			histogram[digit] = offset;
+			offset += digitCount;
+		}
+
+		for (uint32_t i = 0; i < count; i++) {
+			uint32_t digit = (srcSortKeys[i].depth >> shift) & JE_PRIMITIVE_SORT_RADIX_MASK;
+			destSortKeys[histogram[digit]] = srcSortKeys[i];
+			histogram[digit]++;
+		}
+
+		struct jePrimitiveSortKey* swapSortKeys = srcSortKeys;
+		srcSortKeys = destSortKeys;
+		destSortKeys = swapSortKeys;
+	}
+
+	return srcSortKeys;
+}
+struct jePrimitiveDepthState* jePrimitiveDepthState_find(
+	struct jePrimitiveDepthState* depthStates, uint32_t capacityBits, uint32_t depth) {
+	/*Returns the entry for the depth, or the unused entry it would be added at*/
+	uint32_t mask = (1U << capacityBits) - 1U;
+	uint32_t slot = (depth * 0x9E3779B1U) >> (32U - capacityBits);
+
+	while (((depthStates[slot].state & JE_PRIMITIVE_DEPTH_STATE_USED_BIT) != 0) &&
+		   (depthStates[slot].depth != depth)) {
+		slot = (slot + 1U) & mask;
+	}
+
+	return &depthStates[slot];
+}
+void jePrimitiveDepthState_add(struct jePrimitiveDepthState* depthState, uint32_t depth, uint32_t submission) {
+	uint32_t state = depthState->state | JE_PRIMITIVE_DEPTH_STATE_USED_BIT;
+
+	if ((submission & JE_PRIMITIVE_SUBMISSION_OPAQUE_BIT) != 0) {
+		uint32_t textureId =
+			(submission & JE_PRIMITIVE_SUBMISSION_TEXTURE_MASK) >> JE_PRIMITIVE_SUBMISSION_TEXTURE_SHIFT;
+		uint32_t textureBits = textureId << JE_PRIMITIVE_DEPTH_STATE_TEXTURE_SHIFT;
+
+		if (((state & JE_PRIMITIVE_DEPTH_STATE_TRANSLUCENT_BIT) != 0) ||
+			(((state & JE_PRIMITIVE_DEPTH_STATE_OPAQUE_BIT) != 0) &&
+			 ((state & JE_PRIMITIVE_DEPTH_STATE_TEXTURE_MASK) != textureBits))) {
+			state |= JE_PRIMITIVE_DEPTH_STATE_CONTESTED_BIT;
+		}
+		if ((state & JE_PRIMITIVE_DEPTH_STATE_OPAQUE_BIT) == 0) {
+			state |= JE_PRIMITIVE_DEPTH_STATE_OPAQUE_BIT | textureBits;
+		}
+	} else {
+		if ((state & JE_PRIMITIVE_DEPTH_STATE_OPAQUE_BIT) != 0) {
+			state |= JE_PRIMITIVE_DEPTH_STATE_CONTESTED_BIT;
+		}
+		state |= JE_PRIMITIVE_DEPTH_STATE_TRANSLUCENT_BIT;
+	}
+
+	depthState->depth = depth;
+	depthState->state = state;
+}
+bool jePrimitiveGather_push(struct jePrimitiveGather* gather, uint32_t submission) {
+	bool ok = true;
+
+	bool instanced = (submission & JE_PRIMITIVE_SUBMISSION_INSTANCE_BIT) != 0;
+	bool opaque = (submission & JE_PRIMITIVE_SUBMISSION_OPAQUE_BIT) != 0;
+	uint32_t textureId = (submission & JE_PRIMITIVE_SUBMISSION_TEXTURE_MASK) >> JE_PRIMITIVE_SUBMISSION_TEXTURE_SHIFT;
+	uint32_t index = submission & JE_PRIMITIVE_SUBMISSION_INDEX_MASK;
+
+	struct jeDrawRange* drawRange = &gather->drawRange;
+	if ((drawRange->count > 0) &&
+		((drawRange->instanced != instanced) || (drawRange->opaque != opaque) || (drawRange->textureId != textureId))) {
+		ok = ok && jePrimitiveGather_flush(gather);
+	}
+
+	if (drawRange->count == 0) {
+		drawRange->instanced = instanced;
+		drawRange->opaque = opaque;
+		drawRange->textureId = textureId;
+		drawRange->start = instanced ? gather->sortedInstanceCount
+									 : (gather->sortedPrimitiveCount * gather->primitiveVertexCount);
+	}
+
+	if (instanced) {
+		gather->sortedInstances[gather->sortedInstanceCount] = gather->instances[index];
+		gather->sortedInstanceCount++;
+		drawRange->count++;
+	} else {
+		memcpy(
+			(void*)(gather->sortedVertices + (gather->primitiveSize * gather->sortedPrimitiveCount)),
+			(const void*)(gather->vertices + (gather->primitiveSize * index)),
+			gather->primitiveSize);
+		gather->sortedPrimitiveCount++;
+		drawRange->count += gather->primitiveVertexCount;
+	}
+
+	return ok;
+}
+bool jePrimitiveGather_flush(struct jePrimitiveGather* gather) {
+	bool ok = true;
+
+	if (gather->drawRange.count > 0) {
+		ok = jeArray_push(gather->drawRanges, (const void*)&gather->drawRange, 1);
+		gather->drawRange.count = 0;
+	}
+
+	return ok;
+}
 
 const char* jeVertex_getDebugString(const struct jeVertex* vertex) {
 	if (vertex == NULL) {
@@ -170,17 +424,17 @@ const char* jeVertex_primitiveGetDebugString(const struct jeVertex* vertices, ui
 	return jeVertex_arrayGetDebugString(vertices, primitiveVertexCount);
 }
 void jeVertex_createPointQuad(struct jeVertex* quadVertices, const struct jeVertex* pointVertices) {
-	/* Render point as two triangles represented by 6 vertices.
+	/* Render point as a quad of 4 vertices.
 	 *
-	 * For visualization below, source indices = A..B, dest indices = 0..5,
-	 * offset source indices = A+..B+ (x+=1 or y+=1 depending on line slope, see below)
+	 * For visualization below, source index = A, dest indices = 0..3,
+	 * offset source indices = A+ (x+=1 or y+=1)
 	 *
-	 *  0    2,3
-	 *  x-----x+
+	 *  0     1
+	 *  A-----x+
 	 *  | \   |
 	 *  |   \ |
 	 *  y+---xy+
-	 * 1,4    5
+	 *  2     3
 	 *
 	 */
 
@@ -205,33 +459,31 @@ void jeVertex_createPointQuad(struct jeVertex* quadVertices, const struct jeVert
 
 		/*Give the triangles actual width, as OpenGL won't render degenerate triangles*/
 		static const float pointWidth = 1.0F;
-		quadVertices[2].x += pointWidth;
+		quadVertices[1].x += pointWidth;
 		quadVertices[3].x += pointWidth;
-		quadVertices[5].x += pointWidth;
 
-		quadVertices[1].y += pointWidth;
-		quadVertices[4].y += pointWidth;
-		quadVertices[5].y += pointWidth;
+		quadVertices[2].y += pointWidth;
+		quadVertices[3].y += pointWidth;
 	}
 }
 void jeVertex_createLineQuad(struct jeVertex* quadVertices, const struct jeVertex* lineVertices) {
-	/* Render line as two triangles represented by 6 vertices.
+	/* Render line as a quad of 4 vertices.
 	 *
-	 * For visualization below, source indices = A..B, dest indices = 0..5,
+	 * For visualization below, source indices = A..B, dest indices = 0..3,
 	 * offset source indices = A+..B+ (x+=1 or y+=1 depending on line slope, see below)
 	 *
 	 * Vertical/mostly vertical line A to B:
-	 * 0 A---A+ 1,4
-	 *    \ / \
-	 * 2,3 B---B+ 5
+	 *   0 A---A+ 1
+	 *      \ / \
+	 *     2 B---B+ 3
 	 *
 	 * Horizontal/mostly horizontal line A to B:
-	 *  0    2,3
+	 *  0     2
 	 *  A-----B
 	 *  | \   |
 	 *  |   \ |
 	 *  A+----B+
-	 * 1,4    5
+	 *  1     3
 	 *
 	 * NOTE: vertices are not necessarily clockwise, thus not compatible with back-face culling.
 	 */
@@ -251,13 +503,10 @@ void jeVertex_createLineQuad(struct jeVertex* quadVertices, const struct jeVerte
 	}
 
 	if (ok) {
-		for (uint32_t i = 0; i < JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT; i++) {
-			quadVertices[i] = lineVertices[0];
-		}
-
+		quadVertices[0] = lineVertices[0];
+		quadVertices[1] = lineVertices[0];
 		quadVertices[2] = lineVertices[1];
 		quadVertices[3] = lineVertices[1];
-		quadVertices[5] = lineVertices[1];
 
 		/*Give the triangles actual width, as OpenGL won't render degenerate triangles*/
 		static const float lineWidth = 1.0F;
@@ -267,14 +516,12 @@ void jeVertex_createLineQuad(struct jeVertex* quadVertices, const struct jeVerte
 		float isVerticalLine = lineWidth * (float)(lengthX <= lengthY);
 		quadVertices[1].x += isVerticalLine;
 		quadVertices[1].y += isHorizontalLine;
-		quadVertices[4].x += isVerticalLine;
-		quadVertices[4].y += isHorizontalLine;
-		quadVertices[5].x += isVerticalLine;
-		quadVertices[5].y += isHorizontalLine;
+		quadVertices[3].x += isVerticalLine;
+		quadVertices[3].y += isHorizontalLine;
 	}
 }
 void jeVertex_createSpriteQuad(struct jeVertex* quadVertices, const struct jeVertex* spriteVertices) {
-	/* Render sprite as two triangles represented by 6 clockwise vertices */
+	/* Render sprite as a quad of 4 vertices, ordered top-left, top-right, bottom-left, bottom-right */
 
 	JE_TRACE("quadVertices=%p, spriteVertices=%p", (void*)quadVertices, (void*)spriteVertices);
 
@@ -300,17 +547,219 @@ void jeVertex_createSpriteQuad(struct jeVertex* quadVertices, const struct jeVer
 		quadVertices[2].y = spriteVertices[1].y;
 		quadVertices[2].v = spriteVertices[1].v;
 
+		quadVertices[3].x = spriteVertices[1].x;
 		quadVertices[3].y = spriteVertices[1].y;
+		quadVertices[3].u = spriteVertices[1].u;
 		quadVertices[3].v = spriteVertices[1].v;
+	}
+}
+void jeVertex_createTriangleQuad(struct jeVertex* quadVertices, const struct jeVertex* triangleVertices) {
+	/* Render triangle as a quad whose second triangle is degenerate, so that all primitives share one layout */
+
+	JE_TRACE("quadVertices=%p, triangleVertices=%p", (void*)quadVertices, (void*)triangleVertices);
+
+	bool ok = true;
+
+	if (quadVertices == NULL) {
+		JE_ERROR("quadVertices=NULL");
+		ok = false;
+	}
+
+	if (triangleVertices == NULL) {
+		JE_ERROR("triangleVertices=NULL");
+		ok = false;
+	}
+
+	if (ok) {
+		quadVertices[0] = triangleVertices[0];
+		quadVertices[1] = triangleVertices[1];
+		quadVertices[2] = triangleVertices[2];
+		quadVertices[3] = triangleVertices[2];
+	}
+}
+void jeVertex_createQuadIndices(uint32_t* indices, uint32_t quadCount) {
+	JE_TRACE("indices=%p, quadCount=%u", (void*)indices, quadCount);
+
+	bool ok = true;
+
+	if (indices == NULL) {
+		JE_ERROR("indices=NULL");
+		ok = false;
+	}
+
+	for (uint32_t i = 0; ok && (i < quadCount); i++) {
+		uint32_t vertexIndex = i * JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT;
+		uint32_t* quadIndices = &indices[i * JE_PRIMITIVE_TYPE_QUADS_INDEX_COUNT];
+		quadIndices[0] = vertexIndex;
+		quadIndices[1] = vertexIndex + 1;
+		quadIndices[2] = vertexIndex + 2;
+		quadIndices[3] = vertexIndex + 2;
+		quadIndices[4] = vertexIndex + 1;
+		quadIndices[5] = vertexIndex + 3;
+	}
+}
+int32_t jeVertex_packRound(float value, float min, float max) {
+	/*Clamp then round half up.  Hand-rolled rather than fminf/floorf, which are libm calls on many targets*/
+	if (!(value >= min)) {
+		value = min; /*also catches NaN*/
+	}
+	if (value > max) {
+		value = max;
+	}
+
+	value += 0.5F;
+	int32_t result = (int32_t)value;
+	if ((float)result > value) {
+		result--;
+	}
+
+	return result;
+}
+bool jeVertex_getOpaque(const struct jeVertex* vertices, uint32_t vertexCount) {
+	bool opaque = true;
+
+	for (uint32_t i = 0; i < vertexCount; i++) {
+		opaque = opaque && (vertices[i].a >= 1.0F);
+	}
+
+	return opaque;
+}
+bool jeVertex_getPrimitiveVisible(
+	const struct jeVertex* vertices, uint32_t primitiveType, float x1, float y1, float x2, float y2) {
+	uint32_t vertexCount = jePrimitiveType_getVertexCount(primitiveType);
+
+	float minX = vertices[0].x;
+	float minY = vertices[0].y;
+	float maxX = vertices[0].x;
+	float maxY = vertices[0].y;
+	for (uint32_t i = 1; i < vertexCount; i++) {
+		minX = (vertices[i].x < minX) ? vertices[i].x : minX;
+		minY = (vertices[i].y < minY) ? vertices[i].y : minY;
+		maxX = (vertices[i].x > maxX) ? vertices[i].x : maxX;
+		maxY = (vertices[i].y > maxY) ? vertices[i].y : maxY;
+	}
+
+	/*Points and lines are widened by a pixel towards +x or +y when expanded to quads*/
+	if ((primitiveType == JE_PRIMITIVE_TYPE_POINTS) || (primitiveType == JE_PRIMITIVE_TYPE_LINES)) {
+		maxX += 1.0F;
+		maxY += 1.0F;
+	}
+
+	return (maxX > x1) && (minX < x2) && (maxY > y1) && (minY < y2);
+}
+void jeVertex_pack(struct jeVertexPacked* packedVertex, const struct jeVertex* vertex) {
+	JE_TRACE("packedVertex=%p, vertex=%p", (void*)packedVertex, (const void*)vertex);
+
+	bool ok = true;
 
-		quadVertices[4].x = spriteVertices[1].x;
-		quadVertices[4].u = spriteVertices[1].u;
+	if (packedVertex == NULL) {
+		JE_ERROR("packedVertex=NULL");
+		ok = false;
+	}
 
-		quadVertices[5].x = spriteVertices[1].x;
-		quadVertices[5].y = spriteVertices[1].y;
-		quadVertices[5].u = spriteVertices[1].u;
-		quadVertices[5].v = spriteVertices[1].v;
+	if (vertex == NULL) {
+		JE_ERROR("vertex=NULL");
+		ok = false;
 	}
+
+	if (ok) {
+		packedVertex->x = (int16_t)jeVertex_packRound(vertex->x, -32768.0F, 32767.0F);
+		packedVertex->y = (int16_t)jeVertex_packRound(vertex->y, -32768.0F, 32767.0F);
+		packedVertex->z = vertex->z;
+
+		packedVertex->r = (uint8_t)jeVertex_packRound(vertex->r * 255.0F, 0.0F, 255.0F);
+		packedVertex->g = (uint8_t)jeVertex_packRound(vertex->g * 255.0F, 0.0F, 255.0F);
+		packedVertex->b = (uint8_t)jeVertex_packRound(vertex->b * 255.0F, 0.0F, 255.0F);
+		packedVertex->a = (uint8_t)jeVertex_packRound(vertex->a * 255.0F, 0.0F, 255.0F);
+
+		packedVertex->u = (uint16_t)jeVertex_packRound(vertex->u, 0.0F, 65535.0F);
+		packedVertex->v = (uint16_t)jeVertex_packRound(vertex->v, 0.0F, 65535.0F);
+	}
+}
+bool jeInstance_create(struct jeInstance* instance, const struct jeVertex* vertices, uint32_t primitiveType) {
+	/* Returns false if the primitive cannot be drawn as an instance, in which case it must be expanded to vertices.
+	 *
+	 * Instances must rasterize exactly as the expanded quad would; see jeVertex_create*Quad()*/
+
+	JE_TRACE("instance=%p, vertices=%p, primitiveType=%u", (void*)instance, (const void*)vertices, primitiveType);
+
+	bool ok = true;
+
+	if (instance == NULL) {
+		JE_ERROR("instance=NULL");
+		ok = false;
+	}
+
+	if (vertices == NULL) {
+		JE_ERROR("vertices=NULL");
+		ok = false;
+	}
+
+	struct jeVertex rectVertices[2];
+	if (ok) {
+		switch (primitiveType) {
+			case JE_PRIMITIVE_TYPE_POINTS: {
+				static const float pointWidth = 1.0F;
+				rectVertices[0] = vertices[0];
+				rectVertices[1] = vertices[0];
+				rectVertices[1].x += pointWidth;
+				rectVertices[1].y += pointWidth;
+				break;
+			}
+			case JE_PRIMITIVE_TYPE_LINES: {
+				/*Only lines which fill a rect, i.e. axis-aligned, and with one color and uv for the whole line*/
+				static const float lineWidth = 1.0F;
+				const struct jeVertex* a = &vertices[0];
+				const struct jeVertex* b = &vertices[1];
+				ok = ((a->x == b->x) || (a->y == b->y)) && (a->z == b->z) && (a->r == b->r) && (a->g == b->g) &&
+					 (a->b == b->b) && (a->a == b->a) && (a->u == b->u) && (a->v == b->v);
+
+				if (ok) {
+					rectVertices[0] = *a;
+					rectVertices[1] = *a;
+					if (fabsf(b->x - a->x) > fabsf(b->y - a->y)) {
+						rectVertices[0].x = (a->x < b->x) ? a->x : b->x;
+						rectVertices[1].x = (a->x < b->x) ? b->x : a->x;
+						rectVertices[1].y += lineWidth;
+					} else {
+						rectVertices[0].y = (a->y < b->y) ? a->y : b->y;
+						rectVertices[1].y = (a->y < b->y) ? b->y : a->y;
+						rectVertices[1].x += lineWidth;
+					}
+				}
+				break;
+			}
+			case JE_PRIMITIVE_TYPE_SPRITES: {
+				rectVertices[0] = vertices[0];
+				rectVertices[1] = vertices[1];
+				break;
+			}
+			default: {
+				ok = false;
+				break;
+			}
+		}
+	}
+
+	if (ok) {
+		instance->x0 = rectVertices[0].x;
+		instance->y0 = rectVertices[0].y;
+		instance->x1 = rectVertices[1].x;
+		instance->y1 = rectVertices[1].y;
+		instance->z = rectVertices[0].z;
+
+		instance->u0 = (uint16_t)jeVertex_packRound(rectVertices[0].u, 0.0F, 65535.0F);
+		instance->v0 = (uint16_t)jeVertex_packRound(rectVertices[0].v, 0.0F, 65535.0F);
+		instance->u1 = (uint16_t)jeVertex_packRound(rectVertices[1].u, 0.0F, 65535.0F);
+		instance->v1 = (uint16_t)jeVertex_packRound(rectVertices[1].v, 0.0F, 65535.0F);
+
+		instance->r = (uint8_t)jeVertex_packRound(rectVertices[0].r * 255.0F, 0.0F, 255.0F);
+		instance->g = (uint8_t)jeVertex_packRound(rectVertices[0].g * 255.0F, 0.0F, 255.0F);
+		instance->b = (uint8_t)jeVertex_packRound(rectVertices[0].b * 255.0F, 0.0F, 255.0F);
+		instance->a = (uint8_t)jeVertex_packRound(rectVertices[0].a * 255.0F, 0.0F, 255.0F);
+	}
+
+	return ok;
 }
 
 bool jeVertexBuffer_create(struct jeVertexBuffer* vertexBuffer) {
@@ -328,7 +777,21 @@ bool jeVertexBuffer_create(struct jeVertexBuffer* vertexBuffer) {
 	}
 
 	if (ok) {
-		ok = jeArray_create(&vertexBuffer->vertices, sizeof(struct jeVertex));
+		vertexBuffer->vertexFormat = JE_VERTEX_FORMAT_FLOAT;
+	}
+
+	ok = ok && jeArray_create(&vertexBuffer->vertices, sizeof(struct jeVertex));
+	ok = ok && jeArray_create(&vertexBuffer->instances, sizeof(struct jeInstance));
+	ok = ok && jeArray_create(&vertexBuffer->submissions, sizeof(uint32_t));
+	ok = ok && jeArray_create(&vertexBuffer->drawRanges, sizeof(struct jeDrawRange));
+	ok = ok && jeArray_create(&vertexBuffer->sortKeys, sizeof(struct jePrimitiveSortKey));
+	ok = ok && jeArray_create(&vertexBuffer->sortKeysScratch, sizeof(struct jePrimitiveSortKey));
+	ok = ok && jeArray_create(&vertexBuffer->depthStates, sizeof(struct jePrimitiveDepthState));
+	ok = ok && jeArray_create(&vertexBuffer->sortedVertices, sizeof(struct jeVertex));
+	ok = ok && jeArray_create(&vertexBuffer->sortedInstances, sizeof(struct jeInstance));
+
+	if ((!ok) && (vertexBuffer != NULL)) {
+		jeVertexBuffer_destroy(vertexBuffer);
 	}
 
 	return ok;
@@ -337,6 +800,14 @@ void jeVertexBuffer_destroy(struct jeVertexBuffer* vertexBuffer) {
 	JE_TRACE("vertexBuffer=%p", (void*)vertexBuffer);
 
 	if (vertexBuffer != NULL) {
+		jeArray_destroy(&vertexBuffer->sortedInstances);
+		jeArray_destroy(&vertexBuffer->sortedVertices);
+		jeArray_destroy(&vertexBuffer->depthStates);
+		jeArray_destroy(&vertexBuffer->sortKeysScratch);
+		jeArray_destroy(&vertexBuffer->sortKeys);
+		jeArray_destroy(&vertexBuffer->drawRanges);
+		jeArray_destroy(&vertexBuffer->submissions);
+		jeArray_destroy(&vertexBuffer->instances);
 		jeArray_destroy(&vertexBuffer->vertices);
 		vertexBuffer = NULL;
 	}
@@ -351,9 +822,102 @@ void jeVertexBuffer_reset(struct jeVertexBuffer* vertexBuffer) {
 
 	if (ok) {
 		jeArray_setCount(&vertexBuffer->vertices, 0);
+		jeArray_setCount(&vertexBuffer->instances, 0);
+		jeArray_setCount(&vertexBuffer->submissions, 0);
+		jeArray_setCount(&vertexBuffer->drawRanges, 0);
+		vertexBuffer->opaqueTextureMask = 0;
 	}
 }
-bool jeVertexBuffer_sort(struct jeVertexBuffer* vertexBuffer, uint32_t primitiveType) {
+bool jeVertexBuffer_setFormat(struct jeVertexBuffer* vertexBuffer, uint32_t vertexFormat) {
+	JE_TRACE("vertexBuffer=%p, vertexFormat=%u", (void*)vertexBuffer, vertexFormat);
+
+	bool ok = true;
+
+	if (vertexBuffer == NULL) {
+		JE_ERROR("vertexBuffer=NULL");
+		ok = false;
+	}
+
+	if (jeVertexFormat_getValid(vertexFormat) == false) {
+		JE_ERROR("invalid vertexFormat, vertexFormat=%u", vertexFormat);
+		ok = false;
+	}
+
+	if (ok && (vertexBuffer->vertexFormat != vertexFormat)) {
+		uint32_t vertexSize = jeVertexFormat_getVertexSize(vertexFormat);
+
+		jeArray_destroy(&vertexBuffer->sortedVertices);
+		jeArray_destroy(&vertexBuffer->vertices);
+
+		ok = ok && jeArray_create(&vertexBuffer->vertices, vertexSize);
+		ok = ok && jeArray_create(&vertexBuffer->sortedVertices, vertexSize);
+
+		if (ok) {
+			vertexBuffer->vertexFormat = vertexFormat;
+		}
+	}
+
+	if (ok) {
+		jeVertexBuffer_reset(vertexBuffer);
+	}
+
+	return ok;
+}
+void jeVertexBuffer_setInstancing(struct jeVertexBuffer* vertexBuffer, bool instancing) {
+	JE_TRACE("vertexBuffer=%p, instancing=%u", (void*)vertexBuffer, (uint32_t)instancing);
+
+	bool ok = true;
+
+	if (vertexBuffer == NULL) {
+		JE_ERROR("vertexBuffer=NULL");
+		ok = false;
+	}
+
+	if (ok) {
+		vertexBuffer->instancing = instancing;
+	}
+}
+void jeVertexBuffer_setTextureBinaryAlpha(struct jeVertexBuffer* vertexBuffer, uint32_t textureId, bool binaryAlpha) {
+	JE_TRACE(
+		"vertexBuffer=%p, textureId=%u, binaryAlpha=%u", (void*)vertexBuffer, textureId, (uint32_t)binaryAlpha);
+
+	bool ok = true;
+
+	if (vertexBuffer == NULL) {
+		JE_ERROR("vertexBuffer=NULL");
+		ok = false;
+	}
+
+	if (textureId >= JE_PRIMITIVE_TEXTURE_COUNT) {
+		JE_ERROR("textureId out of range, textureId=%u", textureId);
+		ok = false;
+	}
+
+	if (ok && binaryAlpha) {
+		vertexBuffer->binaryAlphaTextureMask |= 1U << textureId;
+	} else if (ok) {
+		vertexBuffer->binaryAlphaTextureMask &= ~(1U << textureId);
+	}
+}
+/*Whether the primitive is drawn unblended; see jeVertexBuffer_sortImpl() for how opaque primitives are ordered*/
+bool jeVertexBuffer_getPrimitiveOpaque(
+	const struct jeVertexBuffer* vertexBuffer,
+	const struct jeVertex* vertices,
+	uint32_t primitiveType,
+	uint32_t textureId) {
+	bool opaque = (vertexBuffer != NULL) && (vertices != NULL) && (textureId < JE_PRIMITIVE_TEXTURE_COUNT);
+
+	opaque = opaque && ((vertexBuffer->binaryAlphaTextureMask & (1U << textureId)) != 0);
+	opaque = opaque && jeVertex_getOpaque(vertices, jePrimitiveType_getVertexCount(primitiveType));
+
+	return opaque;
+}
+bool jeVertexBuffer_sortImpl(
+	struct jeVertexBuffer* vertexBuffer,
+	uint32_t primitiveType,
+	bool useRadixSort,
+	void* optDestVertices,
+	void* optDestInstances) {
 	bool ok = true;
 
 	if (vertexBuffer == NULL) {
@@ -369,100 +933,328 @@ bool jeVertexBuffer_sort(struct jeVertexBuffer* vertexBuffer, uint32_t primitive
 	uint32_t primitiveVertexCount = jePrimitiveType_getVertexCount(primitiveType);
 	uint32_t vertexCount = 0;
 	uint32_t primitiveCount = 0;
-	struct jeVertex* vertices = NULL;
+	uint32_t instanceCount = 0;
+	uint32_t submissionCount = 0;
 
 	if (ok) {
 		vertexCount = vertexBuffer->vertices.count;
 		primitiveCount = vertexCount / primitiveVertexCount;
-		vertices = (struct jeVertex*)vertexBuffer->vertices.data;
+		instanceCount = vertexBuffer->instances.count;
+		submissionCount = vertexBuffer->submissions.count;
+	}
 
-		if (vertices == NULL) {
-			JE_ERROR("vertices=NULL");
-			ok = false;
-		}
+	/*Vertices staged without jeVertexBuffer_pushPrimitive() have no submissions, and are all sorted in array order*/
+	bool hasSubmissions = submissionCount > 0;
+	uint32_t sortCount = hasSubmissions ? submissionCount : primitiveCount;
+
+	JE_TRACE(
+		"vertexBuffer=%p, vertexCount=%u, primitiveCount=%u, instanceCount=%u, submissionCount=%u",
+		(void*)vertexBuffer,
+		vertexCount,
+		primitiveCount,
+		instanceCount,
+		submissionCount);
+
+	if (ok && hasSubmissions && (primitiveType != JE_PRIMITIVE_TYPE_QUADS)) {
+		JE_ERROR("pushed primitives can only be sorted as quads, primitiveType=%u", primitiveType);
+		ok = false;
 	}
 
-	JE_TRACE("vertexBuffer=%p, vertexCount=%u, primitiveCount=%u", (void*)vertexBuffer, vertexCount, primitiveCount);
+	if (ok && (instanceCount > 0) && (optDestVertices != NULL) && (optDestInstances == NULL)) {
+		JE_ERROR("optDestInstances=NULL, but the buffer has instances");
+		ok = false;
+	}
 
-	struct jeArray unsortedPrimitivesBuffer;
-	ok = ok && jeArray_create(&unsortedPrimitivesBuffer, sizeof(struct jeVertex));
-	ok = ok && jeArray_setCount(&unsortedPrimitivesBuffer, vertexCount);
-	const struct jeVertex* unsortedVertices = NULL;
+	/*Depth states are only needed to find which opaque primitives can skip the sort, and have a load of at most 1/2*/
+	bool hasOpaque = ok && hasSubmissions && (vertexBuffer->opaqueTextureMask != 0);
+	uint32_t depthStateBits = JE_PRIMITIVE_DEPTH_STATE_MIN_CAPACITY_BITS;
+	while (hasOpaque && ((1U << depthStateBits) < (sortCount * 2U))) {
+		depthStateBits++;
+	}
+
+	/*Scratch buffers only ever grow, so this does not allocate once the buffer has seen its largest frame*/
+	ok = ok && jeArray_setCount(&vertexBuffer->sortKeys, sortCount);
+	ok = ok && jeArray_setCount(&vertexBuffer->sortKeysScratch, sortCount);
+	if (hasOpaque) {
+		ok = ok && jeArray_setCount(&vertexBuffer->depthStates, 1U << depthStateBits);
+	}
+	ok = ok && jeArray_setCount(&vertexBuffer->drawRanges, 0);
+	if (optDestVertices == NULL) {
+		ok = ok && jeArray_setCount(&vertexBuffer->sortedVertices, vertexCount);
+	}
+	if (optDestInstances == NULL) {
+		ok = ok && jeArray_setCount(&vertexBuffer->sortedInstances, instanceCount);
+	}
+
+	struct jePrimitiveGather gather;
+	memset((void*)&gather, 0, sizeof(gather));
+
+	const uint32_t* submissions = NULL;
+	struct jePrimitiveSortKey* sortKeys = NULL;
+	size_t vertexSize = 0;
+	size_t depthOffset = 0;
 
 	if (ok) {
-		unsortedVertices = (const struct jeVertex*)unsortedPrimitivesBuffer.data;
+		vertexSize = (size_t)vertexBuffer->vertices.stride;
+		depthOffset = offsetof(struct jeVertex, z);
+		if (vertexBuffer->vertexFormat == JE_VERTEX_FORMAT_PACKED) {
+			depthOffset = offsetof(struct jeVertexPacked, z);
+		}
 
-		if (unsortedVertices == NULL) {
-			JE_ERROR("unsortedVertices=NULL");
+		gather.vertices = (const char*)vertexBuffer->vertices.data;
+		gather.sortedVertices = (char*)optDestVertices;
+		if (gather.sortedVertices == NULL) {
+			gather.sortedVertices = (char*)vertexBuffer->sortedVertices.data;
+		}
+		gather.instances = (const struct jeInstance*)vertexBuffer->instances.data;
+		gather.sortedInstances = (struct jeInstance*)optDestInstances;
+		if (gather.sortedInstances == NULL) {
+			gather.sortedInstances = (struct jeInstance*)vertexBuffer->sortedInstances.data;
+		}
+		gather.primitiveSize = vertexSize * primitiveVertexCount;
+		gather.primitiveVertexCount = primitiveVertexCount;
+		gather.drawRanges = &vertexBuffer->drawRanges;
+
+		submissions = (const uint32_t*)vertexBuffer->submissions.data;
+		sortKeys = (struct jePrimitiveSortKey*)vertexBuffer->sortKeys.data;
+
+		if ((gather.vertices == NULL) || (gather.sortedVertices == NULL) || (gather.instances == NULL) ||
+			(gather.sortedInstances == NULL) || (submissions == NULL) || (sortKeys == NULL)) {
+			JE_ERROR(
+				"unallocated buffers, vertices=%p, sortedVertices=%p, instances=%p, sortedInstances=%p, "
+				"submissions=%p, sortKeys=%p",
+				(const void*)gather.vertices,
+				(void*)gather.sortedVertices,
+				(const void*)gather.instances,
+				(void*)gather.sortedInstances,
+				(const void*)submissions,
+				(void*)sortKeys);
 			ok = false;
 		}
 	}
 
-	if (ok) {
-		memcpy((void*)unsortedVertices, (const void*)vertices, sizeof(struct jeVertex) * vertexCount);
+	struct jePrimitiveDepthState* depthStates = NULL;
+	if (ok && hasOpaque) {
+		depthStates = (struct jePrimitiveDepthState*)vertexBuffer->depthStates.data;
+		memset((void*)depthStates, 0, sizeof(struct jePrimitiveDepthState) * vertexBuffer->depthStates.count);
 	}
 
-	struct jeArray sortKeysBuffer;
-	if (!jeArray_create(&sortKeysBuffer, sizeof(struct jePrimitiveSortKey))) {
-		ok = false;
+	struct jePrimitiveDepthState* depthState = NULL;
+	if (ok) {
+		/*Generate sort keys array from vertices and instances, in submission order*/
+		for (uint32_t i = 0; i < sortCount; i++) {
+			uint32_t submission = hasSubmissions ? submissions[i] : i;
+			uint32_t index = submission & JE_PRIMITIVE_SUBMISSION_INDEX_MASK;
+			float z = 0.0F;
+			if ((submission & JE_PRIMITIVE_SUBMISSION_INSTANCE_BIT) != 0) {
+				z = gather.instances[index].z;
+			} else {
+				const char* primitive = gather.vertices + (gather.primitiveSize * index);
+				memcpy((void*)&z, (const void*)(primitive + depthOffset), sizeof(z));
+			}
+
+			uint32_t depth = jePrimitiveSortKey_getDepth(z);
+			sortKeys[i].depth = depth;
+			sortKeys[i].index = i;
+
+			/*Runs of primitives at one depth are common, e.g. tiles, so the last entry found is reused*/
+			if (hasOpaque && ((depthState == NULL) || (depthState->depth != depth))) {
+				depthState = jePrimitiveDepthState_find(depthStates, depthStateBits, depth);
+			}
+			if (hasOpaque) {
+				jePrimitiveDepthState_add(depthState, depth, submission);
+			}
+		}
 	}
 
-	ok = ok && jeArray_setCount(&sortKeysBuffer, primitiveCount);
-	struct jePrimitiveSortKey* sortKeys = (struct jePrimitiveSortKey*)sortKeysBuffer.data;
+	/* Opaque primitives are drawn first and without blending, so the depth test alone orders them.  As the depth
+	 * test lets the later draw win ties, this only keeps submission order for opaque primitives which share their
+	 * depth with neither translucent primitives nor opaque primitives of another texture.  The rest are sorted*/
+	uint32_t sortedCount = sortCount;
+	uint32_t opaqueCount = 0;
+	struct jePrimitiveSortKey* opaqueSortKeys = (struct jePrimitiveSortKey*)vertexBuffer->sortKeysScratch.data;
+	if (ok && hasOpaque) {
+		sortedCount = 0;
+		for (uint32_t i = 0; i < sortCount; i++) {
+			struct jePrimitiveSortKey sortKey = sortKeys[i];
+			bool opaque = (submissions[i] & JE_PRIMITIVE_SUBMISSION_OPAQUE_BIT) != 0;
+			if (opaque && (depthState->depth != sortKey.depth)) {
+				depthState = jePrimitiveDepthState_find(depthStates, depthStateBits, sortKey.depth);
+			}
+			if (opaque) {
+				opaque = (depthState->state & JE_PRIMITIVE_DEPTH_STATE_CONTESTED_BIT) == 0;
+			}
 
-	if (ok) {
-		/*Generate sort keys array from vertices array*/
-		for (uint32_t i = 0; i < primitiveCount; i++) {
-			uint32_t primitiveVertexIndex = primitiveVertexCount * i;
-			sortKeys[i].z = vertices[primitiveVertexIndex].z;
-			sortKeys[i].index = primitiveVertexIndex;
+			if (opaque) {
+				opaqueSortKeys[opaqueCount] = sortKey;
+				opaqueCount++;
+			} else {
+				sortKeys[sortedCount] = sortKey;
+				sortedCount++;
+			}
 		}
+	}
 
-		/*Sort the sort keys array.  Uses both index and depth in order for sort to be stable*/
-		qsort(sortKeys, primitiveCount, sizeof(struct jePrimitiveSortKey), jePrimitiveSortKey_less);
+	/*Opaque primitives are grouped by texture, and otherwise kept in submission order*/
+	for (uint32_t textureId = 0; ok && (opaqueCount > 0) && (textureId < JE_PRIMITIVE_TEXTURE_COUNT); textureId++) {
+		if ((vertexBuffer->opaqueTextureMask & (1U << textureId)) == 0) {
+			continue;
+		}
 
-		/*Sort vertices using sort key order*/
-		for (uint32_t i = 0; i < primitiveCount; i++) {
-			uint32_t srcPrimitiveVertexIndex = sortKeys[i].index;
-			uint32_t destPrimitiveVertexIndex = primitiveVertexCount * i;
-
-			if ((srcPrimitiveVertexIndex + primitiveVertexCount - 1) > vertexCount) {
-				JE_ERROR(
-					"src primitive starting index out of bounds, vertexBuffer=%p, index=%u, vertexCount=%u",
-					(void*)vertexBuffer,
-					srcPrimitiveVertexIndex,
-					vertexCount);
-				continue;
+		uint32_t textureBits = textureId << JE_PRIMITIVE_SUBMISSION_TEXTURE_SHIFT;
+		for (uint32_t i = 0; ok && (i < opaqueCount); i++) {
+			uint32_t submission = submissions[opaqueSortKeys[i].index];
+			if ((submission & JE_PRIMITIVE_SUBMISSION_TEXTURE_MASK) == textureBits) {
+				ok = jePrimitiveGather_push(&gather, submission);
 			}
+		}
+	}
 
-			if ((destPrimitiveVertexIndex + primitiveVertexCount - 1) > vertexCount) {
-				JE_ERROR(
-					"dest primitive starting index out of bounds, vertexBuffer=%p, index=%u, vertexCount=%u",
-					(void*)vertexBuffer,
-					destPrimitiveVertexIndex,
-					vertexCount);
-				continue;
+	/*Sort the keys only; the vertex payload is then moved exactly once, below*/
+	if (ok && useRadixSort) {
+		sortKeys = jePrimitiveSortKey_radixSort(
+			sortKeys, (struct jePrimitiveSortKey*)vertexBuffer->sortKeysScratch.data, sortedCount);
+	} else if (ok) {
+		qsort(sortKeys, sortedCount, sizeof(struct jePrimitiveSortKey), jePrimitiveSortKey_less);
+	}
+
+	/*Gather the remaining vertices and instances in sort key order, all drawn blended*/
+	for (uint32_t i = 0; ok && (i < sortedCount); i++) {
+		uint32_t submission = hasSubmissions ? submissions[sortKeys[i].index] : sortKeys[i].index;
+		ok = jePrimitiveGather_push(&gather, submission & ~JE_PRIMITIVE_SUBMISSION_OPAQUE_BIT);
+	}
+
+	ok = ok && jePrimitiveGather_flush(&gather);
+
+	if (ok) {
+		vertexBuffer->sortedPrimitiveCount = sortedCount;
+
+		/*Vertices not forming a whole primitive keep their place at the end*/
+		size_t sortedSize = gather.primitiveSize * primitiveCount;
+		memcpy(
+			(void*)(gather.sortedVertices + sortedSize),
+			(const void*)(gather.vertices + sortedSize),
+			(vertexSize * vertexCount) - sortedSize);
+	}
+
+	if (ok && (optDestVertices == NULL)) {
+		struct jeArray swapVertices = vertexBuffer->vertices;
+		vertexBuffer->vertices = vertexBuffer->sortedVertices;
+		vertexBuffer->sortedVertices = swapVertices;
+	}
+
+	if (ok && (optDestInstances == NULL)) {
+		struct jeArray swapInstances = vertexBuffer->instances;
+		vertexBuffer->instances = vertexBuffer->sortedInstances;
+		vertexBuffer->sortedInstances = swapInstances;
+	}
+
+	if (ok && hasSubmissions && (optDestVertices == NULL) && (optDestInstances == NULL)) {
+		/*Submissions now follow draw order, so that sorting again is stable*/
+		uint32_t* sortedSubmissions = (uint32_t*)vertexBuffer->submissions.data;
+		uint32_t submissionIndex = 0;
+		const struct jeDrawRange* drawRanges = (const struct jeDrawRange*)vertexBuffer->drawRanges.data;
+		for (uint32_t i = 0; i < vertexBuffer->drawRanges.count; i++) {
+			const struct jeDrawRange* drawRange = &drawRanges[i];
+
+			uint32_t flags = drawRange->opaque ? JE_PRIMITIVE_SUBMISSION_OPAQUE_BIT : 0;
+			flags |= drawRange->textureId << JE_PRIMITIVE_SUBMISSION_TEXTURE_SHIFT;
+			uint32_t start = drawRange->start;
+			uint32_t count = drawRange->count;
+			if (drawRange->instanced) {
+				flags |= JE_PRIMITIVE_SUBMISSION_INSTANCE_BIT;
+			} else {
+				start /= primitiveVertexCount;
+				count /= primitiveVertexCount;
 			}
 
-			for (uint32_t j = 0; j < primitiveVertexCount; j++) {
-				uint32_t srcVertexIndex = srcPrimitiveVertexIndex + j;
-				uint32_t destVertexIndex = destPrimitiveVertexIndex + j;
-				vertices[destVertexIndex] = unsortedVertices[srcVertexIndex];
+			for (uint32_t j = 0; j < count; j++) {
+				sortedSubmissions[submissionIndex] = (start + j) | flags;
+				submissionIndex++;
 			}
 		}
 	}
 
-	jeArray_destroy(&sortKeysBuffer);
-	jeArray_destroy(&unsortedPrimitivesBuffer);
+	return ok;
+}
+bool jeVertexBuffer_sort(struct jeVertexBuffer* vertexBuffer, uint32_t primitiveType) {
+	return jeVertexBuffer_sortImpl(
+		vertexBuffer,
+		primitiveType,
+		/*useRadixSort*/ true,
+		/*optDestVertices*/ NULL,
+		/*optDestInstances*/ NULL);
+}
+bool jeVertexBuffer_sortInto(
+	struct jeVertexBuffer* vertexBuffer, uint32_t primitiveType, void* destVertices, void* optDestInstances) {
+	bool ok = true;
+
+	if (destVertices == NULL) {
+		JE_ERROR("destVertices=NULL");
+		ok = false;
+	}
+
+	ok = ok && jeVertexBuffer_sortImpl(
+				   vertexBuffer, primitiveType, /*useRadixSort*/ true, destVertices, optDestInstances);
 
 	return ok;
 }
+uint32_t jeVertexBuffer_getSubmissionFlags(struct jeVertexBuffer* vertexBuffer, bool opaque, uint32_t textureId) {
+	uint32_t flags = textureId << JE_PRIMITIVE_SUBMISSION_TEXTURE_SHIFT;
+
+	if (opaque) {
+		flags |= JE_PRIMITIVE_SUBMISSION_OPAQUE_BIT;
+		vertexBuffer->opaqueTextureMask |= 1U << textureId;
+	}
+
+	return flags;
+}
+void jeVertexBuffer_pushVertices(
+	struct jeVertexBuffer* vertexBuffer, const struct jeVertex* vertices, uint32_t count, uint32_t flags) {
+	uint32_t quadStart = vertexBuffer->vertices.count / JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT;
+	for (uint32_t i = 0; i < (count / JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT); i++) {
+		uint32_t submission = (quadStart + i) | flags;
+		jeArray_push(&vertexBuffer->submissions, (const void*)&submission, 1);
+	}
+
+	if (vertexBuffer->vertexFormat == JE_VERTEX_FORMAT_PACKED) {
+		struct jeVertexPacked packedVertices[JE_PRIMITIVE_TYPE_MAX_VERTEX_COUNT];
+		for (uint32_t i = 0; i < count; i++) {
+			jeVertex_pack(&packedVertices[i], &vertices[i]);
+		}
+		jeArray_push(&vertexBuffer->vertices, (const void*)packedVertices, count);
+	} else {
+		jeArray_push(&vertexBuffer->vertices, (const void*)vertices, count);
+	}
+}
+void jeVertexBuffer_pushInstance(
+	struct jeVertexBuffer* vertexBuffer, const struct jeInstance* instance, uint32_t flags) {
+	uint32_t submission = vertexBuffer->instances.count | JE_PRIMITIVE_SUBMISSION_INSTANCE_BIT | flags;
+	jeArray_push(&vertexBuffer->submissions, (const void*)&submission, 1);
+
+	if (vertexBuffer->vertexFormat == JE_VERTEX_FORMAT_PACKED) {
+		/*Snap to whole pixels, as the packed vertices of an expanded quad would be*/
+		struct jeInstance packedInstance = *instance;
+		packedInstance.x0 = (float)jeVertex_packRound(instance->x0, -32768.0F, 32767.0F);
+		packedInstance.y0 = (float)jeVertex_packRound(instance->y0, -32768.0F, 32767.0F);
+		packedInstance.x1 = (float)jeVertex_packRound(instance->x1, -32768.0F, 32767.0F);
+		packedInstance.y1 = (float)jeVertex_packRound(instance->y1, -32768.0F, 32767.0F);
+		jeArray_push(&vertexBuffer->instances, (const void*)&packedInstance, 1);
+	} else {
+		jeArray_push(&vertexBuffer->instances, (const void*)instance, 1);
+	}
+}
 void jeVertexBuffer_pushPrimitive(
 	struct jeVertexBuffer* vertexBuffer, const struct jeVertex* vertices, uint32_t primitiveType) {
+	jeVertexBuffer_pushTexturedPrimitive(vertexBuffer, vertices, primitiveType, /*textureId*/ 0);
+}
+void jeVertexBuffer_pushTexturedPrimitive(
+	struct jeVertexBuffer* vertexBuffer, const struct jeVertex* vertices, uint32_t primitiveType, uint32_t textureId) {
 	JE_TRACE(
-		"vertexBuffer=%p, primitiveType=%u, vertices=%s",
+		"vertexBuffer=%p, primitiveType=%u, textureId=%u, vertices=%s",
 		(void*)vertexBuffer,
 		primitiveType,
+		textureId,
 		jeVertex_primitiveGetDebugString(vertices, primitiveType));
 
 	bool ok = true;
@@ -482,30 +1274,46 @@ void jeVertexBuffer_pushPrimitive(
 		ok = false;
 	}
 
+	if (textureId >= JE_PRIMITIVE_TEXTURE_COUNT) {
+		JE_ERROR("textureId out of range, textureId=%u", textureId);
+		ok = false;
+	}
+
+	/*Classified once here, so that the sort only needs to consider translucent primitives*/
+	uint32_t flags = 0;
 	if (ok) {
+		bool opaque = jeVertexBuffer_getPrimitiveOpaque(vertexBuffer, vertices, primitiveType, textureId);
+		flags = jeVertexBuffer_getSubmissionFlags(vertexBuffer, opaque, textureId);
+	}
+
+	struct jeInstance instance;
+	if (ok && vertexBuffer->instancing && jeInstance_create(&instance, vertices, primitiveType)) {
+		jeVertexBuffer_pushInstance(vertexBuffer, &instance, flags);
+	} else if (ok) {
 		struct jeVertex quadVertices[JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT];
 		switch (primitiveType) {
 			case JE_PRIMITIVE_TYPE_POINTS: {
 				jeVertex_createPointQuad(quadVertices, vertices);
-				jeArray_push(&vertexBuffer->vertices, (const void*)&quadVertices, JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT);
+				jeVertexBuffer_pushVertices(vertexBuffer, quadVertices, JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT, flags);
 				break;
 			}
 			case JE_PRIMITIVE_TYPE_LINES: {
 				jeVertex_createLineQuad(quadVertices, vertices);
-				jeArray_push(&vertexBuffer->vertices, (const void*)&quadVertices, JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT);
+				jeVertexBuffer_pushVertices(vertexBuffer, quadVertices, JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT, flags);
 				break;
 			}
 			case JE_PRIMITIVE_TYPE_SPRITES: {
 				jeVertex_createSpriteQuad(quadVertices, vertices);
-				jeArray_push(&vertexBuffer->vertices, (const void*)&quadVertices, JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT);
+				jeVertexBuffer_pushVertices(vertexBuffer, quadVertices, JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT, flags);
 				break;
 			}
 			case JE_PRIMITIVE_TYPE_TRIANGLES: {
-				jeArray_push(&vertexBuffer->vertices, (const void*)vertices, JE_PRIMITIVE_TYPE_TRIANGLES_VERTEX_COUNT);
+				jeVertex_createTriangleQuad(quadVertices, vertices);
+				jeVertexBuffer_pushVertices(vertexBuffer, quadVertices, JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT, flags);
 				break;
 			}
 			case JE_PRIMITIVE_TYPE_QUADS: {
-				jeArray_push(&vertexBuffer->vertices, (const void*)vertices, JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT);
+				jeVertexBuffer_pushVertices(vertexBuffer, vertices, JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT, flags);
 				break;
 			}
 			default: {
@@ -551,12 +1359,20 @@ void jeRendering_runTests() {
 		strlen(jeVertex_primitiveGetDebugString(vertices, JE_PRIMITIVE_TYPE_QUADS)) <
 		JE_PRIMITIVE_TYPE_DEBUG_STRING_BUFFER_SIZE);
 
+	memset((void*)primitiveVertices, 0, sizeof(primitiveVertices));
+	primitiveVertices[1].x = 4.0F;
+	primitiveVertices[1].y = 4.0F;
+	JE_ASSERT(jeVertex_getPrimitiveVisible(primitiveVertices, JE_PRIMITIVE_TYPE_SPRITES, 2.0F, 2.0F, 8.0F, 8.0F));
+	JE_ASSERT(!jeVertex_getPrimitiveVisible(primitiveVertices, JE_PRIMITIVE_TYPE_SPRITES, 4.0F, 0.0F, 8.0F, 8.0F));
+	JE_ASSERT(jeVertex_getPrimitiveVisible(primitiveVertices, JE_PRIMITIVE_TYPE_POINTS, -1.0F, -1.0F, 0.5F, 0.5F));
+	JE_ASSERT(!jeVertex_getPrimitiveVisible(primitiveVertices, JE_PRIMITIVE_TYPE_POINTS, 1.0F, 0.0F, 8.0F, 8.0F));
+
 	struct jeVertexBuffer vertexBuffer;
 	JE_ASSERT(jeVertexBuffer_create(&vertexBuffer));
-	JE_ASSERT(jeVertexBuffer_sort(&vertexBuffer, JE_PRIMITIVE_TYPE_TRIANGLES));
+	JE_ASSERT(jeVertexBuffer_sort(&vertexBuffer, JE_PRIMITIVE_TYPE_QUADS));
 
 	jeVertexBuffer_pushPrimitive(&vertexBuffer, vertices, JE_PRIMITIVE_TYPE_QUADS);
-	JE_ASSERT(jeVertexBuffer_sort(&vertexBuffer, JE_PRIMITIVE_TYPE_TRIANGLES));
+	JE_ASSERT(jeVertexBuffer_sort(&vertexBuffer, JE_PRIMITIVE_TYPE_QUADS));
 	JE_ASSERT(vertexBuffer.vertices.count == JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT);
 
 	vertices[0].x = 1;
@@ -573,23 +1389,559 @@ void jeRendering_runTests() {
 	JE_ASSERT(((struct jeVertex*)jeArray_get(&vertexBuffer.vertices, JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT))->y == 1);
 	JE_ASSERT(((struct jeVertex*)jeArray_get(&vertexBuffer.vertices, JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT))->z == 1);
 	JE_ASSERT(
-		((struct jeVertex*)jeArray_get(
-			 &vertexBuffer.vertices, JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT + JE_PRIMITIVE_TYPE_TRIANGLES_VERTEX_COUNT))
-			->y == 0);
+		((struct jeVertex*)jeArray_get(&vertexBuffer.vertices, JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT + 3))->x == 1);
+	JE_ASSERT(
+		((struct jeVertex*)jeArray_get(&vertexBuffer.vertices, JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT + 3))->y == 0);
 
-	JE_ASSERT(jeVertexBuffer_sort(&vertexBuffer, JE_PRIMITIVE_TYPE_TRIANGLES));
+	JE_ASSERT(jeVertexBuffer_sort(&vertexBuffer, JE_PRIMITIVE_TYPE_QUADS));
 	JE_ASSERT(vertexBuffer.vertices.count == (JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT * 2));
 	JE_ASSERT(((struct jeVertex*)jeArray_get(&vertexBuffer.vertices, 0))->x == 1);
 	JE_ASSERT(((struct jeVertex*)jeArray_get(&vertexBuffer.vertices, 0))->y == 1);
 	JE_ASSERT(((struct jeVertex*)jeArray_get(&vertexBuffer.vertices, 0))->z == 1);
-	JE_ASSERT(
-		((struct jeVertex*)jeArray_get(&vertexBuffer.vertices, JE_PRIMITIVE_TYPE_TRIANGLES_VERTEX_COUNT))->y == 0);
+	JE_ASSERT(((struct jeVertex*)jeArray_get(&vertexBuffer.vertices, 3))->x == 1);
+	JE_ASSERT(((struct jeVertex*)jeArray_get(&vertexBuffer.vertices, 3))->y == 0);
 	JE_ASSERT(((struct jeVertex*)jeArray_get(&vertexBuffer.vertices, JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT))->x == 0);
 	JE_ASSERT(((struct jeVertex*)jeArray_get(&vertexBuffer.vertices, JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT))->y == 0);
 	JE_ASSERT(((struct jeVertex*)jeArray_get(&vertexBuffer.vertices, JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT))->z == 0);
 
+	/*Radix sort must match the reference comparison sort, including equal, negative and signed zero depths*/
+	static const float sortTestDepths[] = {0.0F, -0.0F, 1.0F, -1.0F, 0.5F, -1000.0F, 1000.0F, 1.0F};
+	static const uint32_t sortTestDepthCount = (uint32_t)(sizeof(sortTestDepths) / sizeof(sortTestDepths[0]));
+	static const uint32_t sortTestPrimitiveCount = 64;
+
+	struct jeVertexBuffer referenceVertexBuffer;
+	JE_ASSERT(jeVertexBuffer_create(&referenceVertexBuffer));
+	jeVertexBuffer_reset(&vertexBuffer);
+	for (uint32_t i = 0; i < sortTestPrimitiveCount; i++) {
+		memset((void*)vertices, 0, sizeof(vertices));
+		for (uint32_t j = 0; j < JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT; j++) {
+			vertices[j].x = (float)i;
+			vertices[j].z = sortTestDepths[(i * 7) % sortTestDepthCount];
+		}
+		jeVertexBuffer_pushPrimitive(&vertexBuffer, vertices, JE_PRIMITIVE_TYPE_QUADS);
+		jeVertexBuffer_pushPrimitive(&referenceVertexBuffer, vertices, JE_PRIMITIVE_TYPE_QUADS);
+	}
+	JE_ASSERT(jeVertexBuffer_sort(&vertexBuffer, JE_PRIMITIVE_TYPE_QUADS));
+	JE_ASSERT(jeVertexBuffer_sortReference(&referenceVertexBuffer, JE_PRIMITIVE_TYPE_QUADS));
+	JE_ASSERT(vertexBuffer.vertices.count == referenceVertexBuffer.vertices.count);
+	JE_ASSERT(
+		memcmp(
+			vertexBuffer.vertices.data,
+			referenceVertexBuffer.vertices.data,
+			sizeof(struct jeVertex) * vertexBuffer.vertices.count) == 0);
+	for (uint32_t i = 1; i < vertexBuffer.vertices.count; i++) {
+		const struct jeVertex* prevVertex = (const struct jeVertex*)jeArray_get(&vertexBuffer.vertices, i - 1);
+		const struct jeVertex* vertex = (const struct jeVertex*)jeArray_get(&vertexBuffer.vertices, i);
+		JE_ASSERT(prevVertex->z >= vertex->z);
+		JE_ASSERT((prevVertex->z > vertex->z) || (prevVertex->x <= vertex->x));
+	}
+
+	/*Sorting into external memory (e.g. a mapped GPU buffer) must match, and leave the staged vertices alone*/
+	struct jeVertex sortedIntoVertices[JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT * 2];
+	memset((void*)sortedIntoVertices, 0, sizeof(sortedIntoVertices));
+	sortedIntoVertices[JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT].z = 1.0F;
+	jeVertexBuffer_reset(&referenceVertexBuffer);
+	jeVertexBuffer_pushPrimitive(&referenceVertexBuffer, &sortedIntoVertices[0], JE_PRIMITIVE_TYPE_QUADS);
+	jeVertexBuffer_pushPrimitive(
+		&referenceVertexBuffer, &sortedIntoVertices[JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT], JE_PRIMITIVE_TYPE_QUADS);
+	memset((void*)sortedIntoVertices, 0, sizeof(sortedIntoVertices));
+	JE_ASSERT(jeVertexBuffer_sortInto(
+		&referenceVertexBuffer, JE_PRIMITIVE_TYPE_QUADS, sortedIntoVertices, /*optDestInstances*/ NULL));
+	JE_ASSERT(sortedIntoVertices[0].z == 1.0F);
+	JE_ASSERT(sortedIntoVertices[JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT].z == 0.0F);
+	JE_ASSERT(((struct jeVertex*)jeArray_get(&referenceVertexBuffer.vertices, 0))->z == 0.0F);
+	jeVertexBuffer_destroy(&referenceVertexBuffer);
+
+	/*Packed vertices are converted at push time, and sort the same as float vertices*/
+	JE_ASSERT(jeVertexFormat_getVertexSize(JE_VERTEX_FORMAT_PACKED) < jeVertexFormat_getVertexSize(JE_VERTEX_FORMAT_FLOAT));
+	JE_ASSERT(jeVertexBuffer_setFormat(&vertexBuffer, JE_VERTEX_FORMAT_PACKED));
+	JE_ASSERT(vertexBuffer.vertices.stride == sizeof(struct jeVertexPacked));
+	memset((void*)vertices, 0, sizeof(vertices));
+	vertices[0].x = -2.4F;
+	vertices[0].y = 3.6F;
+	vertices[0].r = 1.0F;
+	vertices[0].a = 0.5F;
+	vertices[1] = vertices[0];
+	vertices[1].x = 8.0F;
+	vertices[1].u = 16.0F;
+	jeVertexBuffer_pushPrimitive(&vertexBuffer, vertices, JE_PRIMITIVE_TYPE_SPRITES);
+	vertices[0].z = 1.0F;
+	vertices[1].z = 1.0F;
+	jeVertexBuffer_pushPrimitive(&vertexBuffer, vertices, JE_PRIMITIVE_TYPE_SPRITES);
+	JE_ASSERT(vertexBuffer.vertices.count == (JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT * 2));
+
+	const struct jeVertexPacked* packedVertex = (const struct jeVertexPacked*)jeArray_get(&vertexBuffer.vertices, 0);
+	JE_ASSERT(packedVertex->x == -2);
+	JE_ASSERT(packedVertex->y == 4);
+	JE_ASSERT(packedVertex->r == 255);
+	JE_ASSERT(packedVertex->g == 0);
+	JE_ASSERT(packedVertex->a == 128);
+	JE_ASSERT(packedVertex->z == 0.0F);
+
+	JE_ASSERT(jeVertexBuffer_sort(&vertexBuffer, JE_PRIMITIVE_TYPE_QUADS));
+	packedVertex = (const struct jeVertexPacked*)jeArray_get(&vertexBuffer.vertices, 0);
+	JE_ASSERT(packedVertex->z == 1.0F);
+	packedVertex = (const struct jeVertexPacked*)jeArray_get(&vertexBuffer.vertices, JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT);
+	JE_ASSERT(packedVertex->z == 0.0F);
+	JE_ASSERT(jeVertexBuffer_setFormat(&vertexBuffer, JE_VERTEX_FORMAT_FLOAT));
+	JE_ASSERT(vertexBuffer.vertices.count == 0);
+
+	/*Instances must cover exactly the corners of the quad they replace*/
+	struct jeInstance instance;
+	memset((void*)vertices, 0, sizeof(vertices));
+	vertices[0].x = 2.0F;
+	vertices[0].y = 3.0F;
+	vertices[0].u = 4.0F;
+	vertices[0].a = 1.0F;
+	vertices[1] = vertices[0];
+	vertices[1].x = 10.0F;
+	vertices[1].y = 7.0F;
+	vertices[1].v = 8.0F;
+	struct jeVertex quadVertices[JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT];
+	JE_ASSERT(jeInstance_create(&instance, vertices, JE_PRIMITIVE_TYPE_SPRITES));
+	jeVertex_createSpriteQuad(quadVertices, vertices);
+	JE_ASSERT((instance.x0 == quadVertices[0].x) && (instance.y0 == quadVertices[0].y));
+	JE_ASSERT((instance.x1 == quadVertices[1].x) && (instance.y0 == quadVertices[1].y));
+	JE_ASSERT((instance.x0 == quadVertices[2].x) && (instance.y1 == quadVertices[2].y));
+	JE_ASSERT((instance.x1 == quadVertices[3].x) && (instance.y1 == quadVertices[3].y));
+	JE_ASSERT((instance.u0 == 4) && (instance.v0 == 0) && (instance.u1 == 4) && (instance.v1 == 8));
+	JE_ASSERT((instance.r == 0) && (instance.a == 255));
+
+	JE_ASSERT(jeInstance_create(&instance, vertices, JE_PRIMITIVE_TYPE_POINTS));
+	jeVertex_createPointQuad(quadVertices, vertices);
+	JE_ASSERT((instance.x0 == quadVertices[0].x) && (instance.y0 == quadVertices[0].y));
+	JE_ASSERT((instance.x1 == quadVertices[3].x) && (instance.y1 == quadVertices[3].y));
+	JE_ASSERT((instance.u0 == instance.u1) && (instance.v0 == instance.v1));
+
+	vertices[1] = vertices[0];
+	vertices[1].x = -6.0F;
+	JE_ASSERT(jeInstance_create(&instance, vertices, JE_PRIMITIVE_TYPE_LINES));
+	JE_ASSERT((instance.x0 == -6.0F) && (instance.x1 == 2.0F) && (instance.y0 == 3.0F) && (instance.y1 == 4.0F));
+	vertices[1].y = 5.0F;
+	JE_ASSERT(jeInstance_create(&instance, vertices, JE_PRIMITIVE_TYPE_LINES) == false);
+	JE_ASSERT(jeInstance_create(&instance, vertices, JE_PRIMITIVE_TYPE_TRIANGLES) == false);
+
+	/*Triangles are stored as quads with a degenerate second triangle, so every primitive is indexed alike*/
+	uint32_t quadIndices[JE_PRIMITIVE_TYPE_QUADS_INDEX_COUNT * 2];
+	jeVertex_createQuadIndices(quadIndices, 2);
+	JE_ASSERT((quadIndices[0] == 0) && (quadIndices[1] == 1) && (quadIndices[2] == 2));
+	JE_ASSERT((quadIndices[3] == 2) && (quadIndices[4] == 1) && (quadIndices[5] == 3));
+	JE_ASSERT((quadIndices[6] == 4) && (quadIndices[11] == 7));
+
+	vertices[2] = vertices[1];
+	vertices[2].x = 20.0F;
+	jeVertex_createTriangleQuad(quadVertices, vertices);
+	JE_ASSERT((quadVertices[1].x == vertices[1].x) && (quadVertices[2].x == 20.0F) && (quadVertices[3].x == 20.0F));
+	jeVertexBuffer_pushPrimitive(&vertexBuffer, vertices, JE_PRIMITIVE_TYPE_TRIANGLES);
+	JE_ASSERT(vertexBuffer.vertices.count == JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT);
+	jeVertexBuffer_reset(&vertexBuffer);
+
+	/*Instances and expanded primitives sort together, and are split into ranges wherever they alternate*/
+	jeVertexBuffer_setInstancing(&vertexBuffer, true);
+	memset((void*)vertices, 0, sizeof(vertices));
+	vertices[0].z = 2.0F;
+	vertices[1].z = 2.0F;
+	jeVertexBuffer_pushPrimitive(&vertexBuffer, vertices, JE_PRIMITIVE_TYPE_SPRITES);
+	vertices[0].z = 1.0F;
+	vertices[1].z = 1.0F;
+	jeVertexBuffer_pushPrimitive(&vertexBuffer, vertices, JE_PRIMITIVE_TYPE_SPRITES);
+	vertices[0].z = 0.0F;
+	vertices[1].z = 0.0F;
+	jeVertexBuffer_pushPrimitive(&vertexBuffer, vertices, JE_PRIMITIVE_TYPE_SPRITES);
+	for (uint32_t i = 0; i < JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT; i++) {
+		vertices[i].z = 1.0F;
+	}
+	jeVertexBuffer_pushPrimitive(&vertexBuffer, vertices, JE_PRIMITIVE_TYPE_QUADS);
+	JE_ASSERT(vertexBuffer.instances.count == 3);
+	JE_ASSERT(vertexBuffer.vertices.count == JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT);
+
+	for (uint32_t i = 0; i < 2; i++) {
+		JE_ASSERT(jeVertexBuffer_sort(&vertexBuffer, JE_PRIMITIVE_TYPE_QUADS));
+		JE_ASSERT(vertexBuffer.drawRanges.count == 3);
+
+		const struct jeDrawRange* drawRange = (const struct jeDrawRange*)jeArray_get(&vertexBuffer.drawRanges, 0);
+		JE_ASSERT(drawRange->instanced && (drawRange->start == 0) && (drawRange->count == 2));
+		drawRange = (const struct jeDrawRange*)jeArray_get(&vertexBuffer.drawRanges, 1);
+		JE_ASSERT(!drawRange->instanced && (drawRange->start == 0));
+		JE_ASSERT(drawRange->count == JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT);
+		drawRange = (const struct jeDrawRange*)jeArray_get(&vertexBuffer.drawRanges, 2);
+		JE_ASSERT(drawRange->instanced && (drawRange->start == 2) && (drawRange->count == 1));
+
+		JE_ASSERT(((const struct jeInstance*)jeArray_get(&vertexBuffer.instances, 0))->z == 2.0F);
+		JE_ASSERT(((const struct jeInstance*)jeArray_get(&vertexBuffer.instances, 1))->z == 1.0F);
+		JE_ASSERT(((const struct jeInstance*)jeArray_get(&vertexBuffer.instances, 2))->z == 0.0F);
+	}
+
+	/*Full vertex alpha is only opaque on binary-alpha textures, as soft texel alpha still needs blending*/
+	jeVertexBuffer_reset(&vertexBuffer);
+	memset((void*)vertices, 0, sizeof(vertices));
+	for (uint32_t i = 0; i < JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT; i++) {
+		vertices[i].a = 1.0F;
+	}
+	jeVertexBuffer_pushPrimitive(&vertexBuffer, vertices, JE_PRIMITIVE_TYPE_SPRITES);
+	JE_ASSERT(vertexBuffer.opaqueTextureMask == 0);
+	JE_ASSERT(!jeVertexBuffer_getPrimitiveOpaque(&vertexBuffer, vertices, JE_PRIMITIVE_TYPE_SPRITES, 0));
+	jeVertexBuffer_setTextureBinaryAlpha(&vertexBuffer, 0, true);
+	jeVertexBuffer_setTextureBinaryAlpha(&vertexBuffer, 1, true);
+	jeVertexBuffer_reset(&vertexBuffer);
+	JE_ASSERT(vertexBuffer.binaryAlphaTextureMask == 3U);
+	JE_ASSERT(jeVertexBuffer_getPrimitiveOpaque(&vertexBuffer, vertices, JE_PRIMITIVE_TYPE_SPRITES, 0));
+
+	/*Opaque primitives are drawn first in submission order, and only translucent primitives are sorted*/
+	jeVertexBuffer_pushPrimitive(&vertexBuffer, vertices, JE_PRIMITIVE_TYPE_SPRITES);
+	vertices[0].a = 0.5F;
+	vertices[0].z = 1.0F;
+	vertices[1].z = 1.0F;
+	jeVertexBuffer_pushPrimitive(&vertexBuffer, vertices, JE_PRIMITIVE_TYPE_SPRITES);
+	vertices[0].a = 1.0F;
+	for (uint32_t i = 0; i < JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT; i++) {
+		vertices[i].z = 2.0F;
+	}
+	jeVertexBuffer_pushPrimitive(&vertexBuffer, vertices, JE_PRIMITIVE_TYPE_QUADS);
+
+	JE_ASSERT(jeVertexBuffer_sort(&vertexBuffer, JE_PRIMITIVE_TYPE_QUADS));
+	JE_ASSERT(vertexBuffer.sortedPrimitiveCount == 1);
+	JE_ASSERT(vertexBuffer.drawRanges.count == 3);
+	const struct jeDrawRange* drawRange = (const struct jeDrawRange*)jeArray_get(&vertexBuffer.drawRanges, 0);
+	JE_ASSERT(drawRange->opaque && drawRange->instanced && (drawRange->count == 1));
+	drawRange = (const struct jeDrawRange*)jeArray_get(&vertexBuffer.drawRanges, 1);
+	JE_ASSERT(drawRange->opaque && !drawRange->instanced);
+	drawRange = (const struct jeDrawRange*)jeArray_get(&vertexBuffer.drawRanges, 2);
+	JE_ASSERT(!drawRange->opaque && drawRange->instanced && (drawRange->start == 1));
+	JE_ASSERT(((const struct jeInstance*)jeArray_get(&vertexBuffer.instances, 0))->z == 0.0F);
+	JE_ASSERT(((const struct jeInstance*)jeArray_get(&vertexBuffer.instances, 1))->z == 1.0F);
+
+	/*Opaque primitives are grouped by texture, while translucent primitives only split ranges by texture*/
+	jeVertexBuffer_reset(&vertexBuffer);
+	memset((void*)vertices, 0, sizeof(vertices));
+	for (uint32_t i = 0; i < 4; i++) {
+		vertices[0].a = 1.0F;
+		vertices[0].z = (float)(10 + (i % 2));
+		jeVertexBuffer_pushTexturedPrimitive(&vertexBuffer, vertices, JE_PRIMITIVE_TYPE_POINTS, i % 2);
+		vertices[0].a = 0.5F;
+		vertices[0].z = (float)(4 - i);
+		jeVertexBuffer_pushTexturedPrimitive(&vertexBuffer, vertices, JE_PRIMITIVE_TYPE_POINTS, i % 2);
+	}
+	JE_ASSERT(vertexBuffer.opaqueTextureMask == 3U);
+
+	for (uint32_t i = 0; i < 2; i++) {
+		JE_ASSERT(jeVertexBuffer_sort(&vertexBuffer, JE_PRIMITIVE_TYPE_QUADS));
+		JE_ASSERT(vertexBuffer.drawRanges.count == 6);
+		drawRange = (const struct jeDrawRange*)jeArray_get(&vertexBuffer.drawRanges, 0);
+		JE_ASSERT(drawRange->opaque && (drawRange->textureId == 0) && (drawRange->count == 2));
+		drawRange = (const struct jeDrawRange*)jeArray_get(&vertexBuffer.drawRanges, 1);
+		JE_ASSERT(drawRange->opaque && (drawRange->textureId == 1) && (drawRange->count == 2));
+		for (uint32_t j = 2; j < 6; j++) {
+			drawRange = (const struct jeDrawRange*)jeArray_get(&vertexBuffer.drawRanges, j);
+			JE_ASSERT(!drawRange->opaque && (drawRange->textureId == ((j - 2) % 2)) && (drawRange->count == 1));
+		}
+	}
+
+	/* Primitives sharing a depth are drawn in submission order, as the depth test lets the later draw win ties.
+	 * Opaque primitives sharing a depth with translucent primitives or another texture are sorted instead*/
+	static const float tieTestDepths[] = {1.0F, 1.0F, 2.0F, 2.0F, 3.0F};
+	static const float tieTestAlphas[] = {0.5F, 1.0F, 1.0F, 1.0F, 1.0F};
+	static const uint32_t tieTestTextureIds[] = {0, 0, 1, 0, 0};
+	static const float tieTestDrawOrder[] = {4.0F, 2.0F, 3.0F, 0.0F, 1.0F};
+	jeVertexBuffer_reset(&vertexBuffer);
+	memset((void*)vertices, 0, sizeof(vertices));
+	for (uint32_t i = 0; i < 5; i++) {
+		vertices[0].x = (float)i;
+		vertices[0].z = tieTestDepths[i];
+		vertices[0].a = tieTestAlphas[i];
+		jeVertexBuffer_pushTexturedPrimitive(&vertexBuffer, vertices, JE_PRIMITIVE_TYPE_POINTS, tieTestTextureIds[i]);
+	}
+
+	for (uint32_t i = 0; i < 2; i++) {
+		JE_ASSERT(jeVertexBuffer_sort(&vertexBuffer, JE_PRIMITIVE_TYPE_QUADS));
+		JE_ASSERT(vertexBuffer.sortedPrimitiveCount == 4);
+		JE_ASSERT(vertexBuffer.drawRanges.count == 3);
+		drawRange = (const struct jeDrawRange*)jeArray_get(&vertexBuffer.drawRanges, 0);
+		JE_ASSERT(drawRange->opaque && (drawRange->textureId == 0) && (drawRange->count == 1));
+		drawRange = (const struct jeDrawRange*)jeArray_get(&vertexBuffer.drawRanges, 1);
+		JE_ASSERT(!drawRange->opaque && (drawRange->textureId == 1) && (drawRange->count == 1));
+		drawRange = (const struct jeDrawRange*)jeArray_get(&vertexBuffer.drawRanges, 2);
+		JE_ASSERT(!drawRange->opaque && (drawRange->textureId == 0) && (drawRange->count == 3));
+		for (uint32_t j = 0; j < 5; j++) {
+			JE_ASSERT(((const struct jeInstance*)jeArray_get(&vertexBuffer.instances, j))->x0 == tieTestDrawOrder[j]);
+		}
+	}
+
+	jeVertexBuffer_setInstancing(&vertexBuffer, false);
+	jeVertexBuffer_reset(&vertexBuffer);
+	JE_ASSERT(vertexBuffer.instances.count == 0);
+	JE_ASSERT(vertexBuffer.opaqueTextureMask == 0);
+
 	jeVertexBuffer_reset(&vertexBuffer);
 	JE_ASSERT(vertexBuffer.vertices.count == 0);
 	jeVertexBuffer_destroy(&vertexBuffer);
 #endif
 }
+int jePrimitiveReferenceSortKey_less(const void* rawSortKeyA, const void* rawSortKeyB) {
+	const struct jePrimitiveReferenceSortKey* sortKeyA = (const struct jePrimitiveReferenceSortKey*)rawSortKeyA;
+	const struct jePrimitiveReferenceSortKey* sortKeyB = (const struct jePrimitiveReferenceSortKey*)rawSortKeyB;
+
+	int result = 0;
+	if (sortKeyA->z > sortKeyB->z) {
+		result = -1;
+	} else if (sortKeyA->z < sortKeyB->z) {
+		result = 1;
+	} else if (sortKeyA->index < sortKeyB->index) {
+		result = -1;
+	} else if (sortKeyA->index > sortKeyB->index) {
+		result = 1;
+	}
+
+	return result;
+}
+/* The jeVertexBuffer_sort() this file had before the radix sort, so that benchmarks measure against it: copies
+ * every vertex and allocates keys each call, sorts the keys with qsort(), then scatters vertices back in place*/
+bool jeVertexBuffer_sortReference(struct jeVertexBuffer* vertexBuffer, uint32_t primitiveType) {
+	bool ok = true;
+
+	if (vertexBuffer == NULL) {
+		JE_ERROR("vertexBuffer=NULL");
+		ok = false;
+	}
+
+	if (ok && (vertexBuffer->vertexFormat != JE_VERTEX_FORMAT_FLOAT)) {
+		JE_ERROR("only float vertices can be sorted, vertexFormat=%u", vertexBuffer->vertexFormat);
+		ok = false;
+	}
+
+	uint32_t primitiveVertexCount = jePrimitiveType_getVertexCount(primitiveType);
+	uint32_t vertexCount = 0;
+	uint32_t primitiveCount = 0;
+	struct jeVertex* vertices = NULL;
+
+	if (ok) {
+		vertexCount = vertexBuffer->vertices.count;
+		primitiveCount = vertexCount / primitiveVertexCount;
+		vertices = (struct jeVertex*)vertexBuffer->vertices.data;
+	}
+
+	struct jeArray unsortedVerticesBuffer;
+	ok = ok && jeArray_create(&unsortedVerticesBuffer, sizeof(struct jeVertex));
+	ok = ok && jeArray_setCount(&unsortedVerticesBuffer, vertexCount);
+	const struct jeVertex* unsortedVertices = (const struct jeVertex*)unsortedVerticesBuffer.data;
+
+	if (ok) {
+		memcpy((void*)unsortedVertices, (const void*)vertices, sizeof(struct jeVertex) * vertexCount);
+	}
+
+	struct jeArray sortKeysBuffer;
+	ok = ok && jeArray_create(&sortKeysBuffer, sizeof(struct jePrimitiveReferenceSortKey));
+	ok = ok && jeArray_setCount(&sortKeysBuffer, primitiveCount);
+	struct jePrimitiveReferenceSortKey* sortKeys = (struct jePrimitiveReferenceSortKey*)sortKeysBuffer.data;
+
+	if (ok) {
+		for (uint32_t i = 0; i < primitiveCount; i++) {
+			uint32_t primitiveVertexIndex = primitiveVertexCount * i;
+			sortKeys[i].z = vertices[primitiveVertexIndex].z;
+			sortKeys[i].index = primitiveVertexIndex;
+		}
+
+		qsort(sortKeys, primitiveCount, sizeof(struct jePrimitiveReferenceSortKey), jePrimitiveReferenceSortKey_less);
+
+		for (uint32_t i = 0; i < primitiveCount; i++) {
+			uint32_t srcVertexIndex = sortKeys[i].index;
+			uint32_t destVertexIndex = primitiveVertexCount * i;
+			for (uint32_t j = 0; j < primitiveVertexCount; j++) {
+				vertices[destVertexIndex + j] = unsortedVertices[srcVertexIndex + j];
+			}
+		}
+	}
+
+	jeArray_destroy(&sortKeysBuffer);
+	jeArray_destroy(&unsortedVerticesBuffer);
+
+	return ok;
+}
+void jeRendering_runBenchmarks() {
+	static const uint32_t spriteCounts[] = {1000, 10000, 100000};
+	static const uint32_t spriteCountsCount = (uint32_t)(sizeof(spriteCounts) / sizeof(spriteCounts[0]));
+
+	struct jeVertexBuffer unsortedVertexBuffer;
+	struct jeVertexBuffer vertexBuffer;
+	bool ok = jeVertexBuffer_create(&unsortedVertexBuffer);
+	ok = ok && jeVertexBuffer_create(&vertexBuffer);
+
+	for (uint32_t i = 0; ok && (i < spriteCountsCount); i++) {
+		uint32_t spriteCount = spriteCounts[i];
+		uint32_t iterations = JE_PRIMITIVE_SORT_BENCHMARK_PRIMITIVES_TOTAL / spriteCount;
+
+		for (uint32_t uniqueDepths = 0; ok && (uniqueDepths <= 1); uniqueDepths++) {
+			/*Deterministic pseudo-random depths; either a handful of layers (typical scene) or all distinct*/
+			uint32_t seed = 1;
+			jeVertexBuffer_reset(&unsortedVertexBuffer);
+			for (uint32_t j = 0; j < spriteCount; j++) {
+				seed = (seed * 1103515245U) + 12345U;
+
+				struct jeVertex spriteVertices[JE_PRIMITIVE_TYPE_SPRITES_VERTEX_COUNT];
+				memset((void*)spriteVertices, 0, sizeof(spriteVertices));
+				spriteVertices[0].x = (float)(j % 256);
+				spriteVertices[0].y = (float)(j / 256);
+				spriteVertices[0].z = uniqueDepths ? (float)(seed >> 8) / 256.0F
+												   : (float)((seed >> 16) % JE_PRIMITIVE_SORT_BENCHMARK_DEPTH_COUNT);
+				spriteVertices[1] = spriteVertices[0];
+				spriteVertices[1].x += 8.0F;
+				spriteVertices[1].y += 8.0F;
+				jeVertexBuffer_pushPrimitive(&unsortedVertexBuffer, spriteVertices, JE_PRIMITIVE_TYPE_SPRITES);
+			}
+
+			/* The reference is the whole pre-change sort, copy and qsort included.  Sorting keys with qsort instead
+			 * of the radix sort, but otherwise taking the current path, isolates the cost of the key sort itself*/
+			static const char* const sortNames[] = {"reference copy+qsort", "keys qsort", "keys radix"};
+			for (uint32_t sortMode = 0; ok && (sortMode < 3); sortMode++) {
+				double seconds = 0.0;
+				for (uint32_t j = 0; ok && (j < iterations); j++) {
+					ok = ok && jeArray_setCount(&vertexBuffer.vertices, unsortedVertexBuffer.vertices.count);
+					if (ok) {
+						memcpy(
+							vertexBuffer.vertices.data,
+							unsortedVertexBuffer.vertices.data,
+							sizeof(struct jeVertex) * unsortedVertexBuffer.vertices.count);
+					}
+
+					double startSeconds = jeBenchmark_getSeconds();
+					if (sortMode == 0) {
+						ok = ok && jeVertexBuffer_sortReference(&vertexBuffer, JE_PRIMITIVE_TYPE_QUADS);
+					} else {
+						ok = ok && jeVertexBuffer_sortImpl(
+									 &vertexBuffer,
+									 JE_PRIMITIVE_TYPE_QUADS,
+									 /*useRadixSort*/ sortMode == 2,
+									 /*optDestVertices*/ NULL,
+									 /*optDestInstances*/ NULL);
+					}
+					seconds += jeBenchmark_getSeconds() - startSeconds;
+				}
+
+				jeBenchmark_log(
+					je_temp_buffer_format(
+						"jeVertexBuffer_sort %s, sprites=%u, depths=%s",
+						sortNames[sortMode],
+						spriteCount,
+						uniqueDepths ? "unique" : "layered"),
+					seconds,
+					iterations);
+			}
+		}
+	}
+
+	/* Per-frame CPU cost of each vertex format, with and without instancing:
+	 * push, sort, and write the sorted vertices out as for an upload*/
+	struct jeArray uploadBuffer;
+	ok = ok && jeArray_create(&uploadBuffer, 1);
+
+	for (uint32_t config = 0; ok && (config < (JE_VERTEX_FORMAT_COUNT * 2)); config++) {
+		static const uint32_t spriteCount = 10000;
+		static const uint32_t iterations = 100;
+
+		uint32_t vertexFormat = config % JE_VERTEX_FORMAT_COUNT;
+		bool instancing = config >= JE_VERTEX_FORMAT_COUNT;
+
+		ok = ok && jeVertexBuffer_setFormat(&vertexBuffer, vertexFormat);
+		jeVertexBuffer_setInstancing(&vertexBuffer, instancing);
+
+		uint32_t uploadBytes = 0;
+		double startSeconds = jeBenchmark_getSeconds();
+		for (uint32_t i = 0; ok && (i < iterations); i++) {
+			jeVertexBuffer_reset(&vertexBuffer);
+
+			for (uint32_t j = 0; j < spriteCount; j++) {
+				struct jeVertex spriteVertices[JE_PRIMITIVE_TYPE_SPRITES_VERTEX_COUNT];
+				memset((void*)spriteVertices, 0, sizeof(spriteVertices));
+				spriteVertices[0].x = (float)(j % 256);
+				spriteVertices[0].y = (float)(j / 256);
+				spriteVertices[0].z = (float)(j % JE_PRIMITIVE_SORT_BENCHMARK_DEPTH_COUNT);
+				spriteVertices[0].r = 1.0F;
+				spriteVertices[0].g = 1.0F;
+				spriteVertices[0].b = 1.0F;
+				spriteVertices[0].a = 1.0F;
+				spriteVertices[1] = spriteVertices[0];
+				spriteVertices[1].x += 8.0F;
+				spriteVertices[1].y += 8.0F;
+				spriteVertices[1].u = 8.0F;
+				spriteVertices[1].v = 8.0F;
+				jeVertexBuffer_pushPrimitive(&vertexBuffer, spriteVertices, JE_PRIMITIVE_TYPE_SPRITES);
+			}
+
+			uint32_t vertexBytes = vertexBuffer.vertices.count * vertexBuffer.vertices.stride;
+			uploadBytes = vertexBytes + (vertexBuffer.instances.count * vertexBuffer.instances.stride);
+			ok = ok && jeArray_setCount(&uploadBuffer, uploadBytes);
+			ok = ok && jeVertexBuffer_sortInto(
+						   &vertexBuffer,
+						   JE_PRIMITIVE_TYPE_QUADS,
+						   uploadBuffer.data,
+						   (void*)((char*)uploadBuffer.data + vertexBytes));
+		}
+		double seconds = jeBenchmark_getSeconds() - startSeconds;
+
+		jeBenchmark_log(
+			je_temp_buffer_format(
+				"push+sort+upload %s vertices%s, sprites=%u, uploadBytes=%u",
+				(vertexFormat == JE_VERTEX_FORMAT_PACKED) ? "packed" : "float",
+				instancing ? " instanced" : "",
+				spriteCount,
+				uploadBytes),
+			seconds,
+			iterations);
+	}
+
+	/*Sort cost for a tile-heavy scene, where most primitives are opaque and skip the sort, vs all translucent*/
+	ok = ok && jeVertexBuffer_setFormat(&vertexBuffer, JE_VERTEX_FORMAT_PACKED);
+	jeVertexBuffer_setInstancing(&vertexBuffer, false);
+	jeVertexBuffer_setTextureBinaryAlpha(&vertexBuffer, 0, true);
+	for (uint32_t opaquePercent = 0; ok && (opaquePercent <= 90); opaquePercent += 90) {
+		static const uint32_t spriteCount = 10000;
+		static const uint32_t iterations = 100;
+
+		jeVertexBuffer_reset(&vertexBuffer);
+		for (uint32_t j = 0; j < spriteCount; j++) {
+			struct jeVertex spriteVertices[JE_PRIMITIVE_TYPE_SPRITES_VERTEX_COUNT];
+			memset((void*)spriteVertices, 0, sizeof(spriteVertices));
+			spriteVertices[0].x = (float)(j % 256);
+			spriteVertices[0].y = (float)(j / 256);
+			bool opaque = (j % 100) < opaquePercent;
+
+			/*Tiles share a layer behind the sprites, as opaque primitives sharing depth with others are sorted*/
+			spriteVertices[0].z = (float)(j % JE_PRIMITIVE_SORT_BENCHMARK_DEPTH_COUNT);
+			if (opaque) {
+				spriteVertices[0].z = (float)JE_PRIMITIVE_SORT_BENCHMARK_DEPTH_COUNT;
+			}
+			spriteVertices[0].a = opaque ? 1.0F : 0.5F;
+			spriteVertices[1] = spriteVertices[0];
+			spriteVertices[1].x += 8.0F;
+			spriteVertices[1].y += 8.0F;
+			jeVertexBuffer_pushPrimitive(&vertexBuffer, spriteVertices, JE_PRIMITIVE_TYPE_SPRITES);
+		}
+
+		uint32_t uploadBytes = vertexBuffer.vertices.count * vertexBuffer.vertices.stride;
+		ok = ok && jeArray_setCount(&uploadBuffer, uploadBytes);
+
+		double startSeconds = jeBenchmark_getSeconds();
+		for (uint32_t i = 0; ok && (i < iterations); i++) {
+			ok = ok && jeVertexBuffer_sortInto(&vertexBuffer, JE_PRIMITIVE_TYPE_QUADS, uploadBuffer.data, NULL);
+		}
+		double seconds = jeBenchmark_getSeconds() - startSeconds;
+
+		jeBenchmark_log(
+			je_temp_buffer_format(
+				"sort+upload, sprites=%u, opaque=%u%%, sorted=%u",
+				spriteCount,
+				opaquePercent,
+				vertexBuffer.sortedPrimitiveCount),
+			seconds,
+			iterations);
+	}
+
+	jeArray_destroy(&uploadBuffer);
+
+	if (!ok) {
+		JE_ERROR("benchmark failed");
+	}
+
+	jeVertexBuffer_destroy(&vertexBuffer);
+	jeVertexBuffer_destroy(&unsortedVertexBuffer);
+}
@@ -18,8 +18,18 @@
 #define JE_PRIMITIVE_TYPE_LINES_VERTEX_COUNT 2
 #define JE_PRIMITIVE_TYPE_SPRITES_VERTEX_COUNT 2
 #define JE_PRIMITIVE_TYPE_TRIANGLES_VERTEX_COUNT 3
-#define JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT 6
-#define JE_PRIMITIVE_TYPE_MAX_VERTEX_COUNT 6
+#define JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT 4
+#define JE_PRIMITIVE_TYPE_MAX_VERTEX_COUNT 4
+
+/*Quads are drawn as two indexed triangles, (0, 1, 2) and (2, 1, 3); see jeVertex_createQuadIndices()*/
+#define JE_PRIMITIVE_TYPE_QUADS_INDEX_COUNT 6
+
+/*Primitives are tagged with the texture they sample, from 0 up to JE_PRIMITIVE_TEXTURE_COUNT - 1*/
+#define JE_PRIMITIVE_TEXTURE_COUNT 16
+
+#define JE_VERTEX_FORMAT_FLOAT 0
+#define JE_VERTEX_FORMAT_PACKED 1
+#define JE_VERTEX_FORMAT_COUNT 2
 
 struct jeVertex {
 	float x;
@@ -35,27 +45,129 @@ struct jeVertex {
 	float u;
 	float v;
 };
+
+/*Compact vertex layout; positions are snapped to whole pixels, colors are normalized 8-bit, uvs are texels*/
+struct jeVertexPacked {
+	int16_t x;
+	int16_t y;
+	float z;
+
+	uint8_t r;
+	uint8_t g;
+	uint8_t b;
+	uint8_t a;
+
+	uint16_t u;
+	uint16_t v;
+};
+
+/*Compact record for a rect primitive (sprite, point or axis-aligned line), drawn by instancing a unit quad*/
+struct jeInstance {
+	float x0;
+	float y0;
+	float x1;
+	float y1;
+	float z;
+
+	uint16_t u0;
+	uint16_t v0;
+	uint16_t u1;
+	uint16_t v1;
+
+	uint8_t r;
+	uint8_t g;
+	uint8_t b;
+	uint8_t a;
+};
+
+/*Run of consecutive sorted vertices or instances, which can be drawn with a single call*/
+struct jeDrawRange {
+	bool instanced;
+
+	/*Opaque ranges come first, unsorted, and are meant to be drawn without blending*/
+	bool opaque;
+
+	/*Opaque ranges are grouped by texture; translucent ranges keep depth order and split where it changes*/
+	uint32_t textureId;
+
+	uint32_t start;
+	uint32_t count;
+};
+
 struct jeVertexBuffer {
+	/*One of JE_VERTEX_FORMAT_*; vertices are converted to this layout as they are pushed*/
+	uint32_t vertexFormat;
 	struct jeArray vertices;
+
+	/*When set, rect primitives are pushed as instances instead of being expanded to vertices*/
+	bool instancing;
+	struct jeArray instances;
+
+	/* Each quad and instance pushed, in submission order, so that both can be sorted together.  Primitives are
+	 * classified as opaque (alpha=1 on a binary-alpha texture) or translucent as they are pushed*/
+	struct jeArray submissions;
+
+	/* Bit per texture whose texels are all fully transparent or fully opaque.  Only these can be drawn unblended
+	 * without losing soft edges, so textures are treated as translucent until flagged.  Kept across resets*/
+	uint32_t binaryAlphaTextureMask;
+
+	/*Bit per texture used by opaque submissions since the last reset, so the sort only groups textures in use*/
+	uint32_t opaqueTextureMask;
+
+	/*Output of the last sort, in draw order*/
+	struct jeArray drawRanges;
+	uint32_t sortedPrimitiveCount;
+
+	/*Scratch space owned by the buffer and reused by every sort, so steady-state frames do not allocate*/
+	struct jeArray sortKeys;
+	struct jeArray sortKeysScratch;
+	struct jeArray depthStates;
+	struct jeArray sortedVertices;
+	struct jeArray sortedInstances;
 };
 
 JE_API_PUBLIC bool jePrimitiveType_getValid(uint32_t primitiveType);
 JE_API_PUBLIC uint32_t jePrimitiveType_getVertexCount(uint32_t primitiveType);
 
+JE_API_PUBLIC bool jeVertexFormat_getValid(uint32_t vertexFormat);
+JE_API_PUBLIC uint32_t jeVertexFormat_getVertexSize(uint32_t vertexFormat);
+
 JE_API_PUBLIC const char* jeVertex_getDebugString(const struct jeVertex* vertex);
 JE_API_PUBLIC const char* jeVertex_arrayGetDebugString(const struct jeVertex* vertices, uint32_t vertexCount);
 JE_API_PUBLIC const char* jeVertex_primitiveGetDebugString(const struct jeVertex* vertices, uint32_t primitiveType);
 JE_API_PUBLIC void jeVertex_createPointQuad(struct jeVertex* quadVertices, const struct jeVertex* pointVertices);
 JE_API_PUBLIC void jeVertex_createLineQuad(struct jeVertex* quadVertices, const struct jeVertex* lineVertices);
 JE_API_PUBLIC void jeVertex_createSpriteQuad(struct jeVertex* quadVertices, const struct jeVertex* spriteVertices);
+JE_API_PUBLIC void
+jeVertex_createTriangleQuad(struct jeVertex* quadVertices, const struct jeVertex* triangleVertices);
+JE_API_PUBLIC void jeVertex_createQuadIndices(uint32_t* indices, uint32_t quadCount);
+JE_API_PUBLIC void jeVertex_pack(struct jeVertexPacked* packedVertex, const struct jeVertex* vertex);
+JE_API_PUBLIC bool jeVertex_getPrimitiveVisible(
+	const struct jeVertex* vertices, uint32_t primitiveType, float x1, float y1, float x2, float y2);
+JE_API_PUBLIC bool
+jeInstance_create(struct jeInstance* instance, const struct jeVertex* vertices, uint32_t primitiveType);
 
 JE_API_PUBLIC bool jeVertexBuffer_create(struct jeVertexBuffer* vertexBuffer);
 JE_API_PUBLIC void jeVertexBuffer_destroy(struct jeVertexBuffer* vertexBuffer);
 JE_API_PUBLIC void jeVertexBuffer_reset(struct jeVertexBuffer* vertexBuffer);
+JE_API_PUBLIC bool jeVertexBuffer_setFormat(struct jeVertexBuffer* vertexBuffer, uint32_t vertexFormat);
+JE_API_PUBLIC void jeVertexBuffer_setInstancing(struct jeVertexBuffer* vertexBuffer, bool instancing);
+JE_API_PUBLIC void jeVertexBuffer_setTextureBinaryAlpha(
+	struct jeVertexBuffer* vertexBuffer, uint32_t textureId, bool binaryAlpha);
+JE_API_PUBLIC bool jeVertexBuffer_getPrimitiveOpaque(
+	const struct jeVertexBuffer* vertexBuffer,
+	const struct jeVertex* vertices,
+	uint32_t primitiveType,
+	uint32_t textureId);
 JE_API_PUBLIC bool jeVertexBuffer_sort(struct jeVertexBuffer* vertexBuffer, uint32_t primitiveType);
+JE_API_PUBLIC bool jeVertexBuffer_sortInto(
+	struct jeVertexBuffer* vertexBuffer, uint32_t primitiveType, void* destVertices, void* optDestInstances);
 JE_API_PUBLIC void jeVertexBuffer_pushPrimitive(
 	struct jeVertexBuffer* vertexBuffer, const struct jeVertex* vertices, uint32_t primitiveType);
+JE_API_PUBLIC void jeVertexBuffer_pushTexturedPrimitive(
+	struct jeVertexBuffer* vertexBuffer, const struct jeVertex* vertices, uint32_t primitiveType, uint32_t textureId);
 
 JE_API_PUBLIC void jeRendering_runTests();
+JE_API_PUBLIC void jeRendering_runBenchmarks();
 
 #endif
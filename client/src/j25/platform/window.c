@@ -25,6 +25,43 @@
 
 #define JE_GL_MESSAGE_BUFFER_CAPACITY (4 * 1024)
 
+/*Vertices are streamed through a ring of buffer segments, one per frame in flight*/
+#define JE_WINDOW_STREAM_SEGMENT_COUNT 3
+#define JE_WINDOW_STREAM_SEGMENT_START_SIZE (64 * 1024)
+#define JE_WINDOW_STREAM_FENCE_TIMEOUT_NS ((GLuint64)1000000000)
+
+/*Marks that no texture has been bound yet by the current flush*/
+#define JE_WINDOW_TEXTURE_ID_UNBOUND 0xFFFFFFFFU
+
+/*Quad indices never change, so they live in a static buffer which only grows to fit the largest frame*/
+#define JE_WINDOW_INDEX_START_QUAD_CAPACITY 4096
+
+#define JE_WINDOW_ATTRIB_POS 0
+#define JE_WINDOW_ATTRIB_COL 1
+#define JE_WINDOW_ATTRIB_UV 2
+#define JE_WINDOW_ATTRIB_DEPTH 3
+
+#define JE_WINDOW_INSTANCE_ATTRIB_CORNER 0
+#define JE_WINDOW_INSTANCE_ATTRIB_RECT 1
+#define JE_WINDOW_INSTANCE_ATTRIB_UV_RECT 2
+#define JE_WINDOW_INSTANCE_ATTRIB_COL 3
+#define JE_WINDOW_INSTANCE_ATTRIB_DEPTH 4
+
+/* Opaque primitives are drawn unblended, and only textures whose texels are all either transparent or opaque may
+ * hold them (see jeImage_getBinaryAlpha()).  Texels with alpha below this are cut out*/
+#define JE_WINDOW_OPAQUE_MIN_ALPHA 0.5F
+
+/*Set to 0 to always expand rect primitives on the CPU, even where instanced arrays are supported*/
+#if !defined(JE_WINDOW_INSTANCING)
+#define JE_WINDOW_INSTANCING 1
+#endif
+
+/* One of JE_VERTEX_FORMAT_*.  The packed layout is smaller, but snaps positions to whole pixels within +/- 32767 and
+ * colors to 8 bits, so apps opt in to it with jeWindow_setVertexFormat()*/
+#if !defined(JE_WINDOW_VERTEX_FORMAT)
+#define JE_WINDOW_VERTEX_FORMAT JE_VERTEX_FORMAT_FLOAT
+#endif
+
 /*https://www.khronos.org/registry/OpenGL/specs/gl/glspec21.pdf*/
 /*https://www.khronos.org/registry/OpenGL/specs/gl/GLSLangSpec.1.20.pdf*/
 #define JE_WINDOW_VERT_SHADER \
@@ -33,8 +70,10 @@
 	"uniform vec3 scaleXyz;" /*Transforms from world (+/- windowSize) to normalized device coords (-1.0 \
 								to 1.0)*/ \
 	"uniform vec2 scaleUv;"  /*Converts to normalized texture coords (0.0 to 1.0)*/ \
+	"uniform vec2 offset;"   /*Camera translation; only non-zero for retained layers, which are kept in world coords*/ \
 \
-	"attribute vec4 srcPos;" \
+	"attribute vec2 srcPos;" \
+	"attribute float srcDepth;" \
 	"attribute vec4 srcCol;" \
 	"attribute vec2 srcUv;" \
 \
@@ -42,20 +81,49 @@
 	"varying vec2 uv;" \
 \
 	"void main() {" \
-	"gl_Position = vec4(srcPos.xyz * scaleXyz, 1);" \
+	"gl_Position = vec4(vec3(srcPos + offset, srcDepth) * scaleXyz, 1);" \
 	"col = srcCol;" \
 	"uv = srcUv * scaleUv;" \
 	"}"
+/* Draws a struct jeInstance per instance, as a triangle strip over a unit quad.  Corners are either 0 or 1, and
+ * the rect is interpolated without mix() so that each corner lands exactly on the rect's edges*/
+#define JE_WINDOW_INSTANCE_VERT_SHADER \
+	"#version 120\n" \
+\
+	"uniform vec3 scaleXyz;" \
+	"uniform vec2 scaleUv;" \
+	"uniform vec2 offset;" \
+\
+	"attribute vec2 srcCorner;" \
+	"attribute vec4 srcRect;" \
+	"attribute vec4 srcUvRect;" \
+	"attribute vec4 srcCol;" \
+	"attribute float srcDepth;" \
+\
+	"varying vec4 col;" \
+	"varying vec2 uv;" \
+\
+	"void main() {" \
+	"vec2 pos = (srcRect.xy * (1.0 - srcCorner)) + (srcRect.zw * srcCorner);" \
+	"gl_Position = vec4(vec3(pos + offset, srcDepth) * scaleXyz, 1);" \
+	"col = srcCol;" \
+	"uv = ((srcUvRect.xy * (1.0 - srcCorner)) + (srcUvRect.zw * srcCorner)) * scaleUv;" \
+	"}"
 #define JE_WINDOW_FRAG_SHADER \
 	"#version 120\n" \
 \
 	"uniform sampler2D srcTexture;" \
+	"uniform float minAlpha;" /*Fragments below are discarded; used to cut out transparent texels when unblended*/ \
 \
 	"varying vec4 col;" \
 	"varying vec2 uv;" \
 \
 	"void main() {" \
-	"gl_FragColor = texture2D(srcTexture, uv).rgba * col;" \
+	"vec4 color = texture2D(srcTexture, uv).rgba * col;" \
+	"if (color.a < minAlpha) {" \
+	"discard;" \
+	"}" \
+	"gl_FragColor = color;" \
 	"}"
 
 struct jeSDL {
@@ -75,6 +143,33 @@ struct jeController {
 	float controllerAxisThreshold;
 };
 
+/*A translucent primitive pushed to a layer, in world coords*/
+struct jeWindowLayerPrimitive {
+	struct jeVertex vertices[JE_PRIMITIVE_TYPE_MAX_VERTEX_COUNT];
+	uint32_t primitiveType;
+	uint32_t textureId;
+};
+
+/* A retained layer keeps its primitives between frames, in world coords.  Opaque primitives are sorted and uploaded
+ * to the layer's own static buffer once per rebuild, then drawn each frame the layer is queued, at the queued offset.
+ * Translucent primitives must blend over whatever the frame draws behind them, so they are instead pushed to the
+ * frame when the layer is queued, and sorted along with the frame's own*/
+struct jeWindowLayer {
+	struct jeVertexBuffer vertexBuffer;
+	struct jeArray translucentPrimitives;
+	GLuint vbo;
+	bool uploaded;
+	bool drawQueued;
+	GLfloat offsetX;
+	GLfloat offsetY;
+};
+
+/*Images are kept after upload, so that textures can be recreated along with the GL context*/
+struct jeWindowTexture {
+	struct jeImage image;
+	GLuint texture;
+};
+
 struct jeWindow {
 	bool open;
 
@@ -84,19 +179,58 @@ struct jeWindow {
 	Uint32 nextFrameStartMs;
 
 	struct jeVertexBuffer vertexBuffer;
-	struct jeImage image;
 	SDL_Window* window;
 
 	struct jeController controller;
 	const Uint8* keyState;
 
 	SDL_GLContext context;
-	GLuint texture;
 	GLuint vertShader;
 	GLuint fragShader;
 	GLuint program;
+	GLint minAlphaLocation;
+	GLint offsetLocation;
+	GLint scaleUvLocation;
 	GLuint vbo;
 	GLuint vao;
+	GLuint ibo;
+	uint32_t iboQuadCapacity;
+
+	/*Instanced rect rendering, when supported; shares the fragment shader and stream buffer*/
+	bool instancing;
+	GLuint instanceVertShader;
+	GLuint instanceProgram;
+	GLint instanceMinAlphaLocation;
+	GLint instanceOffsetLocation;
+	GLint instanceScaleUvLocation;
+	GLuint instanceVao;
+	GLuint quadVbo;
+
+	/* Streaming state.  When glMapBufferRange and fences are available, each frame writes to the next segment of
+	 * the ring unsynchronized, and only waits if the GPU is still reading that segment.  Otherwise the buffer
+	 * is orphaned each frame, which lets the driver hand back fresh storage instead of stalling.*/
+	bool streamUnsynchronized;
+	uint32_t streamSegment;
+	GLsizeiptr streamSegmentSize;
+	GLsync streamFences[JE_WINDOW_STREAM_SEGMENT_COUNT];
+
+	/*Primitives are pushed to the building layer instead of the frame, between jeWindow_beginLayer/endLayer()*/
+	struct jeWindowLayer layers[JE_WINDOW_LAYER_COUNT];
+	struct jeWindowLayer* buildingLayer;
+
+	/*Texture 0 is the sprites image the window was created with; see jeWindow_loadTexture()*/
+	struct jeWindowTexture textures[JE_PRIMITIVE_TEXTURE_COUNT];
+	uint32_t textureCount;
+
+	/*GL state bound by the current flush, so that ranges only switch what differs from the previous range*/
+	GLuint boundProgram;
+	uint32_t boundTextureId;
+
+	/*Primitives pushed to the frame since the last flush, split by whether they were culled off-screen*/
+	uint32_t pushCulledCount;
+	uint32_t pushSubmittedCount;
+
+	struct jeWindowFrameStats frameStats;
 };
 
 bool jeSDL_initReentrant();
@@ -110,6 +244,26 @@ void jeController_destroy(struct jeController* controller);
 void jeController_create(struct jeController* controller);
 
 bool jeWindow_clear(struct jeWindow* window);
+void jeWindow_bindVertexAttributes(uint32_t vertexFormat, GLintptr offset);
+void jeWindow_bindInstanceAttributes(GLintptr offset);
+void jeWindow_drawInstances(uint32_t instanceCount);
+void jeWindow_destroyStreamFences(struct jeWindow* window);
+bool jeWindow_ensureQuadIndices(struct jeWindow* window, uint32_t quadCount);
+void jeWindow_pushValidPrimitive(
+	struct jeWindow* window, const struct jeVertex* vertices, uint32_t primitiveType, uint32_t textureId);
+void* jeWindow_mapStream(struct jeWindow* window, GLsizeiptr size, GLintptr* outOffset);
+bool jeWindow_uploadLayer(struct jeWindow* window, struct jeWindowLayer* layer);
+void jeWindow_uploadTexture(struct jeWindowTexture* texture);
+void jeWindow_classifyTexture(struct jeWindow* window, uint32_t textureId);
+void jeWindow_bindRangeState(struct jeWindow* window, GLuint program, uint32_t textureId);
+void jeWindow_drawRanges(
+	struct jeWindow* window,
+	const struct jeVertexBuffer* vertexBuffer,
+	GLuint vbo,
+	GLintptr vertexOffset,
+	GLintptr instanceOffset,
+	GLfloat offsetX,
+	GLfloat offsetY);
 bool jeWindow_flushPrimitives(struct jeWindow* window);
 void jeWindow_destroyGL(struct jeWindow* window);
 bool jeWindow_initGL(struct jeWindow* window);
@@ -120,6 +274,11 @@ static const GLchar* jeWindow_vertShaderPtr = JE_WINDOW_VERT_SHADER;
 static const GLchar* jeWindow_fragShaderPtr = JE_WINDOW_FRAG_SHADER;
 static const GLint jeWindow_vertShaderSize = sizeof(JE_WINDOW_VERT_SHADER);
 static const GLint jeWindow_fragShaderSize = sizeof(JE_WINDOW_FRAG_SHADER);
+static const GLchar* jeWindow_instanceVertShaderPtr = JE_WINDOW_INSTANCE_VERT_SHADER;
+static const GLint jeWindow_instanceVertShaderSize = sizeof(JE_WINDOW_INSTANCE_VERT_SHADER);
+
+/*Unit quad corners, in triangle strip order; matches the triangles of jeVertex_createSpriteQuad()*/
+static const GLfloat jeWindow_quadCorners[] = {0.0F, 0.0F, 1.0F, 0.0F, 0.0F, 1.0F, 1.0F, 1.0F};
 
 static char jeGl_messageBuffer[JE_GL_MESSAGE_BUFFER_CAPACITY];
 
@@ -421,10 +580,20 @@ void jeWindow_resetPrimitives(struct jeWindow* window) {
 
 	if (ok) {
 		jeVertexBuffer_reset(&window->vertexBuffer);
+		window->pushCulledCount = 0;
+		window->pushSubmittedCount = 0;
+
+		for (uint32_t i = 0; i < JE_WINDOW_LAYER_COUNT; i++) {
+			window->layers[i].drawQueued = false;
+		}
 	}
 }
 void jeWindow_pushPrimitive(struct jeWindow* window, const struct jeVertex* vertices, uint32_t primitiveType) {
-	JE_TRACE("window=%p, primitiveType=%u", (void*)window, primitiveType);
+	jeWindow_pushTexturedPrimitive(window, vertices, primitiveType, /*textureId*/ 0);
+}
+void jeWindow_pushTexturedPrimitive(
+	struct jeWindow* window, const struct jeVertex* vertices, uint32_t primitiveType, uint32_t textureId) {
+	JE_TRACE("window=%p, primitiveType=%u, textureId=%u", (void*)window, primitiveType, textureId);
 
 	bool ok = true;
 
@@ -443,10 +612,666 @@ void jeWindow_pushPrimitive(struct jeWindow* window, const struct jeVertex* vert
 		ok = false;
 	}
 
+	if (ok && (textureId >= window->textureCount)) {
+		JE_ERROR("texture is not loaded, textureId=%u, textureCount=%u", textureId, window->textureCount);
+		ok = false;
+	}
+
 	if (ok) {
-		jeVertexBuffer_pushPrimitive(&window->vertexBuffer, vertices, primitiveType);
+		jeWindow_pushValidPrimitive(window, vertices, primitiveType, textureId);
+	}
+}
+void jeWindow_pushTexturedPrimitives(
+	struct jeWindow* window,
+	const struct jeVertex* vertices,
+	uint32_t primitiveCount,
+	uint32_t primitiveType,
+	uint32_t textureId,
+	float offsetX,
+	float offsetY) {
+	JE_TRACE(
+		"window=%p, primitiveCount=%u, primitiveType=%u, textureId=%u",
+		(void*)window,
+		primitiveCount,
+		primitiveType,
+		textureId);
+
+	bool ok = true;
+
+	if (window == NULL) {
+		JE_ERROR("window=NULL");
+		ok = false;
+	}
+
+	if ((vertices == NULL) && (primitiveCount > 0)) {
+		JE_ERROR("vertices=NULL");
+		ok = false;
+	}
+
+	if (jePrimitiveType_getValid(primitiveType) == false) {
+		JE_ERROR("primitiveType is not valid");
+		ok = false;
+	}
+
+	if (ok && (textureId >= window->textureCount)) {
+		JE_ERROR("texture is not loaded, textureId=%u, textureCount=%u", textureId, window->textureCount);
+		ok = false;
+	}
+
+	if (ok) {
+		uint32_t vertexCount = jePrimitiveType_getVertexCount(primitiveType);
+
+		for (uint32_t i = 0; i < primitiveCount; i++) {
+			struct jeVertex primitiveVertices[JE_PRIMITIVE_TYPE_MAX_VERTEX_COUNT];
+			memcpy(primitiveVertices, &vertices[i * vertexCount], sizeof(struct jeVertex) * vertexCount);
+
+			for (uint32_t j = 0; j < vertexCount; j++) {
+				primitiveVertices[j].x += offsetX;
+				primitiveVertices[j].y += offsetY;
+			}
+
+			jeWindow_pushValidPrimitive(window, primitiveVertices, primitiveType, textureId);
+		}
+	}
+}
+void jeWindow_pushValidPrimitive(
+	struct jeWindow* window, const struct jeVertex* vertices, uint32_t primitiveType, uint32_t textureId) {
+	bool ok = true;
+
+	/*Frame primitives are already in window space, so anything outside the minimum window bounds is not visible.
+	 * Layers are exempt as they are retained in world space and offset at draw time.*/
+	if (ok && (window->buildingLayer == NULL)) {
+		const float halfWidth = (float)JE_WINDOW_MIN_WIDTH / 2.0F;
+		const float halfHeight = (float)JE_WINDOW_MIN_HEIGHT / 2.0F;
+		if (!jeVertex_getPrimitiveVisible(vertices, primitiveType, -halfWidth, -halfHeight, halfWidth, halfHeight)) {
+			window->pushCulledCount++;
+			ok = false;
+		}
+	}
+
+	struct jeWindowLayer* layer = window->buildingLayer;
+	if (ok && (layer != NULL) &&
+		!jeVertexBuffer_getPrimitiveOpaque(&layer->vertexBuffer, vertices, primitiveType, textureId)) {
+		struct jeWindowLayerPrimitive primitive;
+		memset((void*)&primitive, 0, sizeof(primitive));
+		memcpy(
+			(void*)primitive.vertices,
+			(const void*)vertices,
+			sizeof(struct jeVertex) * jePrimitiveType_getVertexCount(primitiveType));
+		primitive.primitiveType = primitiveType;
+		primitive.textureId = textureId;
+
+		jeArray_push(&layer->translucentPrimitives, (const void*)&primitive, 1);
+		ok = false;
+	}
+
+	if (ok) {
+		struct jeVertexBuffer* vertexBuffer = &window->vertexBuffer;
+		if (layer != NULL) {
+			vertexBuffer = &layer->vertexBuffer;
+		} else {
+			window->pushSubmittedCount++;
+		}
+
+		jeVertexBuffer_pushTexturedPrimitive(vertexBuffer, vertices, primitiveType, textureId);
+	}
+}
+bool jeWindow_loadTexture(struct jeWindow* window, const char* filename, uint32_t* outTextureId) {
+	JE_DEBUG("window=%p, filename=%s", (void*)window, (filename != NULL) ? filename : "NULL");
+
+	bool ok = true;
+
+	if (window == NULL) {
+		JE_ERROR("window=NULL");
+		ok = false;
+	}
+
+	if (filename == NULL) {
+		JE_ERROR("filename=NULL");
+		ok = false;
+	}
+
+	if (outTextureId == NULL) {
+		JE_ERROR("outTextureId=NULL");
+		ok = false;
+	}
+
+	if (ok && (window->textureCount >= JE_PRIMITIVE_TEXTURE_COUNT)) {
+		JE_ERROR("too many textures, textureCount=%u", window->textureCount);
+		ok = false;
+	}
+
+	struct jeWindowTexture* texture = NULL;
+	if (ok) {
+		texture = &window->textures[window->textureCount];
+		memset((void*)texture, 0, sizeof(*texture));
+
+		ok = jeImage_createFromPNGFile(&texture->image, filename);
+	}
+
+	if (ok && (window->context != NULL)) {
+		if (SDL_GL_MakeCurrent(window->window, window->context) != 0) {
+			JE_ERROR("SDL_GL_MakeCurrent() failed with error=%s", SDL_GetError());
+			ok = false;
+		}
+	}
+
+	if (ok && (window->context != NULL)) {
+		jeWindow_uploadTexture(texture);
+
+		if (jeGl_getOk(JE_LOG_CONTEXT) == false) {
+			JE_ERROR("jeGl_getOk() error");
+			ok = false;
+		}
+	}
+
+	if (ok) {
+		jeWindow_classifyTexture(window, window->textureCount);
+
+		*outTextureId = window->textureCount;
+		window->textureCount++;
+	}
+
+	if (!ok && (texture != NULL)) {
+		if (texture->texture != 0) {
+			glDeleteTextures(1, &texture->texture);
+		}
+		jeImage_destroy(&texture->image);
+		memset((void*)texture, 0, sizeof(*texture));
+	}
+
+	return ok;
+}
+void jeWindow_beginLayer(struct jeWindow* window, uint32_t layerId) {
+	JE_TRACE("window=%p, layerId=%u", (void*)window, layerId);
+
+	bool ok = true;
+
+	if (window == NULL) {
+		JE_ERROR("window=NULL");
+		ok = false;
+	}
+
+	if (layerId >= JE_WINDOW_LAYER_COUNT) {
+		JE_ERROR("layerId out of range, layerId=%u, layerCount=%u", layerId, (uint32_t)JE_WINDOW_LAYER_COUNT);
+		ok = false;
+	}
+
+	if (ok && (window->buildingLayer != NULL)) {
+		JE_WARN("previous layer was not ended, layerId=%u", (uint32_t)(window->buildingLayer - window->layers));
+	}
+
+	if (ok) {
+		struct jeWindowLayer* layer = &window->layers[layerId];
+
+		/*The layer's contents are replaced, and uploaded on the next flush it is drawn in*/
+		jeVertexBuffer_reset(&layer->vertexBuffer);
+		jeArray_setCount(&layer->translucentPrimitives, 0);
+		layer->uploaded = false;
+
+		window->buildingLayer = layer;
+	}
+}
+void jeWindow_endLayer(struct jeWindow* window) {
+	JE_TRACE("window=%p", (void*)window);
+
+	bool ok = true;
+
+	if (window == NULL) {
+		JE_ERROR("window=NULL");
+		ok = false;
+	}
+
+	if (ok) {
+		window->buildingLayer = NULL;
+	}
+}
+void jeWindow_drawLayer(struct jeWindow* window, uint32_t layerId, float offsetX, float offsetY) {
+	JE_TRACE("window=%p, layerId=%u, offsetX=%f, offsetY=%f", (void*)window, layerId, offsetX, offsetY);
+
+	bool ok = true;
+
+	if (window == NULL) {
+		JE_ERROR("window=NULL");
+		ok = false;
+	}
+
+	if (layerId >= JE_WINDOW_LAYER_COUNT) {
+		JE_ERROR("layerId out of range, layerId=%u, layerCount=%u", layerId, (uint32_t)JE_WINDOW_LAYER_COUNT);
+		ok = false;
+	}
+
+	if (ok && (window->buildingLayer != NULL)) {
+		JE_ERROR("cannot draw a layer while building one, layerId=%u", layerId);
+		ok = false;
+	}
+
+	if (ok) {
+		struct jeWindowLayer* layer = &window->layers[layerId];
+		layer->drawQueued = true;
+		layer->offsetX = (GLfloat)offsetX;
+		layer->offsetY = (GLfloat)offsetY;
+
+		const struct jeWindowLayerPrimitive* primitives =
+			(const struct jeWindowLayerPrimitive*)layer->translucentPrimitives.data;
+		for (uint32_t i = 0; i < layer->translucentPrimitives.count; i++) {
+			struct jeWindowLayerPrimitive primitive = primitives[i];
+			for (uint32_t j = 0; j < jePrimitiveType_getVertexCount(primitive.primitiveType); j++) {
+				primitive.vertices[j].x += offsetX;
+				primitive.vertices[j].y += offsetY;
+			}
+
+			jeWindow_pushValidPrimitive(window, primitive.vertices, primitive.primitiveType, primitive.textureId);
+		}
+	}
+}
+bool jeWindow_setVertexFormat(struct jeWindow* window, uint32_t vertexFormat) {
+	JE_TRACE("window=%p, vertexFormat=%u", (void*)window, vertexFormat);
+
+	bool ok = true;
+
+	if (window == NULL) {
+		JE_ERROR("window=NULL");
+		ok = false;
+	}
+
+	if (ok && (window->buildingLayer != NULL)) {
+		JE_ERROR("cannot change the vertex format while building a layer");
+		ok = false;
+	}
+
+	/*Primitives already pushed are cleared with the old layout, so retained layers must be rebuilt afterwards*/
+	ok = ok && jeVertexBuffer_setFormat(&window->vertexBuffer, vertexFormat);
+	for (uint32_t i = 0; ok && (i < JE_WINDOW_LAYER_COUNT); i++) {
+		struct jeWindowLayer* layer = &window->layers[i];
+		ok = jeVertexBuffer_setFormat(&layer->vertexBuffer, vertexFormat);
+		layer->uploaded = false;
+	}
+
+	return ok;
+}
+void jeWindow_bindVertexAttributes(uint32_t vertexFormat, GLintptr offset) {
+	JE_TRACE("vertexFormat=%u, offset=%ld", vertexFormat, (long)offset);
+
+	if (vertexFormat == JE_VERTEX_FORMAT_PACKED) {
+		static const GLsizei stride = (GLsizei)sizeof(struct jeVertexPacked);
+
+		glVertexAttribPointer(
+			JE_WINDOW_ATTRIB_POS,
+			2,
+			GL_SHORT,
+			GL_FALSE,
+			stride,
+			(const GLvoid*)(offset + (GLintptr)offsetof(struct jeVertexPacked, x)));
+		glVertexAttribPointer(
+			JE_WINDOW_ATTRIB_DEPTH,
+			1,
+			GL_FLOAT,
+			GL_FALSE,
+			stride,
+			(const GLvoid*)(offset + (GLintptr)offsetof(struct jeVertexPacked, z)));
+		glVertexAttribPointer(
+			JE_WINDOW_ATTRIB_COL,
+			4,
+			GL_UNSIGNED_BYTE,
+			GL_TRUE,
+			stride,
+			(const GLvoid*)(offset + (GLintptr)offsetof(struct jeVertexPacked, r)));
+		glVertexAttribPointer(
+			JE_WINDOW_ATTRIB_UV,
+			2,
+			GL_UNSIGNED_SHORT,
+			GL_FALSE,
+			stride,
+			(const GLvoid*)(offset + (GLintptr)offsetof(struct jeVertexPacked, u)));
+	} else {
+		static const GLsizei stride = (GLsizei)sizeof(struct jeVertex);
+
+		glVertexAttribPointer(
+			JE_WINDOW_ATTRIB_POS,
+			2,
+			GL_FLOAT,
+			GL_FALSE,
+			stride,
+			(const GLvoid*)(offset + (GLintptr)offsetof(struct jeVertex, x)));
+		glVertexAttribPointer(
+			JE_WINDOW_ATTRIB_DEPTH,
+			1,
+			GL_FLOAT,
+			GL_FALSE,
+			stride,
+			(const GLvoid*)(offset + (GLintptr)offsetof(struct jeVertex, z)));
+		glVertexAttribPointer(
+			JE_WINDOW_ATTRIB_COL,
+			4,
+			GL_FLOAT,
+			GL_FALSE,
+			stride,
+			(const GLvoid*)(offset + (GLintptr)offsetof(struct jeVertex, r)));
+		glVertexAttribPointer(
+			JE_WINDOW_ATTRIB_UV,
+			2,
+			GL_FLOAT,
+			GL_FALSE,
+			stride,
+			(const GLvoid*)(offset + (GLintptr)offsetof(struct jeVertex, u)));
 	}
 }
+void jeWindow_bindInstanceAttributes(GLintptr offset) {
+	JE_TRACE("offset=%ld", (long)offset);
+
+	static const GLsizei stride = (GLsizei)sizeof(struct jeInstance);
+
+	glVertexAttribPointer(
+		JE_WINDOW_INSTANCE_ATTRIB_RECT,
+		4,
+		GL_FLOAT,
+		GL_FALSE,
+		stride,
+		(const GLvoid*)(offset + (GLintptr)offsetof(struct jeInstance, x0)));
+	glVertexAttribPointer(
+		JE_WINDOW_INSTANCE_ATTRIB_DEPTH,
+		1,
+		GL_FLOAT,
+		GL_FALSE,
+		stride,
+		(const GLvoid*)(offset + (GLintptr)offsetof(struct jeInstance, z)));
+	glVertexAttribPointer(
+		JE_WINDOW_INSTANCE_ATTRIB_UV_RECT,
+		4,
+		GL_UNSIGNED_SHORT,
+		GL_FALSE,
+		stride,
+		(const GLvoid*)(offset + (GLintptr)offsetof(struct jeInstance, u0)));
+	glVertexAttribPointer(
+		JE_WINDOW_INSTANCE_ATTRIB_COL,
+		4,
+		GL_UNSIGNED_BYTE,
+		GL_TRUE,
+		stride,
+		(const GLvoid*)(offset + (GLintptr)offsetof(struct jeInstance, r)));
+}
+void jeWindow_drawInstances(uint32_t instanceCount) {
+	JE_TRACE("instanceCount=%u", instanceCount);
+
+	if (GLEW_VERSION_3_1) {
+		glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)instanceCount);
+	} else {
+		glDrawArraysInstancedARB(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)instanceCount);
+	}
+}
+void jeWindow_destroyStreamFences(struct jeWindow* window) {
+	JE_TRACE("window=%p", (void*)window);
+
+	for (uint32_t i = 0; i < JE_WINDOW_STREAM_SEGMENT_COUNT; i++) {
+		if (window->streamFences[i] != NULL) {
+			glDeleteSync(window->streamFences[i]);
+			window->streamFences[i] = NULL;
+		}
+	}
+}
+bool jeWindow_ensureQuadIndices(struct jeWindow* window, uint32_t quadCount) {
+	JE_TRACE("window=%p, quadCount=%u, iboQuadCapacity=%u", (void*)window, quadCount, window->iboQuadCapacity);
+
+	bool ok = true;
+
+	if (quadCount > window->iboQuadCapacity) {
+		uint32_t quadCapacity = window->iboQuadCapacity;
+		if (quadCapacity == 0) {
+			quadCapacity = JE_WINDOW_INDEX_START_QUAD_CAPACITY;
+		}
+		while (quadCapacity < quadCount) {
+			quadCapacity *= 2;
+		}
+
+		JE_DEBUG("growing index buffer, quadCapacity=%u", quadCapacity);
+
+		struct jeArray indices;
+		ok = ok && jeArray_create(&indices, sizeof(uint32_t));
+		ok = ok && jeArray_setCount(&indices, quadCapacity * JE_PRIMITIVE_TYPE_QUADS_INDEX_COUNT);
+
+		if (ok) {
+			jeVertex_createQuadIndices((uint32_t*)indices.data, quadCapacity);
+
+			/*The element array binding is part of the vao's state*/
+			glBindVertexArray(window->vao);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, window->ibo);
+			glBufferData(
+				GL_ELEMENT_ARRAY_BUFFER,
+				(GLsizeiptr)indices.count * (GLsizeiptr)indices.stride,
+				(const GLvoid*)indices.data,
+				GL_STATIC_DRAW);
+
+			window->iboQuadCapacity = quadCapacity;
+		}
+
+		jeArray_destroy(&indices);
+	}
+
+	return ok;
+}
+void* jeWindow_mapStream(struct jeWindow* window, GLsizeiptr size, GLintptr* outOffset) {
+	JE_TRACE("window=%p, size=%ld", (void*)window, (long)size);
+
+	void* mapped = NULL;
+	*outOffset = 0;
+
+	glBindBuffer(GL_ARRAY_BUFFER, window->vbo);
+
+	GLsizeiptr segmentSize = window->streamSegmentSize;
+	if (size > segmentSize) {
+		if (segmentSize == 0) {
+			segmentSize = JE_WINDOW_STREAM_SEGMENT_START_SIZE;
+		}
+		while (segmentSize < size) {
+			segmentSize *= 2;
+		}
+
+		JE_DEBUG("growing stream buffer, segmentSize=%ld", (long)segmentSize);
+
+		/*Reallocating orphans the old storage, so segments still in use by the GPU no longer need fencing*/
+		jeWindow_destroyStreamFences(window);
+		window->streamSegmentSize = segmentSize;
+		window->streamSegment = 0;
+
+		GLsizeiptr bufferSize = segmentSize;
+		if (window->streamUnsynchronized) {
+			bufferSize *= JE_WINDOW_STREAM_SEGMENT_COUNT;
+		}
+		glBufferData(GL_ARRAY_BUFFER, bufferSize, NULL, GL_STREAM_DRAW);
+	} else if (window->streamUnsynchronized) {
+		window->streamSegment = (window->streamSegment + 1) % JE_WINDOW_STREAM_SEGMENT_COUNT;
+	} else {
+		glBufferData(GL_ARRAY_BUFFER, segmentSize, NULL, GL_STREAM_DRAW);
+	}
+
+	if (window->streamUnsynchronized) {
+		GLsync fence = window->streamFences[window->streamSegment];
+		if (fence != NULL) {
+			/*Only blocks when the GPU is a full ring of frames behind*/
+			GLenum waitResult = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, JE_WINDOW_STREAM_FENCE_TIMEOUT_NS);
+			if ((waitResult == GL_TIMEOUT_EXPIRED) || (waitResult == GL_WAIT_FAILED)) {
+				JE_WARN("glClientWaitSync() failed, waitResult=%u", waitResult);
+			}
+
+			glDeleteSync(fence);
+			window->streamFences[window->streamSegment] = NULL;
+		}
+
+		*outOffset = (GLintptr)window->streamSegment * segmentSize;
+		mapped = glMapBufferRange(
+			GL_ARRAY_BUFFER,
+			*outOffset,
+			size,
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	} else {
+		mapped = glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
+	}
+
+	return mapped;
+}
+void jeWindow_uploadTexture(struct jeWindowTexture* texture) {
+	JE_TRACE("texture=%p, width=%u, height=%u", (void*)texture, texture->image.width, texture->image.height);
+
+	glGenTextures(1, &texture->texture);
+	glBindTexture(GL_TEXTURE_2D, texture->texture);
+	glTexImage2D(
+		GL_TEXTURE_2D,
+		0,
+		GL_RGBA,
+		(GLsizei)texture->image.width,
+		(GLsizei)texture->image.height,
+		0,
+		GL_RGBA,
+		GL_UNSIGNED_BYTE,
+		texture->image.buffer.data);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+}
+void jeWindow_classifyTexture(struct jeWindow* window, uint32_t textureId) {
+	bool binaryAlpha = jeImage_getBinaryAlpha(&window->textures[textureId].image);
+	JE_DEBUG("textureId=%u, binaryAlpha=%u", textureId, (uint32_t)binaryAlpha);
+
+	jeVertexBuffer_setTextureBinaryAlpha(&window->vertexBuffer, textureId, binaryAlpha);
+	for (uint32_t i = 0; i < JE_WINDOW_LAYER_COUNT; i++) {
+		jeVertexBuffer_setTextureBinaryAlpha(&window->layers[i].vertexBuffer, textureId, binaryAlpha);
+	}
+}
+void jeWindow_bindRangeState(struct jeWindow* window, GLuint program, uint32_t textureId) {
+	bool programChanged = (program != window->boundProgram);
+	bool textureChanged = (textureId != window->boundTextureId);
+
+	if (programChanged) {
+		glUseProgram(program);
+		window->boundProgram = program;
+	}
+
+	if (textureChanged) {
+		glBindTexture(GL_TEXTURE_2D, window->textures[textureId].texture);
+		window->boundTextureId = textureId;
+		window->frameStats.textureBindCount++;
+	}
+
+	/*Each program keeps its own uniforms, so the uv scale is only stale if the program or texture changed*/
+	if (programChanged || textureChanged) {
+		const struct jeImage* image = &window->textures[textureId].image;
+
+		/*Converts image coords to normalized texture coords (0.0 to 1.0)*/
+		GLfloat scaleU = 1.0F / (float)(image->width ? image->width : 1);
+		GLfloat scaleV = 1.0F / (float)(image->height ? image->height : 1);
+
+		GLint scaleUvLocation = window->scaleUvLocation;
+		if (program == window->instanceProgram) {
+			scaleUvLocation = window->instanceScaleUvLocation;
+		}
+		glUniform2f(scaleUvLocation, scaleU, scaleV);
+	}
+}
+bool jeWindow_uploadLayer(struct jeWindow* window, struct jeWindowLayer* layer) {
+	JE_TRACE("window=%p, layer=%p", (void*)window, (void*)layer);
+
+	bool ok = true;
+
+	struct jeVertexBuffer* vertexBuffer = &layer->vertexBuffer;
+
+	/*Sorted in place, so the draw ranges stay valid until the layer is next rebuilt*/
+	ok = ok && jeVertexBuffer_sort(vertexBuffer, JE_PRIMITIVE_TYPE_QUADS);
+
+	if (ok) {
+		GLsizeiptr vertexSize = (GLsizeiptr)vertexBuffer->vertices.count * (GLsizeiptr)vertexBuffer->vertices.stride;
+		GLsizeiptr instanceSize =
+			(GLsizeiptr)vertexBuffer->instances.count * (GLsizeiptr)vertexBuffer->instances.stride;
+
+		if (layer->vbo == 0) {
+			glGenBuffers(1, &layer->vbo);
+		}
+
+		glBindBuffer(GL_ARRAY_BUFFER, layer->vbo);
+		glBufferData(GL_ARRAY_BUFFER, vertexSize + instanceSize, NULL, GL_STATIC_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, vertexSize, (const GLvoid*)vertexBuffer->vertices.data);
+		glBufferSubData(GL_ARRAY_BUFFER, vertexSize, instanceSize, (const GLvoid*)vertexBuffer->instances.data);
+
+		layer->uploaded = true;
+		window->frameStats.layerUploadBytes += (uint32_t)(vertexSize + instanceSize);
+	}
+
+	return ok;
+}
+void jeWindow_drawRanges(
+	struct jeWindow* window,
+	const struct jeVertexBuffer* vertexBuffer,
+	GLuint vbo,
+	GLintptr vertexOffset,
+	GLintptr instanceOffset,
+	GLfloat offsetX,
+	GLfloat offsetY) {
+	JE_TRACE("window=%p, vertexBuffer=%p, vbo=%u", (void*)window, (void*)vertexBuffer, vbo);
+
+	/*Attribute pointers capture the bound array buffer, so it must be bound before they are rebound below*/
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+
+	/* Opaque ranges are drawn first and without blending; the depth test alone orders them.  The sort only leaves
+	 * primitives opaque where that matches submission order, see jeVertexBuffer_sortImpl()*/
+	const struct jeDrawRange* drawRanges = (const struct jeDrawRange*)vertexBuffer->drawRanges.data;
+	for (uint32_t pass = 0; pass < 2; pass++) {
+		bool opaque = (pass == 0);
+		if (opaque) {
+			glDisable(GL_BLEND);
+		} else {
+			glEnable(GL_BLEND);
+		}
+
+		GLfloat minAlpha = opaque ? JE_WINDOW_OPAQUE_MIN_ALPHA : 0.0F;
+
+		for (uint32_t i = 0; i < vertexBuffer->drawRanges.count; i++) {
+			const struct jeDrawRange* drawRange = &drawRanges[i];
+			if (drawRange->opaque != opaque) {
+				continue;
+			}
+
+			window->frameStats.batchCount++;
+
+			if (drawRange->instanced) {
+				jeWindow_bindRangeState(window, window->instanceProgram, drawRange->textureId);
+				glUniform1f(window->instanceMinAlphaLocation, minAlpha);
+				glUniform2f(window->instanceOffsetLocation, offsetX, offsetY);
+				glBindVertexArray(window->instanceVao);
+				jeWindow_bindInstanceAttributes(
+					instanceOffset + ((GLintptr)drawRange->start * (GLintptr)sizeof(struct jeInstance)));
+				jeWindow_drawInstances(drawRange->count);
+			} else {
+				jeWindow_bindRangeState(window, window->program, drawRange->textureId);
+				glUniform1f(window->minAlphaLocation, minAlpha);
+				glUniform2f(window->offsetLocation, offsetX, offsetY);
+				glBindVertexArray(window->vao);
+				jeWindow_bindVertexAttributes(vertexBuffer->vertexFormat, vertexOffset);
+				uint32_t startIndex =
+					(drawRange->start / JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT) * JE_PRIMITIVE_TYPE_QUADS_INDEX_COUNT;
+				uint32_t indexCount =
+					(drawRange->count / JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT) * JE_PRIMITIVE_TYPE_QUADS_INDEX_COUNT;
+				glDrawElements(
+					GL_TRIANGLES,
+					(GLsizei)indexCount,
+					GL_UNSIGNED_INT,
+					(const GLvoid*)((GLintptr)startIndex * (GLintptr)sizeof(uint32_t)));
+			}
+		}
+	}
+}
+struct jeWindowFrameStats jeWindow_getFrameStats(const struct jeWindow* window) {
+	struct jeWindowFrameStats frameStats;
+	memset((void*)&frameStats, 0, sizeof(frameStats));
+
+	if (window == NULL) {
+		JE_ERROR("window=NULL");
+	}
+
+	if (window != NULL) {
+		frameStats = window->frameStats;
+	}
+
+	return frameStats;
+}
 bool jeWindow_flushPrimitives(struct jeWindow* window) {
 	bool ok = true;
 
@@ -470,42 +1295,143 @@ bool jeWindow_flushPrimitives(struct jeWindow* window) {
 	}
 
 	uint32_t vertexCount = 0;
+	uint32_t instanceCount = 0;
+	GLsizeiptr vertexSize = 0;
+	GLsizeiptr uploadSize = 0;
 	if (ok) {
 		vertexCount = window->vertexBuffer.vertices.count;
+		instanceCount = window->vertexBuffer.instances.count;
 
-		ok = jeVertexBuffer_sort(&window->vertexBuffer, JE_PRIMITIVE_TYPE_TRIANGLES);
+		/*Instances are uploaded to the same segment, straight after the vertices*/
+		vertexSize = (GLsizeiptr)vertexCount * (GLsizeiptr)window->vertexBuffer.vertices.stride;
+		uploadSize = vertexSize + ((GLsizeiptr)instanceCount * (GLsizeiptr)window->vertexBuffer.instances.stride);
 	}
 
-	const GLvoid* vertexData = NULL;
-	if (ok) {
-		glUseProgram(window->program);
-		glBindVertexArray(window->vao);
+	JE_TRACE("window=%p, vertexCount=%u, instanceCount=%u", (void*)window, vertexCount, instanceCount);
 
-		vertexData = (const GLvoid*)window->vertexBuffer.vertices.data;
-		if (vertexData == NULL) {
-			JE_ERROR("vertexData=NULL");
+	if (ok) {
+		if (SDL_GL_MakeCurrent(window->window, window->context) != 0) {
+			JE_ERROR("SDL_GL_MakeCurrent() failed with error=%s", SDL_GetError());
 			ok = false;
 		}
 	}
 
-	JE_TRACE("window=%p, vertexCount=%u, vertexData=%p", (void*)window, vertexCount, (void*)vertexData);
+	Uint64 uploadStartTime = SDL_GetPerformanceCounter();
+	GLintptr uploadOffset = 0;
+	bool uploaded = false;
+	if (ok && (uploadSize > 0)) {
+		/*Sorting gathers the staged vertices straight into the mapped buffer, so they are copied exactly once*/
+		char* mapped = (char*)jeWindow_mapStream(window, uploadSize, &uploadOffset);
+		if (mapped != NULL) {
+			ok = jeVertexBuffer_sortInto(
+				&window->vertexBuffer, JE_PRIMITIVE_TYPE_QUADS, (void*)mapped, (void*)(mapped + vertexSize));
+			uploaded = true;
+
+			if (glUnmapBuffer(GL_ARRAY_BUFFER) == GL_FALSE) {
+				JE_WARN("glUnmapBuffer() failed, buffer contents were lost and the frame is skipped");
+				uploaded = false;
+			}
+		} else {
+			JE_DEBUG("mapping stream buffer failed, uploading a sorted copy instead");
+
+			ok = jeVertexBuffer_sort(&window->vertexBuffer, JE_PRIMITIVE_TYPE_QUADS);
+			if (ok) {
+				glBufferSubData(
+					GL_ARRAY_BUFFER, uploadOffset, vertexSize, (const GLvoid*)window->vertexBuffer.vertices.data);
+				glBufferSubData(
+					GL_ARRAY_BUFFER,
+					uploadOffset + vertexSize,
+					uploadSize - vertexSize,
+					(const GLvoid*)window->vertexBuffer.instances.data);
+				uploaded = true;
+			}
+		}
+	}
+	Uint64 uploadEndTime = SDL_GetPerformanceCounter();
 
 	if (ok) {
-		if (SDL_GL_MakeCurrent(window->window, window->context) != 0) {
-			JE_ERROR("SDL_GL_MakeCurrent() failed with error=%s", SDL_GetError());
-			ok = false;
+		window->frameStats.vertexCount = vertexCount;
+		window->frameStats.instanceCount = instanceCount;
+		window->frameStats.sortedPrimitiveCount = window->vertexBuffer.sortedPrimitiveCount;
+		window->frameStats.uploadBytes = (uint32_t)uploadSize;
+		window->frameStats.uploadMicroseconds =
+			(uint32_t)(((uploadEndTime - uploadStartTime) * 1000000) / SDL_GetPerformanceFrequency());
+		window->frameStats.layerCount = 0;
+		window->frameStats.layerUploadBytes = 0;
+		window->frameStats.batchCount = 0;
+		window->frameStats.textureBindCount = 0;
+		window->frameStats.culledCount = window->pushCulledCount;
+		window->frameStats.submittedCount = window->pushSubmittedCount;
+
+		window->boundProgram = 0;
+		window->boundTextureId = JE_WINDOW_TEXTURE_ID_UNBOUND;
+	}
+
+	uint32_t quadCount = 0;
+	if (ok && uploaded) {
+		quadCount = vertexCount / JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT;
+	}
+
+	for (uint32_t i = 0; ok && (i < JE_WINDOW_LAYER_COUNT); i++) {
+		struct jeWindowLayer* layer = &window->layers[i];
+		if (layer->drawQueued) {
+			if (!layer->uploaded) {
+				ok = jeWindow_uploadLayer(window, layer);
+			}
+
+			uint32_t layerQuadCount = layer->vertexBuffer.vertices.count / JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT;
+			if (layerQuadCount > quadCount) {
+				quadCount = layerQuadCount;
+			}
+
+			window->frameStats.layerCount++;
 		}
 	}
 
 	if (ok) {
-		glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(vertexCount * sizeof(struct jeVertex)), vertexData, GL_DYNAMIC_DRAW);
-		glDrawArrays(GL_TRIANGLES, 0, (GLsizei)vertexCount);
+		ok = jeWindow_ensureQuadIndices(window, quadCount);
+	}
+
+	if (ok) {
+		/* Layers only hold opaque primitives, and are drawn before the frame, so ties across buffers go to the frame.
+		 * Their translucent primitives were pushed to the frame by jeWindow_drawLayer(), so blend over both*/
+		for (uint32_t i = 0; i < JE_WINDOW_LAYER_COUNT; i++) {
+			const struct jeWindowLayer* layer = &window->layers[i];
+			if (layer->drawQueued && layer->uploaded) {
+				jeWindow_drawRanges(
+					window,
+					&layer->vertexBuffer,
+					layer->vbo,
+					/*vertexOffset*/ 0,
+					/*instanceOffset*/
+					(GLintptr)layer->vertexBuffer.vertices.count * (GLintptr)layer->vertexBuffer.vertices.stride,
+					layer->offsetX,
+					layer->offsetY);
+			}
+		}
+
+		if (uploaded) {
+			jeWindow_drawRanges(
+				window,
+				&window->vertexBuffer,
+				window->vbo,
+				uploadOffset,
+				uploadOffset + vertexSize,
+				/*offsetX*/ 0.0F,
+				/*offsetY*/ 0.0F);
+		}
+
+		if (uploaded && window->streamUnsynchronized) {
+			window->streamFences[window->streamSegment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		}
 
 		glBindVertexArray(0);
 		glUseProgram(0);
 
 		jeGl_getOk(JE_LOG_CONTEXT);
+	}
 
+	if (ok) {
 		jeWindow_resetPrimitives(window);
 	}
 
@@ -519,17 +1445,59 @@ void jeWindow_destroyGL(struct jeWindow* window) {
 	JE_DEBUG("window=%p, hasGLContext=%u", (void*)window, (uint32_t)hasGLContext);
 
 	if (hasGLContext) {
+		jeWindow_destroyStreamFences(window);
+		window->streamSegmentSize = 0;
+		window->streamSegment = 0;
+
+		if (window->instanceVao != 0) {
+			JE_TRACE("deleting instanceVao, instanceVao=%u", window->instanceVao);
+
+			glBindVertexArray(window->instanceVao);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			glDeleteVertexArrays(1, &window->instanceVao);
+			window->instanceVao = 0;
+		}
+
 		if (window->vao != 0) {
 			JE_TRACE("deleting vao, vao=%u", window->vao);
 
 			glBindVertexArray(window->vao);
 			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 			glDeleteVertexArrays(1, &window->vao);
 			window->vao = 0;
 		}
 
 		glBindVertexArray(0);
 
+		if (window->ibo != 0) {
+			JE_TRACE("deleting ibo, ibo=%u", window->ibo);
+
+			glDeleteBuffers(1, &window->ibo);
+			window->ibo = 0;
+		}
+		window->iboQuadCapacity = 0;
+
+		for (uint32_t i = 0; i < JE_WINDOW_LAYER_COUNT; i++) {
+			struct jeWindowLayer* layer = &window->layers[i];
+			if (layer->vbo != 0) {
+				JE_TRACE("deleting layer vbo, layerId=%u, vbo=%u", i, layer->vbo);
+
+				glDeleteBuffers(1, &layer->vbo);
+				layer->vbo = 0;
+			}
+
+			/*Layers keep their primitives, and are uploaded again once the context is recreated*/
+			layer->uploaded = false;
+		}
+
+		if (window->quadVbo != 0) {
+			JE_TRACE("deleting quadVbo, quadVbo=%u", window->quadVbo);
+
+			glDeleteBuffers(1, &window->quadVbo);
+			window->quadVbo = 0;
+		}
+
 		if (window->vbo != 0) {
 			JE_TRACE("deleting vbo, vbo=%u", window->vbo);
 
@@ -537,11 +1505,33 @@ void jeWindow_destroyGL(struct jeWindow* window) {
 			window->vbo = 0;
 		}
 
-		if (window->texture != 0) {
-			JE_TRACE("deleting texture, texture=%u", window->texture);
+		for (uint32_t i = 0; i < window->textureCount; i++) {
+			struct jeWindowTexture* texture = &window->textures[i];
+			if (texture->texture != 0) {
+				JE_TRACE("deleting texture, textureId=%u, texture=%u", i, texture->texture);
+
+				glDeleteTextures(1, &texture->texture);
+				texture->texture = 0;
+			}
+		}
 
-			glDeleteTextures(1, &window->texture);
-			window->texture = 0;
+		if (window->instanceProgram != 0) {
+			JE_TRACE(
+				"deleting instanceProgram, instanceProgram=%u, instanceVertShader=%u",
+				window->instanceProgram,
+				window->instanceVertShader);
+
+			glDetachShader(window->instanceProgram, window->fragShader);
+			glDetachShader(window->instanceProgram, window->instanceVertShader);
+			glDeleteProgram(window->instanceProgram);
+			glDeleteShader(window->instanceVertShader);
+			window->instanceProgram = 0;
+			window->instanceVertShader = 0;
+		}
+		window->instancing = false;
+		jeVertexBuffer_setInstancing(&window->vertexBuffer, false);
+		for (uint32_t i = 0; i < JE_WINDOW_LAYER_COUNT; i++) {
+			jeVertexBuffer_setInstancing(&window->layers[i].vertexBuffer, false);
 		}
 
 		if (window->program != 0) {
@@ -669,9 +1659,10 @@ bool jeWindow_initGL(struct jeWindow* window) {
 		glAttachShader(window->program, window->vertShader);
 		glAttachShader(window->program, window->fragShader);
 
-		glBindAttribLocation(window->program, 0, "srcPos");
-		glBindAttribLocation(window->program, 1, "srcCol");
-		glBindAttribLocation(window->program, 2, "srcUv");
+		glBindAttribLocation(window->program, JE_WINDOW_ATTRIB_POS, "srcPos");
+		glBindAttribLocation(window->program, JE_WINDOW_ATTRIB_COL, "srcCol");
+		glBindAttribLocation(window->program, JE_WINDOW_ATTRIB_UV, "srcUv");
+		glBindAttribLocation(window->program, JE_WINDOW_ATTRIB_DEPTH, "srcDepth");
 
 		glLinkProgram(window->program);
 		glUseProgram(window->program);
@@ -687,28 +1678,64 @@ bool jeWindow_initGL(struct jeWindow* window) {
 	}
 
 	if (ok) {
-		glGenTextures(1, &window->texture);
-		glBindTexture(GL_TEXTURE_2D, window->texture);
-		glTexImage2D(
-			GL_TEXTURE_2D,
-			0,
-			GL_RGBA,
-			(GLsizei)window->image.width,
-			(GLsizei)window->image.height,
-			0,
-			GL_RGBA,
-			GL_UNSIGNED_BYTE,
-			window->image.buffer.data);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		window->instancing =
+			(JE_WINDOW_INSTANCING != 0) &&
+			((GLEW_VERSION_3_3 != 0) ||
+			 ((GLEW_ARB_instanced_arrays != 0) && ((GLEW_VERSION_3_1 != 0) || (GLEW_ARB_draw_instanced != 0))));
+		JE_DEBUG("instancing=%u", (uint32_t)window->instancing);
+	}
+
+	if (ok && window->instancing) {
+		window->instanceVertShader = glCreateShader(GL_VERTEX_SHADER);
+		glShaderSource(
+			window->instanceVertShader, 1, &jeWindow_instanceVertShaderPtr, &jeWindow_instanceVertShaderSize);
+		glCompileShader(window->instanceVertShader);
+
+		window->instanceProgram = glCreateProgram();
+		glAttachShader(window->instanceProgram, window->instanceVertShader);
+		glAttachShader(window->instanceProgram, window->fragShader);
+
+		glBindAttribLocation(window->instanceProgram, JE_WINDOW_INSTANCE_ATTRIB_CORNER, "srcCorner");
+		glBindAttribLocation(window->instanceProgram, JE_WINDOW_INSTANCE_ATTRIB_RECT, "srcRect");
+		glBindAttribLocation(window->instanceProgram, JE_WINDOW_INSTANCE_ATTRIB_UV_RECT, "srcUvRect");
+		glBindAttribLocation(window->instanceProgram, JE_WINDOW_INSTANCE_ATTRIB_COL, "srcCol");
+		glBindAttribLocation(window->instanceProgram, JE_WINDOW_INSTANCE_ATTRIB_DEPTH, "srcDepth");
+
+		glLinkProgram(window->instanceProgram);
+
+		if (jeGl_getOk(JE_LOG_CONTEXT) == false) {
+			JE_ERROR("jeGl_getOk() error");
+			ok = false;
+		}
+		if (jeGl_getShaderOk(window->instanceVertShader, JE_LOG_CONTEXT) == false) {
+			JE_ERROR("jeGl_getShaderOk() error");
+			ok = false;
+		}
+		if (jeGl_getProgramOk(window->instanceProgram, JE_LOG_CONTEXT) == false) {
+			JE_ERROR("jeGl_getProgramOk() error");
+			ok = false;
+		}
+	}
+
+	if (ok) {
+		for (uint32_t i = 0; i < window->textureCount; i++) {
+			jeWindow_uploadTexture(&window->textures[i]);
+		}
 
 		glGenBuffers(1, &window->vbo);
 
+		window->streamUnsynchronized =
+			((GLEW_VERSION_3_2 != 0) || ((GLEW_ARB_map_buffer_range != 0) && (GLEW_ARB_sync != 0)));
+		JE_DEBUG("streamUnsynchronized=%u", (uint32_t)window->streamUnsynchronized);
+
 		glGenVertexArrays(1, &window->vao);
 
 		glBindVertexArray(window->vao);
 		glBindBuffer(GL_ARRAY_BUFFER, window->vbo);
 
+		glGenBuffers(1, &window->ibo);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, window->ibo);
+
 		if (jeGl_getOk(JE_LOG_CONTEXT) == false) {
 			JE_ERROR("jeGl_getOk() failed");
 			ok = false;
@@ -717,7 +1744,6 @@ bool jeWindow_initGL(struct jeWindow* window) {
 
 	if (ok) {
 		GLfloat scaleXyz[3];
-		GLfloat scaleUv[2];
 
 		/*Transforms pos from world coords (+/- windowSize) to normalized device coords (-1.0 to 1.0)*/
 		scaleXyz[0] = 2.0F / JE_WINDOW_MIN_WIDTH;
@@ -726,15 +1752,31 @@ bool jeWindow_initGL(struct jeWindow* window) {
 		/*Normalize z to between -1.0 and 1.0.  Supports depths +/- 2^20.  Near the precise uint32_t limit for float32*/
 		scaleXyz[2] = 1.0F / (float)(1 << 20);
 
-		/*Converts image coords to normalized texture coords (0.0 to 1.0)*/
-		scaleUv[0] = 1.0F / (float)(window->image.width ? window->image.width : 1);
-		scaleUv[1] = 1.0F / (float)(window->image.height ? window->image.height : 1);
-
 		GLint scaleXyzLocation = glGetUniformLocation(window->program, "scaleXyz");
-		GLint scaleUvLocation = glGetUniformLocation(window->program, "scaleUv");
-
 		glUniform3f(scaleXyzLocation, scaleXyz[0], scaleXyz[1], scaleXyz[2]);
-		glUniform2f(scaleUvLocation, scaleUv[0], scaleUv[1]);
+
+		/*Depends on the bound texture, so it is set as textures are bound; see jeWindow_bindRangeState()*/
+		window->scaleUvLocation = glGetUniformLocation(window->program, "scaleUv");
+
+		window->minAlphaLocation = glGetUniformLocation(window->program, "minAlpha");
+		glUniform1f(window->minAlphaLocation, 0.0F);
+
+		window->offsetLocation = glGetUniformLocation(window->program, "offset");
+		glUniform2f(window->offsetLocation, 0.0F, 0.0F);
+
+		if (window->instancing) {
+			glUseProgram(window->instanceProgram);
+			glUniform3f(
+				glGetUniformLocation(window->instanceProgram, "scaleXyz"), scaleXyz[0], scaleXyz[1], scaleXyz[2]);
+			window->instanceScaleUvLocation = glGetUniformLocation(window->instanceProgram, "scaleUv");
+
+			window->instanceMinAlphaLocation = glGetUniformLocation(window->instanceProgram, "minAlpha");
+			glUniform1f(window->instanceMinAlphaLocation, 0.0F);
+
+			window->instanceOffsetLocation = glGetUniformLocation(window->instanceProgram, "offset");
+			glUniform2f(window->instanceOffsetLocation, 0.0F, 0.0F);
+			glUseProgram(window->program);
+		}
 
 		if (jeGl_getOk(JE_LOG_CONTEXT) == false) {
 			JE_ERROR("jeGl_getOk() failed");
@@ -743,19 +1785,50 @@ bool jeWindow_initGL(struct jeWindow* window) {
 	}
 
 	if (ok) {
-		GLuint srcPosLocation = (GLuint)glGetAttribLocation(window->program, "srcPos");
-		GLuint srcColLocation = (GLuint)glGetAttribLocation(window->program, "srcCol");
-		GLuint srcUvLocation = (GLuint)glGetAttribLocation(window->program, "srcUv");
+		glEnableVertexAttribArray(JE_WINDOW_ATTRIB_POS);
+		glEnableVertexAttribArray(JE_WINDOW_ATTRIB_COL);
+		glEnableVertexAttribArray(JE_WINDOW_ATTRIB_UV);
+		glEnableVertexAttribArray(JE_WINDOW_ATTRIB_DEPTH);
 
-		glEnableVertexAttribArray(srcPosLocation);
-		glEnableVertexAttribArray(srcColLocation);
-		glEnableVertexAttribArray(srcUvLocation);
+		/*Pointers are rebound at the streamed segment's offset each frame; see jeWindow_flushPrimitives()*/
+		jeWindow_bindVertexAttributes(window->vertexBuffer.vertexFormat, 0);
 
-		glVertexAttribPointer(srcPosLocation, 4, GL_FLOAT, GL_FALSE, sizeof(struct jeVertex), (const GLvoid*)0);
-		glVertexAttribPointer(
-			srcColLocation, 4, GL_FLOAT, GL_FALSE, sizeof(struct jeVertex), (const GLvoid*)(4 * sizeof(GLfloat)));
-		glVertexAttribPointer(
-			srcUvLocation, 2, GL_FLOAT, GL_FALSE, sizeof(struct jeVertex), (const GLvoid*)(8 * sizeof(GLfloat)));
+		if (jeGl_getOk(JE_LOG_CONTEXT) == false) {
+			JE_ERROR("jeGl_getOk() error");
+			ok = false;
+		}
+	}
+
+	if (ok && window->instancing) {
+		glGenBuffers(1, &window->quadVbo);
+		glGenVertexArrays(1, &window->instanceVao);
+		glBindVertexArray(window->instanceVao);
+
+		glBindBuffer(GL_ARRAY_BUFFER, window->quadVbo);
+		glBufferData(
+			GL_ARRAY_BUFFER,
+			(GLsizeiptr)sizeof(jeWindow_quadCorners),
+			(const GLvoid*)jeWindow_quadCorners,
+			GL_STATIC_DRAW);
+		glEnableVertexAttribArray(JE_WINDOW_INSTANCE_ATTRIB_CORNER);
+		glVertexAttribPointer(JE_WINDOW_INSTANCE_ATTRIB_CORNER, 2, GL_FLOAT, GL_FALSE, 0, (const GLvoid*)0);
+
+		/*All other attributes advance once per instance, and are read from the stream buffer*/
+		static const GLuint instanceAttribs[] = {
+			JE_WINDOW_INSTANCE_ATTRIB_RECT,
+			JE_WINDOW_INSTANCE_ATTRIB_UV_RECT,
+			JE_WINDOW_INSTANCE_ATTRIB_COL,
+			JE_WINDOW_INSTANCE_ATTRIB_DEPTH};
+		glBindBuffer(GL_ARRAY_BUFFER, window->vbo);
+		for (uint32_t i = 0; i < (uint32_t)(sizeof(instanceAttribs) / sizeof(instanceAttribs[0])); i++) {
+			glEnableVertexAttribArray(instanceAttribs[i]);
+			if (GLEW_VERSION_3_3) {
+				glVertexAttribDivisor(instanceAttribs[i], 1);
+			} else {
+				glVertexAttribDivisorARB(instanceAttribs[i], 1);
+			}
+		}
+		jeWindow_bindInstanceAttributes(0);
 
 		if (jeGl_getOk(JE_LOG_CONTEXT) == false) {
 			JE_ERROR("jeGl_getOk() error");
@@ -763,6 +1836,13 @@ bool jeWindow_initGL(struct jeWindow* window) {
 		}
 	}
 
+	if (ok) {
+		jeVertexBuffer_setInstancing(&window->vertexBuffer, window->instancing);
+		for (uint32_t i = 0; i < JE_WINDOW_LAYER_COUNT; i++) {
+			jeVertexBuffer_setInstancing(&window->layers[i].vertexBuffer, window->instancing);
+		}
+	}
+
 	if (ok) {
 		glUseProgram(0);
 		glBindVertexArray(0);
@@ -979,8 +2059,15 @@ void jeWindow_destroy(struct jeWindow* window) {
 
 		jeController_destroy(&window->controller);
 
-		jeImage_destroy(&window->image);
+		for (uint32_t i = 0; i < window->textureCount; i++) {
+			jeImage_destroy(&window->textures[i].image);
+		}
+		window->textureCount = 0;
 
+		for (uint32_t i = 0; i < JE_WINDOW_LAYER_COUNT; i++) {
+			jeVertexBuffer_destroy(&window->layers[i].vertexBuffer);
+			jeArray_destroy(&window->layers[i].translucentPrimitives);
+		}
 		jeVertexBuffer_destroy(&window->vertexBuffer);
 
 		if (window->window != NULL) {
@@ -1043,7 +2130,10 @@ struct jeWindow* jeWindow_create(bool startVisible, const char* optSpritesFilena
 	if (ok) {
 		SDL_SetWindowMinimumSize(window->window, JE_WINDOW_MIN_WIDTH, JE_WINDOW_MIN_HEIGHT);
 
-		if ((optSpritesFilename == NULL) || !jeImage_createFromPNGFile(&window->image, optSpritesFilename)) {
+		struct jeImage* image = &window->textures[0].image;
+		window->textureCount = 1;
+
+		if ((optSpritesFilename == NULL) || !jeImage_createFromPNGFile(image, optSpritesFilename)) {
 			/*
 			 * As a fallback, create a gray texture big enough to allow mapping of color.
 			 * Gray is chosen to have it be visible against the white fill color.
@@ -1051,15 +2141,25 @@ struct jeWindow* jeWindow_create(bool startVisible, const char* optSpritesFilena
 			const struct jeColorRGBA32 grey = {0x80, 0x80, 0x80, 0xFF};
 			const struct jeColorRGBA32 white = {0xFF, 0xFF, 0xFF, 0xFF};
 
-			jeImage_destroy(&window->image);
-			jeImage_create(&window->image, 2048, 2048, grey);
+			jeImage_destroy(image);
+			jeImage_create(image, 2048, 2048, grey);
 
 			/*Topleft texel is used for rendering without texture and must be white*/
-			((struct jeColorRGBA32*)window->image.buffer.data)[0] = white;
+			((struct jeColorRGBA32*)image->buffer.data)[0] = white;
 		}
 	}
 
 	ok = ok && jeVertexBuffer_create(&window->vertexBuffer);
+	ok = ok && jeVertexBuffer_setFormat(&window->vertexBuffer, JE_WINDOW_VERTEX_FORMAT);
+	for (uint32_t i = 0; i < JE_WINDOW_LAYER_COUNT; i++) {
+		ok = ok && jeVertexBuffer_create(&window->layers[i].vertexBuffer);
+		ok = ok && jeVertexBuffer_setFormat(&window->layers[i].vertexBuffer, JE_WINDOW_VERTEX_FORMAT);
+		ok = ok && jeArray_create(&window->layers[i].translucentPrimitives, sizeof(struct jeWindowLayerPrimitive));
+	}
+
+	if (ok) {
+		jeWindow_classifyTexture(window, 0);
+	}
 
 	ok = ok && jeWindow_initGL(window);
 
@@ -1291,14 +2391,54 @@ void jeWindow_runTests() {
 	JE_ASSERT(jeWindow_initGL(window));
 
 	struct jeVertex triangleVertices[JE_PRIMITIVE_TYPE_TRIANGLES_VERTEX_COUNT];
+	memset((void*)triangleVertices, 0, sizeof(triangleVertices));
 	jeWindow_pushPrimitive(window, triangleVertices, JE_PRIMITIVE_TYPE_TRIANGLES);
 
+	struct jeVertex offscreenVertices[JE_PRIMITIVE_TYPE_TRIANGLES_VERTEX_COUNT];
+	memset((void*)offscreenVertices, 0, sizeof(offscreenVertices));
+	for (uint32_t i = 0; i < JE_PRIMITIVE_TYPE_TRIANGLES_VERTEX_COUNT; i++) {
+		offscreenVertices[i].x = (float)JE_WINDOW_MIN_WIDTH;
+	}
+	jeWindow_pushPrimitive(window, offscreenVertices, JE_PRIMITIVE_TYPE_TRIANGLES);
+
+	/*A translucent layer primitive over an opaque frame one must blend over it, so it is drawn with the frame*/
+	struct jeVertex opaqueVertices[JE_PRIMITIVE_TYPE_TRIANGLES_VERTEX_COUNT];
+	memset((void*)opaqueVertices, 0, sizeof(opaqueVertices));
+	struct jeVertex translucentVertices[JE_PRIMITIVE_TYPE_TRIANGLES_VERTEX_COUNT];
+	memset((void*)translucentVertices, 0, sizeof(translucentVertices));
+	for (uint32_t i = 0; i < JE_PRIMITIVE_TYPE_TRIANGLES_VERTEX_COUNT; i++) {
+		opaqueVertices[i].z = 1.0F;
+		opaqueVertices[i].a = 1.0F;
+		translucentVertices[i].a = 0.5F;
+		translucentVertices[i].z = -1.0F;
+	}
+	jeWindow_pushPrimitive(window, opaqueVertices, JE_PRIMITIVE_TYPE_TRIANGLES);
+
+	jeWindow_beginLayer(window, 0);
+	jeWindow_pushPrimitive(window, opaqueVertices, JE_PRIMITIVE_TYPE_TRIANGLES);
+	jeWindow_pushPrimitive(window, translucentVertices, JE_PRIMITIVE_TYPE_TRIANGLES);
+	jeWindow_endLayer(window);
+	JE_ASSERT(window->vertexBuffer.vertices.count == (2 * JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT));
+	JE_ASSERT(window->layers[0].vertexBuffer.vertices.count == JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT);
+	JE_ASSERT(window->layers[0].translucentPrimitives.count == 1);
+	jeWindow_drawLayer(window, 0, 1.0F, 1.0F);
+	JE_ASSERT(window->vertexBuffer.vertices.count == (3 * JE_PRIMITIVE_TYPE_QUADS_VERTEX_COUNT));
+	JE_ASSERT(window->layers[0].translucentPrimitives.count == 1);
+
 	/*Create a second window before displaying to ensure they do not clobber each other with opengl state*/
 	struct jeWindow* window2 = jeWindow_create(/*startVisible*/ false, /*optSpritesFilename*/ NULL);
 	JE_ASSERT(window2 != NULL);
 	jeWindow_destroy(window2);
 
 	JE_ASSERT(jeWindow_step(window));
+	JE_ASSERT(window->frameStats.layerCount == 1);
+	JE_ASSERT(window->frameStats.batchCount == 3);
+	JE_ASSERT(window->frameStats.textureBindCount == 1);
+	JE_ASSERT(window->frameStats.culledCount == 1);
+	JE_ASSERT(window->frameStats.submittedCount == 3);
+	JE_ASSERT(window->frameStats.sortedPrimitiveCount == 2);
+	JE_ASSERT(window->layers[0].uploaded);
+	JE_ASSERT(window->layers[0].drawQueued == false);
 
 	jeWindow_show(window);
 
@@ -25,9 +25,27 @@
 #define JE_WINDOW_MIN_WIDTH 160
 #define JE_WINDOW_MIN_HEIGHT 120
 
+/*Retained layers are identified by index, from 0 up to JE_WINDOW_LAYER_COUNT - 1*/
+#define JE_WINDOW_LAYER_COUNT 8
+
 struct jeVertex;
 struct jeWindow;
 
+/*Rendering statistics for the most recently drawn frame*/
+struct jeWindowFrameStats {
+	uint32_t vertexCount;
+	uint32_t instanceCount;
+	uint32_t sortedPrimitiveCount;
+	uint32_t uploadBytes;
+	uint32_t uploadMicroseconds;
+	uint32_t layerCount;
+	uint32_t layerUploadBytes;
+	uint32_t batchCount;
+	uint32_t textureBindCount;
+	uint32_t culledCount;
+	uint32_t submittedCount;
+};
+
 JE_API_PUBLIC void jeWindow_destroy(struct jeWindow* window);
 JE_API_PUBLIC struct jeWindow* jeWindow_create(bool startVisible, const char* optSpritesFilename);
 JE_API_PUBLIC void jeWindow_show(struct jeWindow* window);
@@ -35,9 +53,25 @@ JE_API_PUBLIC bool jeWindow_step(struct jeWindow* window);
 JE_API_PUBLIC void jeWindow_resetPrimitives(struct jeWindow* window);
 JE_API_PUBLIC void
 jeWindow_pushPrimitive(struct jeWindow* window, const struct jeVertex* vertices, uint32_t primitiveType);
+JE_API_PUBLIC void jeWindow_pushTexturedPrimitive(
+	struct jeWindow* window, const struct jeVertex* vertices, uint32_t primitiveType, uint32_t textureId);
+JE_API_PUBLIC void jeWindow_pushTexturedPrimitives(
+	struct jeWindow* window,
+	const struct jeVertex* vertices,
+	uint32_t primitiveCount,
+	uint32_t primitiveType,
+	uint32_t textureId,
+	float offsetX,
+	float offsetY);
+JE_API_PUBLIC bool jeWindow_loadTexture(struct jeWindow* window, const char* filename, uint32_t* outTextureId);
+JE_API_PUBLIC void jeWindow_beginLayer(struct jeWindow* window, uint32_t layerId);
+JE_API_PUBLIC void jeWindow_endLayer(struct jeWindow* window);
+JE_API_PUBLIC void jeWindow_drawLayer(struct jeWindow* window, uint32_t layerId, float offsetX, float offsetY);
+JE_API_PUBLIC bool jeWindow_setVertexFormat(struct jeWindow* window, uint32_t vertexFormat);
 JE_API_PUBLIC bool jeWindow_getIsOpen(const struct jeWindow* window);
 JE_API_PUBLIC uint32_t jeWindow_getFrame(const struct jeWindow* window);
 JE_API_PUBLIC uint32_t jeWindow_getFps(const struct jeWindow* window);
+JE_API_PUBLIC struct jeWindowFrameStats jeWindow_getFrameStats(const struct jeWindow* window);
 JE_API_PUBLIC bool jeWindow_getInput(const struct jeWindow* window, uint32_t inputId);
 JE_API_PUBLIC bool jeWindow_getMousePos(const struct jeWindow* window, int32_t *outX, int32_t* outY);
 JE_API_PUBLIC bool jeWindow_getMouseButton(const struct jeWindow* window, uint32_t button);
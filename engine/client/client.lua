@@ -1,5 +1,6 @@
 local log = require("engine/util/log")
 local util = require("engine/util/util")
+local SpatialHash = require("engine/util/spatial_hash")
 
 local headlessClientMetatable = {}
 function headlessClientMetatable.__index()
@@ -17,41 +18,363 @@ headlessClient.state = {
 	["logLevel"] = log.logLevel,
 	["testsEnabled"] = true,
 	["testsLogLevel"] = log.testsLogLevel,
-	["inputLeft"] = false,
-	["inputRight"] = false,
-	["inputUp"] = false,
-	["inputDown"] = false,
-	["inputA"] = false,
-	["inputB"] = false,
-	["inputX"] = false,
-	["inputY"] = false,
-	["inputMouseLeft"] = false,
-	["inputMouseMiddle"] = false,
-	["inputMouseRight"] = false,
+	["inputMask"] = 0,
+	["inputMouseMask"] = 0,
 	["breakpointCount"] = 0,
 	["inputMouseX"] = 0,
 	["inputMouseY"] = 0,
+	["frameVertexCount"] = 0,
+	["frameInstanceCount"] = 0,
+	["frameSortedPrimitiveCount"] = 0,
+	["frameUploadBytes"] = 0,
+	["frameUploadMicroseconds"] = 0,
+	["frameLayerCount"] = 0,
+	["frameLayerUploadBytes"] = 0,
+	["frameBatchCount"] = 0,
+	["frameTextureBindCount"] = 0,
+	["frameCulledCount"] = 0,
+	["frameSubmittedCount"] = 0,
 }
+function headlessClient.drawSprites(entities, sprites, _, excludeTag)
+	local missingCount = 0
+	for _, entity in ipairs(entities) do
+		if ((excludeTag == nil) or not entity.tags[excludeTag]) and (sprites[entity.spriteId] == nil) then
+			missingCount = missingCount + 1
+		end
+	end
+	return missingCount
+end
 function headlessClient.writeData(filename, dataStr)
 	return util.writeDataUncompressed(filename, dataStr)
 end
 function headlessClient.readData(filename)
 	return util.readDataUncompressed(filename)
 end
+function headlessClient.getDataExists(filename)
+	return util.getFileExists(filename)
+end
+-- the headless client has no zlib, so its "compressed" data is the data itself
+function headlessClient.compress(dataStr)
+	return dataStr
+end
+function headlessClient.decompress(dataStr)
+	return dataStr
+end
+function headlessClient.newSpatialHash(cellSize)
+	return SpatialHash.new(cellSize)
+end
+function headlessClient.writeDataAsync(filename, dataStr, callback, append)
+	local ok = util.writeDataUncompressed(filename, dataStr, append)
+	if callback ~= nil then
+		callback(ok, filename)
+	end
+	return ok
+end
 
 -- injected by the c client in main.c:jeGame_registerLuaClientBindings()
 local client = jeLuaClientBindings or headlessClient  -- luacheck: globals jeLuaClientBindings
 client.SYSTEM_NAME = "client"
+client.PRIMITIVE_TYPE_POINTS = 1
+client.PRIMITIVE_TYPE_LINES = 2
+client.PRIMITIVE_TYPE_SPRITES = 3
+client.PRIMITIVE_TYPE_TRIANGLES = 4
+client.primitiveVertexCounts = {1, 2, 2, 3}
+-- mirrors core/codec.h:JE_CODEC_HEADER; data starting with it is decoded with client.decode()
+client.ENCODED_HEADER = "JEB1"
+
+function client.getEncoded(dataStr)
+	return string.sub(dataStr, 1, #client.ENCODED_HEADER) == client.ENCODED_HEADER
+end
+
+-- the c client's json codec follows the same rules and output ordering as engine/lib/json/json.lua
+if client ~= headlessClient then
+	util.json = {
+		["encode"] = client.jsonEncode,
+		["decode"] = client.jsonDecode,
+	}
+	util.deepcopy = client.deepcopy
+end
+
+-- mirrors client.c:jeLua_getCameraOffset()
+function client.getCameraOffset(camera)
+	local x1 = camera.x or 0
+	local y1 = camera.y or 0
+	local x2 = camera.x2 or (x1 + (camera.w or 0))
+	local y2 = camera.y2 or (y1 + (camera.h or 0))
+	x1 = camera.x1 or x1
+	y1 = camera.y1 or y1
+
+	return -(x1 + math.floor((x2 - x1) / 2)), -(y1 + math.floor((y2 - y1) / 2))
+end
+
+-- vertex arrays are zero-indexed, with x, y, z, r, g, b, a, u and v fields per vertex.
+-- LuaJIT clients fill struct jeVertex arrays and hand them straight to the c client through its ffi api;
+-- otherwise (headless, or no ffi) each primitive is submitted through the table-based draw bindings
+local function newVertexTables(vertexCount)
+	local vertices = {}
+	for i = 0, vertexCount - 1 do
+		vertices[i] = {
+			["x"] = 0, ["y"] = 0, ["z"] = 0,
+			["r"] = 0, ["g"] = 0, ["b"] = 0, ["a"] = 0,
+			["u"] = 0, ["v"] = 0,
+		}
+	end
+	return vertices
+end
+local primitiveBindings = {"drawPoint", "drawLine", "drawSprite", "drawTriangle"}
+local bindingVertexFields = {
+	{"x1", "y1", "u1", "v1"},
+	{"x2", "y2", "u2", "v2"},
+	{"x3", "y3", "u3", "v3"},
+}
+-- reused for every primitive; the bindings only read the fields of the primitive type they draw.
+-- they also take depth and color per primitive, so these come from its first vertex
+local bindingRenderable = {}
+local bindingDefaults = {}
+local function drawPrimitivesWithBindings(vertices, primitiveCount, primitiveType, textureId, camera)
+	local draw = client[primitiveBindings[primitiveType]]
+	local vertexCount = client.primitiveVertexCounts[primitiveType]
+	if (draw == nil) or (vertexCount == nil) then
+		log.error("not a valid primitiveType, primitiveType=%s", primitiveType)
+		return
+	end
+
+	local renderable = bindingRenderable
+	local defaults = bindingDefaults
+	renderable.textureId = textureId or 0
+	for i = 0, primitiveCount - 1 do
+		local first = vertices[i * vertexCount]
+		renderable.z = first.z
+		renderable.r = first.r
+		renderable.g = first.g
+		renderable.b = first.b
+		renderable.a = first.a
+		for j = 1, vertexCount do
+			local vertex = vertices[(i * vertexCount) + j - 1]
+			local fields = bindingVertexFields[j]
+			renderable[fields[1]] = vertex.x
+			renderable[fields[2]] = vertex.y
+			defaults[fields[3]] = vertex.u
+			defaults[fields[4]] = vertex.v
+		end
+		draw(renderable, defaults, camera)
+	end
+end
+
+local ffi = (client ~= headlessClient) and (jit ~= nil) and require("ffi")  -- luacheck: globals jit
+if ffi then
+	ffi.cdef[[
+		struct jeVertex {
+			float x, y, z, w;
+			float r, g, b, a;
+			float u, v;
+		};
+		struct jeWindow;
+		struct jeLuaClientState {
+			uint32_t width;
+			uint32_t height;
+			uint32_t logLevel;
+			uint32_t testsLogLevel;
+			uint32_t fps;
+			uint32_t frame;
+			uint32_t inputMask;
+			uint32_t inputMouseMask;
+			int32_t inputMouseX;
+			int32_t inputMouseY;
+			uint32_t breakpointCount;
+			uint32_t frameVertexCount;
+			uint32_t frameInstanceCount;
+			uint32_t frameSortedPrimitiveCount;
+			uint32_t frameUploadBytes;
+			uint32_t frameUploadMicroseconds;
+			uint32_t frameLayerCount;
+			uint32_t frameLayerUploadBytes;
+			uint32_t frameBatchCount;
+			uint32_t frameTextureBindCount;
+			uint32_t frameCulledCount;
+			uint32_t frameSubmittedCount;
+			bool running;
+			bool headless;
+			bool testsEnabled;
+		};
+		struct jeLuaFfiApi {
+			struct jeWindow* window;
+			struct jeLuaClientState state;
+			void (*drawPrimitives)(
+				struct jeWindow* window,
+				const struct jeVertex* vertices,
+				uint32_t primitiveCount,
+				uint32_t primitiveType,
+				uint32_t textureId,
+				float offsetX,
+				float offsetY);
+		};
+	]]
+	local ffiApi = ffi.cast("struct jeLuaFfiApi*", client.ffiApi)
+
+	-- reads straight from the struct the c client updates each step; client.ffiApi keeps it alive
+	client.state = ffiApi.state
+
+	function client.newVertices(vertexCount)
+		return ffi.new("struct jeVertex[?]", vertexCount)
+	end
+	function client.drawPrimitives(vertices, primitiveCount, primitiveType, textureId, camera)
+		local offsetX, offsetY = client.getCameraOffset(camera)
+		ffiApi.drawPrimitives(ffiApi.window, vertices, primitiveCount, primitiveType, textureId or 0, offsetX, offsetY)
+	end
+else
+	client.newVertices = newVertexTables
+	client.drawPrimitives = drawPrimitivesWithBindings
+end
+
 function client.onRunTests()
 	headlessClient.writeData("clientTestFile", "")
 	log.assert(headlessClient.readData("clientTestFile") == "")
 	os.remove("clientTestFile")
 
+	-- writes to the same file that are still queued are coalesced; reads wait for queued writes to the file
+	local writeResults = {}
+	local function onWriteComplete(ok)
+		writeResults[#writeResults + 1] = ok
+	end
+	log.assert(client.writeDataAsync("clientTestFile", "first", onWriteComplete))
+	log.assert(client.getDataExists("clientTestFile"))
+	log.assert(client.writeDataAsync("clientTestFile", "second", onWriteComplete))
+	log.assert(client.readData("clientTestFile") == "second")
+	if client ~= headlessClient then
+		client.step()
+	end
+	log.assert((#writeResults == 2) and writeResults[1] and writeResults[2])
+
+	-- appends are never coalesced, and follow the writes queued before them
+	log.assert(client.writeDataAsync("clientTestFile", "first", nil, true))
+	log.assert(client.writeDataAsync("clientTestFile", "second", nil, true))
+	log.assert(client.writeDataAsync("clientTestFile", "third"))
+	log.assert(client.writeDataAsync("clientTestFile", "fourth", nil, true))
+	-- the c client null terminates full writes, but not appends
+	log.assert(string.gsub(client.readData("clientTestFile"), "%z", "") == "thirdfourth")
+	os.remove("clientTestFile")
+
+	local camera = {["x1"] = 0, ["y1"] = 0, ["x2"] = 160, ["y2"] = 120}
+	local offsetX, offsetY = client.getCameraOffset(camera)
+	log.assert((offsetX == -80) and (offsetY == -60))
+
+	local vertices = client.newVertices(2 * client.primitiveVertexCounts[client.PRIMITIVE_TYPE_SPRITES])
+	vertices[1].x = 8
+	vertices[1].y = 8
+	vertices[3].x = 8
+	vertices[3].y = 8
+	log.assert(vertices[0].x == 0)
+	client.drawPrimitives(vertices, 2, client.PRIMITIVE_TYPE_SPRITES, 0, camera)
+
+	-- the vertex array api submits the same primitives whether it takes the ffi or the table-based path
+	local drawnFrameStats = {}
+	for i, drawPath in ipairs({
+		{client.newVertices, client.drawPrimitives},
+		{newVertexTables, drawPrimitivesWithBindings},
+	}) do
+		client.step()
+		for primitiveType, vertexCount in ipairs(client.primitiveVertexCounts) do
+			local primitiveVertices = drawPath[1](3 * vertexCount)
+			for j = 0, (3 * vertexCount) - 1 do
+				local vertex = primitiveVertices[j]
+				local primitive = math.floor(j / vertexCount)
+				vertex.x = ((j % vertexCount) * 8) - (primitive * 60)
+				vertex.y = (j % 2) * 8
+				vertex.z = primitive % 2
+				vertex.r, vertex.g, vertex.b = 1, 1, 1
+				vertex.a = (primitive == 1) and 0.5 or 1
+			end
+			drawPath[2](primitiveVertices, 3, primitiveType, 0, camera)
+		end
+		client.step()
+
+		drawnFrameStats[i] = {
+			client.state.frameSubmittedCount,
+			client.state.frameCulledCount,
+			client.state.frameVertexCount,
+			client.state.frameInstanceCount,
+			client.state.frameSortedPrimitiveCount,
+			client.state.frameBatchCount,
+		}
+	end
+	log.assert(util.tableDeepEquals(drawnFrameStats[1], drawnFrameStats[2]))
+
 	local numTestSuites = 1
 	if client ~= headlessClient then
+		local encodable = {1, -2, 0.5, "a", true, ["b"] = {["a"] = "a", ["c"] = false}}
+		local encoded = client.encode(encodable)
+		log.assert(client.getEncoded(encoded))
+		log.assert(util.tableDeepEquals(client.decode(encoded), encodable))
+		log.assert(client.decode("{}") == nil)
+
+		local compressable = string.rep("compress", 64)
+		local compressed = client.compress(compressable)
+		log.assert(#compressed < #compressable)
+		log.assert(client.decompress(compressed) == compressable)
+		log.assert(client.decompress(client.compress("", 9)) == "")
+		log.assert(client.decompress(compressable) == nil)
+
+		local jsonStr = '{"a":[1,2.5,"b\\n\\u00e9",true,false,null],"c":{}}'
+		local jsonDecoded = client.jsonDecode(jsonStr)
+		log.assert(util.tableDeepEquals(jsonDecoded, util.luaJson.decode(jsonStr)))
+		log.assert(client.jsonEncode(jsonDecoded) == util.luaJson.encode(jsonDecoded))
+		log.assert(not pcall(client.jsonDecode, '{"a":1,}x'))
+
+		local copyable = {0.1 + 0.2, [3] = "a", ["b"] = {true}, [{}] = false}
+		copyable.b.cycle = copyable
+		local copied = client.deepcopy(copyable)
+		log.assert((copied ~= copyable) and (copied.b ~= copyable.b) and (copied.b.cycle == copied))
+		log.assert((copied[1] == copyable[1]) and (copied[3] == "a") and copied.b[1])
+		local shared = {1}
+		copied = client.deepcopy({shared, {shared}, [shared] = shared})
+		log.assert((copied[1] ~= shared) and (copied[2][1] == copied[1]) and (copied[copied[1]] == copied[1]))
+		log.assert(client.deepcopy(1) == 1)
+
+		-- the native spatial hash returns the same entities, in the same order, as the lua one
+		local spatialHashes = {client.newSpatialHash(16), SpatialHash.new(16)}
+		local spatialResults = {{}, {}}
+		local spatialResultCounts = {}
+		local sweepMoves = {{37, 0}, {-37, 0}, {0, 50}, {0, -50}, {0, 0}}
+		local sweepResults = {{}, {}}
+		local sweepSteps = {{}, {}}
+		local sweepResultCounts = {{}, {}}
+		for i, spatialHash in ipairs(spatialHashes) do
+			for entityId = 1, 64 do
+				spatialHash:insert(entityId, (entityId * 7) % 64, (entityId * 13) % 64, entityId % 20, 8)
+			end
+			for entityId = 1, 64, 3 do
+				spatialHash:move(entityId, (entityId * 5) % 64, -entityId, 12, entityId % 30)
+			end
+			for entityId = 2, 64, 5 do
+				spatialHash:remove(entityId)
+			end
+			spatialResultCounts[i] = spatialHash:query(-8, -40, 80, 100, spatialResults[i], 4)
+
+			for j, move in ipairs(sweepMoves) do
+				sweepResults[i][j] = {}
+				sweepSteps[i][j] = {}
+				sweepResultCounts[i][j] = spatialHash:sweep(
+					20.5, 10, 6, 9.5, move[1], move[2], sweepResults[i][j], sweepSteps[i][j], 4)
+			end
+		end
+		log.assert(spatialResultCounts[1] == spatialResultCounts[2])
+		log.assert(util.tableDeepEquals(spatialResults[1], spatialResults[2]))
+		log.assert(util.tableDeepEquals(sweepResultCounts[1], sweepResultCounts[2]))
+		log.assert(util.tableDeepEquals(sweepResults[1], sweepResults[2]))
+		log.assert(util.tableDeepEquals(sweepSteps[1], sweepSteps[2]))
+		log.assert(sweepResultCounts[1][5] == 0)
+
 		numTestSuites = client.runTests()
 	end
 	return numTestSuites
 end
+function client.onRunBenchmarks()
+	local numBenchmarkSuites = 0
+	if client ~= headlessClient then
+		numBenchmarkSuites = client.runBenchmarks()
+	end
+	return numBenchmarkSuites
+end
 
 return client
@@ -1,24 +1,25 @@
 local log = require("engine/util/log")
 local util = require("engine/util/util")
+local client = require("engine/client/client")
+local SpatialHash = require("engine/util/spatial_hash")
+local bit = require("bit")
 
-local FLOAT_EPSILON = 1.19e-07
-local utilRectCollides = util.rectCollides
-local mathFloor = math.floor
-local stringFormat = string.format
+local bitBand = bit.band
+local bitBor = bit.bor
+local bitBnot = bit.bnot
+local bitLshift = bit.lshift
+
+-- searched in place of the entities of tags that no entity has, rather than allocating a table per search
+local EMPTY_TAG_ENTITIES = {}
 
 local Entity = {}
 Entity.SYSTEM_NAME = "entity"
 Entity.ENTITY_CHUNK_SIZE = 64
+Entity.TAG_MASK_WORD_BITS = 32
 function Entity:setBounds(entity, x, y, w, h)
-	local oldEntityX = entity.x
-	local oldEntityY = entity.y
-
-	local oldEntityW = entity.w
-	local oldEntityH = entity.h
-
 	-- optimization: early return if bounds are unchanged, as this call is expensive
-	if ((oldEntityX == x) and (oldEntityY == y)
-		and (oldEntityW == w) and (oldEntityH == h)) then
+	if ((entity.x == x) and (entity.y == y)
+		and (entity.w == w) and (entity.h == h)) then
 		return
 	end
 
@@ -28,84 +29,8 @@ function Entity:setBounds(entity, x, y, w, h)
 		return
 	end
 
-	local entityChunkSize = self.ENTITY_CHUNK_SIZE
-	local oldChunkX1 = mathFloor(oldEntityX / entityChunkSize)
-	local oldChunkY1 = mathFloor(oldEntityY / entityChunkSize)
-	local oldChunkX2 = mathFloor((oldEntityX + oldEntityW - FLOAT_EPSILON) / entityChunkSize)
-	local oldChunkY2 = mathFloor((oldEntityY + oldEntityH - FLOAT_EPSILON) / entityChunkSize)
-	if oldEntityW <= 0 then
-		oldChunkX2 = oldChunkX1 - 1
-	end
-	if oldEntityH <= 0 then
-		oldChunkY2 = oldChunkY1 - 1
-	end
-
-	local chunkX1 = mathFloor(x / entityChunkSize)
-	local chunkY1 = mathFloor(y / entityChunkSize)
-	local chunkX2 = mathFloor((x + w - FLOAT_EPSILON) / entityChunkSize)
-	local chunkY2 = mathFloor((y + h - FLOAT_EPSILON) / entityChunkSize)
-	if w <= 0 then
-		chunkX2 = chunkX1 - 1
-	end
-	if h <= 0 then
-		chunkY2 = chunkY1 - 1
-	end
-
-	local world = self.simulation.state.world
-	local worldEntities = world.entities
-	local entityChunks = entity.chunks
-	local worldChunks = world.chunkEntities
-
-	-- remove entity from chunks outside new bounds
-	for oldChunkY = oldChunkY1, oldChunkY2 do
-		for oldChunkX = oldChunkX1, oldChunkX2 do
-			local outsideNewBounds = (
-				(oldChunkX < chunkX1)
-				or (oldChunkY < chunkY1)
-				or (oldChunkX > chunkX2)
-				or (oldChunkY > chunkY2)
-			)
-			if outsideNewBounds then
-				local chunkKey = stringFormat("%d,%d", oldChunkX, oldChunkY)
-				local chunkId = entityChunks[chunkKey]
-
-				-- swap and pop entity from chunks array
-				local chunk = worldChunks[chunkKey]
-				local swapChunkId = #chunk
-				local swapEntityId = chunk[swapChunkId]
-				local swapEntityChunks = worldEntities[swapEntityId].chunks
-				chunk[chunkId] = swapEntityId
-				swapEntityChunks[chunkKey] = chunkId
-
-				chunk[swapChunkId] = nil
-				entityChunks[chunkKey] = nil
-			end
-		end
-	end
-
-	-- add entity to chunks outside old bounds
-	for chunkY = chunkY1, chunkY2 do
-		for chunkX = chunkX1, chunkX2 do
-			local outsideOldBounds = (
-				(chunkX < oldChunkX1)
-				or (chunkY < oldChunkY1)
-				or (chunkX > oldChunkX2)
-				or (chunkY > oldChunkY2)
-			)
-			if outsideOldBounds then
-				local chunkKey = stringFormat("%d,%d", chunkX, chunkY)
-				local chunk = worldChunks[chunkKey]
-				if chunk == nil then
-					chunk = {}
-					worldChunks[chunkKey] = chunk
-				end
-
-				local chunkId = #chunk + 1
-				chunk[chunkId] = entityId
-				entityChunks[chunkKey] = chunkId
-			end
-		end
-	end
+	self.chunks:move(entityId, x, y, w, h)
+	self.changedEntityIds[entityId] = true
 
 	entity.x = x
 	entity.y = y
@@ -141,6 +66,17 @@ function Entity:tag(entity, tag)
 
 	entityTags[tag] = tagId
 
+	self.changedEntityIds[entityId] = true
+	self.changedTags[tag] = true
+
+	local tagIndex = self:internTag(tag)
+	local tagMaskWord = self.tagMaskWords[self.tagIndexWords[tagIndex]]
+	tagMaskWord[entityId] = bitBor(tagMaskWord[entityId], self.tagIndexBits[tagIndex])
+
+	if self.components[tag] ~= nil then
+		self:attachComponent(entity, tag)
+	end
+
 	self.simulation:broadcast("onEntityTag", false, entity, tag, tagId)
 end
 function Entity:untag(entity, tag)
@@ -155,6 +91,10 @@ function Entity:untag(entity, tag)
 	local tagEntities = worldTagEntities[tag]
 	local tagsCount = #tagEntities
 
+	if self.components[tag] ~= nil then
+		self:detachComponent(entity, tag)
+	end
+
 	local swapTag = tagEntities[tagsCount]
 	local swapEntity = world.entities[swapTag]
 	tagEntities[tagId] = swapEntity.id
@@ -163,85 +103,413 @@ function Entity:untag(entity, tag)
 	tagEntities[tagsCount] = nil
 	entityTags[tag] = nil
 
+	local entityId = entity.id
+	local tagIndex = self.tagIndices[tag]
+	local tagMaskWord = self.tagMaskWords[self.tagIndexWords[tagIndex]]
+	tagMaskWord[entityId] = bitBand(tagMaskWord[entityId], bitBnot(self.tagIndexBits[tagIndex]))
+
+	self.changedEntityIds[entityId] = true
+	self.changedEntityIds[swapEntity.id] = true
+	self.changedTags[tag] = true
+
 	self.simulation:broadcast("onEntityTag", false, entity, tag, nil)
 end
+-- components are opt-in struct-of-arrays storage for hot numeric fields: entities with a component's tag keep its
+-- fields in world.componentColumns[tag][field][entity.id] instead of in the entity table.  entities with a component
+-- get a metatable that reads and writes the columns, so entity.field keeps working; hot loops can index the columns
+-- from getComponentColumns() directly.  component fields are numbers, and setting one to nil sets it to 0
+function Entity:addComponent(tag, fieldNames)
+	for _, fieldName in ipairs(fieldNames) do
+		if self.componentFieldTags[fieldName] ~= nil then
+			log.error("field is already in a component, tag=%s, fieldName=%s, componentTag=%s",
+					  tag, fieldName, self.componentFieldTags[fieldName])
+			return false
+		end
+	end
+
+	self.components[tag] = fieldNames
+	for _, fieldName in ipairs(fieldNames) do
+		self.componentFieldTags[fieldName] = tag
+	end
+
+	if self.simulation.state.world.entities ~= nil then
+		self:rebuildComponents()
+	end
+
+	return true
+end
+function Entity:getComponentColumns(tag)
+	return self.simulation.state.world.componentColumns[tag]
+end
+-- fields already in the entity table are moved into the columns; the rest keep the 0 that entities without the
+-- component have
+function Entity:attachComponent(entity, tag)
+	local entityId = entity.id
+	local fieldColumns = self.componentFieldColumns
+	for _, fieldName in ipairs(self.components[tag]) do
+		local value = rawget(entity, fieldName)
+		if value ~= nil then
+			fieldColumns[fieldName][entityId] = value
+			rawset(entity, fieldName, nil)
+		end
+	end
+
+	setmetatable(entity, self.componentMetatable)
+end
+-- called before the tag is removed, so that the fields are still read from the columns
+function Entity:detachComponent(entity, tag)
+	local entityId = entity.id
+	local fieldColumns = self.componentFieldColumns
+	for _, fieldName in ipairs(self.components[tag]) do
+		local column = fieldColumns[fieldName]
+		rawset(entity, fieldName, column[entityId])
+		column[entityId] = 0
+	end
+
+	local entityTags = entity.tags
+	for componentTag, _ in pairs(self.components) do
+		if (componentTag ~= tag) and (entityTags[componentTag] ~= nil) then
+			return
+		end
+	end
+	setmetatable(entity, nil)
+end
+-- columns are part of the world, so are replaced whenever it is; entity metatables are not saved, and are put back.
+-- fields in entity tables, from saves before saveVersion 5, are moved into the columns
+function Entity:rebuildComponents()
+	local world = self.simulation.state.world
+	local worldEntities = world.entities
+	local worldEntitiesCount = #worldEntities
+
+	world.componentColumns = world.componentColumns or {}
+	local componentColumns = world.componentColumns
+	for tag, fieldNames in pairs(self.components) do
+		local columns = componentColumns[tag] or {}
+		componentColumns[tag] = columns
+
+		for _, fieldName in ipairs(fieldNames) do
+			local column = columns[fieldName] or {}
+			columns[fieldName] = column
+			self.componentFieldColumns[fieldName] = column
+
+			for entityId = #column + 1, worldEntitiesCount do
+				column[entityId] = 0
+			end
+		end
+
+		local tagEntities = world.tagEntities[tag] or {}
+		for i = 1, #tagEntities do
+			self:attachComponent(worldEntities[tagEntities[i]], tag)
+		end
+	end
+end
+-- tags are interned to indices, and each entity has a bit per tag in self.tagMaskWords[word][entity.id], so that
+-- queries can require and exclude several tags.  the masks are not part of the world, and are rebuilt from
+-- world.tagEntities whenever it is replaced; indices are kept for the session, so compiled tag masks stay valid
+function Entity:internTag(tag)
+	local tagIndex = self.tagIndices[tag]
+	if tagIndex ~= nil then
+		return tagIndex
+	end
+
+	tagIndex = #self.tagIndexWords + 1
+	local word = math.floor((tagIndex - 1) / self.TAG_MASK_WORD_BITS) + 1
+	self.tagIndices[tag] = tagIndex
+	self.tagIndexWords[tagIndex] = word
+	self.tagIndexBits[tagIndex] = bitLshift(1, (tagIndex - 1) % self.TAG_MASK_WORD_BITS)
+
+	if self.tagMaskWords[word] == nil then
+		local tagMaskWord = {}
+		for entityId = 1, #self.simulation.state.world.entities do
+			tagMaskWord[entityId] = 0
+		end
+		self.tagMaskWords[word] = tagMaskWord
+	end
+
+	return tagIndex
+end
+-- tag lists are compiled to masks the first time they are queried with, and the masks are cached by the list, so
+-- a list must not be changed after being queried with
+function Entity:getTagMask(tags)
+	local tagMask = self.tagMasks[tags]
+	if tagMask ~= nil then
+		return tagMask
+	end
+
+	local wordBits = {}
+	for _, tag in ipairs(tags) do
+		local tagIndex = self:internTag(tag)
+		local word = self.tagIndexWords[tagIndex]
+		wordBits[word] = bitBor(wordBits[word] or 0, self.tagIndexBits[tagIndex])
+	end
+
+	tagMask = {["words"] = {}, ["bits"] = {}}
+	for word, bits in pairs(wordBits) do
+		tagMask.words[#tagMask.words + 1] = word
+		tagMask.bits[#tagMask.bits + 1] = bits
+	end
+	self.tagMasks[tags] = tagMask
+
+	return tagMask
+end
+function Entity:getTagMaskMatches(entityId, requiredTagMask, excludedTagMask)
+	local tagMaskWords = self.tagMaskWords
+
+	local words = requiredTagMask.words
+	local bits = requiredTagMask.bits
+	for i = 1, #words do
+		local wordBits = bits[i]
+		if bitBand(tagMaskWords[words[i]][entityId], wordBits) ~= wordBits then
+			return false
+		end
+	end
+
+	if excludedTagMask ~= nil then
+		words = excludedTagMask.words
+		bits = excludedTagMask.bits
+		for i = 1, #words do
+			if bitBand(tagMaskWords[words[i]][entityId], bits[i]) ~= 0 then
+				return false
+			end
+		end
+	end
+
+	return true
+end
+function Entity:rebuildTagMasks()
+	local world = self.simulation.state.world
+	local worldEntitiesCount = #world.entities
+
+	for _, tagMaskWord in ipairs(self.tagMaskWords) do
+		for entityId = 1, worldEntitiesCount do
+			tagMaskWord[entityId] = 0
+		end
+		for entityId = worldEntitiesCount + 1, #tagMaskWord do
+			tagMaskWord[entityId] = nil
+		end
+	end
+
+	for tag, tagEntities in pairs(world.tagEntities) do
+		local tagIndex = self:internTag(tag)
+		local tagMaskWord = self.tagMaskWords[self.tagIndexWords[tagIndex]]
+		local tagBits = self.tagIndexBits[tagIndex]
+		for i = 1, #tagEntities do
+			local entityId = tagEntities[i]
+			tagMaskWord[entityId] = bitBor(tagMaskWord[entityId], tagBits)
+		end
+	end
+end
+-- nils the entries after count, so results reused between queries only hold the latest query's entities
+local function truncateResults(results, count)
+	local i = count + 1
+	while results[i] ~= nil do
+		results[i] = nil
+		i = i + 1
+	end
+end
+-- iterators return their results buffer to the pool once they reach the end; a loop that breaks out early leaves
+-- its buffer to the garbage collector instead
+local function iterateResults(results, i)
+	i = i + 1
+	local entity = results[i]
+	if entity == nil then
+		local pool = results.pool
+		pool[#pool + 1] = results
+		return nil
+	end
+
+	return i, entity
+end
+function Entity:getIterationResults()
+	local pool = self.iterationResultsPool
+	local poolCount = #pool
+	local results = pool[poolCount]
+	if results == nil then
+		return {["pool"] = pool}
+	end
+
+	pool[poolCount] = nil
+	return results
+end
 function Entity:find(tag, getAll)
+	if getAll then
+		return self:findAll(tag)
+	end
+
+	local world = self.simulation.state.world
+
+	local tagEntities = world.tagEntities[tag]
+	local entityId = tagEntities and tagEntities[1]
+	if entityId == nil then
+		return nil
+	end
+	return world.entities[entityId]
+end
+-- writes the entities with the tag to outEntities[1..n], and returns n
+function Entity:findAllInto(outEntities, tag)
 	local world = self.simulation.state.world
 
 	local worldEntities = world.entities
-	local tagEntities = world.tagEntities[tag] or {}
-	if not getAll then
-		local entityId = tagEntities[1]
-		if entityId == nil then
-			return nil
-		end
-		return worldEntities[entityId]
+	local tagEntities = world.tagEntities[tag]
+	local tagEntitiesCount = 0
+	if tagEntities ~= nil then
+		tagEntitiesCount = #tagEntities
 	end
 
-	local tagEntitiesCount = #tagEntities
+	for i = 1, tagEntitiesCount do
+		outEntities[i] = worldEntities[tagEntities[i]]
+	end
+	truncateResults(outEntities, tagEntitiesCount)
+
+	return tagEntitiesCount
+end
+function Entity:findAll(tag)
 	local results = {}
+	self:findAllInto(results, tag)
+	return results
+end
+-- for _, entity in entitySys:iterate(tag) do ... end; safe to tag, untag, create and destroy entities in the loop
+function Entity:iterate(tag)
+	local results = self:getIterationResults()
+	self:findAllInto(results, tag)
+	return iterateResults, results, 0
+end
+-- writes the entities with all of requiredTags and none of excludedTags to outEntities[1..n], and returns n.
+-- only the shortest list of entities with one of requiredTags is searched
+function Entity:findAllWithInto(outEntities, requiredTags, excludedTags)
+	local world = self.simulation.state.world
+	local worldEntities = world.entities
+	local worldTagEntities = world.tagEntities
 
-	for i = 1, tagEntitiesCount do
-		results[#results + 1] = worldEntities[tagEntities[i]]
+	local requiredTagMask = self:getTagMask(requiredTags)
+	local excludedTagMask = excludedTags and self:getTagMask(excludedTags)
+
+	local searchedEntityIds = nil
+	for _, tag in ipairs(requiredTags) do
+		local tagEntities = worldTagEntities[tag] or EMPTY_TAG_ENTITIES
+		if (searchedEntityIds == nil) or (#tagEntities < #searchedEntityIds) then
+			searchedEntityIds = tagEntities
+		end
 	end
 
+	local resultsCount = 0
+	if searchedEntityIds ~= nil then
+		for i = 1, #searchedEntityIds do
+			local entityId = searchedEntityIds[i]
+			if self:getTagMaskMatches(entityId, requiredTagMask, excludedTagMask) then
+				resultsCount = resultsCount + 1
+				outEntities[resultsCount] = worldEntities[entityId]
+			end
+		end
+	else
+		for entityId = 1, #worldEntities do
+			local entity = worldEntities[entityId]
+			if not entity.destroyed and self:getTagMaskMatches(entityId, requiredTagMask, excludedTagMask) then
+				resultsCount = resultsCount + 1
+				outEntities[resultsCount] = entity
+			end
+		end
+	end
+	truncateResults(outEntities, resultsCount)
+
+	return resultsCount
+end
+function Entity:findAllWith(requiredTags, excludedTags)
+	local results = {}
+	self:findAllWithInto(results, requiredTags, excludedTags)
 	return results
 end
-function Entity:findAll(tag)
-	return self:find(tag, true)
+function Entity:iterateWith(requiredTags, excludedTags)
+	local results = self:getIterationResults()
+	self:findAllWithInto(results, requiredTags, excludedTags)
+	return iterateResults, results, 0
 end
 function Entity:findBounded(x, y, w, h, filterTag, filterOutEntityId, getAll)
-	local seenResults = nil
-	local results = nil
 	if getAll then
-		results = {}
-		seenResults = {}
+		return self:findAllBounded(x, y, w, h, filterTag, filterOutEntityId)
 	end
 
-	local entityChunkSize = self.ENTITY_CHUNK_SIZE
-	local chunkX1 = mathFloor(x / entityChunkSize)
-	local chunkY1 = mathFloor(y / entityChunkSize)
-	local chunkX2 = mathFloor((x + w - FLOAT_EPSILON) / entityChunkSize)
-	local chunkY2 = mathFloor((y + h - FLOAT_EPSILON) / entityChunkSize)
+	local queryEntityIds = self.queryEntityIds
+	local queryCount = self.chunks:query(x, y, w, h, queryEntityIds, filterOutEntityId)
 
-	local world = self.simulation.state.world
-	local worldChunks = world.chunkEntities
-	local entities = world.entities
-	for chunkY = chunkY1, chunkY2 do
-		for chunkX = chunkX1, chunkX2 do
-			local chunkKey = stringFormat("%d,%d", chunkX, chunkY)
-			local chunkEntities = worldChunks[chunkKey]
-			if chunkEntities == nil then
-				chunkEntities = {}
-			end
+	local entities = self.simulation.state.world.entities
+	for i = 1, queryCount do
+		local entity = entities[queryEntityIds[i]]
+		if (filterTag == nil) or (entity.tags[filterTag] ~= nil) then
+			return entity
+		end
+	end
 
-			local chunkEntitiesCount = #chunkEntities
-			for i = 1, chunkEntitiesCount do
-				local entityId = chunkEntities[i]
-				if (filterOutEntityId == nil) or (entityId ~= filterOutEntityId) then
-					local entity = entities[entityId]
-					if utilRectCollides(x, y, w, h, entity.x, entity.y, entity.w, entity.h) then
-						if (filterTag == nil) or (entity.tags[filterTag] ~= nil) then
-							if not getAll then
-								return entity
-							end
-
-							local entityIdString = tostring(entityId)
-							if not seenResults[entityIdString] then
-								results[#results + 1] = entity
-								seenResults[entityIdString] = true
-							end
-						end
-					end
-				end
-			end
+	return nil
+end
+-- writes the entities colliding with the bounds to outEntities[1..n], and returns n
+function Entity:findAllBoundedInto(outEntities, x, y, w, h, filterTag, filterOutEntityId)
+	local queryEntityIds = self.queryEntityIds
+	local queryCount = self.chunks:query(x, y, w, h, queryEntityIds, filterOutEntityId)
+
+	local entities = self.simulation.state.world.entities
+	local resultsCount = 0
+	for i = 1, queryCount do
+		local entity = entities[queryEntityIds[i]]
+		if (filterTag == nil) or (entity.tags[filterTag] ~= nil) then
+			resultsCount = resultsCount + 1
+			outEntities[resultsCount] = entity
 		end
 	end
+	truncateResults(outEntities, resultsCount)
 
-	return results
+	return resultsCount
 end
 function Entity:findAllBounded(x, y, w, h, filterTag, filterOutEntityId)
-	return self:findBounded(x, y, w, h, filterTag, filterOutEntityId, true)
+	local results = {}
+	self:findAllBoundedInto(results, x, y, w, h, filterTag, filterOutEntityId)
+	return results
+end
+function Entity:iterateBounded(x, y, w, h, filterTag, filterOutEntityId)
+	local results = self:getIterationResults()
+	self:findAllBoundedInto(results, x, y, w, h, filterTag, filterOutEntityId)
+	return iterateResults, results, 0
+end
+-- as findAllBoundedInto(), filtered by tag masks as in findAllWithInto()
+function Entity:findAllBoundedWithInto(outEntities, x, y, w, h, requiredTags, excludedTags, filterOutEntityId)
+	local queryEntityIds = self.queryEntityIds
+	local queryCount = self.chunks:query(x, y, w, h, queryEntityIds, filterOutEntityId)
+
+	local requiredTagMask = self:getTagMask(requiredTags)
+	local excludedTagMask = excludedTags and self:getTagMask(excludedTags)
+
+	local entities = self.simulation.state.world.entities
+	local resultsCount = 0
+	for i = 1, queryCount do
+		local entityId = queryEntityIds[i]
+		if self:getTagMaskMatches(entityId, requiredTagMask, excludedTagMask) then
+			resultsCount = resultsCount + 1
+			outEntities[resultsCount] = entities[entityId]
+		end
+	end
+	truncateResults(outEntities, resultsCount)
+
+	return resultsCount
+end
+function Entity:findAllBoundedWith(x, y, w, h, requiredTags, excludedTags, filterOutEntityId)
+	local results = {}
+	self:findAllBoundedWithInto(results, x, y, w, h, requiredTags, excludedTags, filterOutEntityId)
+	return results
+end
+function Entity:findBoundedWith(x, y, w, h, requiredTags, excludedTags, filterOutEntityId)
+	local queryEntityIds = self.queryEntityIds
+	local queryCount = self.chunks:query(x, y, w, h, queryEntityIds, filterOutEntityId)
+
+	local requiredTagMask = self:getTagMask(requiredTags)
+	local excludedTagMask = excludedTags and self:getTagMask(excludedTags)
+	for i = 1, queryCount do
+		local entityId = queryEntityIds[i]
+		if self:getTagMaskMatches(entityId, requiredTagMask, excludedTagMask) then
+			return self.simulation.state.world.entities[entityId]
+		end
+	end
+
+	return nil
 end
 function Entity:findRelative(entity, offsetX, offsetY, filterTag, getAll)
 	local relativeX = entity.x + (offsetX or 0)
@@ -249,9 +517,45 @@ function Entity:findRelative(entity, offsetX, offsetY, filterTag, getAll)
 
 	return self:findBounded(relativeX, relativeY, entity.w, entity.h, filterTag, entity.id, getAll)
 end
+function Entity:findAllRelativeInto(outEntities, entity, offsetX, offsetY, filterTag)
+	local relativeX = entity.x + (offsetX or 0)
+	local relativeY = entity.y + (offsetY or 0)
+
+	return self:findAllBoundedInto(outEntities, relativeX, relativeY, entity.w, entity.h, filterTag, entity.id)
+end
 function Entity:findAllRelative(entity, offsetX, offsetY, filterTag)
 	return self:findRelative(entity, offsetX, offsetY, filterTag, true)
 end
+function Entity:iterateRelative(entity, offsetX, offsetY, filterTag)
+	local results = self:getIterationResults()
+	self:findAllRelativeInto(results, entity, offsetX, offsetY, filterTag)
+	return iterateResults, results, 0
+end
+-- moves the entity's bounds one pixel at a time, up to moveX or moveY (integers, along one axis), without moving the
+-- entity.  returns the first entity they collide with and the step they first collide at, or nil if none do.  which
+-- of several entities colliding at the same step is returned is unspecified; use findRelative() at that step instead
+function Entity:sweep(entity, moveX, moveY, filterTag)
+	local sweepEntityIds = self.queryEntityIds
+	local sweepSteps = self.sweepSteps
+	local sweepCount = self.chunks:sweep(
+		entity.x, entity.y, entity.w, entity.h, moveX, moveY, sweepEntityIds, sweepSteps, entity.id)
+
+	local entities = self.simulation.state.world.entities
+	local firstEntity = nil
+	local firstStep = nil
+	for i = 1, sweepCount do
+		local step = sweepSteps[i]
+		if (firstStep == nil) or (step < firstStep) then
+			local sweptEntity = entities[sweepEntityIds[i]]
+			if (filterTag == nil) or (sweptEntity.tags[filterTag] ~= nil) then
+				firstEntity = sweptEntity
+				firstStep = step
+			end
+		end
+	end
+
+	return firstEntity, firstStep
+end
 function Entity:destroy(entity)
 	if entity.destroyed then
 		return
@@ -267,11 +571,13 @@ function Entity:destroy(entity)
 	self:setBounds(entity, 0, 0, 0, 0)
 
 	local entityId = entity.id
+	self.chunks:remove(entityId)
 	for key, _ in pairs(entity) do
 		entity[key] = nil
 	end
 
 	entity.destroyed = true
+	self.changedEntityIds[entityId] = true
 
 	local destroyedEntities = self.simulation.state.world.destroyedEntities
 	destroyedEntities[#destroyedEntities + 1] = entityId
@@ -298,30 +604,272 @@ function Entity:create()
 		["z"] = 0,
 		["w"] = 0,
 		["h"] = 0,
-		["chunks"] = {},
 		["tags"] = {},
 	}
 
 	entities[entityId] = entity
+	self.chunks:insert(entityId, 0, 0, 0, 0)
+
+	-- entities without a component keep 0 in its columns, so that the columns stay arrays
+	for _, column in pairs(self.componentFieldColumns) do
+		column[entityId] = 0
+	end
+	for _, tagMaskWord in ipairs(self.tagMaskWords) do
+		tagMaskWord[entityId] = 0
+	end
+	self.changedEntityIds[entityId] = true
 
 	return entity
 end
+-- entities changed other than through Entity's functions must be invalidated, so that incremental saves include them
+function Entity:invalidate(entity)
+	local entityId = entity.id
+	if entityId ~= nil then
+		self.changedEntityIds[entityId] = true
+	end
+end
+-- changes are tracked once, then merged into each named set of changes (the save journal, rewind, etc) on demand
+function Entity:flushChanges()
+	for _, changes in pairs(self.changeSets) do
+		for entityId, _ in pairs(self.changedEntityIds) do
+			changes.entityIds[entityId] = true
+		end
+		for tag, _ in pairs(self.changedTags) do
+			changes.tags[tag] = true
+		end
+	end
+
+	self.changedEntityIds = {}
+	self.changedTags = {}
+end
+function Entity:getChanges(changeSetName)
+	self:flushChanges()
+
+	local changes = self.changeSets[changeSetName]
+	if changes == nil then
+		changes = self:clearChanges(changeSetName)
+	end
+
+	return changes
+end
+-- starts tracking the named set of changes from now, or empties every set of changes if no name is given
+function Entity:clearChanges(changeSetName)
+	if changeSetName == nil then
+		self.changedEntityIds = {}
+		self.changedTags = {}
+		for name, _ in pairs(self.changeSets) do
+			self:clearChanges(name)
+		end
+		return
+	end
+
+	self:flushChanges()
+
+	local changes = {
+		["entityIds"] = {},
+		["tags"] = {},
+	}
+	self.changeSets[changeSetName] = changes
+	return changes
+end
+-- returns the entities and tags in the named set of changes, which replace those in a world without them
+function Entity:getWorldChanges(changeSetName)
+	local world = self.simulation.state.world
+	local worldEntities = world.entities
+	local worldTagEntities = world.tagEntities
+
+	local changes = self:getChanges(changeSetName)
+	local worldChanges = {
+		["entities"] = {},
+		["destroyedEntityIds"] = {},
+		["tagEntities"] = {},
+		["componentColumns"] = {},
+	}
+	for entityId, _ in pairs(changes.entityIds) do
+		local entity = worldEntities[entityId]
+		if entity.destroyed then
+			worldChanges.destroyedEntityIds[#worldChanges.destroyedEntityIds + 1] = entityId
+		else
+			worldChanges.entities[#worldChanges.entities + 1] = entity
+		end
+	end
+	for tag, _ in pairs(changes.tags) do
+		worldChanges.tagEntities[tag] = worldTagEntities[tag]
+	end
+
+	-- component columns hold the values of every changed entity, including those without the component
+	local worldComponentColumns = world.componentColumns
+	for tag, fieldNames in pairs(self.components) do
+		local columns = worldComponentColumns[tag]
+		local changedColumns = {["entityIds"] = {}}
+		for _, fieldName in ipairs(fieldNames) do
+			changedColumns[fieldName] = {}
+		end
+
+		local changedEntityIds = changedColumns.entityIds
+		for entityId, _ in pairs(changes.entityIds) do
+			local i = #changedEntityIds + 1
+			changedEntityIds[i] = entityId
+			for _, fieldName in ipairs(fieldNames) do
+				changedColumns[fieldName][i] = columns[fieldName][entityId]
+			end
+		end
+		worldChanges.componentColumns[tag] = changedColumns
+	end
+
+	return worldChanges
+end
+-- record.state.world is a copy of the world without its entities or tags; they are put back from state.world, with
+-- the changes in record.entity applied
+function Entity:setWorldChanges(record, state)
+	local world = state.world
+	local worldEntities = world.entities
+	local worldTagEntities = world.tagEntities
+
+	local worldChanges = record.entity
+	for _, entity in ipairs(worldChanges.entities) do
+		worldEntities[entity.id] = entity
+	end
+	for _, entityId in ipairs(worldChanges.destroyedEntityIds) do
+		worldEntities[entityId] = {["destroyed"] = true}
+	end
+	for tag, tagEntities in pairs(worldChanges.tagEntities) do
+		worldTagEntities[tag] = tagEntities
+	end
+
+	local worldComponentColumns = world.componentColumns
+	for tag, changedColumns in pairs(worldChanges.componentColumns or {}) do
+		local columns = worldComponentColumns[tag]
+		for fieldName, changedColumn in pairs(changedColumns) do
+			if fieldName ~= "entityIds" then
+				local column = columns[fieldName]
+				for i, entityId in ipairs(changedColumns.entityIds) do
+					column[entityId] = changedColumn[i]
+				end
+			end
+		end
+	end
+
+	local recordWorld = record.state.world
+	recordWorld.entities = worldEntities
+	recordWorld.tagEntities = worldTagEntities
+	recordWorld.componentColumns = worldComponentColumns
+end
+function Entity:removeWorldTables(record)
+	local recordWorld = record.state.world
+	recordWorld.entities = nil
+	recordWorld.tagEntities = nil
+	recordWorld.componentColumns = nil
+end
+-- chunks are not part of the world, as they are rebuilt from entity bounds whenever the world is replaced.
+-- saves from before saveVersion 4 have chunks in the world, which are removed
+function Entity:rebuildChunks()
+	local world = self.simulation.state.world
+	world.chunkEntities = nil
+
+	self.chunks:clear()
+	for entityId, entity in ipairs(world.entities) do
+		if not entity.destroyed then
+			entity.chunks = nil
+			self.chunks:insert(entityId, entity.x, entity.y, entity.w, entity.h)
+		end
+	end
+end
 function Entity:onInit(simulation)
 	self.simulation = simulation
+	self.changeSets = {}
+	self:clearChanges()
+
+	self.queryEntityIds = {}
+	self.sweepSteps = {}
+	self.iterationResultsPool = {}
+
+	self.tagIndices = {}
+	self.tagIndexWords = {}
+	self.tagIndexBits = {}
+	self.tagMaskWords = {}
+	self.tagMasks = setmetatable({}, {["__mode"] = "k"})
+
+	self.components = {}
+	self.componentFieldTags = {}
+	self.componentFieldColumns = {}
+	local componentFieldTags = self.componentFieldTags
+	local componentFieldColumns = self.componentFieldColumns
+	self.componentMetatable = {
+		["__index"] = function(entity, key)
+			local tag = componentFieldTags[key]
+			if (tag ~= nil) and (entity.tags[tag] ~= nil) then
+				return componentFieldColumns[key][entity.id]
+			end
+			return nil
+		end,
+		["__newindex"] = function(entity, key, value)
+			local tag = componentFieldTags[key]
+			if (tag ~= nil) and (entity.tags[tag] ~= nil) then
+				componentFieldColumns[key][entity.id] = value or 0
+				return
+			end
+			rawset(entity, key, value)
+		end,
+	}
 end
 function Entity:onWorldInit()
 	local world = self.simulation.state.world
 	world.entities = {}
 	world.tagEntities = {}
-	world.chunkEntities = {}
 	world.destroyedEntities = {}
+
+	-- the c client's spatial hash, or the headless client's lua one
+	self.chunks = client.newSpatialHash(self.ENTITY_CHUNK_SIZE)
+	self:rebuildTagMasks()
+	self:rebuildComponents()
+
+	self:clearChanges()
 end
-function Entity:onRunTests()
-	self.simulation:worldInit()
+-- only what changed since the last save is added to journal records; the rest of the world is saved whole
+function Entity:onSaveJournal(record)
+	record.entity = self:getWorldChanges("save")
+	self:removeWorldTables(record)
+
+	self:clearChanges("save")
+end
+function Entity:onLoadJournal(record, state)
+	self:setWorldChanges(record, state)
+end
+function Entity:onSaveState()
+	self:clearChanges("save")
+end
+function Entity:onLoadState()
+	self:rebuildChunks()
+	self:rebuildTagMasks()
+	self:rebuildComponents()
+	self:clearChanges()
+end
+-- rewind keyframes hold the whole world; the frames after one only hold what changed since it
+function Entity:onRewindCapture(record, keyframe)
+	if keyframe then
+		self:clearChanges("rewind")
+		return
+	end
 
+	record.entity = self:getWorldChanges("rewind")
+	self:removeWorldTables(record)
+end
+function Entity:onRewindApply(record, state)
+	self:setWorldChanges(record, state)
+end
+function Entity:onRewind()
+	self:rebuildChunks()
+	self:rebuildTagMasks()
+	self:rebuildComponents()
+	self:clearChanges()
+end
+function Entity:onRunTests()
 	local entityChunkSizeBackup = self.ENTITY_CHUNK_SIZE
 	self.ENTITY_CHUNK_SIZE = 64  -- test values are hard-coded to test this chunk size
 
+	self.simulation:worldInit()
+
 	local world = self.simulation.state.world
 	if world.entities == nil then
 		log.error("entities object was not created during World.create()")
@@ -329,9 +877,6 @@ function Entity:onRunTests()
 	if world.tagEntities == nil then
 		log.error("tagEntities object was not created during World.create()")
 	end
-	if world.chunkEntities == nil then
-		log.error("chunkEntities object was not created during World.create()")
-	end
 
 	local entity = self:create()
 	local entity2 = self:create()
@@ -340,15 +885,17 @@ function Entity:onRunTests()
 	log.assert(world.entities[entity2.id] == entity2)
 
 	log.assert((entity.x == 0) and (entity.y == 0) and (entity.w == 0) and (entity.h == 0))
-	log.assert(util.setEquals(util.tableGetKeys(entity.chunks), {}))
+	local queryEntityIds = {}
+	log.assert(self.chunks:query(0, 0, 128, 128, queryEntityIds) == 0)
 	self:tag(entity, "red")
 	log.assert(self:findBounded(0, 0, 100, 100, "red") == nil)
 	log.assert(#self:findAllBounded(0, 0, 100, 100, "red") == 0)
 
 	self:setBounds(entity, 64, 96, 16, 32)
 	log.assert(entity.x == 64 and entity.y == 96 and entity.w == 16 and entity.h == 32)
-	log.assert(util.setEquals(util.tableGetKeys(entity.chunks), {"1,1"}))
-	log.assert(world.chunkEntities["1,1"][entity.chunks["1,1"]] == entity.id)
+	log.assert(self.chunks:query(64, 64, 64, 64, queryEntityIds) == 1)
+	log.assert(queryEntityIds[1] == entity.id)
+	log.assert(self.chunks:query(64, 64, 64, 64, queryEntityIds, entity.id) == 0)
 	log.assert(#self:findAllBounded(0, 0, 100, 100, "red") == 1)
 	log.assert(self:findBounded(0, 0, 100, 100, "red"))
 	log.assert(self:findBounded(0, 0, 64, 96, "red") == nil)
@@ -364,7 +911,7 @@ function Entity:onRunTests()
 	log.assert(entity.y == 32)
 
 	self:setBounds(entity, 0, 0, 0, 0)
-	log.assert(util.setEquals(util.tableGetKeys(entity.chunks), {}))
+	log.assert(self.chunks:query(0, 0, 128, 128, queryEntityIds) == 0)
 
 	self:untag(entity, "red")
 	self:tag(entity, "red")
@@ -404,13 +951,311 @@ function Entity:onRunTests()
 	log.assert(util.setEquals(self:findAll("blue"), entities))
 	log.assert(#self:findAllBounded(0, 0, 100, 100, "blue") == numEntities)
 
+	-- results buffers are overwritten by each query, and iterators reuse theirs once a loop finishes
+	local results = {}
+	log.assert(self:findAllInto(results, "blue") == numEntities)
+	log.assert(util.tableDeepEquals(results, self:findAll("blue")))
+	log.assert(self:findAllBoundedInto(results, 0, 0, 2.5, 2.5, "blue") == 2)
+	log.assert((#results == 2) and util.setEquals(results, {entities[1], entities[2]}))
+	log.assert(self:findAllRelativeInto(results, entities[1], 1, 1, "blue") == 1)
+	log.assert((#results == 1) and (results[1] == entities[2]))
+	log.assert(self:findAllInto(results, "missing") == 0)
+	log.assert(#results == 0)
+
+	local iterated = {}
+	for i, blueEntity in self:iterate("blue") do
+		iterated[i] = blueEntity
+		self:untag(blueEntity, "blue")
+	end
+	log.assert(util.tableDeepEquals(iterated, entities))
+	log.assert(self:find("blue") == nil)
+	local iterationResultsCount = #self.iterationResultsPool
+	for _, boundedEntity in self:iterateBounded(0, 0, 100, 100) do
+		for _ in self:iterateRelative(boundedEntity, 1, 1) do
+			self:tag(boundedEntity, "blue")
+		end
+	end
+	log.assert(#self:findAll("blue") == (numEntities - 1))
+	log.assert(#self.iterationResultsPool == math.max(iterationResultsCount, 2))
+
+	-- tag masks require every tag in one list and none in another, with or without bounds
+	local blueEntities = {entities[1], entities[2], entities[3], entities[4]}
+	log.assert(util.setEquals(self:findAllWith({"blue"}), blueEntities))
+	log.assert(util.setEquals(self:findAllWith({"blue"}, {"2", "3"}), {entities[1], entities[4]}))
+	log.assert(util.tableDeepEquals(self:findAllWith({"4", "blue"}), {entities[4]}))
+	log.assert(#self:findAllWith({"blue", "missing"}) == 0)
+	log.assert(util.tableDeepEquals(self:findAllWith({}, {"blue"}), {entities[5]}))
+	log.assert(util.tableDeepEquals(self:findAllBoundedWith(0, 0, 2.5, 2.5, {"blue"}, {"1"}), {entities[2]}))
+	log.assert(self:findBoundedWith(0, 0, 100, 100, {"5"}, nil, entities[4].id) == entities[5])
+	log.assert(self:findBoundedWith(0, 0, 100, 100, {"5"}, nil, entities[5].id) == nil)
+
+	local maskTags = {}
+	for i = 1, self.TAG_MASK_WORD_BITS + 8 do
+		maskTags[i] = "mask"..i
+		self:tag(entities[5], maskTags[i])
+	end
+	log.assert(util.tableDeepEquals(self:findAllWith(maskTags), {entities[5]}))
+	self:untag(entities[5], maskTags[#maskTags])
+	log.assert(#self:findAllWith(maskTags) == 0)
+	log.assert(util.tableDeepEquals(self:findAllWith({maskTags[1]}, {maskTags[#maskTags]}), {entities[5]}))
+
+	-- masks are rebuilt the same from the world's tag lists
+	self:rebuildTagMasks()
+	log.assert(util.setEquals(self:findAllWith({"blue"}, {"2", "3"}), {entities[1], entities[4]}))
+	log.assert(util.tableDeepEquals(self:findAllWith({maskTags[1]}, {maskTags[#maskTags]}), {entities[5]}))
+
 	for _, entityToDestroy in ipairs(entities) do
 		self:destroy(entityToDestroy)
 	end
 
 	log.assert(util.setEquals(self:findAll("blue"), {}))
 
+	-- entities in more than one chunk are found once, and chunks are rebuilt the same from entity bounds
+	entity = self:create()
+	self:setBounds(entity, 56, 56, 16, 16)
+	log.assert(#self:findAllBounded(0, 0, 128, 128) == 1)
+	self:rebuildChunks()
+	log.assert(util.setEquals(self:findAllBounded(60, 60, 8, 8), {entity}))
+	self:destroy(entity)
+	log.assert(self:findBounded(0, 0, 128, 128) == nil)
+
+	-- sweeps find the same first collision as moving one pixel at a time and checking each step
+	local swept = self:create()
+	self:setBounds(swept, 60.5, 60, 8, 7.5)
+	local obstacleBounds = {{82.25, 58, 4, 4}, {75, 62, 3, 3}, {30, 66, 6, 5}, {61, 90.5, 2, 2}, {50, 20, 4, 4}}
+	local obstacles = {}
+	for i, bounds in ipairs(obstacleBounds) do
+		obstacles[i] = self:create()
+		self:setBounds(obstacles[i], bounds[1], bounds[2], bounds[3], bounds[4])
+		self:tag(obstacles[i], (i == 2) and "sweepTestSkipped" or "sweepTest")
+	end
+	local sweepMoves = {{40, 0}, {-40, 0}, {0, 40}, {0, -60}, {10, 0}}
+	local sweepExpectedSteps = {14, 25, 24, nil, nil}
+	for i, move in ipairs(sweepMoves) do
+		local expectedEntity, expectedStep = nil, nil
+		local steps = math.abs(move[1] + move[2])
+		for step = 1, steps do
+			expectedEntity = self:findRelative(
+				swept, (move[1] / steps) * step, (move[2] / steps) * step, "sweepTest")
+			if expectedEntity ~= nil then
+				expectedStep = step
+				break
+			end
+		end
+		local sweptEntity, sweptStep = self:sweep(swept, move[1], move[2], "sweepTest")
+		log.assert((sweptStep == expectedStep) and (sweptStep == sweepExpectedSteps[i]))
+		log.assert((sweptEntity == nil) == (expectedEntity == nil))
+		log.assert((sweptEntity == nil) or util.tableHasValue(self:findAllRelative(
+			swept, (move[1] / steps) * sweptStep, (move[2] / steps) * sweptStep, "sweepTest"), sweptEntity))
+	end
+	log.assert(self:sweep(swept, 0, 0) == nil)
+	self:destroy(swept)
+	for _, obstacle in ipairs(obstacles) do
+		self:destroy(obstacle)
+	end
+
+	-- component fields are kept in columns, and are read and written through the entity while it has the tag
+	local componentFieldNames = {"componentTestX", "componentTestY"}
+	log.assert(self:addComponent("componentTest", componentFieldNames))
+	local component = self:create()
+	component.componentTestX = 2
+	self:tag(component, "componentTest")
+	local componentColumns = self:getComponentColumns("componentTest")
+	log.assert(rawget(component, "componentTestX") == nil)
+	log.assert((component.componentTestX == 2) and (component.componentTestY == 0))
+	component.componentTestY = 3
+	log.assert(componentColumns.componentTestY[component.id] == 3)
+	self:untag(component, "componentTest")
+	log.assert((rawget(component, "componentTestY") == 3) and (componentColumns.componentTestY[component.id] == 0))
+	log.assert(getmetatable(component) == nil)
+	self:tag(component, "componentTest")
+	log.assert(component.componentTestY == 3)
+
+	-- saves after the first only journal what changed, and loading replays the journal onto the save
+	local saveFilename = "test_entity_save.sav"
+	for i = 1, 32 do
+		self:setBounds(self:create(), i * 8, 0, 8, 8)
+	end
+	local saved = self:create()
+	self:setBounds(saved, 8, 8, 8, 8)
+	self:tag(saved, "saved")
+	log.assert(self.simulation:save(saveFilename))
+
+	self:setPos(saved, 72, 8)
+	saved.savedField = 1
+	self:invalidate(saved)
+	component.componentTestX = 5
+	self:invalidate(component)
+	local destroyed = self:create()
+	self:tag(destroyed, "saved")
+	log.assert(self.simulation:save(saveFilename))
+
+	self:destroy(destroyed)
+	self:untag(saved, "saved")
+	log.assert(self.simulation:save(saveFilename))
+
+	log.assert(self.simulation.private.saveJournal.recordCount == 2)
+	local savedState, journal = self.simulation:readSave(saveFilename)
+	log.assert(journal.recordCount == 2)
+	log.assert(util.tableDeepEquals(savedState.world, self.simulation.state.world))
+	log.assert(savedState.world.entities[saved.id].savedField == 1)
+	log.assert(savedState.world.componentColumns.componentTest.componentTestX[component.id] == 5)
+	os.remove(saveFilename)
+	os.remove(self.simulation:getJournalFilename(saveFilename))
+
+	-- entities loaded from saves have no metatables, which rebuilding components puts back
+	setmetatable(component, nil)
+	log.assert(component.componentTestX == nil)
+	self:rebuildComponents()
+	log.assert(component.componentTestX == 5)
+
+	self:destroy(component)
+	self.components.componentTest = nil
+	for _, fieldName in ipairs(componentFieldNames) do
+		self.componentFieldTags[fieldName] = nil
+		self.componentFieldColumns[fieldName] = nil
+	end
+	world.componentColumns.componentTest = nil
+
 	self.ENTITY_CHUNK_SIZE = entityChunkSizeBackup
 end
+function Entity:onRunBenchmarks()
+	-- compares the c client's spatial hash with the lua one on a 10k entity world, then benchmarks entity moves and
+	-- queries with whichever the client uses
+	local newSpatialHashes = {["lua"] = SpatialHash.new}
+	if not client.state.headless then
+		newSpatialHashes["native"] = client.newSpatialHash
+	end
+
+	local entityCount = 10000
+	local queryEntityIds = {}
+	for name, newSpatialHash in pairs(newSpatialHashes) do
+		local chunks = newSpatialHash(self.ENTITY_CHUNK_SIZE)
+		local offset = 0
+		local function insertAll()
+			chunks:clear()
+			for i = 1, entityCount do
+				chunks:insert(i, (i % 100) * 10, math.floor(i / 100) * 10, 8, 8)
+			end
+		end
+		local function moveAll()
+			offset = offset + 1
+			for i = 1, entityCount do
+				chunks:move(i, ((i % 100) * 10) + offset, math.floor(i / 100) * 10, 8, 8)
+			end
+		end
+		local function queryAll()
+			for i = 1, entityCount do
+				chunks:query((i % 100) * 10, math.floor(i / 100) * 10, 16, 16, queryEntityIds, i)
+			end
+		end
+
+		local iterations = 10
+		util.benchmark(string.format("%s spatial hash insert, entities=%d", name, entityCount), iterations, insertAll)
+		util.benchmark(string.format("%s spatial hash move, entities=%d", name, entityCount), iterations, moveAll)
+		util.benchmark(string.format("%s spatial hash query, queries=%d", name, entityCount), iterations, queryAll)
+	end
+
+	local entities = {}
+	for i = 1, entityCount do
+		local entity = self:create()
+		self:setBounds(entity, (i % 100) * 10, math.floor(i / 100) * 10, 8, 8)
+		self:tag(entity, "benchmark")
+		entities[i] = entity
+	end
+
+	local function moveEntities()
+		for i = 1, entityCount do
+			self:movePos(entities[i], 1, 0)
+		end
+	end
+	local function findEntities()
+		for i = 1, entityCount do
+			self:findRelative(entities[i], 1, 0, "benchmark")
+		end
+	end
+	local function findAllEntities()
+		for i = 1, entityCount do
+			self:findAllRelative(entities[i], 1, 0, "benchmark")
+		end
+	end
+	local results = {}
+	local function findAllEntitiesInto()
+		for i = 1, entityCount do
+			self:findAllRelativeInto(results, entities[i], 1, 0, "benchmark")
+		end
+	end
+	local function iterateEntities()
+		for i = 1, entityCount do
+			for _ in self:iterateRelative(entities[i], 1, 0, "benchmark") do
+			end
+		end
+	end
+	-- every other entity has a second tag, and every fourth a third, which is excluded
+	for i = 1, entityCount, 2 do
+		self:tag(entities[i], "benchmarkOdd")
+		if (i % 4) == 1 then
+			self:tag(entities[i], "benchmarkExcluded")
+		end
+	end
+	local requiredTags = {"benchmark", "benchmarkOdd"}
+	local excludedTags = {"benchmarkExcluded"}
+	local function findAllFiltered()
+		local count = 0
+		for _, entity in ipairs(self:findAll("benchmarkOdd")) do
+			local entityTags = entity.tags
+			if (entityTags.benchmark ~= nil) and (entityTags.benchmarkExcluded == nil) then
+				count = count + 1
+			end
+		end
+		return count
+	end
+	local function findAllWith()
+		return self:findAllWithInto(results, requiredTags, excludedTags)
+	end
+	log.assert(findAllFiltered() == findAllWith())
+	-- moves of up to 8 pixels, checked one pixel at a time or swept at once
+	local function findEntitiesPerPixel()
+		for i = 1, entityCount do
+			for step = 1, 8 do
+				if self:findRelative(entities[i], 0, step, "benchmark") ~= nil then
+					break
+				end
+			end
+		end
+	end
+	local function sweepEntities()
+		for i = 1, entityCount do
+			self:sweep(entities[i], 0, 8, "benchmark")
+		end
+	end
+
+	util.benchmark(string.format("Entity:movePos, entities=%d", entityCount), 10, moveEntities)
+	util.benchmark(string.format("Entity:findRelative, entities=%d", entityCount), 10, findEntities)
+	util.benchmark(string.format("Entity:findAll and filter by tags, entities=%d", entityCount), 100, findAllFiltered)
+	util.benchmark(string.format("Entity:findAllWithInto, entities=%d", entityCount), 100, findAllWith)
+	util.benchmark(string.format("Entity:findRelative per pixel, entities=%d", entityCount), 10, findEntitiesPerPixel)
+	util.benchmark(string.format("Entity:sweep, entities=%d", entityCount), 10, sweepEntities)
+
+	-- the garbage collector is stopped while each query runs once more, so that all it allocates is counted
+	local queryBenchmarks = {
+		{"Entity:findAllRelative", findAllEntities},
+		{"Entity:findAllRelativeInto", findAllEntitiesInto},
+		{"Entity:iterateRelative", iterateEntities},
+	}
+	for _, queryBenchmark in ipairs(queryBenchmarks) do
+		local name, fn = queryBenchmark[1], queryBenchmark[2]
+		util.benchmark(string.format("%s, entities=%d", name, entityCount), 10, fn)
+
+		collectgarbage("stop")
+		local startKilobytes = collectgarbage("count")
+		fn()
+		local allocatedKilobytes = collectgarbage("count") - startKilobytes
+		collectgarbage("restart")
+		log.info("%s allocated %.1fkB, entities=%d", name, allocatedKilobytes, entityCount)
+	end
+
+	return 1
+end
 
 return Entity
@@ -1,46 +1,63 @@
+local log = require("engine/util/log")
 local client = require("engine/client/client")
 
 local Input = {}
 Input.SYSTEM_NAME = "input"
-Input.CLIENT_INPUT_MAP = {
-	["left"] = "inputLeft",
-	["right"] = "inputRight",
-	["up"] = "inputUp",
-	["down"] = "inputDown",
-	["a"] = "inputA",
-	["b"] = "inputB",
-	["x"] = "inputX",
-	["y"] = "inputY",
-	["mouseLeft"] = "inputMouseLeft",
-	["mouseMiddle"] = "inputMouseMiddle",
-	["mouseRight"] = "inputMouseRight",
+-- bits of client.state.inputMask and inputMouseMask; see JE_INPUT_* and JE_MOUSE_BUTTON_* in window.h
+Input.CLIENT_INPUT_BITS = {
+	["left"] = 0,
+	["up"] = 1,
+	["right"] = 2,
+	["down"] = 3,
+	["a"] = 4,
+	["b"] = 5,
+	["x"] = 6,
+	["y"] = 7,
 }
+Input.CLIENT_MOUSE_BUTTON_BITS = {
+	["mouseLeft"] = 0,
+	["mouseMiddle"] = 1,
+	["mouseRight"] = 2,
+}
+function Input.getMaskBit(mask, bit)
+	return (math.floor(mask / (2 ^ bit)) % 2) == 1
+end
+function Input.stepInput(inputs, previousInputs, inputKey, down)
+	local input = {}
+	input.down = down
+
+	input.pressed = false
+	input.released = false
+	input.framesDown = 0
+	if previousInputs[inputKey] then
+		input.pressed = input.down and not previousInputs[inputKey].down
+		input.released = not input.down and previousInputs[inputKey].down
+		if input.down then
+			input.framesDown = previousInputs[inputKey].framesDown + 1
+		end
+	end
+
+	inputs[inputKey] = input
+end
 function Input:stepInputs()
 	local previousInputs = self.inputs or {}
+	local clientState = client.state
 
 	local inputs = {}
 
-	for inputKey, clientInputKey in pairs(self.CLIENT_INPUT_MAP) do
-		local input = {}
-		input.down = client.state[clientInputKey]
-
-		input.pressed = false
-		input.released = false
-		input.framesDown = 0
-		if previousInputs[inputKey] then
-			input.pressed = input.down and not previousInputs[inputKey].down
-			input.released = not input.down and previousInputs[inputKey].down
-			if input.down then
-				input.framesDown = previousInputs[inputKey].framesDown + 1
-			end
-		end
+	local inputMask = clientState.inputMask
+	for inputKey, bit in pairs(self.CLIENT_INPUT_BITS) do
+		self.stepInput(inputs, previousInputs, inputKey, self.getMaskBit(inputMask, bit))
+	end
 
-		inputs[inputKey] = input
+	local inputMouseMask = clientState.inputMouseMask
+	for inputKey, bit in pairs(self.CLIENT_MOUSE_BUTTON_BITS) do
+		self.stepInput(inputs, previousInputs, inputKey, self.getMaskBit(inputMouseMask, bit))
 	end
 
 	self.inputs = inputs
-	self.mouseX = client.state["inputMouseX"]
-	self.mouseY = client.state["inputMouseY"]
+	self.mouseX = clientState.inputMouseX
+	self.mouseY = clientState.inputMouseY
 end
 function Input:get(inputKey)
 	return self.inputs[inputKey].down
@@ -61,5 +78,19 @@ end
 function Input:onStep()
 	self:stepInputs()
 end
+function Input:onRunTests()
+	log.assert(self.getMaskBit(5, 0))
+	log.assert(not self.getMaskBit(5, 1))
+	log.assert(self.getMaskBit(5, 2))
+	log.assert(not self.getMaskBit(0, 7))
+
+	local inputs = {}
+	self.stepInput(inputs, {}, "a", true)
+	log.assert(inputs.a.down and not inputs.a.pressed)
+
+	local nextInputs = {}
+	self.stepInput(nextInputs, {["a"] = {["down"] = false, ["framesDown"] = 0}}, "a", true)
+	log.assert(nextInputs.a.pressed and (nextInputs.a.framesDown == 1))
+end
 
 return Input
@@ -0,0 +1,279 @@
+local log = require("engine/util/log")
+local util = require("engine/util/util")
+local client = require("engine/client/client")
+local Entity = require("engine/systems/entity")
+
+-- keeps the last few seconds of simulation.state in memory, so that any recent frame can be restored and stepped
+-- again.  every few frames a keyframe of the whole state is kept; the frames after it only hold what changed since
+-- the keyframe, so restoring any frame decodes at most two records.  records are encoded and compressed, and the
+-- oldest keyframe and its frames are dropped once there are too many frames or they use too much memory
+local Rewind = {}
+Rewind.SYSTEM_NAME = "rewind"
+function Rewind:reset()
+	self.frames = {}
+	self.firstFrame = self.frame + 1
+	self.lastFrame = self.frame
+	self.keyframe = nil
+	self.keyframeBytes = 0
+	self.lastFrameBytes = 0
+	self.bytes = 0
+end
+function Rewind:getFrameCount()
+	return self.lastFrame - self.firstFrame + 1
+end
+function Rewind:dropFirstKeyframe()
+	local keyframe = self.frames[self.firstFrame].keyframe
+	while (self.firstFrame <= self.lastFrame) and (self.frames[self.firstFrame].keyframe == keyframe) do
+		self.bytes = self.bytes - #self.frames[self.firstFrame].data
+		self.frames[self.firstFrame] = nil
+		self.firstFrame = self.firstFrame + 1
+	end
+end
+function Rewind:capture()
+	local startTimeSeconds = os.clock()
+	local constants = self.simulation.constants
+
+	local frame = self.lastFrame + 1
+
+	-- frames hold everything that changed since their keyframe, so they grow until the next keyframe
+	local keyframe = ((self.keyframe == nil)
+		or ((frame - self.keyframe) >= constants.rewindKeyframeFrames)
+		or ((self.lastFrameBytes * 2) >= self.keyframeBytes))
+
+	local record = {}
+	if keyframe then
+		record.state = self.simulation.state
+	else
+		record.state = self.simulation:getShallowState()
+	end
+	self.simulation:broadcast("onRewindCapture", false, record, keyframe)
+
+	local recordStr = self.simulation:encodeSave(record)
+	local data = recordStr and client.compress(recordStr)
+	if not data then
+		log.error("failed to encode rewind record, frame=%d", frame)
+		self:reset()
+		return false
+	end
+
+	if keyframe then
+		self.keyframe = frame
+		self.keyframeBytes = #data
+		self.lastFrameBytes = 0
+	else
+		self.lastFrameBytes = #data
+	end
+	self.frames[frame] = {
+		["keyframe"] = self.keyframe,
+		["data"] = data,
+	}
+	self.frame = frame
+	self.lastFrame = frame
+	self.bytes = self.bytes + #data
+
+	-- the frames since the current keyframe are always kept
+	while (((self:getFrameCount() > constants.rewindMaxFrames) or (self.bytes > constants.rewindMaxBytes))
+		   and (self.frames[self.firstFrame].keyframe ~= self.keyframe)) do
+		self:dropFirstKeyframe()
+	end
+
+	local captureSeconds = os.clock() - startTimeSeconds
+	self.captureCount = self.captureCount + 1
+	self.captureSeconds = self.captureSeconds + captureSeconds
+	self.maxCaptureSeconds = math.max(self.maxCaptureSeconds, captureSeconds)
+
+	if keyframe then
+		log.debug("keyframe captured, frame=%d, frameCount=%d, bytes=%d, keyframeBytes=%d, captureMicroseconds=%.1f, "
+				  .."averageCaptureMicroseconds=%.1f, maxCaptureMicroseconds=%.1f",
+				  frame, self:getFrameCount(), self.bytes, self.keyframeBytes, captureSeconds * 1000000,
+				  (self.captureSeconds * 1000000) / self.captureCount, self.maxCaptureSeconds * 1000000)
+	end
+
+	return true
+end
+function Rewind:readFrame(frame)
+	local record = self.simulation:decodeSave(client.decompress(self.frames[frame].data))
+	if type(record) ~= "table" then
+		log.error("failed to decode rewind record, frame=%d", frame)
+		return nil
+	end
+
+	return record
+end
+-- replaces simulation.state with the state captured at the end of the given frame; the frames after it are dropped,
+-- as stepping again from it replaces them
+function Rewind:restore(frame)
+	log.debug("frame=%d", frame)
+
+	local startTimeSeconds = os.clock()
+
+	if (frame < self.firstFrame) or (frame > self.lastFrame) then
+		log.warn("frame is not in the rewind buffer, frame=%d, firstFrame=%d, lastFrame=%d",
+				 frame, self.firstFrame, self.lastFrame)
+		return false
+	end
+
+	local keyframe = self.frames[frame].keyframe
+	local keyframeRecord = self:readFrame(keyframe)
+	if keyframeRecord == nil then
+		return false
+	end
+
+	local state = keyframeRecord.state
+	if frame ~= keyframe then
+		local record = self:readFrame(frame)
+		if record == nil then
+			return false
+		end
+
+		self.simulation:broadcast("onRewindApply", false, record, state)
+		state = record.state
+	end
+
+	for droppedFrame = frame + 1, self.lastFrame do
+		self.bytes = self.bytes - #self.frames[droppedFrame].data
+		self.frames[droppedFrame] = nil
+	end
+	self.frame = frame
+	self.lastFrame = frame
+
+	-- the next frame captured is a keyframe, as the changes tracked since this frame's keyframe were lost
+	self.keyframe = nil
+
+	-- journal records only hold changes since the last save, which no longer match the world
+	self.simulation.state = state
+	self.simulation.private.saveJournal = nil
+	self.simulation:broadcast("onRewind", false, frame)
+
+	self.restoreSeconds = os.clock() - startTimeSeconds
+	log.debug("restored, frame=%d, restoreMicroseconds=%.1f", frame, self.restoreSeconds * 1000000)
+
+	return true
+end
+function Rewind:onInit(simulation)
+	self.simulation = simulation
+	self.entitySys = self.simulation:addSystem(Entity)
+
+	-- capturing costs time every step, so frames are only captured while developer debugging or when enabled
+	local constants = self.simulation.constants
+	constants.rewindEnabled = false
+	constants.rewindMaxFrames = 600
+	constants.rewindMaxBytes = 16 * 1024 * 1024
+	constants.rewindKeyframeFrames = 60
+
+	self.frame = 0
+	self.captureCount = 0
+	self.captureSeconds = 0
+	self.maxCaptureSeconds = 0
+	self.restoreSeconds = 0
+	self:reset()
+end
+function Rewind:onWorldInit()
+	self:reset()
+end
+function Rewind:onLoadState()
+	self:reset()
+end
+function Rewind:onStepEnd()
+	local constants = self.simulation.constants
+	if constants.rewindEnabled or constants.developerDebugging then
+		self:capture()
+	end
+end
+function Rewind:onRunTests()
+	local constants = self.simulation.constants
+	local enabledBackup = constants.rewindEnabled
+	local keyframeFramesBackup = constants.rewindKeyframeFrames
+	local maxFramesBackup = constants.rewindMaxFrames
+	constants.rewindEnabled = true
+	constants.rewindKeyframeFrames = 4
+
+	-- creates, moves, changes and destroys entities differently each step
+	local entitySys = self.entitySys
+	local function stepTest(i)
+		local created = entitySys:create()
+		entitySys:setBounds(created, (i * 8) % 128, i * 4, 8, 8)
+		entitySys:tag(created, "rewindTest")
+
+		for _, entity in ipairs(entitySys:findAll("rewindTest")) do
+			entitySys:movePos(entity, 1, i % 2)
+			entity.rewindSteps = (entity.rewindSteps or 0) + 1
+			entitySys:invalidate(entity)
+		end
+
+		if (i % 3) == 0 then
+			entitySys:destroy(entitySys:find("rewindTest"))
+		end
+
+		self.simulation:step()
+	end
+
+	self:reset()
+	local states = {}
+	for i = 1, 12 do
+		stepTest(i)
+		states[i] = util.deepcopy(self.simulation.state)
+	end
+	log.assert(self:getFrameCount() == 12)
+
+	-- restoring a frame, then stepping again, reproduces the same states
+	local restoreFrame = self.firstFrame + 5
+	log.assert(self:restore(restoreFrame))
+	log.assert(self.lastFrame == restoreFrame)
+	log.assert(util.tableDeepEquals(self.simulation.state, states[6]))
+	for i = 7, 12 do
+		stepTest(i)
+		log.assert(util.tableDeepEquals(self.simulation.state, states[i]))
+	end
+
+	log.assert(self:restore(self.firstFrame + 3))
+	log.assert(util.tableDeepEquals(self.simulation.state, states[4]))
+
+	-- the oldest keyframes are dropped once there are too many frames, but never the current one
+	constants.rewindMaxFrames = 6
+	for i = 1, 12 do
+		stepTest(i)
+	end
+	log.assert(self:getFrameCount() <= (constants.rewindMaxFrames + constants.rewindKeyframeFrames))
+	log.assert(self.frames[self.firstFrame].keyframe == self.firstFrame)
+	log.assert(self:restore(self.firstFrame))
+
+	constants.rewindEnabled = enabledBackup
+	constants.rewindKeyframeFrames = keyframeFramesBackup
+	constants.rewindMaxFrames = maxFramesBackup
+end
+function Rewind:onRunBenchmarks()
+	local entitySys = self.entitySys
+	local entities = {}
+	for i = 1, 10000 do
+		local entity = entitySys:create()
+		entitySys:setBounds(entity, (i % 100) * 8, math.floor(i / 100) * 8, 8, 8)
+		entitySys:tag(entity, "rewindBenchmark")
+		entities[i] = entity
+	end
+
+	local function captureKeyframe()
+		self.keyframe = nil
+		self:capture()
+	end
+	local movedCount = 100
+	local function moveAndCapture()
+		for i = 1, movedCount do
+			entitySys:movePos(entities[i], 1, 0)
+		end
+		self:capture()
+	end
+
+	self:reset()
+	local iterations = 20
+	util.benchmark(string.format("rewind keyframe, entities=%d", #entities), iterations, captureKeyframe)
+	util.benchmark(string.format("rewind frame, entities=%d, movedEntities=%d", #entities, movedCount),
+		iterations, moveAndCapture)
+	log.info("bytes=%d, keyframeBytes=%d, frameBytes=%d", self.bytes, self.keyframeBytes, self.lastFrameBytes)
+	util.benchmark(string.format("rewind restore, entities=%d", #entities), iterations, self.restore, self,
+		self.lastFrame)
+
+	return 1
+end
+
+return Rewind
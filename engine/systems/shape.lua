@@ -3,6 +3,13 @@ local log = require("engine/util/log")
 local client = require("engine/client/client")
 local Sprite = require("engine/systems/sprite")
 
+local function setLineVertices(vertices, first, x1, y1, x2, y2)
+	vertices[first].x = x1
+	vertices[first].y = y1
+	vertices[first + 1].x = x2
+	vertices[first + 1].y = y2
+end
+
 local Shape = {}
 Shape.SYSTEM_NAME = "shape"
 function Shape:drawPoint(renderable, camera)
@@ -19,7 +26,7 @@ function Shape:drawRect(renderable, camera, outline)
 		log.assert(renderable.x2 ~= nil)
 		log.assert(renderable.y2 ~= nil)
 
-		renderable = util.deepcopy(renderable)
+		renderable = util.tableCopyInto(self.rectRenderable, renderable)
 		renderable.x = renderable.x1
 		renderable.y = renderable.y1
 		renderable.w = renderable.x2 - renderable.x1
@@ -39,25 +46,36 @@ function Shape:drawRect(renderable, camera, outline)
 		return
 	end
 
-	local srcRenderable = renderable
-	renderable = util.deepcopy(srcRenderable)
-
-	renderable.h = 0
-	client.drawLine(renderable, self.untexturedSprite, camera)
-
-	renderable.y = renderable.y + srcRenderable.h - 1
-	client.drawLine(renderable, self.untexturedSprite, camera)
-
-	renderable.y = renderable.y - srcRenderable.h + 1
-	renderable.h = srcRenderable.h
-
-	renderable.w = 0
-	renderable.y = renderable.y + 1
-	renderable.h = renderable.h - 2
-	client.drawLine(renderable, self.untexturedSprite, camera)
+	-- the outline's four lines are submitted in one call, through the client's vertex array api
+	local sprite = self.untexturedSprite
+	local x = renderable.x + (renderable.offsetX or 0)
+	local y = renderable.y + (renderable.offsetY or 0)
+	local w = renderable.w
+	local h = renderable.h
+	local vertices = self.outlineVertices
+	setLineVertices(vertices, 0, x, y, x + w, y)
+	setLineVertices(vertices, 2, x, y + h - 1, x + w, y + h - 1)
+	setLineVertices(vertices, 4, x, y + 1, x, y + h - 1)
+	setLineVertices(vertices, 6, x + w - 1, y + 1, x + w - 1, y + h - 1)
+
+	local z = renderable.z or 0
+	local r = renderable.r or sprite.r
+	local g = renderable.g or sprite.g
+	local b = renderable.b or sprite.b
+	local a = renderable.a or sprite.a
+	for i = 0, 7 do
+		local vertex = vertices[i]
+		vertex.z = z
+		vertex.r = r
+		vertex.g = g
+		vertex.b = b
+		vertex.a = a
+		vertex.u = ((i % 2) == 0) and sprite.u1 or sprite.u2
+		vertex.v = ((i % 2) == 0) and sprite.v1 or sprite.v2
+	end
 
-	renderable.x = renderable.x + srcRenderable.w - 1
-	client.drawLine(renderable, self.untexturedSprite, camera)
+	client.drawPrimitives(
+		vertices, 4, client.PRIMITIVE_TYPE_LINES, renderable.textureId or sprite.textureId, camera)
 end
 function Shape:drawTriangle(renderable, camera)
 	client.drawTriangle(renderable, self.untexturedSprite, camera)
@@ -67,6 +85,10 @@ function Shape:onInit(simulation)
 	self.spriteSys = self.simulation:addSystem(Sprite)
 
 	self.untexturedSprite = self.spriteSys:getUntextured()
+
+	-- reused by drawRect() rather than copying renderables each call
+	self.rectRenderable = {}
+	self.outlineVertices = client.newVertices(4 * client.primitiveVertexCounts[client.PRIMITIVE_TYPE_LINES])
 end
 
 
@@ -123,6 +145,15 @@ function Shape:onRunTests()
 	self:drawRect(testRect, screen, --[[outline--]] false)
 	self:drawRect(testRect, screen, --[[outline--]] true)
 
+	-- top, bottom, left and right edges; the left and right skip the corners the top and bottom draw
+	local expectedOutline = {8, 8, 16, 8, 8, 15, 16, 15, 8, 9, 8, 15, 15, 9, 15, 15}
+	for i = 0, 7 do
+		local vertex = self.outlineVertices[i]
+		log.assert(vertex.x == expectedOutline[(i * 2) + 1])
+		log.assert(vertex.y == expectedOutline[(i * 2) + 2])
+		log.assert((vertex.z == -3) and (vertex.r == 1) and (vertex.g == 0) and (vertex.a == 1))
+	end
+
 	local testPoint = {
 		["x"] = 8,
 		["y"] = 16,
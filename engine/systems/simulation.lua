@@ -7,6 +7,7 @@ Simulation.__index = Simulation
 Simulation.SYSTEM_NAME = "simulation"
 Simulation.DUMP_FILE = "./game_dump.json"
 Simulation.SAVE_FILE = "./game_save.sav"
+Simulation.SAVE_JOURNAL_SUFFIX = ".journal"
 function Simulation:broadcast(event, tolerate_errors, ...)
 	for _, system in ipairs(self.private.eventListeners) do
 		local eventHandler = system[event]
@@ -74,6 +75,9 @@ function Simulation:step()
 	self.input.fps = client.state.fps
 
 	self:broadcast("onStep", true)
+
+	-- for systems that need the state after every system has stepped, such as rewind
+	self:broadcast("onStepEnd", true)
 end
 function Simulation:draw()
 	log.trace("")
@@ -84,6 +88,10 @@ function Simulation:worldInit()
 	log.debug("")
 
 	self.state.world = {}
+
+	-- journal records only hold changes to the world, so the next save after replacing it must be a full save
+	self.private.saveJournal = nil
+
 	self:broadcast("onWorldInit", false)
 end
 function Simulation:init()
@@ -118,42 +126,249 @@ function Simulation:stop()
 
 	client.step()
 end
+function Simulation:encodeSave(save)
+	-- the headless client has no native encoder, so it always saves json
+	if self.constants.saveEncoded and not client.state.headless then
+		return client.encode(save)
+	end
+	return util.json.encode(save)
+end
+function Simulation:decodeSave(saveStr)
+	-- saves from before saveVersion 2, and from the headless client, are json
+	if client.getEncoded(saveStr) then
+		return client.decode(saveStr)
+	end
+	return util.json.decode(saveStr)
+end
+function Simulation:getJournalFilename(filename)
+	return filename..self.SAVE_JOURNAL_SUFFIX
+end
+-- saves after the first only write what changed to a journal next to the save, which is compacted into a new save
+-- once it has too many records or grows larger than the save itself
 function Simulation:save(filename)
 	log.debug("filename=%s", filename)
 
+	local journal = self.private.saveJournal
+	if ((journal == nil)
+		or (journal.filename ~= filename)
+		or (journal.recordCount >= self.constants.saveJournalMaxRecords)
+		or (journal.bytes >= journal.saveBytes)) then
+		return self:saveSnapshot(filename)
+	end
+
+	return self:saveJournal(journal)
+end
+function Simulation:saveSnapshot(filename)
+	log.debug("filename=%s", filename)
+
+	-- unique across runs, so journal records left over from an earlier save are never applied to this one
+	self.private.saveCount = self.private.saveCount + 1
+	local generation = string.format("%d.%d.%d", os.time(), math.floor(os.clock() * 1000000), self.private.saveCount)
+
 	local save = {
 		["saveVersion"] = self.constants.saveVersion,
+		["saveGeneration"] = generation,
 		["state"] = self.state,
 	}
 
-	if not client.writeData(filename, util.json.encode(save)) then
-		log.error("client.writeData() failed")
+	local saveStr = self:encodeSave(save)
+	if not saveStr then
+		log.error("failed to encode save")
+		return false
+	end
+
+	-- compressed and written off the main thread; failures are reported once the write completes
+	local function onSaveWritten(ok)
+		if not ok then
+			log.error("client.writeDataAsync() failed, filename=%s", filename)
+		end
+	end
+	if not client.writeDataAsync(filename, saveStr, onSaveWritten) then
+		log.error("client.writeDataAsync() failed")
+		self.private.saveJournal = nil
 		return false
 	end
 
+	self.private.saveJournal = {
+		["filename"] = filename,
+		["generation"] = generation,
+		["recordCount"] = 0,
+		["bytes"] = 0,
+		["saveBytes"] = #saveStr,
+	}
+	self:broadcast("onSaveState", false)
+
 	return true
 end
-function Simulation:load(filename)
-	log.info("filename=%s", filename)
+-- everything but the world is small, and recorded whole; systems replace what they track in the world with changes
+function Simulation:getShallowState()
+	local state = {}
+	for key, value in pairs(self.state) do
+		state[key] = value
+	end
+	state.world = {}
+	for key, value in pairs(self.state.world) do
+		state.world[key] = value
+	end
+
+	return state
+end
+function Simulation:saveJournal(journal)
+	local journalFilename = self:getJournalFilename(journal.filename)
+	log.debug("journalFilename=%s, recordCount=%d", journalFilename, journal.recordCount)
+
+	local record = {
+		["saveGeneration"] = journal.generation,
+		["saveSequence"] = journal.recordCount + 1,
+		["state"] = self:getShallowState(),
+	}
+	self:broadcast("onSaveJournal", false, record)
+
+	local recordStr = self:encodeSave(record)
+	if not recordStr then
+		log.error("failed to encode journal record")
+		self.private.saveJournal = nil
+		return false
+	end
+
+	-- records are length prefixed, and newline terminated so that client.readData() never mistakes a record's last
+	-- byte for a null terminator.  the first record after a save replaces the journal instead of appending to it
+	local framedRecordStr = string.format("%d\n", #recordStr)..recordStr.."\n"
+	local append = journal.recordCount > 0
+	local function onJournalWritten(ok)
+		if not ok then
+			log.error("client.writeDataAsync() failed, filename=%s", journalFilename)
+			if self.private.saveJournal == journal then
+				self.private.saveJournal = nil
+			end
+		end
+	end
+	if not client.writeDataAsync(journalFilename, framedRecordStr, onJournalWritten, append) then
+		log.error("client.writeDataAsync() failed")
+		self.private.saveJournal = nil
+		return false
+	end
+
+	journal.recordCount = journal.recordCount + 1
+	journal.bytes = journal.bytes + #framedRecordStr
+
+	return true
+end
+function Simulation:readJournal(journal, state)
+	local journalFilename = self:getJournalFilename(journal.filename)
+	if not client.getDataExists(journalFilename) then
+		return state
+	end
+
+	local journalStr = client.readData(journalFilename)
+	if not journalStr then
+		return state
+	end
+
+	-- records are applied in order, stopping at the first that is incomplete or missing.  the c client null
+	-- terminates the first record written, which is skipped over
+	local pos = 1
+	while true do
+		local recordSize, recordPos = string.match(journalStr, "^%z*(%d+)\n()", pos)
+		if recordSize == nil then
+			break
+		end
+
+		local recordEnd = recordPos + tonumber(recordSize) - 1
+		if string.sub(journalStr, recordEnd + 1, recordEnd + 1) ~= "\n" then
+			log.warn("journal record is truncated, journalFilename=%s", journalFilename)
+			break
+		end
+		pos = recordEnd + 2
+
+		local decoded, record = pcall(self.decodeSave, self, string.sub(journalStr, recordPos, recordEnd))
+		if not decoded or (type(record) ~= "table") then
+			log.warn("failed to decode journal record, journalFilename=%s", journalFilename)
+			break
+		end
+
+		-- records from before the save was last compacted are skipped
+		if record.saveGeneration == journal.generation then
+			if record.saveSequence ~= (journal.recordCount + 1) then
+				log.warn("journal record is out of sequence, journalFilename=%s", journalFilename)
+				break
+			end
+
+			self:broadcast("onLoadJournal", false, record, state)
+			state = record.state
 
+			journal.recordCount = journal.recordCount + 1
+			journal.bytes = pos - 1
+		end
+	end
+
+	log.debug("journalFilename=%s, recordCount=%d", journalFilename, journal.recordCount)
+
+	return state
+end
+-- returns the saved state with its journal replayed, and the journal to continue saving to, without loading them
+function Simulation:readSave(filename)
 	local loadedSaveStr = client.readData(filename)
 	if not loadedSaveStr then
-		return false
+		return
 	end
 
-	local loadedSave = util.json.decode(loadedSaveStr)
+	local loadedSave = self:decodeSave(loadedSaveStr)
+	if type(loadedSave) ~= "table" then
+		log.error("failed to decode save, filename=%s", filename)
+		return
+	end
 
 	if loadedSave.saveVersion and (loadedSave.saveVersion > self.constants.saveVersion) then
 		log.error("save version is too new, saveVersion=%d, save.saveVersion=%d",
 				   self.constants.saveVersion, loadedSave.saveVersion)
-		return false
+		return
 	end
 	if loadedSave.saveVersion and (loadedSave.saveVersion < self.constants.saveVersion) then
 		log.info("save version is older, saveVersion=%d, save.saveVersion=%d",
 				   self.constants.saveVersion, loadedSave.saveVersion)
 	end
 
-	self.state = loadedSave.state
+	-- saves from before saveVersion 3 have no journal; the next save of one is a full save
+	local state = loadedSave.state
+	local journal = nil
+	if loadedSave.saveGeneration ~= nil then
+		journal = {
+			["filename"] = filename,
+			["generation"] = loadedSave.saveGeneration,
+			["recordCount"] = 0,
+			["bytes"] = 0,
+			["saveBytes"] = #loadedSaveStr,
+		}
+		state = self:readJournal(journal, state)
+	end
+
+	return state, journal
+end
+-- whether the save, replayed from its snapshot and journal, equals a full snapshot of the current state; the
+-- snapshot is written next to the save, and the next save of it is a full save
+function Simulation:getSaveMatchesSnapshot(filename)
+	local journaledState, journal = self:readSave(filename)
+	local snapshotFilename = filename..".snapshot"
+	local matches = (
+		(journaledState ~= nil)
+		and self:saveSnapshot(snapshotFilename)
+		and util.tableDeepEquals(journaledState.world, self:readSave(snapshotFilename).world)
+	)
+	os.remove(snapshotFilename)
+
+	return matches, journal
+end
+function Simulation:load(filename)
+	log.info("filename=%s", filename)
+
+	local state, journal = self:readSave(filename)
+	if state == nil then
+		return false
+	end
+
+	self.state = state
+	self.private.saveJournal = journal
 	self:broadcast("onLoadState", false)
 
 	return true
@@ -176,18 +391,55 @@ end
 function Simulation:onRunTests()
 	self:init()
 
-	local gameBeforeSave = util.getComparable(self.state.world)
+	-- read back without loading, as systems may replace the world when a save is loaded
 	log.assert(self:dump("test_dump.sav"))
 	log.assert(self:save("test_save.sav"))
-	log.assert(self:load("test_save.sav"))
+	local loadedState = self:readSave("test_save.sav")
 	os.remove("test_dump.sav")
 	os.remove("test_save.sav")
 
-	local gameAfterLoad = util.getComparable(self.state.world)
-	if gameBeforeSave ~= gameAfterLoad then
+	if not util.tableDeepEquals(self.state.world, loadedState.world) then
 		log.error("Mismatched state before save and after load: before=%s, after=%s",
-				   gameBeforeSave, gameAfterLoad)
+				   util.getComparable(self.state.world), util.getComparable(loadedState.world))
+	end
+
+	-- a save replayed from its snapshot and journal must equal a full snapshot.  entities are changed between saves,
+	-- and every system is stepped.  the world is made big enough that its journal is not compacted into a new save
+	local saveFilename = "test_journal_save.sav"
+	local entitySys = self:getSystem("entity")
+	local entities = {}
+	for i = 1, 256 do
+		entities[i] = entitySys:create()
+		entitySys:setBounds(entities[i], i * 8, 0, 8, 8)
+	end
+	log.assert(self:save(saveFilename))
+	local changedCount = 8
+	for i = 1, changedCount do
+		local entity = entities[i]
+		entitySys:setPos(entity, entity.x, i)
+		entity.journalTestStep = i
+		entitySys:invalidate(entity)
+		if (i % 3) == 0 then
+			entitySys:destroy(entity)
+		end
+
+		self:broadcast("onStep", true)
+		log.assert(self:save(saveFilename))
 	end
+	local matches, journal = self:getSaveMatchesSnapshot(saveFilename)
+	log.assert(matches)
+	log.assert(journal.recordCount == changedCount)
+
+	-- records from before the latest snapshot have an older generation, and are skipped
+	log.assert(self:saveSnapshot(saveFilename))
+	journal = select(2, self:readSave(saveFilename))
+	log.assert(journal.recordCount == 0)
+	log.assert(self:save(saveFilename))
+	journal = select(2, self:readSave(saveFilename))
+	log.assert(journal.recordCount == 1)
+
+	os.remove(saveFilename)
+	os.remove(self:getJournalFilename(saveFilename))
 end
 function Simulation:runTests()
 	if not client.state.testsEnabled then
@@ -201,6 +453,10 @@ function Simulation:runTests()
 	local testSuitesCount = 0
 	local startTimeSeconds = os.clock()
 
+	-- saving and loading are tested with every system the app has added
+	log.info("running tests for %s", self.SYSTEM_NAME)
+	testSuitesCount = testSuitesCount + (self:onRunTests() or 1)
+
 	for _, system in pairs(self.private.systems) do
 		if system.onRunTests and system.SYSTEM_NAME ~= "simulation" then
 			log.info("running tests for %s", system.SYSTEM_NAME)
@@ -217,6 +473,27 @@ function Simulation:runTests()
 	log.info("complete, testSuitesCount=%d, testTimeSeconds=%.2f",
 				  testSuitesCount, testTimeSeconds)
 end
+function Simulation:runBenchmarks()
+	log.info("starting")
+
+	local benchmarkSuitesCount = 0
+	local startTimeSeconds = os.clock()
+
+	for _, system in pairs(self.private.systems) do
+		if system.onRunBenchmarks and system.SYSTEM_NAME ~= "simulation" then
+			log.info("running benchmarks for %s", system.SYSTEM_NAME)
+
+			self:init()
+			benchmarkSuitesCount = benchmarkSuitesCount + (system:onRunBenchmarks() or 1)
+		end
+	end
+
+	local endTimeSeconds = os.clock()
+	local benchmarkTimeSeconds = endTimeSeconds - startTimeSeconds
+
+	log.info("complete, benchmarkSuitesCount=%d, benchmarkTimeSeconds=%.2f",
+				  benchmarkSuitesCount, benchmarkTimeSeconds)
+end
 function Simulation:run(...)
 	local startTimeSeconds = os.clock()
 
@@ -235,6 +512,11 @@ function Simulation:run(...)
 	local function runInternal()
 		self:runTests()
 
+		if util.tableHasValue(self.private.args, "--benchmark") then
+			self:runBenchmarks()
+			return
+		end
+
 		self:init()
 		self:start()
 
@@ -274,11 +556,20 @@ function Simulation.new()
 			["args"] = {},
 			["startTimeSeconds"] = 0,
 			["endTimeSeconds"] = 0,
+			-- the save being journaled to, see Simulation:save()
+			["saveJournal"] = nil,
+			["saveCount"] = 0,
 		},
 
 		-- Constants defining the behavior of the simulation
 		["constants"] = {
-			["saveVersion"] = 1,
+			-- 2: saves are encoded with client.encode() when saveEncoded is set
+			-- 3: saves have a saveGeneration, and may be followed by a journal of changes
+			-- 4: entity chunks are no longer saved, as they are rebuilt from entity bounds
+			-- 5: entity component fields are saved in world.componentColumns instead of in entities
+			["saveVersion"] = 5,
+			["saveEncoded"] = true,
+			["saveJournalMaxRecords"] = 64,
 			["developerDebugging"] = false,
 		},
 
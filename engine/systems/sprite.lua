@@ -6,7 +6,36 @@ local Camera = require("engine/systems/camera")
 
 local Sprite = {}
 Sprite.SYSTEM_NAME = "sprite"
-function Sprite:addSprite(spriteId, u, v, w, h, r, g, b, a)
+Sprite.STATIC_LAYER_ID = 0
+Sprite.DEFAULT_TEXTURE_ID = 0
+Sprite.STATIC_TAGS = {"spriteStatic", "sprite"}
+Sprite.DYNAMIC_TAGS = {"sprite"}
+Sprite.DYNAMIC_EXCLUDED_TAGS = {"spriteStatic"}
+Sprite.loadedTextures = {}
+-- texture 0 is the sprites image the client was started with; games can load extra atlases to split up their art
+function Sprite:loadTexture(filename)
+	log.trace("filename=%s", filename)
+
+	if client.state.headless then
+		return self.DEFAULT_TEXTURE_ID
+	end
+
+	local textureId = self.loadedTextures[filename]
+	if textureId ~= nil then
+		return textureId
+	end
+
+	local success
+	success, textureId = client.loadTexture({["filename"] = filename})
+	if not success then
+		log.error("failed to load texture, filename=%s", filename)
+		return self.DEFAULT_TEXTURE_ID
+	end
+
+	self.loadedTextures[filename] = textureId
+	return textureId
+end
+function Sprite:addSprite(spriteId, u, v, w, h, r, g, b, a, textureId)
 	local sprites = self.simulation.constants.sprites
 	local sprite = sprites[spriteId]
 	if sprite == nil then
@@ -20,6 +49,7 @@ function Sprite:addSprite(spriteId, u, v, w, h, r, g, b, a)
 			["g"] = g or 1,
 			["b"] = b or 1,
 			["a"] = a or 1,
+			["textureId"] = textureId or self.DEFAULT_TEXTURE_ID,
 		}
 		sprites[spriteId] = sprite
 	end
@@ -42,6 +72,11 @@ function Sprite:getInvalid()
 end
 function Sprite:attach(entity, sprite)
 	entity.spriteId = sprite.spriteId
+	self.entitySys:invalidate(entity)
+
+	if entity.tags.spriteStatic then
+		self:invalidateStatic()
+	end
 
 	self.entitySys:tag(entity, "sprite")
 end
@@ -49,6 +84,41 @@ function Sprite:detach(entity)
 	self.entitySys:untag(entity, "sprite")
 	entity.spriteId = nil
 end
+-- static sprites are drawn from a layer retained by the client, which is only rebuilt after they change.
+-- translucent ones are still resubmitted by the client every frame, so that they blend over what is behind them.
+-- tagging, untagging and destroying them invalidates the layer; anything else that changes how one is drawn
+-- (moving it, changing its color, etc) must call invalidateStatic()
+function Sprite:setStatic(entity, static)
+	if static then
+		self.entitySys:tag(entity, "spriteStatic")
+	else
+		self.entitySys:untag(entity, "spriteStatic")
+	end
+end
+function Sprite:invalidateStatic()
+	self.staticDirty = true
+end
+function Sprite:drawStatic(camera)
+	if self.staticDirty then
+		local sprites = self.simulation.constants.sprites
+
+		client.beginLayer(self.STATIC_LAYER_ID)
+		-- entities that were untagged from "sprite" have no spriteId, so only those with both tags are drawn
+		local staticEntities = self.staticEntities
+		self.entitySys:findAllWithInto(staticEntities, self.STATIC_TAGS)
+		client.drawSprites(staticEntities, sprites, self.staticLayerCamera)
+		client.endLayer()
+
+		self.staticDirty = false
+	end
+
+	client.drawLayer(self.STATIC_LAYER_ID, camera)
+end
+function Sprite:onEntityTag(entity, tag)
+	if (tag == "spriteStatic") or ((tag == "sprite") and entity.tags.spriteStatic) then
+		self:invalidateStatic()
+	end
+end
 function Sprite:onInit(simulation)
 	self.simulation = simulation
 	self.entitySys = self.simulation:addSystem(Entity)
@@ -58,24 +128,53 @@ function Sprite:onInit(simulation)
 	self.simulation.constants.untexturedSprite = self:addSprite("flatColor", 0, 0, 0, 0)
 
 	self.simulation.constants.invalidSprite = self:addSprite("invalid", 8, 0, 8, 8)
+
+	-- static sprites are retained in world coords; the camera offset is applied when the layer is drawn
+	self.staticLayerCamera = {
+		["x1"] = 0,
+		["y1"] = 0,
+		["x2"] = 0,
+		["y2"] = 0,
+	}
+	self.staticDirty = true
+
+	-- reused each draw, rather than allocating a new list of entities every frame
+	self.drawEntities = {}
+	self.staticEntities = {}
+end
+function Sprite:onWorldInit()
+	self:invalidateStatic()
+end
+function Sprite:onLoadState()
+	self:invalidateStatic()
+end
+function Sprite:onRewind()
+	self:invalidateStatic()
 end
 function Sprite:onCameraDraw(camera)
 	local sprites = self.simulation.constants.sprites
+	local entities = self.drawEntities
+	-- all sprites are submitted in one call; static sprites are excluded as they are drawn from their layer
+	self.entitySys:findAllWithInto(entities, self.DYNAMIC_TAGS, self.DYNAMIC_EXCLUDED_TAGS)
 
-	for _, entity in ipairs(self.entitySys:findAll("sprite")) do
-		local sprite = sprites[entity.spriteId]
-		if sprite then
-			client.drawSprite(entity, sprite, camera)
-		else
-			log.error("invalid spriteId, entity=%s", util.getComparable(entity))
+	local missingCount = client.drawSprites(entities, sprites, camera)
+	if missingCount > 0 then
+		for _, entity in ipairs(entities) do
+			if sprites[entity.spriteId] == nil then
+				log.error("invalid spriteId, entity=%s", util.getComparable(entity))
+			end
 		end
 	end
+
+	self:drawStatic(camera)
 end
 function Sprite:onRunTests()
 	local entity = self.entitySys:create()
 	local testSprite = self:addSprite("test", 40, 0, 8, 8)
 
 	log.assert(self:get("test") == testSprite)
+	log.assert(testSprite.textureId == self.DEFAULT_TEXTURE_ID)
+	log.assert(self:addSprite("testTextured", 0, 0, 8, 8, nil, nil, nil, nil, 1).textureId == 1)
 
 	self:attach(entity, testSprite)
 	log.assert(entity.spriteId == "test")
@@ -83,6 +182,23 @@ function Sprite:onRunTests()
 
 	self.simulation:draw()
 
+	local sprites = self.simulation.constants.sprites
+	local missingEntity = {["tags"] = {}, ["spriteId"] = "missing"}
+	log.assert(client.drawSprites({entity, missingEntity}, sprites, self.staticLayerCamera) == 1)
+	log.assert(client.drawSprites({entity, missingEntity}, sprites, self.staticLayerCamera, "sprite") == 1)
+	log.assert(client.drawSprites({entity}, sprites, self.staticLayerCamera) == 0)
+
+	self:setStatic(entity, true)
+	log.assert(entity.tags.spriteStatic)
+	log.assert(self.staticDirty)
+	self.simulation:draw()
+	log.assert(not self.staticDirty)
+
+	self:setStatic(entity, false)
+	log.assert(entity.tags.spriteStatic == nil)
+	log.assert(self.staticDirty)
+	self.simulation:draw()
+
 	self:detach(entity, testSprite)
 	log.assert(entity.spriteId == nil)
 	log.assert(entity.tags.sprite == nil)
@@ -45,6 +45,7 @@ function Template:apply(entity, template)
 		local h = entity.h
 
 		util.tableExtend(entity, templateProperties)
+		entitySys:invalidate(entity)
 
 		-- restore fields that cannot be set by a template
 		entity.x = x
@@ -74,6 +74,7 @@ end
 function Text:attach(entity, font, text)
 	entity.fontId = font.fontId
 	entity.text = text
+	self.entitySys:invalidate(entity)
 	self.entitySys:tag(entity, "text")
 end
 function Text:detach(entity)
@@ -98,7 +99,7 @@ end
 function Text:onCameraDraw(camera)
 	local fonts = self.simulation.constants.fonts
 
-	for _, entity in ipairs(self.entitySys:findAll("text")) do
+	for _, entity in self.entitySys:iterate("text") do
 		local font = self:getDefaultFont()
 		if entity.fontId ~= nil then
 			local entityFont = fonts[entity.fontId]
@@ -31,6 +31,10 @@ local function logImpl(level, format, ...)
 		log.debugger()
 	end
 end
+-- for skipping work (e.g. util.getComparable()) done only to build the arguments of a log that would be dropped
+function log.getLevelEnabled(level)
+	return log.logLevel <= level
+end
 function log.trace(format, ...)
 	logImpl(log.LOG_LEVEL_TRACE, "[trace %s:%d] %s() "..format, ...)
 end
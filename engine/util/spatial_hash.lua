@@ -0,0 +1,243 @@
+-- lua version of the c client's spatial hash (core/spatial.c, bound by client.c:jeLua_newSpatialHash()), used by the
+-- headless client.
+-- entities are added to every cell their bounds overlap; cells are keyed by number rather than string, and keep
+-- entity ids in the order they were added, so that both versions return query results in the same order
+local FLOAT_EPSILON = 1.19e-07
+-- cell keys are (cellY * CELL_KEY_STRIDE) + cellX, which are unique while cellX is within +/- 2^25
+local CELL_KEY_STRIDE = 2 ^ 26
+local mathFloor = math.floor
+local mathAbs = math.abs
+
+-- mirrors util.rectCollides()
+local function getEntityCollides(entity, x, y, w, h)
+	return ((x < (entity.x + entity.w)) and ((x + w) > entity.x)
+		and (y < (entity.y + entity.h)) and ((y + h) > entity.y)
+		and (w > 0) and (h > 0) and (entity.w > 0) and (entity.h > 0))
+end
+-- returns the first step (from 1) that the bounds collide with the entity, or nil if none do.  the step is estimated
+-- from the entity's position on the moving axis, then confirmed with the same test as queries, so that rounding never
+-- changes the result
+local function getEntitySweepStep(entity, x, y, w, h, signX, signY, steps)
+	local movingX = (signX ~= 0)
+	local sign = signX + signY
+	local position, size, entityPosition, entitySize = y, h, entity.y, entity.h
+	if movingX then
+		position, size, entityPosition, entitySize = x, w, entity.x, entity.w
+	end
+
+	local lastFreeStep = position - entityPosition - entitySize
+	local pastLastStep = position + size - entityPosition
+	if sign > 0 then
+		lastFreeStep = entityPosition - position - size
+		pastLastStep = entityPosition + entitySize - position
+	end
+	local firstStep = mathFloor(lastFreeStep) + 1
+	if firstStep > steps then
+		return nil
+	end
+
+	local step = math.max(1, firstStep)
+	while (step > 1) and getEntityCollides(entity, x + (signX * (step - 1)), y + (signY * (step - 1)), w, h) do
+		step = step - 1
+	end
+	while ((step <= steps) and (step <= (pastLastStep + 1))
+		   and not getEntityCollides(entity, x + (signX * step), y + (signY * step), w, h)) do
+		step = step + 1
+	end
+
+	if (step <= steps) and getEntityCollides(entity, x + (signX * step), y + (signY * step), w, h) then
+		return step
+	end
+	return nil
+end
+
+local SpatialHash = {}
+SpatialHash.__index = SpatialHash
+function SpatialHash:getCellBounds(x, y, w, h)
+	local cellSize = self.cellSize
+	local cellX1 = mathFloor(x / cellSize)
+	local cellY1 = mathFloor(y / cellSize)
+	local cellX2 = mathFloor((x + w - FLOAT_EPSILON) / cellSize)
+	local cellY2 = mathFloor((y + h - FLOAT_EPSILON) / cellSize)
+	if w <= 0 then
+		cellX2 = cellX1 - 1
+	end
+	if h <= 0 then
+		cellY2 = cellY1 - 1
+	end
+
+	return cellX1, cellY1, cellX2, cellY2
+end
+function SpatialHash:removeCellEntity(cellKey, entityId)
+	local cell = self.cells[cellKey]
+	local cellCount = #cell
+	for i = 1, cellCount do
+		if cell[i] == entityId then
+			cell[i] = cell[cellCount]
+			cell[cellCount] = nil
+			return
+		end
+	end
+end
+function SpatialHash:insert(entityId, x, y, w, h)
+	local entity = self.entities[entityId]
+	if entity == nil then
+		entity = {["cellX1"] = 0, ["cellY1"] = 0, ["cellX2"] = -1, ["cellY2"] = -1}
+		self.entities[entityId] = entity
+	end
+
+	local cellX1, cellY1, cellX2, cellY2 = self:getCellBounds(x, y, w, h)
+	local oldCellX1 = entity.cellX1
+	local oldCellY1 = entity.cellY1
+	local oldCellX2 = entity.cellX2
+	local oldCellY2 = entity.cellY2
+
+	-- only cells entered or left are changed, so entities keep their place in the cells they stay in
+	for cellY = oldCellY1, oldCellY2 do
+		for cellX = oldCellX1, oldCellX2 do
+			if (cellX < cellX1) or (cellY < cellY1) or (cellX > cellX2) or (cellY > cellY2) then
+				self:removeCellEntity((cellY * CELL_KEY_STRIDE) + cellX, entityId)
+			end
+		end
+	end
+
+	local cells = self.cells
+	for cellY = cellY1, cellY2 do
+		for cellX = cellX1, cellX2 do
+			if (cellX < oldCellX1) or (cellY < oldCellY1) or (cellX > oldCellX2) or (cellY > oldCellY2) then
+				local cellKey = (cellY * CELL_KEY_STRIDE) + cellX
+				local cell = cells[cellKey]
+				if cell == nil then
+					cell = {}
+					cells[cellKey] = cell
+				end
+				cell[#cell + 1] = entityId
+			end
+		end
+	end
+
+	entity.x = x
+	entity.y = y
+	entity.w = w
+	entity.h = h
+	entity.cellX1 = cellX1
+	entity.cellY1 = cellY1
+	entity.cellX2 = cellX2
+	entity.cellY2 = cellY2
+end
+SpatialHash.move = SpatialHash.insert
+function SpatialHash:remove(entityId)
+	local entity = self.entities[entityId]
+	if entity == nil then
+		return
+	end
+
+	for cellY = entity.cellY1, entity.cellY2 do
+		for cellX = entity.cellX1, entity.cellX2 do
+			self:removeCellEntity((cellY * CELL_KEY_STRIDE) + cellX, entityId)
+		end
+	end
+
+	self.entities[entityId] = nil
+end
+-- writes the ids of entities colliding with the bounds to outEntityIds[1..n], and returns n
+function SpatialHash:query(x, y, w, h, outEntityIds, excludeEntityId)
+	local cellX1, cellY1, cellX2, cellY2 = self:getCellBounds(x, y, w, h)
+
+	-- entities in more than one cell are only returned once; each query marks the entities it returns
+	local queryId = self.queryId + 1
+	self.queryId = queryId
+	local queryIds = self.queryIds
+
+	local cells = self.cells
+	local entities = self.entities
+	local resultCount = 0
+	for cellY = cellY1, cellY2 do
+		for cellX = cellX1, cellX2 do
+			local cell = cells[(cellY * CELL_KEY_STRIDE) + cellX]
+			if cell ~= nil then
+				for i = 1, #cell do
+					local entityId = cell[i]
+					if (getEntityCollides(entities[entityId], x, y, w, h)
+						and (queryIds[entityId] ~= queryId) and (entityId ~= excludeEntityId)) then
+						queryIds[entityId] = queryId
+
+						resultCount = resultCount + 1
+						outEntityIds[resultCount] = entityId
+					end
+				end
+			end
+		end
+	end
+
+	return resultCount
+end
+-- moves the bounds one step at a time, up to moveX or moveY (integers, along one axis), and writes the ids of entities
+-- colliding with them at any step to outEntityIds[1..n] and the first step each collides at to outSteps[1..n].
+-- returns n
+function SpatialHash:sweep(x, y, w, h, moveX, moveY, outEntityIds, outSteps, excludeEntityId)
+	if (moveX ~= mathFloor(moveX)) or (moveY ~= mathFloor(moveY)) or ((moveX ~= 0) and (moveY ~= 0)) then
+		error("moves must be integers, along one axis")
+	end
+
+	local signX = ((moveX > 0) and 1) or ((moveX < 0) and -1) or 0
+	local signY = ((moveY > 0) and 1) or ((moveY < 0) and -1) or 0
+	local steps = mathAbs(moveX + moveY)
+	if steps == 0 then
+		return 0
+	end
+
+	-- every entity colliding with the bounds at any step collides with the bounds covering all steps
+	local sweptX = x + ((signX < 0) and moveX or signX)
+	local sweptY = y + ((signY < 0) and moveY or signY)
+	local sweptW = w + mathAbs(moveX) - (signX * signX)
+	local sweptH = h + mathAbs(moveY) - (signY * signY)
+	local cellX1, cellY1, cellX2, cellY2 = self:getCellBounds(sweptX, sweptY, sweptW, sweptH)
+
+	local queryId = self.queryId + 1
+	self.queryId = queryId
+	local queryIds = self.queryIds
+
+	local cells = self.cells
+	local entities = self.entities
+	local resultCount = 0
+	for cellY = cellY1, cellY2 do
+		for cellX = cellX1, cellX2 do
+			local cell = cells[(cellY * CELL_KEY_STRIDE) + cellX]
+			if cell ~= nil then
+				for i = 1, #cell do
+					local entityId = cell[i]
+					if (queryIds[entityId] ~= queryId) and (entityId ~= excludeEntityId) then
+						queryIds[entityId] = queryId
+
+						local entity = entities[entityId]
+						local step = getEntityCollides(entity, sweptX, sweptY, sweptW, sweptH)
+							and getEntitySweepStep(entity, x, y, w, h, signX, signY, steps)
+						if step then
+							resultCount = resultCount + 1
+							outEntityIds[resultCount] = entityId
+							outSteps[resultCount] = step
+						end
+					end
+				end
+			end
+		end
+	end
+
+	return resultCount
+end
+function SpatialHash:clear()
+	self.cells = {}
+	self.entities = {}
+	self.queryIds = {}
+end
+function SpatialHash.new(cellSize)
+	local spatialHash = setmetatable({}, SpatialHash)
+	spatialHash.cellSize = cellSize
+	spatialHash.queryId = 0
+	spatialHash:clear()
+
+	return spatialHash
+end
+
+return SpatialHash
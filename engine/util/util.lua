@@ -6,8 +6,40 @@ util.SYSTEM_NAME = "util"
 
 function util.noop()
 end
-function util.deepcopy(data)
-	return json.decode(json.encode(data))
+-- cycle-safe, and copies keys and values as-is rather than round tripping through json; metatables are not copied.
+-- this is the headless fallback; engine/client/client.lua swaps in the c client's client.deepcopy()
+function util.deepcopy(data, copies)
+	if type(data) ~= "table" then
+		return data
+	end
+
+	copies = copies or {}
+	local copy = copies[data]
+	if copy ~= nil then
+		return copy
+	end
+
+	copy = {}
+	copies[data] = copy
+	for key, value in pairs(data) do
+		copy[util.deepcopy(key, copies)] = util.deepcopy(value, copies)
+	end
+	return copy
+end
+
+function util.benchmark(label, iterations, fn, ...)
+	-- results are printed regardless of log level, as they are only produced when explicitly requested
+	local startTimeSeconds = os.clock()
+	for _ = 1, iterations do
+		fn(...)
+	end
+	local seconds = os.clock() - startTimeSeconds
+
+	print(string.format("[bench] %s: iterations=%d, total=%.3fms, average=%.3fus",
+		label, iterations, seconds * 1000, (seconds * 1000000) / math.max(iterations, 1)))
+	io.flush()
+
+	return seconds
 end
 
 function util.sign(x)
@@ -143,6 +175,18 @@ end
 function util.tableGetSorted(values)
 	return util.tableDeepSort(util.deepcopy(values))
 end
+-- shallow copies src into an existing dest, clearing the fields src lacks, so per-frame copies needn't allocate
+function util.tableCopyInto(dest, src)
+	for key, _ in pairs(dest) do
+		if src[key] == nil then
+			dest[key] = nil
+		end
+	end
+	for key, value in pairs(src) do
+		dest[key] = value
+	end
+	return dest
+end
 function util.tableExtend(dest, ...)
 	for i = 1, select("#", ...) do
 		local overrides = select(i, ...)
@@ -163,6 +207,25 @@ function util.tableExtend(dest, ...)
 
 	return dest
 end
+-- unlike comparing getComparable() strings, this does not depend on the order pairs() visits keys in
+function util.tableDeepEquals(a, b)
+	if (type(a) ~= "table") or (type(b) ~= "table") then
+		return a == b
+	end
+
+	for key, value in pairs(a) do
+		if not util.tableDeepEquals(value, b[key]) then
+			return false
+		end
+	end
+	for key, _ in pairs(b) do
+		if a[key] == nil then
+			return false
+		end
+	end
+
+	return true
+end
 
 function util.setCreate(values)
 	values = util.tableGetSorted(values)
@@ -201,8 +264,8 @@ end
 function util.getFileExists(filename)
 	return (io.open(filename, "r") ~= nil)
 end
-function util.writeDataUncompressed(filename, dataStr)
-	local file, errMsg = io.open(filename, "w")
+function util.writeDataUncompressed(filename, dataStr, append)
+	local file, errMsg = io.open(filename, append and "a" or "w")
 	if file == nil then
 		log.error("io.open() failed, filename=%s, error=%s", filename, errMsg)
 		return false
@@ -244,6 +307,20 @@ function util.onRunTests()
 	log.assert(util.getComparable(util.tableDeepSort({3, 2, 1})) == util.getComparable({1, 2, 3}))
 	log.assert(util.getComparable(util.tableDeepSort(util.tableGetValues({["a"] = 1, ["b"] = 2}))) == util.getComparable({1, 2}))
 	log.assert(util.getComparable(util.setCreate({1, 2, 3, 3})) == util.getComparable({1, 2, 3}))
+	log.assert(util.tableDeepEquals({1, ["a"] = {["b"] = 2}}, {1, ["a"] = {["b"] = 2}}))
+	log.assert(not util.tableDeepEquals({1, ["a"] = {["b"] = 2}}, {1, ["a"] = {["b"] = 3}}))
+	log.assert(not util.tableDeepEquals({1, 2}, {1}))
+	log.assert(not util.tableDeepEquals({1}, {1, 2}))
+	local copyable = {0.1 + 0.2, [3] = "a", ["b"] = {true}, [{}] = false}
+	copyable.b.cycle = copyable
+	local copied = util.deepcopy(copyable)
+	log.assert((copied ~= copyable) and (copied.b ~= copyable.b) and (copied.b.cycle == copied))
+	log.assert((copied[1] == copyable[1]) and (copied[3] == "a") and copied.b[1])
+	local shared = {1}
+	copied = util.deepcopy({shared, {shared}, [shared] = shared})
+	log.assert((copied[1] ~= shared) and (copied[2][1] == copied[1]) and (copied[copied[1]] == copied[1]))
+	log.assert(util.tableCopyInto({["a"] = 1, ["c"] = 3}, {["a"] = 2, ["b"] = 2}).c == nil)
+	log.assert(util.tableCopyInto({["a"] = 1, ["c"] = 3}, {["a"] = 2, ["b"] = 2}).a == 2)
 	log.assert(util.setEquals({}, {}))
 	log.assert(util.setEquals({1, 2}, {2, 1, 1}))
 	log.assert(util.setEquals({1, 2, ["a"] = "b", ["c"] = {["d"] = 1}}, {1, 2, ["a"] = "b", ["c"] = {["d"] = 1}}))
@@ -252,6 +329,8 @@ function util.onRunTests()
 	log.assert(not util.setEquals({1, 2, ["a"] = "b"}, {1, ["a"] = "b"}))
 end
 
+-- the lua implementation is kept as the headless fallback; engine/client/client.lua swaps in the native one
+util.luaJson = json
 util.json = json
 
 return util